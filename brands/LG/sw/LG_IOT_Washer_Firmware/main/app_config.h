@@ -49,6 +49,15 @@ extern "C" {
 #define PIN_START_STOP_BUTTON   GPIO_NUM_32
 #define PIN_DOOR_SENSOR         GPIO_NUM_34
 
+// Program dial (CONFIG_DIAL_ENCODER). The encoder pins are input-only and
+// need external pull-ups. Every free output left is a strapping pin, so the
+// WS2812 ring takes GPIO4 from the TFT reset, which is then tied to EN
+#define PIN_DIAL_ENC_A          GPIO_NUM_35
+#define PIN_DIAL_ENC_B          GPIO_NUM_39
+#if CONFIG_DIAL_ENCODER
+#define PIN_PROGRAM_DIAL        GPIO_NUM_4
+#endif
+
 // UART for ODrive
 #define PIN_ODRIVE_TX           GPIO_NUM_17
 #define PIN_ODRIVE_RX           GPIO_NUM_16
@@ -67,7 +76,9 @@ extern "C" {
 #define PIN_TFT_SCLK            GPIO_NUM_18
 #define PIN_TFT_CS              GPIO_NUM_5
 #define PIN_TFT_DC              GPIO_NUM_2
+#if !CONFIG_DIAL_ENCODER
 #define PIN_TFT_RST             GPIO_NUM_4
+#endif
 #define PIN_TFT_BL              GPIO_NUM_19
 #define TFT_SPI_HOST            VSPI_HOST
 #define TFT_SPI_FREQ            20000000
@@ -94,6 +105,9 @@ extern "C" {
 #define LEDC_CH_DRUM_LED        LEDC_CHANNEL_2
 #define LEDC_CH_FILL            LEDC_CHANNEL_3
 
+#define PUMP_SOFT_START_MS      300                 // Pump ramp from current duty to target
+#define DRUM_LED_FADE_MS        100                 // Drum light fade on power on/off
+
 /*===========================================================================
  * WiFi Configuration
  *===========================================================================*/
@@ -104,6 +118,8 @@ extern "C" {
  * Timing Constants (milliseconds/seconds)
  *===========================================================================*/
 #define BUTTON_DEBOUNCE_MS      50
+#define BUTTON_LONG_PRESS_MS    2000    // START held this long = long press
+#define INPUT_ULP_AWAKE_PERIOD_US 5000  // ULP button sampling period while awake
 #define DISPLAY_REFRESH_MS      100
 #define MOTOR_UPDATE_MS         50
 
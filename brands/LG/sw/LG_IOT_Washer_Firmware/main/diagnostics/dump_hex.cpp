@@ -0,0 +1,51 @@
+/*
+ * dump_hex.cpp
+ * Binary diagnostic dumps as console hex lines
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "dump_hex.h"
+
+#include <stdio.h>
+
+static void flush_line(dump_hex_writer_t *writer)
+{
+    if (writer->used == 0) {
+        return;
+    }
+    char line[8 + 2 * DUMP_HEX_LINE_BYTES + 1];
+    int pos = snprintf(line, sizeof(line), "%s ", writer->prefix);
+    for (size_t i = 0; i < writer->used && pos + 2 < (int)sizeof(line); i++) {
+        pos += snprintf(line + pos, sizeof(line) - pos, "%02x", writer->pending[i]);
+    }
+    printf("%s\n", line);
+    writer->used = 0;
+}
+
+void dump_hex_begin(dump_hex_writer_t *writer, const char *prefix)
+{
+    writer->prefix = prefix;
+    writer->used = 0;
+    printf("%s BEGIN\n", prefix);
+}
+
+esp_err_t dump_hex_write(void *ctx, const void *data, size_t len)
+{
+    auto *writer = static_cast<dump_hex_writer_t *>(ctx);
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++) {
+        writer->pending[writer->used++] = bytes[i];
+        if (writer->used == DUMP_HEX_LINE_BYTES) {
+            flush_line(writer);
+        }
+    }
+    return ESP_OK;
+}
+
+void dump_hex_end(dump_hex_writer_t *writer)
+{
+    flush_line(writer);
+    printf("%s END\n", writer->prefix);
+}
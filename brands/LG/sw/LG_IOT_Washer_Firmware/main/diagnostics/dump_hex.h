@@ -0,0 +1,56 @@
+/*
+ * dump_hex.h
+ * Binary diagnostic dumps as console hex lines
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Sink for a binary dump, called with consecutive pieces of it
+ * @return ESP_OK to continue; any other value aborts the dump
+ */
+typedef esp_err_t (*dump_write_fn)(void *ctx, const void *data, size_t len);
+
+#define DUMP_HEX_LINE_BYTES     32
+
+typedef struct {
+    const char *prefix;
+    size_t used;
+    uint8_t pending[DUMP_HEX_LINE_BYTES];
+} dump_hex_writer_t;
+
+/*===========================================================================
+ * Hex Writer
+ *
+ * Prints "<prefix> BEGIN", one "<prefix> <hex>" line per 32 bytes and
+ * "<prefix> END", the framing sim_host.py and the decoders look for.
+ *===========================================================================*/
+
+/**
+ * @brief Start a dump: print "<prefix> BEGIN"
+ */
+void dump_hex_begin(dump_hex_writer_t *writer, const char *prefix);
+
+/**
+ * @brief dump_write_fn printing hex lines; @p ctx is the dump_hex_writer_t
+ */
+esp_err_t dump_hex_write(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief Print the last partial line and "<prefix> END"
+ */
+void dump_hex_end(dump_hex_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,243 @@
+/*
+ * event_record.cpp
+ * Compact recording of the events dispatched by the system manager, for
+ * deterministic replay on the host
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why the manager's dispatches are recorded, and not the producers' posts:
+ * - What the manager does depends on the order it dispatches events in,
+ *   after the safety lane has gone first and dial deltas and ticks have
+ *   been collapsed. Recording posts would leave that interleaving to be
+ *   reproduced by the replay. Recording dispatches captures it as it
+ *   happened, and tasks_post_replay_event() feeds the events back
+ *   unchanged, one at a time.
+ * - Only the manager appends, so the RAM buffer needs no lock. It only
+ *   grows: a reader takes the published length and copies bytes that no
+ *   longer change. When it is full, recording stops and the header says
+ *   so. A ring would have to drop the start of the session, and a replay
+ *   cannot start in the middle.
+ * - Ticks are most of a session, so a tick one second after the previous
+ *   event with a count of 1 takes one byte. A 75 minute cycle with no
+ *   input during it takes about 5 KB; a tick dispatched a millisecond off
+ *   takes three bytes.
+ */
+
+#include "event_record.h"
+#include "dump_hex.h"
+
+#include <atomic>
+#include <string.h>
+
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "event_record";
+
+#define FLAG_VALUE_ONE      0x10
+#define FLAG_ONE_SECOND     0x20
+#define TYPE_MASK           0x0F
+
+static_assert(WM_EVENT_TYPE_COUNT <= TYPE_MASK + 1, "event type must fit in 4 bits");
+
+#if CONFIG_EVENT_RECORD
+
+static uint8_t s_buffer[CONFIG_EVENT_RECORD_BYTES];
+static std::atomic<uint32_t> s_used{0};         // Published bytes of s_buffer
+static event_record_write_fn s_sink = nullptr;
+static void *s_sink_ctx = nullptr;
+static int64_t s_start_us = 0;
+static uint32_t s_last_ms = 0;
+static bool s_recording = false;
+
+/*===========================================================================
+ * Recording
+ *===========================================================================*/
+
+static size_t put_varint(uint8_t *out, uint32_t value)
+{
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+static void append(const void *data, size_t len)
+{
+    if (s_sink) {
+        if (s_sink(s_sink_ctx, data, len) != ESP_OK) {
+            ESP_LOGW(TAG, "Sink failed; recording stopped");
+            s_recording = false;
+        }
+        return;
+    }
+    const uint32_t used = s_used.load(std::memory_order_relaxed);
+    if (used + len > sizeof(s_buffer)) {
+        reinterpret_cast<event_record_header_t *>(s_buffer)->flags |= EVENT_RECORD_FLAG_TRUNCATED;
+        ESP_LOGW(TAG, "Buffer full after %lu bytes; recording stopped", (unsigned long)used);
+        s_recording = false;
+        return;
+    }
+    memcpy(s_buffer + used, data, len);
+    s_used.store(used + len, std::memory_order_release);
+}
+
+void event_record_set_sink(event_record_write_fn write, void *ctx)
+{
+    s_sink = write;
+    s_sink_ctx = ctx;
+}
+
+void event_record_start(void)
+{
+    s_used.store(0, std::memory_order_relaxed);
+    s_start_us = esp_timer_get_time();
+    s_last_ms = 0;
+    s_recording = true;
+
+    event_record_header_t header = {};
+    header.magic = EVENT_RECORD_MAGIC;
+    header.version = EVENT_RECORD_FORMAT_VERSION;
+    append(&header, sizeof(header));
+}
+
+void event_record_dispatch(const wm_event_t *event)
+{
+    if (!s_recording || !event) {
+        return;
+    }
+    const uint32_t time_ms = (uint32_t)((esp_timer_get_time() - s_start_us) / 1000);
+    const uint32_t delta_ms = time_ms - s_last_ms;
+    s_last_ms = time_ms;
+
+    uint8_t rec[EVENT_RECORD_MAX_BYTES];
+    size_t n = 1;
+    rec[0] = (uint8_t)(event->type & TYPE_MASK);
+    if (delta_ms == 1000) {
+        rec[0] |= FLAG_ONE_SECOND;
+    } else {
+        n += put_varint(rec + n, delta_ms);
+    }
+    if (event->value == 1) {
+        rec[0] |= FLAG_VALUE_ONE;
+    } else {
+        const uint32_t zigzag = ((uint32_t)event->value << 1) ^ (uint32_t)(event->value >> 31);
+        n += put_varint(rec + n, zigzag);
+    }
+    append(rec, n);
+}
+
+esp_err_t event_record_dump(event_record_write_fn write, void *ctx)
+{
+    if (s_sink) {
+        return ESP_ERR_NOT_SUPPORTED;
+    }
+    const uint32_t used = s_used.load(std::memory_order_acquire);
+    return write(ctx, s_buffer, used);
+}
+
+#else // !CONFIG_EVENT_RECORD
+
+void event_record_set_sink(event_record_write_fn write, void *ctx)
+{
+    (void)write;
+    (void)ctx;
+}
+
+void event_record_start(void)
+{
+}
+
+void event_record_dispatch(const wm_event_t *event)
+{
+    (void)event;
+}
+
+esp_err_t event_record_dump(event_record_write_fn write, void *ctx)
+{
+    (void)write;
+    (void)ctx;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_EVENT_RECORD
+
+void event_record_dump_uart(void)
+{
+    dump_hex_writer_t writer;
+    dump_hex_begin(&writer, "EREC");
+    esp_err_t ret = event_record_dump(dump_hex_write, &writer);
+    dump_hex_end(&writer);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Dump failed: %s", esp_err_to_name(ret));
+    }
+}
+
+/*===========================================================================
+ * Decoding
+ *===========================================================================*/
+
+static bool get_varint(event_record_reader_t *reader, uint32_t *value)
+{
+    uint32_t result = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (reader->pos >= reader->len) {
+            return false;
+        }
+        const uint8_t byte = reader->data[reader->pos++];
+        result |= (uint32_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+esp_err_t event_record_reader_init(event_record_reader_t *reader, const uint8_t *data, size_t len)
+{
+    event_record_header_t header;
+    if (!reader || !data || len < sizeof(header)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != EVENT_RECORD_MAGIC) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (header.version != EVENT_RECORD_FORMAT_VERSION) {
+        return ESP_ERR_INVALID_VERSION;
+    }
+    reader->data = data;
+    reader->len = len;
+    reader->pos = sizeof(header);
+    reader->time_ms = 0;
+    reader->flags = header.flags;
+    return ESP_OK;
+}
+
+esp_err_t event_record_next(event_record_reader_t *reader, event_record_entry_t *entry)
+{
+    if (reader->pos >= reader->len) {
+        return ESP_ERR_NOT_FOUND;
+    }
+    const uint8_t head = reader->data[reader->pos++];
+    uint32_t delta_ms = 1000;
+    if (!(head & FLAG_ONE_SECOND) && !get_varint(reader, &delta_ms)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    uint32_t zigzag = 2;    // Decodes to 1
+    if (!(head & FLAG_VALUE_ONE) && !get_varint(reader, &zigzag)) {
+        return ESP_ERR_INVALID_SIZE;
+    }
+    reader->time_ms += delta_ms;
+    entry->time_ms = reader->time_ms;
+    entry->type = (wm_event_type_t)(head & TYPE_MASK);
+    entry->value = (int32_t)((zigzag >> 1) ^ (0u - (zigzag & 1)));
+    return ESP_OK;
+}
@@ -0,0 +1,114 @@
+/*
+ * event_record.h
+ * Compact recording of the events dispatched by the system manager, for
+ * deterministic replay on the host
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "tasks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Format (little endian): a 6-byte header, then one record per dispatched
+ * event, in dispatch order:
+ *
+ *   byte 0     bits 0-3 event type, bit 4 value is 1, bit 5 one second
+ *              after the previous record
+ *   varint     milliseconds since the previous record (absent with bit 5)
+ *   varint     zigzag value (absent with bit 4)
+ *
+ * A steady timer tick is one byte. Times count from event_record_start().
+ */
+#define EVENT_RECORD_MAGIC          0x52454D57u     // "WMER"
+#define EVENT_RECORD_FORMAT_VERSION 1
+#define EVENT_RECORD_FLAG_TRUNCATED 0x01            // The RAM buffer filled up
+
+#define EVENT_RECORD_MAX_BYTES      11              // Longest encoded record
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t flags;
+} event_record_header_t;
+
+typedef struct {
+    uint32_t time_ms;           // Since event_record_start()
+    wm_event_type_t type;
+    int32_t value;
+} event_record_entry_t;
+
+typedef esp_err_t (*event_record_write_fn)(void *ctx, const void *data, size_t len);
+
+/**
+ * @brief Stream the recording to @p write instead of the RAM buffer
+ *
+ * Call before tasks_create_all(). The host build writes its --record file
+ * this way; @p write runs on the manager task.
+ */
+void event_record_set_sink(event_record_write_fn write, void *ctx);
+
+/**
+ * @brief Start a new recording; called by tasks_create_all()
+ */
+void event_record_start(void);
+
+/**
+ * @brief Append an event as the manager dispatches it (manager task only)
+ */
+void event_record_dispatch(const wm_event_t *event);
+
+/**
+ * @brief Stream the RAM recording through @p write
+ *
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED without CONFIG_EVENT_RECORD or
+ *         with a sink, or the first error returned by @p write
+ */
+esp_err_t event_record_dump(event_record_write_fn write, void *ctx);
+
+/**
+ * @brief Print the RAM recording to the console as "EREC <hex>" lines
+ */
+void event_record_dump_uart(void);
+
+/*===========================================================================
+ * Decoding
+ *===========================================================================*/
+
+typedef struct {
+    const uint8_t *data;
+    size_t len;
+    size_t pos;
+    uint32_t time_ms;
+    uint8_t flags;              // From the header
+} event_record_reader_t;
+
+/**
+ * @brief Check the header of a recording and prepare to read it
+ *
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if it is not a recording, or
+ *         ESP_ERR_INVALID_VERSION for another format version
+ */
+esp_err_t event_record_reader_init(event_record_reader_t *reader, const uint8_t *data, size_t len);
+
+/**
+ * @brief Decode the next record
+ *
+ * @return ESP_OK, ESP_ERR_NOT_FOUND at the end, or ESP_ERR_INVALID_SIZE
+ *         if the data ends inside a record
+ */
+esp_err_t event_record_next(event_record_reader_t *reader, event_record_entry_t *entry);
+
+#ifdef __cplusplus
+}
+#endif
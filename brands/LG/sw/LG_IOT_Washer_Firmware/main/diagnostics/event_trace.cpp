@@ -0,0 +1,181 @@
+/*
+ * event_trace.cpp
+ * Per-core binary event trace for profiling the control plane
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why a binary trace next to ESP_LOG:
+ * - A log line on a hot path (every ODrive command, every edge) costs a
+ *   format and a UART write, enough to change the timing being looked at,
+ *   so those lines were debug-only and normally compiled out. A trace record
+ *   is a timer read and a 16-byte store; the formatting happens on the host
+ *   (tools/trace_decode/trace_decode.py, Chrome trace JSON).
+ * - One ring per core. The slot is claimed with an atomic fetch-add, so a
+ *   writer preempted by an ISR or migrated to the other core still gets its
+ *   own slot; no lock is taken. The price is that a record being written
+ *   while a dump runs can come out torn, which is why dumping pauses
+ *   recording first.
+ * - Records carry a small per-task number, handed out on a task's first
+ *   record and kept in the FreeRTOS task number (uxTaskNumber, meant for
+ *   trace tools); the dump adds a number -> name table so the timeline shows
+ *   one row per task.
+ */
+
+#include "event_trace.h"
+
+#include <atomic>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_timer.h"
+
+#if CONFIG_EVENT_TRACE
+
+#define RECORDS_PER_CORE    CONFIG_EVENT_TRACE_RECORDS
+#define TRACE_CORES         2
+static_assert((RECORDS_PER_CORE & (RECORDS_PER_CORE - 1)) == 0,
+              "CONFIG_EVENT_TRACE_RECORDS must be a power of two");
+static_assert(portNUM_PROCESSORS <= TRACE_CORES, "one ring per core");
+
+static struct {
+    std::atomic<uint32_t> written{0};
+    event_trace_record_t records[RECORDS_PER_CORE];
+} s_rings[TRACE_CORES];
+
+static std::atomic<bool> s_enabled{true};
+static std::atomic<uint16_t> s_task_numbers{0};
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+#define TASK_SLOTS 40
+static TaskStatus_t s_status[TASK_SLOTS];   // Dump-time only
+#endif
+
+/*===========================================================================
+ * Recording
+ *===========================================================================*/
+
+static uint16_t current_task_number(void)
+{
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    TaskHandle_t task = xTaskGetCurrentTaskHandle();
+    UBaseType_t number = uxTaskGetTaskNumber(task);
+    if (number == 0) {
+        // Only the task itself assigns its number, so this cannot race
+        number = s_task_numbers.fetch_add(1, std::memory_order_relaxed) + 1;
+        vTaskSetTaskNumber(task, number);
+    }
+    return (uint16_t)number;
+#else
+    return 0;
+#endif
+}
+
+void event_trace_record(event_trace_id_t id, uint32_t a, uint32_t b)
+{
+    if (!s_enabled.load(std::memory_order_relaxed)) {
+        return;
+    }
+    const int core = esp_cpu_get_core_id();
+    const bool isr = xPortInIsrContext();
+    auto &ring = s_rings[core];
+    const uint32_t slot = ring.written.fetch_add(1, std::memory_order_relaxed);
+
+    event_trace_record_t &rec = ring.records[slot & (RECORDS_PER_CORE - 1)];
+    rec.time_us = (uint32_t)esp_timer_get_time();
+    rec.id = (uint8_t)id;
+    rec.flags = (uint8_t)(core | (isr ? 2 : 0));
+    rec.task = isr ? 0 : current_task_number();
+    rec.a = a;
+    rec.b = b;
+}
+
+void event_trace_set_enabled(bool enabled)
+{
+    s_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+/*===========================================================================
+ * Dump
+ *===========================================================================*/
+
+esp_err_t event_trace_dump(dump_write_fn write, void *ctx)
+{
+    const bool was_enabled = s_enabled.exchange(false);
+    // Let a writer that passed the enabled check finish its record
+    vTaskDelay(1);
+
+    event_trace_header_t header = {};
+    header.magic = EVENT_TRACE_MAGIC;
+    header.version = EVENT_TRACE_FORMAT_VERSION;
+    header.record_size = sizeof(event_trace_record_t);
+    header.cores = portNUM_PROCESSORS;
+    header.now_us = (uint32_t)esp_timer_get_time();
+    for (int c = 0; c < portNUM_PROCESSORS; c++) {
+        uint32_t written = s_rings[c].written.load();
+        header.written[c] = written;
+        header.records[c] = (uint16_t)(written < RECORDS_PER_CORE ? written : RECORDS_PER_CORE);
+    }
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    // Only tasks that have recorded something have a number
+    const UBaseType_t tasks = uxTaskGetSystemState(s_status, TASK_SLOTS, nullptr);
+    for (UBaseType_t i = 0; i < tasks; i++) {
+        if (uxTaskGetTaskNumber(s_status[i].xHandle) != 0) {
+            header.task_count++;
+        }
+    }
+#endif
+
+    esp_err_t ret = write(ctx, &header, sizeof(header));
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    for (UBaseType_t i = 0; i < tasks && ret == ESP_OK; i++) {
+        UBaseType_t number = uxTaskGetTaskNumber(s_status[i].xHandle);
+        if (number == 0) {
+            continue;
+        }
+        event_trace_task_t entry = {};
+        entry.number = (uint16_t)number;
+        strncpy(entry.name, s_status[i].pcTaskName, sizeof(entry.name) - 1);
+        ret = write(ctx, &entry, sizeof(entry));
+    }
+#endif
+    for (int c = 0; c < portNUM_PROCESSORS && ret == ESP_OK; c++) {
+        const auto &ring = s_rings[c];
+        const uint32_t first = header.written[c] - header.records[c];
+        for (uint32_t i = 0; i < header.records[c] && ret == ESP_OK; i++) {
+            ret = write(ctx, &ring.records[(first + i) & (RECORDS_PER_CORE - 1)],
+                        sizeof(event_trace_record_t));
+        }
+    }
+
+    s_enabled.store(was_enabled);
+    return ret;
+}
+
+#else // !CONFIG_EVENT_TRACE
+
+void event_trace_record(event_trace_id_t id, uint32_t a, uint32_t b)
+{
+    (void)id;
+    (void)a;
+    (void)b;
+}
+
+void event_trace_set_enabled(bool enabled)
+{
+    (void)enabled;
+}
+
+esp_err_t event_trace_dump(dump_write_fn write, void *ctx)
+{
+    (void)write;
+    (void)ctx;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+#endif // CONFIG_EVENT_TRACE
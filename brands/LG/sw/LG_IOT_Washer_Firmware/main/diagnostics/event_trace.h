@@ -0,0 +1,120 @@
+/*
+ * event_trace.h
+ * Per-core binary event trace for profiling the control plane
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include "dump_hex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Trace Points
+ *
+ * X(id, kind): kind is B (begin), E (end) or I (instant). A begin and its
+ * end share the name stem before _BEGIN/_END. tools/trace_decode/
+ * trace_decode.py parses this list, so keep one entry per line and the
+ * argument comment on the same line. Append only; ids are positional.
+ *===========================================================================*/
+
+#define EVENT_TRACE_IDS(X) \
+    X(ETRACE_EVENT_POST,        I)  /* a = producer, b = event type */ \
+    X(ETRACE_EVENT_DROP,        I)  /* a = producer, b = event type (ring full) */ \
+    X(ETRACE_DISPATCH_BEGIN,    B)  /* a = event type, b = value */ \
+    X(ETRACE_DISPATCH_END,      E)  /* a = event type */ \
+    X(ETRACE_COMMAND_BEGIN,     B)  /* a = command type, b = arg0 */ \
+    X(ETRACE_COMMAND_END,       E)  /* a = command type */ \
+    X(ETRACE_COMMAND_DROP,      I)  /* a = command type (ring full) */ \
+    X(ETRACE_BUTTON_EDGE,       I)  /* a = button index, b = level */ \
+    X(ETRACE_DOOR_EDGE,         I)  /* a = level */ \
+    X(ETRACE_ODRIVE_CMD_BEGIN,  B)  /* a = first 4 command bytes, b = length */ \
+    X(ETRACE_ODRIVE_CMD_END,    E)  /* a = esp_err_t, b = response length */ \
+    X(ETRACE_FRAME_BEGIN,       B)  /* */ \
+    X(ETRACE_FRAME_END,         E)  /* */
+
+typedef enum {
+#define EVENT_TRACE_ENUM(id, kind) id,
+    EVENT_TRACE_IDS(EVENT_TRACE_ENUM)
+#undef EVENT_TRACE_ENUM
+    ETRACE_ID_COUNT
+} event_trace_id_t;
+
+/*===========================================================================
+ * Recording
+ *
+ * ETRACE() compiles to nothing without CONFIG_EVENT_TRACE; the arguments
+ * are not evaluated. With it, a record costs a timer read and a 16-byte
+ * store into the current core's ring, and is safe from tasks and ISRs.
+ *===========================================================================*/
+
+#if CONFIG_EVENT_TRACE
+#define ETRACE(id, a, b) event_trace_record((id), (uint32_t)(a), (uint32_t)(b))
+#else
+#define ETRACE(id, a, b) ((void)0)
+#endif
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;           // esp_timer time (low 32 bits)
+    uint8_t id;                 // event_trace_id_t
+    uint8_t flags;              // Bit 0 = core, bit 1 = ISR context
+    uint16_t task;              // Trace task number (0 = ISR or unknown)
+    uint32_t a;
+    uint32_t b;
+} event_trace_record_t;
+
+/*
+ * Dump format (little endian): header, task_count task entries, then the
+ * records of each core in turn, oldest first. Served after the latency
+ * dump by trace_dump_all() (trace.h).
+ */
+#define EVENT_TRACE_MAGIC           0x54454D57u     // "WMET"
+#define EVENT_TRACE_FORMAT_VERSION  1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t record_size;
+    uint8_t cores;
+    uint8_t task_count;
+    uint32_t now_us;
+    uint32_t written[2];        // Records ever written per core
+    uint16_t records[2];        // Records in the dump per core
+} event_trace_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint16_t number;            // Matches event_trace_record_t.task
+    char name[14];              // NUL-terminated, truncated
+} event_trace_task_t;
+
+/**
+ * @brief Append one record to the current core's ring (use ETRACE())
+ */
+void event_trace_record(event_trace_id_t id, uint32_t a, uint32_t b);
+
+/**
+ * @brief Pause or resume recording (recording starts enabled)
+ */
+void event_trace_set_enabled(bool enabled);
+
+/**
+ * @brief Stream a dump through @p write
+ *
+ * Recording is paused for the duration so the rings hold still.
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED without CONFIG_EVENT_TRACE, or the
+ *         first error returned by @p write
+ */
+esp_err_t event_trace_dump(dump_write_fn write, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,145 @@
+/*
+ * heap_report.cpp
+ * Heap fragmentation report and steady-state allocation check
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why a separate check instead of watching free heap:
+ * - Free heap going up and down says little; a steady state that allocates
+ *   and frees every frame keeps the same free total while the largest free
+ *   block shrinks. The report therefore shows largest block and block
+ *   counts next to the totals, and fragmentation as the share of free
+ *   memory outside the largest block.
+ * - The steady-state check counts allocations over a window chosen by the
+ *   operator (simulator "$H1" ... "$H0"). With the ESP-IDF heap tracer
+ *   enabled it counts every malloc and dumps the callers; without it the
+ *   net change in allocated blocks is still a useful smoke test.
+ * - The host build supplies a tracer that counts the same way from its
+ *   malloc wrappers, and cycle_check --heap runs whole cycles inside this
+ *   check under CTest, so churn fails a build before it reaches a device.
+ */
+
+#include "heap_report.h"
+#include "sdkconfig.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#if CONFIG_HEAP_TRACING_STANDALONE
+#include "esp_check.h"
+#include "esp_heap_trace.h"
+#endif
+
+static const char *TAG = "heap_report";
+
+#define HEAP_TRACE_RECORDS  64
+
+static const struct {
+    const char *name;
+    uint32_t caps;
+} s_regions[] = {
+    { "internal", MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT },
+    { "dma",      MALLOC_CAP_DMA },
+    { "default",  MALLOC_CAP_DEFAULT },
+};
+
+static size_t s_boot_blocks = 0;
+static size_t s_check_blocks = 0;
+static int64_t s_check_start_us = 0;
+static bool s_checking = false;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+static heap_trace_record_t s_trace_records[HEAP_TRACE_RECORDS];
+static bool s_trace_ready = false;
+#endif
+
+static size_t allocated_blocks(void)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, MALLOC_CAP_DEFAULT);
+    return info.allocated_blocks;
+}
+
+void heap_report_log(const char *label)
+{
+    for (const auto &region : s_regions) {
+        multi_heap_info_t info;
+        heap_caps_get_info(&info, region.caps);
+        const unsigned frag = info.total_free_bytes
+            ? (unsigned)(100 - (uint64_t)info.largest_free_block * 100 / info.total_free_bytes)
+            : 0;
+        ESP_LOGI(TAG, "[%s] %-8s free=%u largest=%u min=%u blocks=%u/%u frag=%u%%",
+                 label, region.name, (unsigned)info.total_free_bytes,
+                 (unsigned)info.largest_free_block, (unsigned)info.minimum_free_bytes,
+                 (unsigned)info.allocated_blocks, (unsigned)info.free_blocks, frag);
+    }
+}
+
+void heap_report_mark_boot(void)
+{
+    s_boot_blocks = allocated_blocks();
+    heap_report_log("boot");
+}
+
+esp_err_t heap_report_check_start(void)
+{
+    if (s_checking) {
+        return ESP_ERR_INVALID_STATE;
+    }
+#if CONFIG_HEAP_TRACING_STANDALONE
+    if (!s_trace_ready) {
+        ESP_RETURN_ON_ERROR(heap_trace_init_standalone(s_trace_records, HEAP_TRACE_RECORDS),
+                            TAG, "Heap trace init failed");
+        s_trace_ready = true;
+    }
+    ESP_RETURN_ON_ERROR(heap_trace_start(HEAP_TRACE_ALL), TAG, "Heap trace start failed");
+#endif
+    s_check_blocks = allocated_blocks();
+    s_check_start_us = esp_timer_get_time();
+    s_checking = true;
+    ESP_LOGI(TAG, "Steady-state check started");
+    return ESP_OK;
+}
+
+esp_err_t heap_report_check_stop(uint32_t *allocations)
+{
+    if (!s_checking) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_checking = false;
+    const uint32_t window_ms = (uint32_t)((esp_timer_get_time() - s_check_start_us) / 1000);
+    const size_t blocks = allocated_blocks();
+    uint32_t count = blocks > s_check_blocks ? (uint32_t)(blocks - s_check_blocks) : 0;
+
+#if CONFIG_HEAP_TRACING_STANDALONE
+    heap_trace_stop();
+    heap_trace_summary_t summary = {};
+    if (heap_trace_summary(&summary) == ESP_OK) {
+        count = (uint32_t)summary.total_allocations;
+        ESP_LOGI(TAG, "%u allocations, %u frees in %lu ms%s",
+                 (unsigned)summary.total_allocations, (unsigned)summary.total_frees,
+                 (unsigned long)window_ms, summary.has_overflowed ? " (records overflowed)" : "");
+    }
+    if (count > 0) {
+        heap_trace_dump();
+    }
+#else
+    ESP_LOGI(TAG, "%u new blocks in %lu ms (enable CONFIG_HEAP_TRACING_STANDALONE for callers)",
+             (unsigned)count, (unsigned long)window_ms);
+#endif
+
+    if (count == 0) {
+        ESP_LOGI(TAG, "Steady state: no heap allocations");
+    } else {
+        ESP_LOGW(TAG, "Steady state: %u heap allocations", (unsigned)count);
+    }
+    ESP_LOGI(TAG, "%d blocks allocated since boot", (int)blocks - (int)s_boot_blocks);
+    heap_report_log("steady");
+    if (allocations) {
+        *allocations = count;
+    }
+    return ESP_OK;
+}
@@ -0,0 +1,54 @@
+/*
+ * heap_report.h
+ * Heap fragmentation report and steady-state allocation check
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Heap Report API
+ *===========================================================================*/
+
+/**
+ * @brief Log free, largest block, low-water mark, block counts and
+ *        fragmentation for the internal, DMA and default heaps
+ * @param label Printed with each line ("boot", "steady", ...)
+ */
+void heap_report_log(const char *label);
+
+/**
+ * @brief Log the report once boot is done and remember the heap state
+ *
+ * Call after all tasks are created; later checks compare against this.
+ */
+void heap_report_mark_boot(void);
+
+/**
+ * @brief Start counting heap allocations
+ *
+ * Uses the heap tracer when CONFIG_HEAP_TRACING_STANDALONE is enabled, so
+ * heap_report_check_stop() can name the callers; otherwise only the change
+ * in allocated block count is reported.
+ * @return ESP_ERR_INVALID_STATE if a check is already running
+ */
+esp_err_t heap_report_check_start(void);
+
+/**
+ * @brief Stop counting and report allocations since heap_report_check_start()
+ * @param[out] allocations Allocations seen (tracer) or net new blocks
+ * @return ESP_ERR_INVALID_STATE if no check is running
+ */
+esp_err_t heap_report_check_stop(uint32_t *allocations);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,107 @@
+/*
+ * latency_hist.cpp
+ * Log2-bucketed latency histograms for control-plane measurements
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why log2 buckets:
+ * - Latencies of interest range from a few microseconds (queue hand-off) to
+ *   hundreds of milliseconds (a blocked task). Power-of-two buckets cover
+ *   that range in 22 counters, recording is a count-leading-zeros and an
+ *   increment, and the result is still precise enough to tell a 50 ms
+ *   polling loop from an interrupt.
+ */
+
+#include "latency_hist.h"
+
+#include <string.h>
+#include <stdio.h>
+
+#include "esp_log.h"
+
+static const char *TAG = "latency";
+
+static inline int bucket_for(uint32_t us)
+{
+    if (us == 0) {
+        return 0;
+    }
+    int bucket = 32 - __builtin_clz(us);    // floor(log2(us)) + 1
+    return (bucket < LATENCY_HIST_BUCKETS) ? bucket : LATENCY_HIST_BUCKETS - 1;
+}
+
+static inline uint32_t bucket_upper_us(int bucket)
+{
+    return (bucket == 0) ? 0 : (1u << bucket) - 1;
+}
+
+void latency_hist_reset(latency_hist_t *hist)
+{
+    memset(hist, 0, sizeof(*hist));
+}
+
+void latency_hist_record(latency_hist_t *hist, uint32_t latency_us)
+{
+    hist->buckets[bucket_for(latency_us)]++;
+    if (hist->count == 0 || latency_us < hist->min_us) {
+        hist->min_us = latency_us;
+    }
+    if (latency_us > hist->max_us) {
+        hist->max_us = latency_us;
+    }
+    hist->sum_us += latency_us;
+    hist->count++;
+}
+
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint8_t percent)
+{
+    if (hist->count == 0) {
+        return 0;
+    }
+
+    // Rank of the requested sample, rounded up so p100 is the last one
+    uint64_t rank = ((uint64_t)hist->count * percent + 99) / 100;
+    if (rank == 0) {
+        rank = 1;
+    }
+
+    uint64_t seen = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS; i++) {
+        seen += hist->buckets[i];
+        if (seen >= rank) {
+            uint32_t upper = bucket_upper_us(i);
+            return (upper < hist->max_us) ? upper : hist->max_us;
+        }
+    }
+    return hist->max_us;
+}
+
+void latency_hist_log(const char *name, const latency_hist_t *hist)
+{
+    if (hist->count == 0) {
+        ESP_LOGI(TAG, "%s: no samples", name);
+        return;
+    }
+
+    ESP_LOGI(TAG, "%s: n=%lu min=%luus avg=%luus p50<=%luus p99<=%luus max=%luus",
+             name, (unsigned long)hist->count, (unsigned long)hist->min_us,
+             (unsigned long)(hist->sum_us / hist->count),
+             (unsigned long)latency_hist_percentile(hist, 50),
+             (unsigned long)latency_hist_percentile(hist, 99),
+             (unsigned long)hist->max_us);
+
+    // One compact line of "<upper bound>:<count>" for the non-empty buckets
+    char line[192];
+    int pos = 0;
+    for (int i = 0; i < LATENCY_HIST_BUCKETS && pos < (int)sizeof(line) - 24; i++) {
+        if (hist->buckets[i] == 0) {
+            continue;
+        }
+        pos += snprintf(line + pos, sizeof(line) - pos, " <%lu:%lu",
+                        (unsigned long)bucket_upper_us(i) + 1, (unsigned long)hist->buckets[i]);
+    }
+    ESP_LOGI(TAG, "%s buckets(us):%s", name, line);
+}
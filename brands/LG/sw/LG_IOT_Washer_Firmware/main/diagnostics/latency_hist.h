@@ -0,0 +1,66 @@
+/*
+ * latency_hist.h
+ * Log2-bucketed latency histograms for control-plane measurements
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Histogram Configuration
+ *===========================================================================*/
+
+// Bucket i holds samples in [2^(i-1), 2^i) microseconds (bucket 0 holds 0 us);
+// the last bucket also collects everything above 2^(N-2) us (~1 s at 22).
+#define LATENCY_HIST_BUCKETS    22
+
+typedef struct {
+    uint32_t buckets[LATENCY_HIST_BUCKETS];
+    uint32_t count;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint64_t sum_us;
+} latency_hist_t;
+
+/*===========================================================================
+ * Histogram API
+ *
+ * A histogram has no lock of its own: record from one task only, or wrap
+ * record/snapshot in the owner's critical section.
+ *===========================================================================*/
+
+/**
+ * @brief Clear all samples
+ */
+void latency_hist_reset(latency_hist_t *hist);
+
+/**
+ * @brief Add one sample
+ * @param latency_us Measured latency in microseconds
+ */
+void latency_hist_record(latency_hist_t *hist, uint32_t latency_us);
+
+/**
+ * @brief Estimate a percentile from the buckets
+ * @param percent 0-100
+ * @return Upper bound of the bucket containing the percentile (us), 0 if empty
+ */
+uint32_t latency_hist_percentile(const latency_hist_t *hist, uint8_t percent);
+
+/**
+ * @brief Print count/min/avg/p50/p99/max and the non-empty buckets
+ * @param name Label for the log line
+ */
+void latency_hist_log(const char *name, const latency_hist_t *hist);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,350 @@
+/*
+ * runtime_stats.cpp
+ * Per-task CPU/stack, heap and control-plane queue telemetry
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why a sampler task:
+ * - FreeRTOS keeps only cumulative run-time counters, so a load figure
+ *   needs two samples. The sampler diffs consecutive uxTaskGetSystemState()
+ *   calls every RUNTIME_STATS_PERIOD_MS and keeps the result as a snapshot;
+ *   the log, the HTTP API and the diagnostics screen all read that snapshot
+ *   instead of walking the task list themselves.
+ * - uxTaskGetSystemState() suspends the scheduler while it copies the task
+ *   list, so it runs from one priority-1 task at a slow rate rather than
+ *   from every reader.
+ * - Stack figures are FreeRTOS high-water marks (least free stack ever), in
+ *   bytes on ESP-IDF. Queue figures are the control plane's own counters.
+ */
+
+#include "runtime_stats.h"
+#include "tasks/static_alloc.h"
+#include "sdkconfig.h"
+
+#include <stdarg.h>
+#include <string.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+
+#include "esp_heap_caps.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "rt_stats";
+
+#ifndef CONFIG_RUNTIME_STATS_LOG_PERIOD_S
+#define CONFIG_RUNTIME_STATS_LOG_PERIOD_S 0
+#endif
+
+// uxTaskGetSystemState() fails outright if the array cannot hold every task
+#define STATUS_SLOTS (RUNTIME_STATS_MAX_TASKS + 16)
+
+static TaskStatus_t s_status[STATUS_SLOTS];
+
+// Run-time counters from the previous sample, matched by task handle
+static struct {
+    TaskHandle_t handle;
+    uint32_t run_time;
+} s_prev[STATUS_SLOTS];
+static UBaseType_t s_prev_count = 0;
+static uint32_t s_prev_total = 0;
+
+static SemaphoreHandle_t s_lock = nullptr;
+static StaticMutexSlot s_lock_slot;
+static runtime_stats_t s_snapshot;
+static bool s_have_snapshot = false;
+static TaskHandle_t s_task = nullptr;
+static StaticTaskSlot<3072> s_task_slot;
+
+/*===========================================================================
+ * Sampling
+ *===========================================================================*/
+
+static uint32_t previous_run_time(TaskHandle_t handle)
+{
+    for (UBaseType_t i = 0; i < s_prev_count; i++) {
+        if (s_prev[i].handle == handle) {
+            return s_prev[i].run_time;
+        }
+    }
+    return 0;   // Created during the window: all of its time is new
+}
+
+static void sample_tasks(runtime_stats_t *out)
+{
+    out->task_total = (uint16_t)uxTaskGetNumberOfTasks();
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY
+    // Counters are compared as 32-bit: deltas stay right across a wrap
+    configRUN_TIME_COUNTER_TYPE total_raw = 0;
+    UBaseType_t count = uxTaskGetSystemState(s_status, STATUS_SLOTS, &total_raw);
+    const uint32_t total = (uint32_t)total_raw;
+    if (count == 0) {
+        return;     // More than STATUS_SLOTS tasks
+    }
+
+    const uint32_t window = total - s_prev_total;
+    out->window_us = window;
+    const uint64_t capacity = (uint64_t)window * portNUM_PROCESSORS;
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        const TaskStatus_t &ts = s_status[i];
+        runtime_task_stats_t entry = {};
+        strncpy(entry.name, ts.pcTaskName, sizeof(entry.name) - 1);
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        entry.core = (ts.xCoreID == tskNO_AFFINITY) ? -1 : (int8_t)ts.xCoreID;
+#else
+        entry.core = -1;
+#endif
+        entry.priority = (uint8_t)ts.uxCurrentPriority;
+        entry.stack_free_bytes = ts.usStackHighWaterMark;
+        if (capacity > 0) {
+            uint32_t used = (uint32_t)ts.ulRunTimeCounter - previous_run_time(ts.xHandle);
+            uint64_t permille = (uint64_t)used * 1000 / capacity;
+            entry.cpu_permille = (uint16_t)(permille > 1000 ? 1000 : permille);
+        }
+
+        // Keep the list sorted by load, busiest first
+        int pos = out->task_count;
+        if (pos == RUNTIME_STATS_MAX_TASKS) {
+            if (entry.cpu_permille <= out->tasks[pos - 1].cpu_permille) {
+                continue;
+            }
+            pos--;
+        } else {
+            out->task_count++;
+        }
+        while (pos > 0 && out->tasks[pos - 1].cpu_permille < entry.cpu_permille) {
+            out->tasks[pos] = out->tasks[pos - 1];
+            pos--;
+        }
+        out->tasks[pos] = entry;
+    }
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        s_prev[i].handle = s_status[i].xHandle;
+        s_prev[i].run_time = (uint32_t)s_status[i].ulRunTimeCounter;
+    }
+    s_prev_count = count;
+    s_prev_total = total;
+#endif
+}
+
+static void sample(runtime_stats_t *out)
+{
+    memset(out, 0, sizeof(*out));
+    out->sample_us = (uint32_t)esp_timer_get_time();
+
+    sample_tasks(out);
+
+    out->heap_free = heap_caps_get_free_size(MALLOC_CAP_8BIT);
+    out->heap_min_free = heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+    out->heap_largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+
+    for (int p = 0; p < WM_PRODUCER_COUNT; p++) {
+        tasks_get_event_ring_stats((wm_producer_t)p, &out->events[p]);
+    }
+    tasks_get_command_queue_stats(&out->commands);
+}
+
+static void runtime_stats_task(void *arg)
+{
+    (void)arg;
+    // Static: a snapshot is too large for this task's stack
+    static runtime_stats_t fresh;
+    const uint32_t log_every = (uint32_t)CONFIG_RUNTIME_STATS_LOG_PERIOD_S * 1000 / RUNTIME_STATS_PERIOD_MS;
+    uint32_t since_log = 0;
+    TickType_t last_wake = xTaskGetTickCount();
+
+    while (true) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(RUNTIME_STATS_PERIOD_MS));
+        sample(&fresh);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_snapshot = fresh;
+        s_have_snapshot = true;
+        xSemaphoreGive(s_lock);
+
+        if (log_every > 0 && ++since_log >= log_every) {
+            since_log = 0;
+            runtime_stats_log(&fresh);
+        }
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+esp_err_t runtime_stats_start(void)
+{
+    if (s_task) {
+        return ESP_OK;
+    }
+#if !CONFIG_FREERTOS_USE_TRACE_FACILITY || !CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    // Heap and queue figures still work; tasks are missing or show 0% CPU
+    ESP_LOGW(TAG, "FreeRTOS trace facility or run-time stats disabled");
+#endif
+
+    s_lock = create_mutex(s_lock_slot);
+    if (!s_lock) {
+        return ESP_ERR_NO_MEM;
+    }
+    // Baseline only (not published), so the first window is a real interval
+    sample(&s_snapshot);
+
+    if (create_task(s_task_slot, runtime_stats_task, "wm_stats", nullptr, 1, &s_task,
+                    tskNO_AFFINITY) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Sampling every %d ms", RUNTIME_STATS_PERIOD_MS);
+    return ESP_OK;
+}
+
+bool runtime_stats_get(runtime_stats_t *out)
+{
+    if (!s_lock || !out) {
+        return false;
+    }
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool ok = s_have_snapshot;
+    if (ok) {
+        *out = s_snapshot;
+    }
+    xSemaphoreGive(s_lock);
+    return ok;
+}
+
+void runtime_stats_log(const runtime_stats_t *stats)
+{
+    ESP_LOGI(TAG, "heap free=%lu min=%lu largest=%lu, tasks=%u, window=%lums",
+             (unsigned long)stats->heap_free, (unsigned long)stats->heap_min_free,
+             (unsigned long)stats->heap_largest_block, (unsigned)stats->task_total,
+             (unsigned long)(stats->window_us / 1000));
+
+    for (int p = 0; p < WM_PRODUCER_COUNT; p++) {
+        const wm_queue_stats_t &q = stats->events[p];
+        if (q.sent == 0 && q.dropped == 0) {
+            continue;
+        }
+        ESP_LOGI(TAG, "event ring %d: sent=%lu dropped=%lu high_water=%lu", p,
+                 (unsigned long)q.sent, (unsigned long)q.dropped, (unsigned long)q.high_water);
+    }
+    ESP_LOGI(TAG, "command ring: sent=%lu dropped=%lu high_water=%lu",
+             (unsigned long)stats->commands.sent, (unsigned long)stats->commands.dropped,
+             (unsigned long)stats->commands.high_water);
+
+    for (int i = 0; i < stats->task_count; i++) {
+        const runtime_task_stats_t &t = stats->tasks[i];
+        ESP_LOGI(TAG, "  %-16s core=%2d prio=%2u cpu=%3u.%u%% stack_free=%lu",
+                 t.name, t.core, (unsigned)t.priority, t.cpu_permille / 10, t.cpu_permille % 10,
+                 (unsigned long)t.stack_free_bytes);
+    }
+}
+
+// snprintf that keeps counting once the buffer is full
+static void __attribute__((format(printf, 4, 5)))
+json_append(char *buf, size_t len, size_t *pos, const char *fmt, ...)
+{
+    size_t at = (*pos < len) ? *pos : len;
+    va_list args;
+    va_start(args, fmt);
+    int n = vsnprintf(len ? buf + at : nullptr, len - at, fmt, args);
+    va_end(args);
+    if (n > 0) {
+        *pos += (size_t)n;
+    }
+}
+
+size_t runtime_stats_to_json(const runtime_stats_t *stats, char *buf, size_t len)
+{
+    size_t pos = 0;
+#define append(...) json_append(buf, len, &pos, __VA_ARGS__)
+
+    append("{\"uptime_ms\":%llu,\"window_ms\":%lu,",
+           (unsigned long long)(esp_timer_get_time() / 1000), (unsigned long)(stats->window_us / 1000));
+    append("\"heap\":{\"free\":%lu,\"min_free\":%lu,\"largest_block\":%lu},",
+           (unsigned long)stats->heap_free, (unsigned long)stats->heap_min_free,
+           (unsigned long)stats->heap_largest_block);
+
+    append("\"event_rings\":[");
+    for (int p = 0; p < WM_PRODUCER_COUNT; p++) {
+        const wm_queue_stats_t &q = stats->events[p];
+        append("%s{\"sent\":%lu,\"dropped\":%lu,\"depth\":%lu,\"high_water\":%lu}",
+               p ? "," : "", (unsigned long)q.sent, (unsigned long)q.dropped,
+               (unsigned long)q.depth, (unsigned long)q.high_water);
+    }
+    append("],\"command_ring\":{\"sent\":%lu,\"dropped\":%lu,\"depth\":%lu,\"high_water\":%lu},",
+           (unsigned long)stats->commands.sent, (unsigned long)stats->commands.dropped,
+           (unsigned long)stats->commands.depth, (unsigned long)stats->commands.high_water);
+
+    append("\"task_total\":%u,\"tasks\":[", (unsigned)stats->task_total);
+    for (int i = 0; i < stats->task_count; i++) {
+        const runtime_task_stats_t &t = stats->tasks[i];
+        append("%s{\"name\":\"%s\",\"core\":%d,\"prio\":%u,\"cpu_permille\":%u,\"stack_free\":%lu}",
+               i ? "," : "", t.name, t.core, (unsigned)t.priority, (unsigned)t.cpu_permille,
+               (unsigned long)t.stack_free_bytes);
+    }
+    append("]}");
+#undef append
+    return pos;
+}
+
+int runtime_stats_row_count(const runtime_stats_t *stats)
+{
+    return 4 + stats->task_count;
+}
+
+void runtime_stats_format_row(const runtime_stats_t *stats, int row,
+                              char *label, size_t label_len,
+                              char *value, size_t value_len)
+{
+    label[0] = '\0';
+    value[0] = '\0';
+
+    switch (row) {
+        case 0:
+            snprintf(label, label_len, "Heap");
+            snprintf(value, value_len, "%luk/%luk", (unsigned long)(stats->heap_free / 1024),
+                     (unsigned long)(stats->heap_largest_block / 1024));
+            return;
+        case 1:
+            snprintf(label, label_len, "Heap min");
+            snprintf(value, value_len, "%luk", (unsigned long)(stats->heap_min_free / 1024));
+            return;
+        case 2: {
+            uint32_t high = 0;
+            uint32_t dropped = 0;
+            for (int p = 0; p < WM_PRODUCER_COUNT; p++) {
+                if (stats->events[p].high_water > high) {
+                    high = stats->events[p].high_water;
+                }
+                dropped += stats->events[p].dropped;
+            }
+            snprintf(label, label_len, "Events");
+            snprintf(value, value_len, "%lu/%lud", (unsigned long)high, (unsigned long)dropped);
+            return;
+        }
+        case 3:
+            snprintf(label, label_len, "Commands");
+            snprintf(value, value_len, "%lu/%lud", (unsigned long)stats->commands.high_water,
+                     (unsigned long)stats->commands.dropped);
+            return;
+        default:
+            break;
+    }
+
+    int idx = row - 4;
+    if (idx < 0 || idx >= stats->task_count) {
+        return;
+    }
+    const runtime_task_stats_t &t = stats->tasks[idx];
+    snprintf(label, label_len, "%s", t.name);
+    snprintf(value, value_len, "%u%% %lu", (unsigned)((t.cpu_permille + 5) / 10),
+             (unsigned long)t.stack_free_bytes);
+}
@@ -0,0 +1,97 @@
+/*
+ * runtime_stats.h
+ * Per-task CPU/stack, heap and control-plane queue telemetry
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "tasks/tasks.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Runtime Stats Configuration
+ *===========================================================================*/
+
+#define RUNTIME_STATS_MAX_TASKS     24      // Tasks beyond this are counted but not listed
+#define RUNTIME_STATS_PERIOD_MS     2000    // CPU load is averaged over this window
+#define RUNTIME_STATS_NAME_LEN      16      // configMAX_TASK_NAME_LEN on ESP-IDF
+
+typedef struct {
+    char name[RUNTIME_STATS_NAME_LEN];
+    int8_t core;                // -1 = unpinned or unknown
+    uint8_t priority;
+    uint16_t cpu_permille;      // Share of total CPU time (all cores) in the last window
+    uint32_t stack_free_bytes;  // Stack high-water mark: least free stack ever seen
+} runtime_task_stats_t;
+
+typedef struct {
+    uint32_t sample_us;         // esp_timer time of this snapshot (low 32 bits)
+    uint32_t window_us;         // Length of the CPU window
+    uint16_t task_total;        // Tasks that exist (may exceed task_count)
+    uint8_t task_count;         // Entries filled in tasks[]
+    runtime_task_stats_t tasks[RUNTIME_STATS_MAX_TASKS];
+    uint32_t heap_free;
+    uint32_t heap_min_free;     // Lowest free heap since boot
+    uint32_t heap_largest_block;
+    wm_queue_stats_t events[WM_PRODUCER_COUNT];
+    wm_queue_stats_t commands;
+} runtime_stats_t;
+
+/*===========================================================================
+ * Runtime Stats API
+ *===========================================================================*/
+
+/**
+ * @brief Start the low-priority sampler task
+ *
+ * Samples every RUNTIME_STATS_PERIOD_MS and logs a summary every
+ * CONFIG_RUNTIME_STATS_LOG_PERIOD_S (0 = only on request). Call after
+ * tasks_create_all().
+ * @return ESP_OK on success
+ */
+esp_err_t runtime_stats_start(void);
+
+/**
+ * @brief Copy the latest snapshot
+ * @return false if no sample has been taken yet
+ */
+bool runtime_stats_get(runtime_stats_t *out);
+
+/**
+ * @brief Print heap, queue and per-task lines to the log
+ */
+void runtime_stats_log(const runtime_stats_t *stats);
+
+/**
+ * @brief Render a snapshot as JSON for the HTTP API
+ * @return Length the full document needs, like snprintf; a value >= @p len
+ *         means the output was truncated
+ */
+size_t runtime_stats_to_json(const runtime_stats_t *stats, char *buf, size_t len);
+
+/**
+ * @brief Number of rows runtime_stats_format_row() can produce
+ */
+int runtime_stats_row_count(const runtime_stats_t *stats);
+
+/**
+ * @brief One "label / value" row for the diagnostics screen
+ *
+ * Rows are heap, minimum heap, event rings, command ring, then one per task.
+ */
+void runtime_stats_format_row(const runtime_stats_t *stats, int row,
+                              char *label, size_t label_len,
+                              char *value, size_t value_len);
+
+#ifdef __cplusplus
+}
+#endif
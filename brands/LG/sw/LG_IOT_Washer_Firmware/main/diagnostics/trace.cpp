@@ -0,0 +1,263 @@
+/*
+ * trace.cpp
+ * End-to-end latency trace from input edge to actuator output and display
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why a trace id instead of more histograms:
+ * - s_input_latency in tasks.cpp only covers edge to dispatch. A button
+ *   that "feels laggy" can just as well be slow in the actuator task or wait
+ *   for the next display frame, and those stages run in other tasks. Each
+ *   input event gets a 16-bit id when it is posted; the id rides along in
+ *   wm_event_t and in every wm_command_t the manager sends while handling
+ *   it, so each stage can be attributed to the input that caused it.
+ * - Every stage is appended to a small binary ring (8 bytes per record) for
+ *   offline analysis, and the delay from the previous stage goes into a
+ *   latency_hist_t so the numbers are available without a host.
+ * - Only the first command and first actuation of a trace are counted in
+ *   the histograms; a power-on batch still shows up in full in the records.
+ */
+
+#include "trace.h"
+#include "event_trace.h"
+#include "latency_hist.h"
+#include "sdkconfig.h"
+
+#include <string.h>
+#include <stdio.h>
+
+#include "freertos/FreeRTOS.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "trace";
+
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static trace_record_t s_records[TRACE_BUFFER_RECORDS];
+static uint32_t s_written = 0;      // Records ever written; head = s_written % size
+static bool s_frozen = false;       // Set while trace_dump_uart() reads s_records
+static uint16_t s_next_id = 0;
+static uint32_t s_dropped = 0;      // Inputs lost to a full event ring
+
+// Stage times of the most recent traces, slot = id % TRACE_INFLIGHT
+static struct {
+    uint16_t id;
+    uint8_t seen;                   // Bit per trace_stage_t
+    uint32_t time_us[TRACE_STAGE_COUNT];
+} s_inflight[TRACE_INFLIGHT];
+
+// Delay from the previous stage, indexed by trace_stage_t (EDGE unused)
+static latency_hist_t s_stage_hist[TRACE_STAGE_COUNT];
+static latency_hist_t s_edge_to_actuate;
+static latency_hist_t s_edge_to_frame;
+
+static const char *const s_stage_names[TRACE_STAGE_COUNT] = {
+    "edge", "enqueue", "dispatch", "command", "actuate", "frame",
+};
+
+static inline uint32_t now_us(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+/*===========================================================================
+ * Recording (s_lock held)
+ *===========================================================================*/
+
+static void mark_locked(uint16_t id, trace_stage_t stage, uint32_t time_us, uint8_t arg)
+{
+    if (!s_frozen) {
+        trace_record_t &rec = s_records[s_written % TRACE_BUFFER_RECORDS];
+        rec.time_us = time_us;
+        rec.id = id;
+        rec.stage = (uint8_t)stage;
+        rec.arg = arg;
+        s_written++;
+    }
+
+    auto &slot = s_inflight[id % TRACE_INFLIGHT];
+    if (stage == TRACE_STAGE_EDGE) {
+        slot.id = id;
+        slot.seen = 0;
+    }
+    const uint8_t bit = (uint8_t)(1u << stage);
+    if (slot.id != id || (slot.seen & bit)) {
+        return;     // Evicted by a newer trace, or a repeat of this stage
+    }
+    slot.seen |= bit;
+    slot.time_us[stage] = time_us;
+
+    // The frame follows the manager's state change, not the actuator
+    int prev = (stage == TRACE_STAGE_FRAME) ? TRACE_STAGE_DISPATCH : (int)stage - 1;
+    while (prev >= 0 && !(slot.seen & (1u << prev))) {
+        prev--;
+    }
+    if (prev >= 0) {
+        latency_hist_record(&s_stage_hist[stage], time_us - slot.time_us[prev]);
+    }
+    if (slot.seen & (1u << TRACE_STAGE_EDGE)) {
+        const uint32_t total = time_us - slot.time_us[TRACE_STAGE_EDGE];
+        if (stage == TRACE_STAGE_ACTUATE) {
+            latency_hist_record(&s_edge_to_actuate, total);
+        } else if (stage == TRACE_STAGE_FRAME) {
+            latency_hist_record(&s_edge_to_frame, total);
+        }
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+uint16_t trace_begin(void)
+{
+#if CONFIG_LATENCY_TRACE
+    portENTER_CRITICAL_SAFE(&s_lock);
+    if (++s_next_id == 0) {
+        s_next_id = 1;      // 0 means "not traced"
+    }
+    uint16_t id = s_next_id;
+    portEXIT_CRITICAL_SAFE(&s_lock);
+    return id;
+#else
+    return 0;
+#endif
+}
+
+void trace_mark(uint16_t id, trace_stage_t stage, uint32_t time_us, uint8_t arg)
+{
+    if (id == 0 || stage >= TRACE_STAGE_COUNT) {
+        return;
+    }
+    if (time_us == 0) {
+        time_us = now_us();
+    }
+    portENTER_CRITICAL_SAFE(&s_lock);
+    mark_locked(id, stage, time_us, arg);
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void trace_drop(uint16_t id)
+{
+    if (id == 0) {
+        return;
+    }
+    portENTER_CRITICAL_SAFE(&s_lock);
+    s_dropped++;
+    auto &slot = s_inflight[id % TRACE_INFLIGHT];
+    if (slot.id == id) {
+        slot.seen = 0;      // Nothing more will arrive for it
+    }
+    portEXIT_CRITICAL_SAFE(&s_lock);
+}
+
+void trace_frame_done(uint32_t frame_start_us)
+{
+#if CONFIG_LATENCY_TRACE
+    const uint8_t dispatched = 1u << TRACE_STAGE_DISPATCH;
+    const uint8_t framed = 1u << TRACE_STAGE_FRAME;
+    const uint32_t now = now_us();
+    portENTER_CRITICAL(&s_lock);
+    for (int i = 0; i < TRACE_INFLIGHT; i++) {
+        auto &slot = s_inflight[i];
+        if ((slot.seen & (dispatched | framed)) != dispatched) {
+            continue;
+        }
+        // A frame that started before the dispatch may not show its effect
+        if ((int32_t)(frame_start_us - slot.time_us[TRACE_STAGE_DISPATCH]) >= 0) {
+            mark_locked(slot.id, TRACE_STAGE_FRAME, now, 0);
+        }
+    }
+    portEXIT_CRITICAL(&s_lock);
+#else
+    (void)frame_start_us;
+#endif
+}
+
+esp_err_t trace_dump(dump_write_fn write, void *ctx)
+{
+#if CONFIG_LATENCY_TRACE
+    // Freeze the ring instead of copying it: the writer may print or send
+    // for far too long for a critical section, and 4 KB is a lot of stack
+    portENTER_CRITICAL(&s_lock);
+    s_frozen = true;
+    const uint32_t written = s_written;
+    portEXIT_CRITICAL(&s_lock);
+
+    const uint32_t count = written < TRACE_BUFFER_RECORDS ? written : TRACE_BUFFER_RECORDS;
+    trace_dump_header_t header = {};
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_FORMAT_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    header.count = (uint16_t)count;
+    header.lost = written - count;
+    header.now_us = now_us();
+
+    esp_err_t ret = write(ctx, &header, sizeof(header));
+    const uint32_t first = written - count;
+    for (uint32_t i = 0; i < count && ret == ESP_OK; i++) {
+        ret = write(ctx, &s_records[(first + i) % TRACE_BUFFER_RECORDS], sizeof(trace_record_t));
+    }
+
+    portENTER_CRITICAL(&s_lock);
+    s_frozen = false;
+    portEXIT_CRITICAL(&s_lock);
+    return ret;
+#else
+    (void)write;
+    (void)ctx;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t trace_dump_all(dump_write_fn write, void *ctx)
+{
+    esp_err_t ret = trace_dump(write, ctx);
+    if (ret != ESP_OK && ret != ESP_ERR_NOT_SUPPORTED) {
+        return ret;
+    }
+    const bool latency = ret == ESP_OK;
+    ret = event_trace_dump(write, ctx);
+    if (ret == ESP_ERR_NOT_SUPPORTED && latency) {
+        ret = ESP_OK;
+    }
+    return ret;
+}
+
+void trace_dump_uart(void)
+{
+    dump_hex_writer_t writer;
+    dump_hex_begin(&writer, "TRACE");
+    esp_err_t ret = trace_dump_all(dump_hex_write, &writer);
+    dump_hex_end(&writer);
+    if (ret != ESP_OK) {
+        ESP_LOGW(TAG, "Dump failed: %s", esp_err_to_name(ret));
+    }
+}
+
+void trace_log_histograms(void)
+{
+    // Copy under the lock, log outside it
+    static latency_hist_t stage_copy[TRACE_STAGE_COUNT];
+    static latency_hist_t actuate_copy;
+    static latency_hist_t frame_copy;
+    portENTER_CRITICAL(&s_lock);
+    memcpy(stage_copy, s_stage_hist, sizeof(stage_copy));
+    actuate_copy = s_edge_to_actuate;
+    frame_copy = s_edge_to_frame;
+    portEXIT_CRITICAL(&s_lock);
+
+    char name[24];
+    for (int i = TRACE_STAGE_ENQUEUE; i < TRACE_STAGE_COUNT; i++) {
+        snprintf(name, sizeof(name), "trace_%s", s_stage_names[i]);
+        latency_hist_log(name, &stage_copy[i]);
+    }
+    latency_hist_log("trace_edge_to_actuate", &actuate_copy);
+    latency_hist_log("trace_edge_to_frame", &frame_copy);
+    ESP_LOGI(TAG, "%lu records written, %lu inputs dropped before the ring",
+             (unsigned long)s_written, (unsigned long)s_dropped);
+}
@@ -0,0 +1,121 @@
+/*
+ * trace.h
+ * End-to-end latency trace from input edge to actuator output and display
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "dump_hex.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Trace Configuration
+ *===========================================================================*/
+
+#define TRACE_BUFFER_RECORDS    512     // 8 bytes each; oldest records are overwritten
+#define TRACE_INFLIGHT          16      // Traces followed at once for the histograms
+
+// Path of one input through the control plane, in order
+typedef enum {
+    TRACE_STAGE_EDGE = 0,       // GPIO/ULP edge (time taken from the event)
+    TRACE_STAGE_ENQUEUE,        // Event posted to its ring or collapsed
+    TRACE_STAGE_DISPATCH,       // Manager starts handling the event
+    TRACE_STAGE_COMMAND,        // Manager posts an actuator command
+    TRACE_STAGE_ACTUATE,        // Actuator task applied the command
+    TRACE_STAGE_FRAME,          // First display frame drawn after dispatch
+    TRACE_STAGE_COUNT
+} trace_stage_t;
+
+/*
+ * Dump format (little endian). /api/trace and trace_dump_uart() send it
+ * followed by the event trace dump (event_trace.h); each section starts
+ * with its own magic, and tools/trace_decode/trace_decode.py reads both.
+ */
+#define TRACE_MAGIC             0x52544D57u     // "WMTR"
+#define TRACE_FORMAT_VERSION    1
+
+typedef struct __attribute__((packed)) {
+    uint32_t magic;
+    uint8_t version;
+    uint8_t record_size;
+    uint16_t count;             // Records that follow, oldest first
+    uint32_t lost;              // Records overwritten since boot
+    uint32_t now_us;            // esp_timer time of the dump (low 32 bits)
+} trace_dump_header_t;
+
+typedef struct __attribute__((packed)) {
+    uint32_t time_us;           // esp_timer time (low 32 bits)
+    uint16_t id;                // Trace id carried by the event and its commands
+    uint8_t stage;              // trace_stage_t
+    uint8_t arg;                // Event type (EDGE/ENQUEUE/DISPATCH) or command type
+} trace_record_t;
+
+/*===========================================================================
+ * Trace API
+ *
+ * All functions may be called from any task; trace_mark() also from ISRs.
+ * With CONFIG_LATENCY_TRACE off they do nothing and ids are always 0.
+ *===========================================================================*/
+
+/**
+ * @brief Allocate a trace id for a new input (never returns 0 when enabled)
+ */
+uint16_t trace_begin(void);
+
+/**
+ * @brief Record one stage of trace @p id
+ * @param time_us Time of the stage; 0 = now
+ * @param arg Event or command type, stored in the record
+ */
+void trace_mark(uint16_t id, trace_stage_t stage, uint32_t time_us, uint8_t arg);
+
+/**
+ * @brief Count an input whose event never reached its ring; trace @p id
+ *        stops at TRACE_STAGE_EDGE
+ */
+void trace_drop(uint16_t id);
+
+/**
+ * @brief Call from the display task after each frame
+ * @param frame_start_us Time the frame started drawing; traces dispatched
+ *        before that moment get their TRACE_STAGE_FRAME
+ */
+void trace_frame_done(uint32_t frame_start_us);
+
+/**
+ * @brief Stream the latency dump (header + records) through @p write
+ *
+ * New records are not stored while the dump runs.
+ * @return ESP_OK, ESP_ERR_NOT_SUPPORTED without CONFIG_LATENCY_TRACE, or
+ *         the first error returned by @p write
+ */
+esp_err_t trace_dump(dump_write_fn write, void *ctx);
+
+/**
+ * @brief Stream every enabled trace: the latency dump, then the event trace
+ * @return ESP_ERR_NOT_SUPPORTED if neither trace is enabled
+ */
+esp_err_t trace_dump_all(dump_write_fn write, void *ctx);
+
+/**
+ * @brief Print trace_dump_all() to the console as "TRACE <hex>" lines
+ */
+void trace_dump_uart(void);
+
+/**
+ * @brief Log the per-stage and end-to-end histograms
+ */
+void trace_log_histograms(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -16,6 +16,11 @@
 #include "ui_controller.h"
 #include "drivers/freehome/freehome_manager.h"
 #include "drivers/wifi/wifi_manager.h"
+#if CONFIG_RUNTIME_STATS
+#include "diagnostics/runtime_stats.h"
+#endif
+#include "diagnostics/trace.h"
+#include "diagnostics/event_trace.h"
 
 #include "esp_wifi.h"
 
@@ -30,7 +35,9 @@
 #include "driver/spi_master.h"
 #include "driver/gpio.h"
 #include "driver/ledc.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "qrcodegen.hpp"
 
 static const char *TAG = "display";
@@ -40,16 +47,23 @@ static const char *TAG = "display";
 
 static uint16_t *s_sprite_buf = nullptr;
 static uint16_t *s_prev_sprite_buf = nullptr;
+#if CONFIG_STATIC_ALLOCATION
+// 80 KB that would otherwise be the two largest heap blocks
+DMA_ATTR static uint16_t s_sprite_storage[SPRITE_WIDTH * SPRITE_HEIGHT];
+static uint16_t s_prev_sprite_storage[SPRITE_WIDTH * SPRITE_HEIGHT];
+#endif
 
 static void (*s_simulator_draw_cb)(int16_t, int16_t, int16_t, int16_t, uint16_t) = nullptr;
-static void (*s_simulator_bitmap_cb)(int16_t, int16_t, int16_t, int16_t, const uint16_t *) = nullptr;
+static void (*s_simulator_bitmap_cb)(int16_t, int16_t, int16_t, int16_t, const uint16_t *,
+                                     const uint16_t *) = nullptr;
 
 void display_set_simulator_hook(void (*cb)(int16_t, int16_t, int16_t, int16_t, uint16_t))
 {
     s_simulator_draw_cb = cb;
 }
 
-void display_set_simulator_bitmap_hook(void (*cb)(int16_t, int16_t, int16_t, int16_t, const uint16_t *))
+void display_set_simulator_bitmap_hook(void (*cb)(int16_t, int16_t, int16_t, int16_t, const uint16_t *,
+                                                  const uint16_t *))
 {
     s_simulator_bitmap_cb = cb;
 }
@@ -143,7 +157,10 @@ esp_err_t display_init(void)
 
     // Configure GPIO
     gpio_config_t io_conf = {};
-    io_conf.pin_bit_mask = (1ULL << DISPLAY_PIN_DC) | (1ULL << DISPLAY_PIN_RST);
+    io_conf.pin_bit_mask = (1ULL << DISPLAY_PIN_DC);
+#ifdef DISPLAY_PIN_RST
+    io_conf.pin_bit_mask |= (1ULL << DISPLAY_PIN_RST);
+#endif
     io_conf.mode = GPIO_MODE_OUTPUT;
     io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
     io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
@@ -178,11 +195,14 @@ esp_err_t display_init(void)
         return ret;
     }
 
-    // Hardware reset
+    // Hardware reset; a panel tied to EN was reset with the chip and
+    // CMD_SWRESET below covers a soft restart
+#ifdef DISPLAY_PIN_RST
     gpio_set_level(DISPLAY_PIN_RST, 0);
     vTaskDelay(pdMS_TO_TICKS(100));
     gpio_set_level(DISPLAY_PIN_RST, 1);
     vTaskDelay(pdMS_TO_TICKS(100));
+#endif
 
     // Initialize display (ST7789)
     display_send_cmd(CMD_SWRESET);
@@ -226,6 +246,11 @@ esp_err_t display_init(void)
     // Clear screen
     display_clear(COLOR_BLACK);
 
+#if CONFIG_STATIC_ALLOCATION
+    s_sprite_buf = s_sprite_storage;
+    s_prev_sprite_buf = s_prev_sprite_storage;
+    memset(s_prev_sprite_buf, 0, sizeof(s_prev_sprite_storage));
+#else
     // Allocate sprite buffer
     s_sprite_buf = static_cast<uint16_t *>(heap_caps_malloc(SPRITE_WIDTH * SPRITE_HEIGHT * 2, MALLOC_CAP_DMA));
     if (!s_sprite_buf)
@@ -245,6 +270,7 @@ esp_err_t display_init(void)
     {
         memset(s_prev_sprite_buf, 0, SPRITE_WIDTH * SPRITE_HEIGHT * 2);
     }
+#endif
 
     return ESP_OK;
 }
@@ -359,17 +385,57 @@ static void sprite_fill_circle(int x, int y, int r, uint16_t color)
     }
 }
 
+/*
+ * QR codes are redrawn every frame while a provisioning page is shown, but
+ * the text rarely changes. qrcodegen builds the code in std::vectors, so
+ * the modules are kept in a bitmap and only re-encoded when the text
+ * changes; the frame loop then stays off the heap.
+ */
+#define QR_CACHE_MAX_SIZE   57      // Modules per side (version 10)
+
+static struct {
+    char text[128];
+    int size;                       // 0 = empty
+    uint8_t modules[(QR_CACHE_MAX_SIZE * QR_CACHE_MAX_SIZE + 7) / 8];
+} s_qr_cache;
+
+static bool qr_cache_update(const char *text)
+{
+    if (s_qr_cache.size > 0 && strcmp(s_qr_cache.text, text) == 0) {
+        return true;
+    }
+    s_qr_cache.size = 0;
+    if (strlen(text) >= sizeof(s_qr_cache.text)) {
+        return false;
+    }
+    qrcodegen::QrCode qr = qrcodegen::QrCode::encodeText(text, qrcodegen::QrCode::Ecc::LOW);
+    const int qsize = qr.getSize();
+    if (qsize <= 0 || qsize > QR_CACHE_MAX_SIZE) {
+        return false;
+    }
+    memset(s_qr_cache.modules, 0, sizeof(s_qr_cache.modules));
+    for (int row = 0; row < qsize; ++row) {
+        for (int col = 0; col < qsize; ++col) {
+            if (qr.getModule(col, row)) {
+                const int bit = row * qsize + col;
+                s_qr_cache.modules[bit / 8] |= (uint8_t)(1u << (bit % 8));
+            }
+        }
+    }
+    strcpy(s_qr_cache.text, text);
+    s_qr_cache.size = qsize;
+    return true;
+}
+
 // Draw a QR code into the sprite at (x,y) with pixel size 'size'.
 // The QR will be drawn with black modules on white background.
 static void sprite_draw_qr(int x, int y, int size, const char *text)
 {
     if (!text)
         return;
-    // Generate QR using minimal encoder
-    qrcodegen::QrCode qr = qrcodegen::QrCode::encodeText(text, qrcodegen::QrCode::Ecc::LOW);
-    int qsize = qr.getSize();
-    if (qsize <= 0)
+    if (!qr_cache_update(text))
         return;
+    int qsize = s_qr_cache.size;
 
     // module pixel size (fit into size)
     int module_px = size / qsize;
@@ -385,7 +451,8 @@ static void sprite_draw_qr(int x, int y, int size, const char *text)
     {
         for (int col = 0; col < qsize; ++col)
         {
-            if (qr.getModule(col, row))
+            const int bit = row * qsize + col;
+            if (s_qr_cache.modules[bit / 8] & (1u << (bit % 8)))
             {
                 int px = x + margin + col * module_px;
                 int py = y + margin + row * module_px;
@@ -400,27 +467,17 @@ static void sprite_push(int x, int y)
     if (!s_sprite_buf)
         return;
 
-    // Check for changes if we have a previous buffer
-    bool changed = true;
-    if (s_prev_sprite_buf)
+    // The simulator sends the difference to the previous frame, or nothing
+    // if there is none, so it gets both before the previous buffer moves on
+    if (s_simulator_bitmap_cb)
     {
-        if (memcmp(s_sprite_buf, s_prev_sprite_buf, SPRITE_WIDTH * SPRITE_HEIGHT * 2) == 0)
-        {
-            changed = false;
-        }
-        else
-        {
-            // Update previous buffer
-            memcpy(s_prev_sprite_buf, s_sprite_buf, SPRITE_WIDTH * SPRITE_HEIGHT * 2);
-        }
+        // Simulator expects Big Endian (Network Byte Order)
+        // s_sprite_buf is already Big Endian (for SPI)
+        s_simulator_bitmap_cb(x, y, SPRITE_WIDTH, SPRITE_HEIGHT, s_sprite_buf, s_prev_sprite_buf);
     }
-
-    // Send to simulator only if changed
-    if (changed && s_simulator_bitmap_cb)
+    if (s_prev_sprite_buf)
     {
-        // Simulator expects Big Endian (Network Byte Order) for direct hex conversion
-        // s_sprite_buf is already Big Endian (for SPI)
-        s_simulator_bitmap_cb(x, y, SPRITE_WIDTH, SPRITE_HEIGHT, s_sprite_buf);
+        memcpy(s_prev_sprite_buf, s_sprite_buf, SPRITE_WIDTH * SPRITE_HEIGHT * 2);
     }
 
     // Send to Display
@@ -730,7 +787,7 @@ void display_draw_bitmap(int16_t x, int16_t y, int16_t w, int16_t h,
 {
     if (s_simulator_bitmap_cb)
     {
-        s_simulator_bitmap_cb(x, y, w, h, data);
+        s_simulator_bitmap_cb(x, y, w, h, data, nullptr);
     }
 
     if (!s_initialized || data == nullptr)
@@ -959,6 +1016,49 @@ static void draw_machine_settings(const ui_render_state_t &ui_state)
     }
 }
 
+static void draw_diagnostics(const ui_render_state_t &ui_state)
+{
+    sprite_clear(COLOR_BGROUND);
+    sprite_draw_text(4, 4, "Diagnostics", FONT_LARGE, COLOR_BLACK, COLOR_BGROUND);
+#if CONFIG_RUNTIME_STATS
+    // Static: the snapshot is too large for the display task's stack
+    static runtime_stats_t stats;
+    if (!runtime_stats_get(&stats))
+    {
+        draw_list_item(32, false, "Sampling...", "");
+        return;
+    }
+    // The dial scrolls; the cursor is the first visible row
+    int count = runtime_stats_row_count(&stats);
+    int y = 32;
+    for (int i = ui_state.diag_cursor; i < count && i < ui_state.diag_cursor + 4; ++i)
+    {
+        char label[RUNTIME_STATS_NAME_LEN];
+        char value[16];
+        runtime_stats_format_row(&stats, i, label, sizeof(label), value, sizeof(value));
+        draw_list_item(y, false, label, value);
+        y += 18;
+    }
+#else
+    (void)ui_state;
+    draw_list_item(32, false, "Disabled", "");
+#endif
+}
+
+static void draw_resume_prompt(void)
+{
+    sprite_clear(COLOR_BGROUND);
+    sprite_draw_text(4, 4, "Resume wash?", FONT_LARGE, COLOR_BLACK, COLOR_BGROUND);
+    char stage[32];
+    machine_get_stage_label(stage, sizeof(stage));
+    const int eta = machine_get_eta();
+    char left[16];
+    snprintf(left, sizeof(left), "%d:%02d", eta / 60, eta % 60);
+    draw_list_item(32, false, stage, left);
+    draw_list_item(50, false, "Start", "resume");
+    draw_list_item(68, false, "Hold", "discard");
+}
+
 static void draw_freehome_menu(const ui_render_state_t &ui_state)
 {
     sprite_clear(COLOR_BGROUND);
@@ -1150,16 +1250,17 @@ void display_update_progress(int current, int total)
     int bar_width = DISPLAY_WIDTH - 24;
     int fill_width = (current * bar_width) / total;
 
-    // Draw progress bar at bottom
-    display_draw_rect(10, 250, DISPLAY_WIDTH - 20, 20, COLOR_WHITE);
+    // Draw progress bar at the bottom of the panel
+    const int16_t bar_y = DISPLAY_HEIGHT - 30;
+    display_draw_rect(10, bar_y, DISPLAY_WIDTH - 20, 20, COLOR_WHITE);
 
     // Clear progress bar interior
-    display_fill_rect(12, 252, bar_width, 16, COLOR_BLACK);
+    display_fill_rect(12, bar_y + 2, bar_width, 16, COLOR_BLACK);
 
     // Draw filled portion
     if (fill_width > 0)
     {
-        display_fill_rect(12, 252, fill_width, 16, COLOR_GREEN);
+        display_fill_rect(12, bar_y + 2, fill_width, 16, COLOR_GREEN);
     }
 }
 
@@ -1176,11 +1277,9 @@ static void display_draw_ui(void)
     // Background color for the UI area (matches logo background)
     uint16_t bg_color = 0xB7FF;
 
-    // Offset to center the 188x107 UI on 240x320 screen
-    // X: (240 - 188) / 2 = 26
-    // Y: 5 (Top)
-    int ox = 26;
-    int oy = 5;
+    // Offset to center the 188x107 UI on 240x320 screen (display.h)
+    int ox = SPRITE_X;
+    int oy = SPRITE_Y;
 
     ui_render_state_t ui_state = ui_controller_get_render_state();
 
@@ -1206,6 +1305,14 @@ static void display_draw_ui(void)
     {
         draw_machine_settings(ui_state);
     }
+    else if (ui_state.menu == UI_MENU_DIAGNOSTICS)
+    {
+        draw_diagnostics(ui_state);
+    }
+    else if (ui_state.menu == UI_MENU_RESUME)
+    {
+        draw_resume_prompt();
+    }
     else
     {
         // Draw Main UI
@@ -1278,7 +1385,7 @@ static void display_draw_ui(void)
         sprite_draw_text(141, 29, buf, FONT_MEDIUM, COLOR_BLACK, bg_color);
 
         // Progress Bar (Draw directly to screen or sprite? Sprite is better)
-        // But progress bar is at Y=250, which is OUTSIDE the sprite (107 height + 5 offset = 112)
+        // But the progress bar is near the bottom of the panel, OUTSIDE the sprite (107 height + 5 offset = 112)
         // So we must draw progress bar directly to screen.
     }
 
@@ -1305,7 +1412,11 @@ void display_task_entry(void *pvParameters)
 
     while (1)
     {
+        const uint32_t frame_start_us = (uint32_t)esp_timer_get_time();
+        ETRACE(ETRACE_FRAME_BEGIN, 0, 0);
         display_draw_ui();
+        ETRACE(ETRACE_FRAME_END, 0, 0);
+        trace_frame_done(frame_start_us);
         vTaskDelay(pdMS_TO_TICKS(100));
     }
 }
@@ -44,7 +44,8 @@ extern "C" {
 #ifndef DISPLAY_PIN_DC
 #define DISPLAY_PIN_DC      PIN_TFT_DC
 #endif
-#ifndef DISPLAY_PIN_RST
+// No reset pin when the panel reset is tied to EN
+#if !defined(DISPLAY_PIN_RST) && defined(PIN_TFT_RST)
 #define DISPLAY_PIN_RST     PIN_TFT_RST
 #endif
 #ifndef DISPLAY_PIN_BL
@@ -60,6 +61,15 @@ extern "C" {
 #define DISPLAY_HEIGHT      240
 #endif
 
+// Where the UI sprite (SPRITE_WIDTH x SPRITE_HEIGHT) is pushed on the
+// panel: centred across the 240-pixel side, 5 pixels from the top
+#ifndef SPRITE_X
+#define SPRITE_X            ((240 - SPRITE_WIDTH) / 2)
+#endif
+#ifndef SPRITE_Y
+#define SPRITE_Y            5
+#endif
+
 /*===========================================================================
  * Color Definitions (RGB565)
  *===========================================================================*/
@@ -305,9 +315,11 @@ void display_set_simulator_hook(void (*cb)(int16_t x, int16_t y, int16_t w, int1
 
 /**
  * @brief Set simulator callback for drawing bitmaps
- * @param cb Callback function receiving rect coordinates and pixel data
+ * @param cb Callback function receiving rect coordinates and pixel data, and
+ *           the data of the previous call for the sprite (nullptr otherwise)
  */
-void display_set_simulator_bitmap_hook(void (*cb)(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data));
+void display_set_simulator_bitmap_hook(void (*cb)(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                                                  const uint16_t *previous));
 
 /**
  * @brief Display task entry point
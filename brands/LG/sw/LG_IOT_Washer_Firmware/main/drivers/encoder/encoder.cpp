@@ -0,0 +1,199 @@
+/*
+ * encoder.cpp
+ * PCNT quadrature driver for the program dial
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why the dial is counted by the PCNT peripheral:
+ * - Both quadrature edges are decoded and glitch filtered in hardware, so
+ *   contact bounce never reaches the CPU. The unit's limits are set to one
+ *   detent, which makes the hardware reset the count itself on every click;
+ *   the only interrupt is the limit event, one per detent, and no pulse can
+ *   be lost between reading and clearing a counter.
+ * - The first detent wakes the dial task, which waits ENCODER_COALESCE_MS
+ *   and posts everything collected in that window as one WM_EVENT_DIAL_DELTA.
+ *   A fast spin therefore costs one event per window instead of one per
+ *   detent, and an idle dial costs nothing.
+ * - The detent count per window is also the dial speed, which
+ *   encoder_accelerate() uses to scale the delta.
+ */
+
+#include "encoder.h"
+#include "app_config.h"
+#include "tasks/tasks.h"
+#include "tasks/static_alloc.h"
+
+#include <stdlib.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#include "driver/pulse_cnt.h"
+#include "esp_check.h"
+#include "esp_log.h"
+
+static const char *TAG = "encoder";
+
+static pcnt_unit_handle_t s_unit = nullptr;
+static pcnt_channel_handle_t s_chan_a = nullptr;
+static pcnt_channel_handle_t s_chan_b = nullptr;
+static TaskHandle_t s_task = nullptr;
+static StaticTaskSlot<2048> s_task_slot;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static int32_t s_pending_detents = 0;
+
+/*===========================================================================
+ * Interrupt and Task
+ *===========================================================================*/
+
+static bool IRAM_ATTR on_detent(pcnt_unit_handle_t unit, const pcnt_watch_event_data_t *edata,
+                                void *user_ctx)
+{
+    (void)unit;
+    (void)user_ctx;
+    portENTER_CRITICAL_ISR(&s_lock);
+    s_pending_detents += (edata->watch_point_value > 0) ? 1 : -1;
+    portEXIT_CRITICAL_ISR(&s_lock);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveFromISR(s_task, &woken);
+    return woken == pdTRUE;
+}
+
+static void encoder_task(void *arg)
+{
+    (void)arg;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        // Let the rest of a spin arrive before reporting it
+        vTaskDelay(pdMS_TO_TICKS(ENCODER_COALESCE_MS));
+        ulTaskNotifyTake(pdTRUE, 0);
+
+        portENTER_CRITICAL(&s_lock);
+        int32_t detents = s_pending_detents;
+        s_pending_detents = 0;
+        portEXIT_CRITICAL(&s_lock);
+
+        if (detents != 0) {
+            tasks_post_dial_delta(encoder_accelerate(detents));
+        }
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+int encoder_accelerate(int detents)
+{
+    int multiplier = 1 + abs(detents) / ENCODER_ACCEL_STEP;
+    if (multiplier > ENCODER_ACCEL_MAX) {
+        multiplier = ENCODER_ACCEL_MAX;
+    }
+    return detents * multiplier;
+}
+
+// Channels, watch points and callbacks on a new unit
+static esp_err_t configure_unit(void)
+{
+    pcnt_glitch_filter_config_t filter_config = {
+        .max_glitch_ns = ENCODER_GLITCH_NS,
+    };
+    ESP_RETURN_ON_ERROR(pcnt_unit_set_glitch_filter(s_unit, &filter_config), TAG,
+                        "glitch filter failed");
+
+    // Standard x4 quadrature decoding: each channel counts the edges of one
+    // phase and uses the other phase as direction
+    pcnt_chan_config_t chan_a_config = {
+        .edge_gpio_num = PIN_DIAL_ENC_A,
+        .level_gpio_num = PIN_DIAL_ENC_B,
+        .flags = {},
+    };
+    pcnt_chan_config_t chan_b_config = {
+        .edge_gpio_num = PIN_DIAL_ENC_B,
+        .level_gpio_num = PIN_DIAL_ENC_A,
+        .flags = {},
+    };
+    ESP_RETURN_ON_ERROR(pcnt_new_channel(s_unit, &chan_a_config, &s_chan_a), TAG,
+                        "channel A failed");
+    ESP_RETURN_ON_ERROR(pcnt_new_channel(s_unit, &chan_b_config, &s_chan_b), TAG,
+                        "channel B failed");
+    ESP_RETURN_ON_ERROR(pcnt_channel_set_edge_action(s_chan_a, PCNT_CHANNEL_EDGE_ACTION_DECREASE,
+                                                     PCNT_CHANNEL_EDGE_ACTION_INCREASE),
+                        TAG, "channel A edges failed");
+    ESP_RETURN_ON_ERROR(pcnt_channel_set_level_action(s_chan_a, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                      PCNT_CHANNEL_LEVEL_ACTION_INVERSE),
+                        TAG, "channel A levels failed");
+    ESP_RETURN_ON_ERROR(pcnt_channel_set_edge_action(s_chan_b, PCNT_CHANNEL_EDGE_ACTION_INCREASE,
+                                                     PCNT_CHANNEL_EDGE_ACTION_DECREASE),
+                        TAG, "channel B edges failed");
+    ESP_RETURN_ON_ERROR(pcnt_channel_set_level_action(s_chan_b, PCNT_CHANNEL_LEVEL_ACTION_KEEP,
+                                                      PCNT_CHANNEL_LEVEL_ACTION_INVERSE),
+                        TAG, "channel B levels failed");
+
+    ESP_RETURN_ON_ERROR(pcnt_unit_add_watch_point(s_unit, ENCODER_COUNTS_PER_DETENT), TAG,
+                        "watch point failed");
+    ESP_RETURN_ON_ERROR(pcnt_unit_add_watch_point(s_unit, -ENCODER_COUNTS_PER_DETENT), TAG,
+                        "watch point failed");
+
+    // The task must exist before the first limit interrupt can fire
+    if (!s_task &&
+        create_task(s_task_slot, encoder_task, "wm_dial", nullptr, 4, &s_task, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create dial task");
+        return ESP_ERR_NO_MEM;
+    }
+
+    pcnt_event_callbacks_t callbacks = {
+        .on_reach = on_detent,
+    };
+    ESP_RETURN_ON_ERROR(pcnt_unit_register_event_callbacks(s_unit, &callbacks, nullptr), TAG,
+                        "callbacks failed");
+    ESP_RETURN_ON_ERROR(pcnt_unit_enable(s_unit), TAG, "enable failed");
+    ESP_RETURN_ON_ERROR(pcnt_unit_clear_count(s_unit), TAG, "clear failed");
+    ESP_RETURN_ON_ERROR(pcnt_unit_start(s_unit), TAG, "start failed");
+    return ESP_OK;
+}
+
+// Undo a failed configure_unit() so encoder_init() can be retried
+static void release_unit(void)
+{
+    pcnt_unit_disable(s_unit);      // Fails harmlessly if never enabled
+    if (s_chan_a) {
+        pcnt_del_channel(s_chan_a);
+        s_chan_a = nullptr;
+    }
+    if (s_chan_b) {
+        pcnt_del_channel(s_chan_b);
+        s_chan_b = nullptr;
+    }
+    pcnt_del_unit(s_unit);
+    s_unit = nullptr;
+}
+
+esp_err_t encoder_init(void)
+{
+    if (s_unit) {
+        return ESP_OK;
+    }
+
+    // Counter wraps to zero at +/- one detent; see the note at the top
+    pcnt_unit_config_t unit_config = {
+        .low_limit = -ENCODER_COUNTS_PER_DETENT,
+        .high_limit = ENCODER_COUNTS_PER_DETENT,
+        .intr_priority = 0,
+        .flags = {},
+    };
+    ESP_RETURN_ON_ERROR(pcnt_new_unit(&unit_config, &s_unit), TAG, "PCNT unit failed");
+    esp_err_t ret = configure_unit();
+    if (ret != ESP_OK) {
+        release_unit();
+        return ret;
+    }
+
+    ESP_LOGI(TAG, "Dial encoder on GPIO%d/%d (%d counts per detent)",
+             PIN_DIAL_ENC_A, PIN_DIAL_ENC_B, ENCODER_COUNTS_PER_DETENT);
+    return ESP_OK;
+}
@@ -0,0 +1,49 @@
+/*
+ * encoder.h
+ * PCNT quadrature driver for the program dial
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Encoder Configuration
+ *===========================================================================*/
+
+#define ENCODER_COUNTS_PER_DETENT   4       // Quadrature edges per dial click (x4 decoding)
+#define ENCODER_GLITCH_NS           1000    // Pulses shorter than this are filtered in hardware
+#define ENCODER_COALESCE_MS         50      // Detents in this window become one event
+#define ENCODER_ACCEL_STEP          3       // Each further 3 detents per window adds 1x
+#define ENCODER_ACCEL_MAX           4       // Cap on the acceleration multiplier
+
+/*===========================================================================
+ * Encoder API
+ *===========================================================================*/
+
+/**
+ * @brief Start the dial encoder
+ *
+ * Configures a PCNT unit on PIN_DIAL_ENC_A/B and a small task that posts
+ * coalesced WM_EVENT_DIAL_DELTA events. Call after tasks_create_all().
+ * @return ESP_OK on success
+ */
+esp_err_t encoder_init(void);
+
+/**
+ * @brief Scale a coalesced detent count by dial speed
+ * @param detents Detents seen in one ENCODER_COALESCE_MS window (signed)
+ * @return Delta to report to the UI (same sign, magnitude >= |detents|)
+ */
+int encoder_accelerate(int detents);
+
+#ifdef __cplusplus
+}
+#endif
@@ -8,20 +8,24 @@
 #include "gpio_hal.h"
 #include "app_config.h"
 #include "machine_state.h"
+#include "drivers/sound/sound.h"
 #if CONFIG_SIMULATOR_MODE
 #include "simulator.h"
 #endif
 
 #include "driver/gpio.h"
 #include "driver/ledc.h"
-#include "driver/dac_oneshot.h"
+#include "driver/dac_continuous.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "../../ulp/ulp_manager.h"
+#include "tasks/tasks.h"
+#include "diagnostics/event_trace.h"
 
 static const char *TAG = "gpio_hal";
-static dac_oneshot_handle_t s_dac_handle = nullptr;
+static dac_continuous_handle_t s_dac_handle = nullptr;
 
 /*
  * Why this HAL exists:
@@ -69,7 +73,7 @@ esp_err_t app_gpio_init(void)
         .mode = GPIO_MODE_INPUT,
         .pull_up_en = GPIO_PULLUP_DISABLE,
         .pull_down_en = GPIO_PULLDOWN_DISABLE,
-        .intr_type = GPIO_INTR_DISABLE,
+        .intr_type = GPIO_INTR_ANYEDGE,     // Handler installed by app_input_irq_init()
     };
     ret = gpio_config(&sensor_conf);
     if (ret != ESP_OK) {
@@ -147,6 +151,13 @@ esp_err_t app_ledc_init(void)
         }
     }
     
+    // Fades run in the LEDC hardware; the service only handles the end interrupt
+    ret = ledc_fade_func_install(0);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to install LEDC fade service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+
     ESP_LOGI(TAG, "LEDC (PWM) initialized at %d Hz, %d-bit resolution", 
              LEDC_FREQUENCY, LEDC_DUTY_RES);
     return ESP_OK;
@@ -159,18 +170,28 @@ esp_err_t app_ledc_init(void)
 esp_err_t app_dac_init(void)
 {
     // ESP32 DAC channels: DAC_CHAN_0 = GPIO25, DAC_CHAN_1 = GPIO26
-    // We use GPIO25 for speaker
-    dac_oneshot_config_t cfg = {};
-    cfg.chan_id = DAC_CHAN_0;
-    
-
-    esp_err_t ret = dac_oneshot_new_channel(&cfg, &s_dac_handle);
+    // We use GPIO25 for speaker. Samples are clocked out by the I2S0 DMA at
+    // SOUND_SAMPLE_RATE, so pitch no longer depends on CPU timing.
+    dac_continuous_config_t cfg = {};
+    cfg.chan_mask = DAC_CHANNEL_MASK_CH0;
+    cfg.desc_num = SOUND_DMA_DESC_NUM;
+    // With CONFIG_DAC_DMA_AUTO_16BIT_ALIGN each 8-bit sample takes two bytes
+    cfg.buf_size = SOUND_BLOCK_SAMPLES * 2;
+    cfg.freq_hz = SOUND_SAMPLE_RATE;
+    cfg.offset = 0;
+    // The default PLL_D2 clock cannot divide down to 8 kHz; APLL can
+    cfg.clk_src = DAC_DIGI_CLK_SRC_APLL;
+    cfg.chan_mode = DAC_CHANNEL_MODE_SIMUL;
+
+    esp_err_t ret = dac_continuous_new_channels(&cfg, &s_dac_handle);
     if (ret != ESP_OK) {
         ESP_LOGE(TAG, "Failed to create DAC channel: %s", esp_err_to_name(ret));
         return ret;
     }
 
-    ESP_LOGI(TAG, "DAC initialized on GPIO25 using oneshot driver");
+    // Channel stays disabled until the sound task has something to play
+    ESP_LOGI(TAG, "DAC initialized on GPIO25 using continuous (DMA) driver at %d Hz",
+             SOUND_SAMPLE_RATE);
     return ESP_OK;
 }
 
@@ -199,7 +220,18 @@ void gpio_write(int pin, int level)
  * PWM (LEDC) Operations
  *===========================================================================*/
 
-static inline void hal_ledc_update(ledc_channel_t channel, uint32_t duty)
+/*
+ * Why ramps use the LEDC hardware fader:
+ * - The drum light animation used to be ~50 duty writes paced by
+ *   vTaskDelay(2) from the manager task, and pump soft-start would have
+ *   needed the same. ledc_set_fade_time_and_start() hands the whole ramp to
+ *   the peripheral and returns immediately, so the caller never blocks.
+ * - A new duty or ramp on a channel first stops any fade still running
+ *   there, so the latest request always wins. Stopping a pump is never
+ *   ramped.
+ */
+
+static inline void hal_ledc_sim_update(ledc_channel_t channel, uint32_t duty)
 {
 #if CONFIG_SIMULATOR_MODE
     // Map channel to GPIO for simulation visualization
@@ -214,30 +246,59 @@ static inline void hal_ledc_update(ledc_channel_t channel, uint32_t duty)
     if (pin != -1) {
         simulator_send_gpio_state(pin, duty > 0 ? 1 : 0);
     }
+#else
+    (void)channel;
+    (void)duty;
 #endif
+}
+
+static inline void hal_ledc_update(ledc_channel_t channel, uint32_t duty)
+{
+    hal_ledc_sim_update(channel, duty);
     /*
-     * Update the LEDC duty. We call `ledc_update_duty` after setting the
-     * duty because on some targets the actual timer update is applied only
-     * when `ledc_update_duty` is invoked. Keeping these two calls together
-     * avoids subtle timing differences across SDK versions.
+     * The thread-safe duty API is required once the fade service is
+     * installed; it also applies the new duty immediately.
      */
-    ledc_set_duty(LEDC_MODE, channel, duty);
-    ledc_update_duty(LEDC_MODE, channel);
+    ledc_fade_stop(LEDC_MODE, channel);
+    ledc_set_duty_and_update(LEDC_MODE, channel, duty, 0);
+}
+
+static inline void hal_ledc_fade(ledc_channel_t channel, uint32_t duty, uint32_t time_ms)
+{
+    if (time_ms == 0) {
+        hal_ledc_update(channel, duty);
+        return;
+    }
+    // The simulator only shows on/off, so report the end state up front
+    hal_ledc_sim_update(channel, duty);
+    ledc_fade_stop(LEDC_MODE, channel);
+    esp_err_t err = ledc_set_fade_time_and_start(LEDC_MODE, channel, duty, time_ms, LEDC_FADE_NO_WAIT);
+    if (err != ESP_OK) {
+        ESP_LOGW(TAG, "Fade on channel %d failed (%s); setting duty directly",
+                 channel, esp_err_to_name(err));
+        ledc_set_duty_and_update(LEDC_MODE, channel, duty, 0);
+    }
+}
+
+// Pumps ramp up from their current duty and stop immediately
+static inline void hal_pump_update(ledc_channel_t channel, uint32_t duty)
+{
+    hal_ledc_fade(channel, duty, duty > 0 ? PUMP_SOFT_START_MS : 0);
 }
 
 void pwm_set_circulation_pump(uint32_t duty)
 {
-    hal_ledc_update(LEDC_CH_CIRCULATION, duty);
+    hal_pump_update(LEDC_CH_CIRCULATION, duty);
 }
 
 void pwm_set_drain_pump(uint32_t duty)
 {
-    hal_ledc_update(LEDC_CH_DRAIN, duty);
+    hal_pump_update(LEDC_CH_DRAIN, duty);
 }
 
 void pwm_set_fill_pump(uint32_t duty)
 {
-    hal_ledc_update(LEDC_CH_FILL, duty);
+    hal_pump_update(LEDC_CH_FILL, duty);
 }
 
 void pwm_set_drum_led(uint32_t duty)
@@ -245,20 +306,31 @@ void pwm_set_drum_led(uint32_t duty)
     hal_ledc_update(LEDC_CH_DRUM_LED, duty);
 }
 
-/*===========================================================================
- * DAC Operations
- *===========================================================================*/
+void pwm_fade_drum_led(uint32_t duty, uint32_t time_ms)
+{
+    hal_ledc_fade(LEDC_CH_DRUM_LED, duty, time_ms);
+}
 
-void dac_output(uint8_t value)
+void pwm_fade_circulation_pump(uint32_t duty, uint32_t time_ms)
 {
-    if (!s_dac_handle) {
-        ESP_LOGW(TAG, "DAC handle not initialized");
-        return;
-    }
-    dac_oneshot_output_voltage(s_dac_handle, value);
+    hal_ledc_fade(LEDC_CH_CIRCULATION, duty, time_ms);
+}
+
+void pwm_fade_drain_pump(uint32_t duty, uint32_t time_ms)
+{
+    hal_ledc_fade(LEDC_CH_DRAIN, duty, time_ms);
 }
 
-dac_oneshot_handle_t gpio_hal_get_dac_handle(void)
+void pwm_fade_fill_pump(uint32_t duty, uint32_t time_ms)
+{
+    hal_ledc_fade(LEDC_CH_FILL, duty, time_ms);
+}
+
+/*===========================================================================
+ * DAC Operations
+ *===========================================================================*/
+
+dac_continuous_handle_t gpio_hal_get_dac_handle(void)
 {
     return s_dac_handle;
 }
@@ -267,61 +339,132 @@ dac_oneshot_handle_t gpio_hal_get_dac_handle(void)
  * Button Handling
  *===========================================================================*/
 
-// Forward declarations for button handlers (implemented in main)
-extern void handle_power_button(void);
-extern void handle_start_stop_button(void);
-extern void handle_start_stop_long_press(void);
+/*
+ * Why inputs are interrupt driven:
+ * - Buttons and the door used to be polled every 50 ms by a dedicated task,
+ *   adding up to 50 ms of latency and 20 wakeups a second while idle. Now
+ *   the door GPIO interrupt and the ULP button interrupt post events
+ *   directly, stamped with the edge time. The ULP still does the button
+ *   debouncing, so the handlers only classify edges.
+ * - Simulator inputs go through the same handlers from task context
+ *   (higher_priority_task_woken == nullptr), so both paths behave alike.
+ */
 
-void check_buttons(void)
+static int s_last_door_level = -1;
+static uint32_t s_start_press_us = 0;
+static bool s_start_pressed = false;
+
+static void post_input_event(wm_event_type_t type, int32_t value, uint32_t timestamp_us,
+                             BaseType_t *higher_priority_task_woken)
 {
-    /* Non-blocking button handling using debounced levels from the ULP
-     * coprocessor. The ULP filters noise; here we only look for level
-     * transitions to generate short/long press events.
-     */
-    TickType_t now = xTaskGetTickCount();
+    wm_event_t evt = {
+        .type = type,
+        .value = value,
+        .timestamp_us = timestamp_us ? timestamp_us : 1,
+    };
+    if (higher_priority_task_woken) {
+        tasks_post_event_from_isr(&evt, higher_priority_task_woken);
+    } else {
+        tasks_post_event(WM_PRODUCER_SIM, &evt);    // Only the simulator calls in from a task
+    }
+}
+
+static void handle_door_edge(int level, uint32_t timestamp_us, BaseType_t *higher_priority_task_woken)
+{
+    ETRACE(ETRACE_DOOR_EDGE, level, 0);
+    // Contact bounce produces repeated edges; only forward real changes
+    if (level == s_last_door_level) {
+        return;
+    }
+    s_last_door_level = level;
+    post_input_event(WM_EVENT_DOOR_STATE, level ? 1 : 0, timestamp_us, higher_priority_task_woken);
+}
+
+static void handle_button_edge(int index, uint32_t level, uint32_t timestamp_us,
+                               BaseType_t *higher_priority_task_woken)
+{
+    ETRACE(ETRACE_BUTTON_EDGE, index, level);
+    if (index == 0) {
+        // POWER button (short press) – only reacts on the press edge
+        if (level) {
+            post_input_event(WM_EVENT_POWER_BUTTON, 0, timestamp_us, higher_priority_task_woken);
+        }
+        return;
+    }
+
+    // START/STOP button: short vs long press is decided on release
+    if (level) {
+        s_start_pressed = true;
+        s_start_press_us = timestamp_us;
+        return;
+    }
+    if (!s_start_pressed) {
+        return;     // Release without a press (e.g. button was masked)
+    }
+    s_start_pressed = false;
+
+    uint32_t held_ms = (timestamp_us - s_start_press_us) / 1000;
+    post_input_event(held_ms >= BUTTON_LONG_PRESS_MS ? WM_EVENT_START_LONG_PRESS : WM_EVENT_START_BUTTON,
+                     (int32_t)held_ms, timestamp_us, higher_priority_task_woken);
+}
 
-    // Door sensor: sample once, keep it simple and fast
+static void door_isr(void *arg)
+{
+    (void)arg;
+    BaseType_t woken = pdFALSE;
+    handle_door_edge(gpio_get_level(static_cast<gpio_num_t>(PIN_DOOR_SENSOR)),
+                     (uint32_t)esp_timer_get_time(), &woken);
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+esp_err_t app_input_irq_init(void)
+{
+    // Publish the current door state once; edges keep it up to date
     int door_level = gpio_read(PIN_DOOR_SENSOR);
     machine_set_door_open(door_level != 0);
+    s_last_door_level = door_level;
+    tasks_post_simple_event(WM_PRODUCER_SYSTEM, WM_EVENT_DOOR_STATE, door_level ? 1 : 0);
 
-    static int last_power_state = 0;
-    static int last_start_state = 0;
-    static TickType_t start_press_tick = 0;
-
-    uint32_t mask = ulp_get_button_mask();
+#if !CONFIG_SIMULATOR_MODE
+    esp_err_t ret = gpio_install_isr_service(0);
+    if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {    // Already installed is fine
+        ESP_LOGE(TAG, "Failed to install GPIO ISR service: %s", esp_err_to_name(ret));
+        return ret;
+    }
+    ret = gpio_isr_handler_add(static_cast<gpio_num_t>(PIN_DOOR_SENSOR), door_isr, nullptr);
+    if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to add door ISR: %s", esp_err_to_name(ret));
+        return ret;
+    }
+#endif
 
-    // POWER button (short press) – only reacts on rising edge
-    int power_state = static_cast<int>(ulp_button_level(0));
-    if (power_state != last_power_state) {
-        last_power_state = power_state;
-        if (power_state) {
-            ESP_LOGI(TAG, "Power button pressed (ULP filtered)");
-            handle_power_button();
-        }
+    esp_err_t err = ulp_buttons_set_edge_callback(handle_button_edge);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to hook ULP button interrupt: %s", esp_err_to_name(err));
+        return err;
     }
 
-    // START/STOP button (short vs long press) gated by mask bit1
-    if (mask & 0x2) {
-        int start_state = static_cast<int>(ulp_button_level(1));
-        if (start_state != last_start_state) {
-            last_start_state = start_state;
-            if (start_state) {
-                start_press_tick = now;
-            } else {
-                uint32_t held_ms = (now - start_press_tick) * portTICK_PERIOD_MS;
-                if (held_ms >= 2000) {
-                    ESP_LOGI(TAG, "Start/Stop long press ( %u ms )", held_ms);
-                    handle_start_stop_long_press();
-                } else {
-                    ESP_LOGI(TAG, "Start/Stop short press ( %u ms )", held_ms);
-                    handle_start_stop_button();
-                }
-                start_press_tick = 0;
-            }
+    // Sample faster while awake: debounce latency is samples x period
+    ulp_set_awake_period(INPUT_ULP_AWAKE_PERIOD_US);
+
+    ESP_LOGI(TAG, "Input interrupts enabled (door GPIO%d, ULP buttons)", PIN_DOOR_SENSOR);
+    return ESP_OK;
+}
+
+#if CONFIG_SIMULATOR_MODE
+void gpio_hal_sim_input(int pin, int level)
+{
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    if (pin == PIN_DOOR_SENSOR) {
+        handle_door_edge(level ? 1 : 0, now_us, nullptr);
+    } else if (pin == PIN_POWER_BUTTON) {
+        handle_button_edge(0, level ? 1 : 0, now_us, nullptr);
+    } else if (pin == PIN_START_STOP_BUTTON) {
+        if (ulp_get_button_mask() & 0x2) {
+            handle_button_edge(1, level ? 1 : 0, now_us, nullptr);
         }
-    } else {
-        // Masked off: reset state to avoid stale long-press timing
-        last_start_state = 0;
-        start_press_tick = 0;
     }
 }
+#endif
@@ -9,8 +9,9 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include "sdkconfig.h"
 #include "esp_err.h"
-#include "driver/dac_oneshot.h"
+#include "driver/dac_continuous.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -33,7 +34,7 @@ esp_err_t app_gpio_init(void);
 esp_err_t app_ledc_init(void);
 
 /**
- * @brief Initialize DAC for audio output
+ * @brief Initialize DAC for DMA-driven audio output
  * @return ESP_OK on success
  */
 esp_err_t app_dac_init(void);
@@ -63,6 +64,8 @@ void gpio_write(int pin, int level);
 /**
  * @brief Set PWM duty cycle for circulation pump
  * @param duty Duty cycle (0-4095 for 12-bit resolution)
+ * @note Like the other pumps, a non-zero duty is reached over
+ *       PUMP_SOFT_START_MS by the LEDC fader; 0 stops at once
  */
 void pwm_set_circulation_pump(uint32_t duty);
 
@@ -90,31 +93,52 @@ void pwm_set_power_led(uint32_t duty);
  */
 void pwm_set_drum_led(uint32_t duty);
 
-/*===========================================================================
- * DAC Operations
- *===========================================================================*/
+/**
+ * @brief Fade the drum LED to a duty cycle in hardware
+ * @param duty Target duty cycle (0-4095)
+ * @param time_ms Fade length; returns immediately
+ */
+void pwm_fade_drum_led(uint32_t duty, uint32_t time_ms);
 
 /**
- * @brief Output voltage on DAC (for audio)
- * @param value 8-bit value (0-255)
+ * @brief Ramp a pump to a duty cycle over an explicit time (also ramps down)
  */
-void dac_output(uint8_t value);
+void pwm_fade_circulation_pump(uint32_t duty, uint32_t time_ms);
+void pwm_fade_drain_pump(uint32_t duty, uint32_t time_ms);
+void pwm_fade_fill_pump(uint32_t duty, uint32_t time_ms);
+
+/*===========================================================================
+ * DAC Operations
+ *===========================================================================*/
 
 /**
- * @brief Retrieve underlying DAC oneshot handle
+ * @brief Retrieve underlying DAC continuous (DMA) handle
  * @return Handle created during app_dac_init (nullptr if not initialized)
+ * @note The channel is created disabled; the sound driver enables it while
+ *       streaming and owns all writes to it.
  */
-dac_oneshot_handle_t gpio_hal_get_dac_handle(void);
+dac_continuous_handle_t gpio_hal_get_dac_handle(void);
 
 /*===========================================================================
  * Button Handling
  *===========================================================================*/
 
 /**
- * @brief Check and debounce button inputs
- * Updates door_is_open, handles power and start/stop button presses
+ * @brief Enable interrupt-driven inputs
+ *
+ * Installs the door sensor GPIO interrupt and hooks the ULP button
+ * interrupt; both post timestamped events with tasks_post_event_from_isr().
+ * Posts the current door state once. Call after the event queue exists.
+ * @return ESP_OK on success
  */
-void check_buttons(void);
+esp_err_t app_input_irq_init(void);
+
+#if CONFIG_SIMULATOR_MODE
+/**
+ * @brief Feed a simulated input edge through the same path as the ISRs
+ */
+void gpio_hal_sim_input(int pin, int level);
+#endif
 
 #ifdef __cplusplus
 }
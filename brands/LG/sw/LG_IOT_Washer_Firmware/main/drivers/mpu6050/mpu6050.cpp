@@ -28,6 +28,10 @@
 
 #include "driver/i2c_master.h"
 #include "esp_log.h"
+#include "sdkconfig.h"
+#if CONFIG_SIM_PLANT
+#include "sim_plant.h"
+#endif
 
 static const char *TAG = "mpu6050";
 
@@ -94,8 +98,47 @@ static int s_history_index = 0;
  * Internal I2C Functions
  *===========================================================================*/
 
+#if CONFIG_SIM_PLANT
+/*
+ * While the plant model (sim_plant) runs it answers the registers, the same
+ * way odrive.cpp routes to it: WHO_AM_I, the tub acceleration in the
+ * configured range (clipped like the sensor) and 25 C. Writes are accepted
+ * and ignored, so everything above this level runs as on the machine. With
+ * the plant stopped the reads go over I2C to whatever sensor is fitted.
+ */
+static void put_reg16(uint8_t *regs, uint8_t reg, float value)
+{
+    const float clipped = value > 32767.0f ? 32767.0f : (value < -32768.0f ? -32768.0f : value);
+    const int16_t raw = (int16_t)lroundf(clipped);
+    regs[reg] = (uint8_t)((uint16_t)raw >> 8);
+    regs[reg + 1] = (uint8_t)raw;
+}
+
+static esp_err_t plant_read_reg(uint8_t reg, uint8_t *data, size_t len)
+{
+    uint8_t regs[0x80] = {};
+    if (reg + len > sizeof(regs)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    float accel_g[3];
+    sim_plant_read_accel(accel_g);
+    put_reg16(regs, MPU6050_REG_ACCEL_XOUT_H, accel_g[0] * s_accel_scale);
+    put_reg16(regs, MPU6050_REG_ACCEL_YOUT_H, accel_g[1] * s_accel_scale);
+    put_reg16(regs, MPU6050_REG_ACCEL_ZOUT_H, accel_g[2] * s_accel_scale);
+    put_reg16(regs, MPU6050_REG_TEMP_OUT_H, (25.0f - 36.53f) * 340.0f);
+    regs[MPU6050_REG_WHO_AM_I] = MPU6050_I2C_ADDR;
+    memcpy(data, regs + reg, len);
+    return ESP_OK;
+}
+#endif
+
 static esp_err_t mpu6050_write_reg(uint8_t reg, uint8_t data)
 {
+#if CONFIG_SIM_PLANT
+    if (sim_plant_is_running()) {
+        return ESP_OK;
+    }
+#endif
     if (!s_mpu_device) {
         return ESP_ERR_INVALID_STATE;
     }
@@ -106,6 +149,11 @@ static esp_err_t mpu6050_write_reg(uint8_t reg, uint8_t data)
 
 static esp_err_t mpu6050_read_reg(uint8_t reg, uint8_t *data, size_t len)
 {
+#if CONFIG_SIM_PLANT
+    if (sim_plant_is_running()) {
+        return plant_read_reg(reg, data, len);
+    }
+#endif
     if (!s_mpu_device) {
         return ESP_ERR_INVALID_STATE;
     }
@@ -129,7 +177,12 @@ esp_err_t mpu6050_init(void)
         return ESP_OK;
     }
     
-    if (!s_i2c_bus) {
+#if CONFIG_SIM_PLANT
+    const bool on_bus = !sim_plant_is_running();
+#else
+    const bool on_bus = true;
+#endif
+    if (on_bus && !s_i2c_bus) {
         esp_err_t ret = i2c_master_get_bus_handle(MPU6050_I2C_NUM, &s_i2c_bus);
         if (ret != ESP_OK) {
             i2c_master_bus_config_t bus_cfg = {};
@@ -148,7 +201,7 @@ esp_err_t mpu6050_init(void)
         }
     }
 
-    if (!s_mpu_device) {
+    if (on_bus && !s_mpu_device) {
         i2c_device_config_t dev_cfg = {};
         dev_cfg.dev_addr_length = I2C_ADDR_BIT_LEN_7;
         dev_cfg.device_address = MPU6050_I2C_ADDR;
@@ -21,10 +21,17 @@
  *   relatively infrequent compared to the motor control loop.
  */
 
+// app_config.h first: its ODRIVE_BAUD_RATE replaces odrive.h's default
+#include "app_config.h"
 #include "odrive.h"
 #include "machine_state.h"
-#include "app_config.h"
+#include "diagnostics/event_trace.h"
+#include "tasks/static_alloc.h"
+#if CONFIG_SIMULATOR_MODE
+#include "sim_plant.h"
+#endif
 
+#include <math.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -46,11 +53,20 @@ static const char *TAG = "odrive";
 
 static bool s_initialized = false;
 static SemaphoreHandle_t s_uart_mutex = nullptr;
+static StaticMutexSlot s_uart_mutex_slot;
 
 /*===========================================================================
  * Internal Functions
  *===========================================================================*/
 
+// First four command bytes as one trace argument ("w ax", "r ax", ...)
+static inline uint32_t command_tag(const char *cmd, size_t len)
+{
+    uint32_t tag = 0;
+    memcpy(&tag, cmd, len < sizeof(tag) ? len : sizeof(tag));
+    return tag;
+}
+
 /**
  * @brief Send command to ODrive and optionally read response
  * @param cmd Command string (without newline)
@@ -84,14 +100,14 @@ static esp_err_t odrive_send_command(const char *cmd, char *response,
     char cmd_buf[ODRIVE_BUF_SIZE];
     int len = snprintf(cmd_buf, sizeof(cmd_buf), "%s\n", cmd);
     
+    ETRACE(ETRACE_ODRIVE_CMD_BEGIN, command_tag(cmd_buf, len), len);
     int written = uart_write_bytes(ODRIVE_UART_NUM, cmd_buf, len);
     if (written < 0) {
         xSemaphoreGive(s_uart_mutex);
+        ETRACE(ETRACE_ODRIVE_CMD_END, ESP_FAIL, 0);
         return ESP_FAIL;
     }
     
-    ESP_LOGD(TAG, "TX: %s", cmd);
-    
     // Read response if buffer provided
     if (response != nullptr && response_len > 0) {
         memset(response, 0, response_len);
@@ -122,6 +138,7 @@ static esp_err_t odrive_send_command(const char *cmd, char *response,
             // Check timeout
             if ((esp_timer_get_time() - start) > (timeout_ms * 1000)) {
                 xSemaphoreGive(s_uart_mutex);
+                ETRACE(ETRACE_ODRIVE_CMD_END, ESP_ERR_TIMEOUT, total_read);
                 ESP_LOGW(TAG, "Response timeout");
                 return ESP_ERR_TIMEOUT;
             }
@@ -132,11 +149,10 @@ static esp_err_t odrive_send_command(const char *cmd, char *response,
         // Remove trailing newline
         char *nl = strchr(response, '\n');
         if (nl) *nl = '\0';
-        
-        ESP_LOGD(TAG, "RX: %s", response);
     }
     
     xSemaphoreGive(s_uart_mutex);
+    ETRACE(ETRACE_ODRIVE_CMD_END, ESP_OK, response ? strlen(response) : 0);
     return ESP_OK;
 }
 
@@ -173,7 +189,7 @@ esp_err_t odrive_init(void)
 #endif
     
     // Create mutex
-    s_uart_mutex = xSemaphoreCreateMutex();
+    s_uart_mutex = create_mutex(s_uart_mutex_slot);
     if (s_uart_mutex == nullptr) {
         ESP_LOGE(TAG, "Failed to create mutex");
         return ESP_FAIL;
@@ -217,6 +233,11 @@ esp_err_t odrive_init(void)
 
 esp_err_t odrive_set_state(uint8_t axis, odrive_axis_state_t state)
 {
+#if CONFIG_SIMULATOR_MODE
+    if (axis == 0 && (state == AXIS_STATE_IDLE || state == AXIS_STATE_CLOSED_LOOP_CONTROL)) {
+        sim_plant_set_motor_enabled(state == AXIS_STATE_CLOSED_LOOP_CONTROL);
+    }
+#endif
     char cmd[64];
     snprintf(cmd, sizeof(cmd), "w axis%d.requested_state %d", axis, (int)state);
     return odrive_send_command(cmd, nullptr, 0, 100);
@@ -233,9 +254,14 @@ esp_err_t odrive_set_control_mode(uint8_t axis, odrive_control_mode_t mode)
 esp_err_t odrive_set_velocity(uint8_t axis, float velocity)
 {
 #if CONFIG_SIMULATOR_MODE
-    int rpm = (int)(velocity * 60.0f);
+    // Rounded: the RPM went through turns/s, and 1000/60*60 truncates to 999
+    int rpm = (int)lroundf(velocity * 60.0f);
     machine_set_target_rpm(abs(rpm));
-    machine_set_current_rpm(abs(rpm)); // Instant response for sim
+    if (sim_plant_is_running()) {
+        sim_plant_set_velocity(velocity);   // The plant reports the speed it reaches
+    } else {
+        machine_set_current_rpm(abs(rpm)); // Instant response for sim
+    }
     machine_set_motor_dir(rpm < 0); // True if negative (CCW?)
 #endif
     char cmd[64];
@@ -252,6 +278,14 @@ esp_err_t odrive_set_velocity_ff(uint8_t axis, float velocity, float torque_ff)
 
 esp_err_t odrive_get_velocity(uint8_t axis, float *velocity)
 {
+#if CONFIG_SIMULATOR_MODE
+    if (sim_plant_is_running()) {
+        sim_plant_state_t plant;
+        sim_plant_get_state(&plant);
+        *velocity = plant.velocity_rpm / 60.0f;
+        return ESP_OK;
+    }
+#endif
     char cmd[64];
     snprintf(cmd, sizeof(cmd), "r axis%d.encoder.vel_estimate", axis);
     return odrive_read_float(cmd, velocity);
@@ -259,6 +293,14 @@ esp_err_t odrive_get_velocity(uint8_t axis, float *velocity)
 
 esp_err_t odrive_get_current(uint8_t axis, float *current)
 {
+#if CONFIG_SIMULATOR_MODE
+    if (sim_plant_is_running()) {
+        sim_plant_state_t plant;
+        sim_plant_get_state(&plant);
+        *current = plant.current;
+        return ESP_OK;
+    }
+#endif
     char cmd[64];
     snprintf(cmd, sizeof(cmd), "r axis%d.motor.current_control.Iq_measured", axis);
     return odrive_read_float(cmd, current);
@@ -271,6 +313,9 @@ esp_err_t odrive_get_bus_voltage(float *voltage)
 
 esp_err_t odrive_emergency_stop(void)
 {
+#if CONFIG_SIMULATOR_MODE
+    sim_plant_set_motor_enabled(false);
+#endif
     // Set both axes to idle immediately
     odrive_send_command("w axis0.requested_state 1", nullptr, 0, 50);
     odrive_send_command("w axis1.requested_state 1", nullptr, 0, 50);
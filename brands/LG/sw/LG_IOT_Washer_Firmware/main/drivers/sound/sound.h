@@ -10,6 +10,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include "esp_err.h"
+#include "sound_synth.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -19,25 +20,11 @@ extern "C" {
  * Sound Configuration
  *===========================================================================*/
 
-#define SOUND_SAMPLE_RATE       8000    // 8 kHz sample rate
+// SOUND_SAMPLE_RATE and SOUND_MAX_VOICES live in sound_synth.h
 #define SOUND_DAC_CHANNEL       1       // DAC channel (GPIO25)
-
-/*===========================================================================
- * ADSR Envelope Parameters
- *===========================================================================*/
-
-typedef struct {
-    uint16_t attack_ms;     // Time to reach peak (ms)
-    uint16_t decay_ms;      // Time to reach sustain level (ms)
-    uint8_t  sustain_level; // Sustain level (0-255)
-    uint16_t release_ms;    // Time to fade out (ms)
-} adsr_envelope_t;
-
-// Predefined envelopes
-extern const adsr_envelope_t ADSR_BEEP;      // Short beep
-extern const adsr_envelope_t ADSR_ALERT;     // Alert tone
-extern const adsr_envelope_t ADSR_SOFT;      // Soft tone
-extern const adsr_envelope_t ADSR_SHARP;     // Sharp attack
+#define SOUND_BLOCK_SAMPLES     128     // Samples rendered per DMA block (16 ms)
+#define SOUND_DMA_DESC_NUM      2       // DMA blocks in flight (double buffering)
+#define SOUND_IDLE_SHUTDOWN_MS  500     // Keep DAC clocked this long after the last tone
 
 /*===========================================================================
  * Sound API
@@ -51,6 +38,10 @@ esp_err_t sound_init(void);
 
 /**
  * @brief Play a tone with specified frequency and duration
+ *
+ * The tone takes a voice from the pool and mixes with anything already
+ * playing. Returns immediately.
+ *
  * @param frequency Frequency in Hz (20-20000)
  * @param duration_ms Duration in milliseconds
  * @param envelope ADSR envelope to use (nullptr for default)
@@ -65,6 +56,9 @@ void sound_play_effect(uint8_t effect_id);
 
 /**
  * @brief Stop any currently playing sound
+ *
+ * Silences every voice, including effects requested before this call that
+ * have not started yet. Sounds requested after it play normally.
  */
 void sound_stop(void);
 
@@ -80,22 +74,6 @@ bool sound_is_playing(void);
  */
 void sound_set_volume(uint8_t volume);
 
-/*===========================================================================
- * Predefined Sound Effects
- *===========================================================================*/
-
-#define SOUND_EFFECT_STARTUP        0
-#define SOUND_EFFECT_BUTTON_PRESS   1
-#define SOUND_EFFECT_CYCLE_START    2
-#define SOUND_EFFECT_CYCLE_END      3
-#define SOUND_EFFECT_ERROR          4
-#define SOUND_EFFECT_DOOR_OPEN      5
-#define SOUND_EFFECT_WATER_FILL     6
-#define SOUND_EFFECT_ON             7
-#define SOUND_EFFECT_OFF            8
-#define SOUND_EFFECT_SELECT         9
-#define SOUND_EFFECT_STOP           10
-
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,616 @@
+/*
+ * sound_synth.cpp
+ * Fixed-point voice-pool synthesizer (no ESP-IDF dependencies)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why the synthesizer is split from the sound driver:
+ * - This file only turns timelines into samples; the DMA, queue and task
+ *   live in sound.cpp. Keeping it free of ESP-IDF headers lets the exact
+ *   same code run on the host (tools/sound_render) to write WAVs and
+ *   benchmark the inner loop.
+ *
+ * Why the inner loop is fixed-point and incremental:
+ * - The envelope used to be recomputed from elapsed milliseconds with
+ *   several divisions per sample. Each note now precomputes its segment
+ *   boundaries in samples and a Q16 slope per segment, so a sample costs one
+ *   add for the envelope; the only divisions happen at segment changes.
+ * - The old 8-bit phase increment ((f * 256) / rate) rounded every pitch to
+ *   a multiple of 31.25 Hz. A 32-bit accumulator with linear interpolation
+ *   between table entries keeps pitch error well below 0.01 Hz.
+ * - Volume is a multiply and a shift instead of a divide by 255*255.
+ *
+ * Why fixed effects can be pre-rendered:
+ * - Timeline effects are deterministic, so the build renders them once with
+ *   this code (tools/sound_render --blob) and embeds the samples. A PCM voice
+ *   then only scales and adds samples; see CONFIG_SOUND_PCM_CACHE.
+ */
+
+#include "sound_synth.h"
+
+#include <string.h>
+
+/*===========================================================================
+ * Predefined ADSR Envelopes
+ *===========================================================================*/
+
+const adsr_envelope_t ADSR_BEEP = {
+    .attack_ms = 5,
+    .decay_ms = 20,
+    .sustain_level = 200,
+    .release_ms = 30
+};
+
+const adsr_envelope_t ADSR_ALERT = {
+    .attack_ms = 10,
+    .decay_ms = 50,
+    .sustain_level = 180,
+    .release_ms = 100
+};
+
+const adsr_envelope_t ADSR_SOFT = {
+    .attack_ms = 50,
+    .decay_ms = 100,
+    .sustain_level = 150,
+    .release_ms = 200
+};
+
+const adsr_envelope_t ADSR_SHARP = {
+    .attack_ms = 2,
+    .decay_ms = 10,
+    .sustain_level = 220,
+    .release_ms = 20
+};
+
+/*===========================================================================
+ * Sine Wave Lookup Table (256 entries, 8-bit)
+ *===========================================================================*/
+
+static const uint8_t sine_table[256] = {
+    128,131,134,137,140,143,146,149,152,155,158,162,165,167,170,173,
+    176,179,182,185,188,190,193,196,198,201,203,206,208,211,213,215,
+    218,220,222,224,226,228,230,232,234,235,237,238,240,241,243,244,
+    245,246,248,249,250,250,251,252,253,253,254,254,254,255,255,255,
+    255,255,255,255,254,254,254,253,253,252,251,250,250,249,248,246,
+    245,244,243,241,240,238,237,235,234,232,230,228,226,224,222,220,
+    218,215,213,211,208,206,203,201,198,196,193,190,188,185,182,179,
+    176,173,170,167,165,162,158,155,152,149,146,143,140,137,134,131,
+    128,124,121,118,115,112,109,106,103,100, 97, 93, 90, 88, 85, 82,
+     79, 76, 73, 70, 67, 65, 62, 59, 57, 54, 52, 49, 47, 44, 42, 40,
+     37, 35, 33, 31, 29, 27, 25, 23, 21, 20, 18, 17, 15, 14, 12, 11,
+     10,  9,  7,  6,  5,  5,  4,  3,  2,  2,  1,  1,  1,  0,  0,  0,
+      0,  0,  0,  0,  1,  1,  1,  2,  2,  3,  4,  5,  5,  6,  7,  9,
+     10, 11, 12, 14, 15, 17, 18, 20, 21, 23, 25, 27, 29, 31, 33, 35,
+     37, 40, 42, 44, 47, 49, 52, 54, 57, 59, 62, 65, 67, 70, 73, 76,
+     79, 82, 85, 88, 90, 93, 97,100,103,106,109,112,115,118,121,124
+};
+
+/*===========================================================================
+ * Sound Sequences (Ported from Arduino)
+ *===========================================================================*/
+
+static const sound_note_t on_sound_notes[] = {
+    { 1499, 233, 1, 0.1 },
+    { 1895.94, 267, 1, 0.1 },
+    { 2253.07, 132, 1, 0.1 },
+    { 1895.94, 136, 1, 0.1 },
+    { 2253, 200, 1, 0.1 },
+    { 2997.99, 350, 1, 0.0 },
+};
+
+static const sound_note_t off_sound_notes[] = {
+    { 2974.56, 233, 1, 0.1 },
+    { 2253, 267, 1, 0.1 },
+    { 1895.94, 132, 1, 0.1 },
+    { 2253, 136, 1, 0.1 },
+    { 1895.94, 200, 1, 0.1 },
+    { 1499, 350, 1, 0.0 },
+};
+
+static const sound_note_t select_sound_notes[] = {
+    { 2703.10, 250, 1.0, 0.0 },
+};
+
+static const sound_note_t error_sound_notes[] = {
+    { 6031.15, 90, 1.0, 0.50 },
+    { 2253.07, 240, 1.0, 0.0 },
+};
+
+static const sound_note_t start_sound_notes[] = {
+    { 2253.07, 90, 1.0, 0.75 },
+    { 2533.27, 103, 1.0, 0.70 },
+    { 3383.53, 300, 1.0, 0.0 },
+};
+
+static const sound_note_t stop_sound_notes[] = {
+    { 3383.53, 96, 1.0, 0.75 },
+    { 3009.71, 104, 1.0, 0.70 },
+    { 2253.07, 300, 1.0, 0.0 },
+};
+
+static const sound_note_t end_sound_notes[] = {
+    { 2253.07, 600, 1.0, 0.0 },
+    { 3009.71, 200, 1.0, 0.5 },
+    { 2830.57, 200, 1.0, 0.5 },
+    { 2521.55, 200, 1.0, 0.5 },
+    { 2253.07, 600, 1.0, 0.0 },
+    { 1895.94, 600, 1.0, 0.0 },
+    { 1999.81, 200, 1.0, 0.5 },
+    { 2253.07, 200, 1.0, 0.5 },
+    { 2521.55, 200, 1.0, 0.5 },
+    { 1685.90, 200, 1.0, 0.5 },
+    { 1895.94, 200, 1.0, 0.5 },
+    { 1999.81, 200, 1.0, 0.5 },
+    { 1895.94, 600, 1.0, 0.0 },
+    { 2253.07, 600, 1.0, 0.0 },
+    { 2253.07, 600, 1.0, 0.0 },
+    { 2997.99, 200, 1.0, 0.5 },
+    { 2830.57, 200, 1.0, 0.5 },
+    { 2521.55, 200, 1.0, 0.5 },
+    { 2253.07, 600, 1.0, 0.0 },
+    { 2997.99, 600, 1.0, 0.0 },
+    { 2997.99, 200, 1.0, 0.5 },
+    { 3371.81, 200, 1.0, 0.5 },
+    { 2997.99, 200, 1.0, 0.5 },
+    { 2830.57, 200, 1.0, 0.5 },
+    { 2521.55, 200, 1.0, 0.5 },
+    { 2830.57, 200, 1.0, 0.0 },
+    { 2997.99, 700, 1.0, 0.0 },
+};
+
+#define TIMELINE(notes, repeat, gap_ms) \
+    { notes, (uint8_t)(sizeof(notes) / sizeof(notes[0])), repeat, gap_ms }
+
+static const sound_timeline_t on_sound = TIMELINE(on_sound_notes, 1, 0);
+static const sound_timeline_t off_sound = TIMELINE(off_sound_notes, 1, 0);
+static const sound_timeline_t select_sound = TIMELINE(select_sound_notes, 1, 0);
+static const sound_timeline_t error_sound = TIMELINE(error_sound_notes, 3, 400);
+static const sound_timeline_t start_sound = TIMELINE(start_sound_notes, 1, 0);
+static const sound_timeline_t stop_sound = TIMELINE(stop_sound_notes, 1, 0);
+static const sound_timeline_t end_sound = TIMELINE(end_sound_notes, 1, 0);
+
+/*===========================================================================
+ * Internal Functions
+ *===========================================================================*/
+
+static inline uint32_t ms_to_samples(uint32_t ms)
+{
+    return (ms * SOUND_SAMPLE_RATE) / 1000;
+}
+
+/**
+ * @brief Set up the stage that starts at the voice's current position
+ *
+ * Stages that are already over (zero length, or cut short by a release that
+ * must start earlier) are skipped, so a voice is always in a stage whose
+ * stage_end lies after position.
+ */
+static void voice_enter_stage(synth_voice_t *voice, uint8_t stage)
+{
+    uint32_t pos = voice->position;
+
+    for (;;) {
+        voice->stage = stage;
+        switch (stage) {
+            case SYNTH_STAGE_ATTACK:
+                voice->stage_end = voice->attack_end;
+                break;
+            case SYNTH_STAGE_DECAY:
+                voice->level_q16 = voice->peak_q16;
+                voice->stage_end = voice->decay_end;
+                break;
+            case SYNTH_STAGE_SUSTAIN:
+                voice->level_q16 = voice->sustain_q16;
+                voice->stage_end = voice->release_start;
+                break;
+            case SYNTH_STAGE_RELEASE:
+                // Release always ends with the note, starting from wherever
+                // the envelope is now
+                voice->stage_end = voice->total_samples;
+                break;
+            default:
+                voice->level_q16 = 0;
+                voice->slope_q16 = 0;
+                voice->stage_end = UINT32_MAX;
+                return;
+        }
+
+        if (voice->stage_end > pos) {
+            break;
+        }
+        stage++;
+    }
+
+    int32_t target;
+    switch (stage) {
+        case SYNTH_STAGE_ATTACK:  target = voice->peak_q16; break;
+        case SYNTH_STAGE_DECAY:   target = voice->sustain_q16; break;
+        case SYNTH_STAGE_SUSTAIN: target = voice->sustain_q16; break;
+        default:                  target = 0; break;
+    }
+    voice->slope_q16 = (target - voice->level_q16) / (int32_t)(voice->stage_end - pos);
+}
+
+/**
+ * @brief Prepare a voice to render one note
+ * @param peak Envelope peak (0-255)
+ */
+static void voice_begin_note(synth_voice_t *voice, float frequency, uint16_t duration_ms,
+                             const adsr_envelope_t *env, uint8_t peak)
+{
+    uint32_t total = ms_to_samples(duration_ms);
+    uint32_t attack = ms_to_samples(env->attack_ms);
+    uint32_t decay = ms_to_samples(env->decay_ms);
+    uint32_t release = ms_to_samples(env->release_ms);
+
+    voice->total_samples = total;
+    voice->attack_end = (attack < total) ? attack : total;
+    voice->decay_end = (attack + decay < total) ? attack + decay : total;
+    voice->release_start = (release < total) ? total - release : 0;
+    if (voice->release_start < voice->decay_end) {
+        voice->release_start = voice->decay_end;
+    }
+
+    voice->peak_q16 = (int32_t)peak << 16;
+    voice->sustain_q16 = (int32_t)((peak * env->sustain_level) / 255) << 16;
+    voice->level_q16 = 0;
+    voice->position = 0;
+    voice->phase = 0;
+    voice->phase_increment = (frequency > 0.0f)
+        ? (uint32_t)((double)frequency * 4294967296.0 / SOUND_SAMPLE_RATE) : 0;
+
+    voice_enter_stage(voice, SYNTH_STAGE_ATTACK);
+}
+
+/**
+ * @brief Load the next note of a voice's timeline
+ * @return false when the timeline is finished
+ */
+static bool voice_next_note(synth_voice_t *voice)
+{
+    const sound_timeline_t *tl = voice->timeline;
+    if (tl == nullptr) {
+        return false;   // Single tones have only one note
+    }
+
+    if (voice->note_index >= tl->count) {
+        if (voice->repeats_left <= 1) {
+            return false;
+        }
+        voice->repeats_left--;
+        voice->note_index = 0;
+        voice->wait_samples = ms_to_samples(tl->repeat_gap_ms);
+    }
+
+    const sound_note_t *note = &tl->notes[voice->note_index++];
+
+    // Notes shape their own envelope: a short rise to start_amp, a decay to
+    // end_amp and a long release, matching the original Arduino sequences
+    uint16_t dur = note->duration_ms;
+    adsr_envelope_t env;
+    env.attack_ms = dur / 10;
+    env.decay_ms = dur / 5;
+    env.release_ms = dur - env.attack_ms - env.decay_ms;
+    if (note->start_amp <= 0.0f) {
+        env.sustain_level = 0;
+    } else if (note->end_amp >= note->start_amp) {
+        env.sustain_level = 255;
+    } else {
+        env.sustain_level = (uint8_t)(note->end_amp / note->start_amp * 255);
+    }
+
+    float amp = (note->start_amp > 1.0f) ? 1.0f : note->start_amp;
+    voice_begin_note(voice, note->frequency, dur, &env, (uint8_t)(amp * 255));
+    return true;
+}
+
+/**
+ * @brief Claim a voice slot, stealing the oldest one if the pool is full
+ */
+static synth_voice_t *voice_alloc(synth_mixer_t *mixer)
+{
+    synth_voice_t *oldest = &mixer->voices[0];
+    for (int i = 0; i < SOUND_MAX_VOICES; i++) {
+        if (!mixer->voices[i].active) {
+            oldest = &mixer->voices[i];
+            break;
+        }
+        if (mixer->voices[i].serial < oldest->serial) {
+            oldest = &mixer->voices[i];
+        }
+    }
+    memset(oldest, 0, sizeof(*oldest));
+    oldest->serial = ++mixer->serial;
+    return oldest;
+}
+
+/**
+ * @brief Add a pre-rendered voice into the mix buffer
+ */
+static void voice_render_pcm(synth_voice_t *voice, int32_t *mix, size_t count, uint8_t volume)
+{
+    size_t i = 0;
+    while (i < count && voice->wait_samples > 0) {
+        voice->wait_samples--;
+        i++;
+    }
+
+    for (; i < count; i++) {
+        if (voice->position >= voice->pcm_len) {
+            voice->active = false;
+            return;
+        }
+        mix[i] += (((int32_t)voice->pcm[voice->position++] - 128) * volume) >> 8;
+    }
+}
+
+/**
+ * @brief Add one voice into the mix buffer
+ *
+ * Handles note boundaries, rests and start delays inside the block, and
+ * deactivates the voice once its timeline is finished.
+ */
+static void voice_render(synth_voice_t *voice, int32_t *mix, size_t count, uint8_t volume)
+{
+    for (size_t i = 0; i < count; i++) {
+        if (voice->wait_samples > 0) {
+            voice->wait_samples--;
+            continue;
+        }
+
+        if (voice->position >= voice->total_samples) {
+            if (!voice_next_note(voice)) {
+                voice->active = false;
+                return;
+            }
+            if (voice->wait_samples > 0) {
+                voice->wait_samples--;
+                continue;
+            }
+        }
+
+        if (voice->position >= voice->stage_end) {
+            voice_enter_stage(voice, voice->stage + 1);
+        }
+
+        if (voice->phase_increment != 0) {
+            // Linear interpolation between neighbouring table entries,
+            // 8 fractional bits taken from below the index
+            uint32_t idx = voice->phase >> 24;
+            int32_t frac = (int32_t)((voice->phase >> 16) & 0xFF);
+            int32_t a = (int32_t)sine_table[idx] - 128;
+            int32_t b = (int32_t)sine_table[(idx + 1) & 0xFF] - 128;
+            int32_t wave = (a << 8) + (b - a) * frac;              // +/-127 in Q8
+
+            // Envelope (0-255 in Q8) times volume, back to 0-255
+            int32_t gain = ((voice->level_q16 >> 8) * volume) >> 16;
+            mix[i] += (wave * gain) >> 16;
+
+            voice->phase += voice->phase_increment;
+        }
+
+        voice->level_q16 += voice->slope_q16;
+        if (voice->level_q16 < 0) voice->level_q16 = 0;
+        voice->position++;
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+void synth_mixer_init(synth_mixer_t *mixer)
+{
+    memset(mixer, 0, sizeof(*mixer));
+    mixer->volume = 255;
+}
+
+void synth_mixer_stop_all(synth_mixer_t *mixer)
+{
+    memset(mixer->voices, 0, sizeof(mixer->voices));
+}
+
+void synth_mixer_start_timeline(synth_mixer_t *mixer, const sound_timeline_t *timeline,
+                                uint16_t delay_ms)
+{
+    if (timeline == nullptr || timeline->count == 0) {
+        return;
+    }
+
+    synth_voice_t *voice = voice_alloc(mixer);
+    voice->timeline = timeline;
+    voice->repeats_left = timeline->repeat;
+    if (!voice_next_note(voice)) {
+        return;
+    }
+    voice->wait_samples += ms_to_samples(delay_ms);
+    voice->active = true;
+}
+
+void synth_mixer_start_tone(synth_mixer_t *mixer, float frequency, uint16_t duration_ms,
+                            const adsr_envelope_t *envelope, uint16_t delay_ms)
+{
+    if (frequency <= 0.0f || duration_ms == 0) {
+        return;
+    }
+
+    synth_voice_t *voice = voice_alloc(mixer);
+    voice_begin_note(voice, frequency, duration_ms,
+                     (envelope != nullptr) ? envelope : &ADSR_BEEP, 255);
+    voice->wait_samples = ms_to_samples(delay_ms);
+    voice->active = true;
+}
+
+void synth_mixer_start_pcm(synth_mixer_t *mixer, const uint8_t *pcm, uint32_t length,
+                           uint16_t delay_ms)
+{
+    if (pcm == nullptr || length == 0) {
+        return;
+    }
+
+    synth_voice_t *voice = voice_alloc(mixer);
+    voice->pcm = pcm;
+    voice->pcm_len = length;
+    voice->wait_samples = ms_to_samples(delay_ms);
+    voice->active = true;
+}
+
+bool synth_effect_is_cacheable(uint8_t effect_id)
+{
+    switch (effect_id) {
+        case SOUND_EFFECT_CYCLE_START:
+        case SOUND_EFFECT_CYCLE_END:
+        case SOUND_EFFECT_ERROR:
+        case SOUND_EFFECT_ON:
+        case SOUND_EFFECT_OFF:
+        case SOUND_EFFECT_SELECT:
+        case SOUND_EFFECT_STOP:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool synth_pcm_find(const uint8_t *blob, size_t blob_len, uint8_t effect_id,
+                    const uint8_t **pcm, uint32_t *length)
+{
+    sound_pcm_header_t header;
+    if (blob == nullptr || blob_len < sizeof(header)) {
+        return false;
+    }
+
+    // The blob has no alignment guarantee, so copy fields out
+    memcpy(&header, blob, sizeof(header));
+    if (header.magic != SOUND_PCM_MAGIC || header.version != SOUND_PCM_VERSION) {
+        return false;
+    }
+
+    for (uint16_t i = 0; i < header.count; i++) {
+        size_t at = sizeof(header) + i * sizeof(sound_pcm_entry_t);
+        if (at + sizeof(sound_pcm_entry_t) > blob_len) {
+            return false;
+        }
+
+        sound_pcm_entry_t entry;
+        memcpy(&entry, blob + at, sizeof(entry));
+        if (entry.effect_id != effect_id) {
+            continue;
+        }
+        if ((size_t)entry.offset + entry.length > blob_len) {
+            return false;
+        }
+        *pcm = blob + entry.offset;
+        *length = entry.length;
+        return true;
+    }
+    return false;
+}
+
+bool synth_mixer_play_effect(synth_mixer_t *mixer, uint8_t effect_id, uint32_t seed)
+{
+    switch (effect_id) {
+        case SOUND_EFFECT_STARTUP:
+            // Ascending arpeggio
+            synth_mixer_start_tone(mixer, 523, 100, &ADSR_SHARP, 0);    // C5
+            synth_mixer_start_tone(mixer, 659, 100, &ADSR_SHARP, 120);  // E5
+            synth_mixer_start_tone(mixer, 784, 200, &ADSR_SOFT, 240);   // G5
+            break;
+
+        case SOUND_EFFECT_BUTTON_PRESS:
+            synth_mixer_start_tone(mixer, 1000, 50, &ADSR_SHARP, 0);
+            break;
+
+        case SOUND_EFFECT_CYCLE_START:
+            synth_mixer_start_timeline(mixer, &start_sound, 0);
+            break;
+
+        case SOUND_EFFECT_CYCLE_END:
+            synth_mixer_start_timeline(mixer, &end_sound, 0);
+            break;
+
+        case SOUND_EFFECT_ERROR:
+            synth_mixer_start_timeline(mixer, &error_sound, 0);
+            break;
+
+        case SOUND_EFFECT_DOOR_OPEN:
+            synth_mixer_start_tone(mixer, 600, 100, &ADSR_SHARP, 0);
+            break;
+
+        case SOUND_EFFECT_WATER_FILL:
+            // Bubbling sound (random frequencies from a small LCG on the seed)
+            for (int i = 0; i < 5; i++) {
+                seed = seed * 1664525u + 1013904223u;
+                float freq = 300 + ((seed >> 16) % 200);
+                synth_mixer_start_tone(mixer, freq, 80, &ADSR_SHARP, i * 100);
+            }
+            break;
+
+        case SOUND_EFFECT_ON:
+            synth_mixer_start_timeline(mixer, &on_sound, 0);
+            break;
+
+        case SOUND_EFFECT_OFF:
+            synth_mixer_start_timeline(mixer, &off_sound, 0);
+            break;
+
+        case SOUND_EFFECT_SELECT:
+            synth_mixer_start_timeline(mixer, &select_sound, 0);
+            break;
+
+        case SOUND_EFFECT_STOP:
+            synth_mixer_start_timeline(mixer, &stop_sound, 0);
+            break;
+
+        default:
+            return false;
+    }
+    return true;
+}
+
+bool synth_mixer_render(synth_mixer_t *mixer, uint8_t *out, size_t count)
+{
+    int32_t mix[128];
+
+    while (count > 0) {
+        size_t n = (count < 128) ? count : 128;
+        memset(mix, 0, n * sizeof(int32_t));
+
+        for (int v = 0; v < SOUND_MAX_VOICES; v++) {
+            synth_voice_t *voice = &mixer->voices[v];
+            if (!voice->active) {
+                continue;
+            }
+            if (voice->pcm != nullptr) {
+                voice_render_pcm(voice, mix, n, mixer->volume);
+            } else {
+                voice_render(voice, mix, n, mixer->volume);
+            }
+        }
+
+        // Convert back to unsigned around the midpoint and clamp the sum
+        for (size_t i = 0; i < n; i++) {
+            int32_t sample = mix[i] + 128;
+            if (sample < 0) sample = 0;
+            if (sample > 255) sample = 255;
+            out[i] = (uint8_t)sample;
+        }
+
+        out += n;
+        count -= n;
+    }
+
+    return synth_mixer_active(mixer);
+}
+
+bool synth_mixer_active(const synth_mixer_t *mixer)
+{
+    for (int v = 0; v < SOUND_MAX_VOICES; v++) {
+        if (mixer->voices[v].active) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,214 @@
+/*
+ * sound_synth.h
+ * Fixed-point voice-pool synthesizer (no ESP-IDF dependencies)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Synth Configuration
+ *===========================================================================*/
+
+#define SOUND_SAMPLE_RATE       8000    // 8 kHz sample rate
+#define SOUND_MAX_VOICES        8       // Mixer voice pool size (oldest voice is stolen)
+
+/*===========================================================================
+ * ADSR Envelope Parameters
+ *===========================================================================*/
+
+typedef struct {
+    uint16_t attack_ms;     // Time to reach peak (ms)
+    uint16_t decay_ms;      // Time to reach sustain level (ms)
+    uint8_t  sustain_level; // Sustain level (0-255)
+    uint16_t release_ms;    // Time to fade out (ms)
+} adsr_envelope_t;
+
+// Predefined envelopes
+extern const adsr_envelope_t ADSR_BEEP;      // Short beep
+extern const adsr_envelope_t ADSR_ALERT;     // Alert tone
+extern const adsr_envelope_t ADSR_SOFT;      // Soft tone
+extern const adsr_envelope_t ADSR_SHARP;     // Sharp attack
+
+/*===========================================================================
+ * Predefined Sound Effects
+ *===========================================================================*/
+
+#define SOUND_EFFECT_STARTUP        0
+#define SOUND_EFFECT_BUTTON_PRESS   1
+#define SOUND_EFFECT_CYCLE_START    2
+#define SOUND_EFFECT_CYCLE_END      3
+#define SOUND_EFFECT_ERROR          4
+#define SOUND_EFFECT_DOOR_OPEN      5
+#define SOUND_EFFECT_WATER_FILL     6
+#define SOUND_EFFECT_ON             7
+#define SOUND_EFFECT_OFF            8
+#define SOUND_EFFECT_SELECT         9
+#define SOUND_EFFECT_STOP           10
+#define SOUND_EFFECT_COUNT          11
+
+/*===========================================================================
+ * Timelines and Voices
+ *===========================================================================*/
+
+typedef struct {
+    float frequency;        // Hz, 0 for a rest
+    uint16_t duration_ms;
+    float start_amp;        // Envelope peak (0.0-1.0)
+    float end_amp;          // Level reached after the decay (0.0-1.0)
+} sound_note_t;
+
+typedef struct {
+    const sound_note_t *notes;
+    uint8_t count;
+    uint8_t repeat;         // Number of times the whole timeline is played
+    uint16_t repeat_gap_ms; // Silence between repetitions
+} sound_timeline_t;
+
+typedef enum {
+    SYNTH_STAGE_ATTACK = 0,
+    SYNTH_STAGE_DECAY,
+    SYNTH_STAGE_SUSTAIN,
+    SYNTH_STAGE_RELEASE,
+    SYNTH_STAGE_DONE,
+} synth_stage_t;
+
+typedef struct {
+    bool active;
+    uint32_t serial;                    // Start order, used for voice stealing
+    const sound_timeline_t *timeline;   // nullptr for a single tone
+    const uint8_t *pcm;                 // Pre-rendered samples, nullptr when synthesizing
+    uint32_t pcm_len;
+    uint8_t note_index;
+    uint8_t repeats_left;
+    uint32_t wait_samples;              // Silence before the next note starts
+
+    // Current note: envelope segments are precomputed in samples and the
+    // level moves by a constant Q16 slope per sample inside each segment
+    uint8_t stage;                      // synth_stage_t
+    int32_t level_q16;                  // Envelope level (0-255) in Q16
+    int32_t slope_q16;                  // Per-sample change in the current stage
+    int32_t peak_q16;
+    int32_t sustain_q16;
+    uint32_t stage_end;                 // Sample index where the current stage ends
+    uint32_t attack_end;
+    uint32_t decay_end;
+    uint32_t release_start;
+    uint32_t total_samples;
+    uint32_t position;
+    uint32_t phase;                     // 32-bit accumulator, top 8 bits index the table
+    uint32_t phase_increment;
+} synth_voice_t;
+
+typedef struct {
+    synth_voice_t voices[SOUND_MAX_VOICES];
+    uint32_t serial;
+    uint8_t volume;                     // Master volume (0-255)
+} synth_mixer_t;
+
+/*===========================================================================
+ * Pre-rendered PCM Blob
+ *
+ * Layout (little-endian): sound_pcm_header_t, then `count` entries, then
+ * the unsigned 8-bit samples. Offsets are from the start of the blob.
+ *===========================================================================*/
+
+#define SOUND_PCM_MAGIC         0x4D435053u     // "SPCM"
+#define SOUND_PCM_VERSION       1
+
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+} sound_pcm_header_t;
+
+typedef struct {
+    uint8_t effect_id;
+    uint8_t reserved[3];
+    uint32_t offset;
+    uint32_t length;
+} sound_pcm_entry_t;
+
+/*===========================================================================
+ * Synth API
+ *===========================================================================*/
+
+/**
+ * @brief Reset a mixer to silence at full volume
+ */
+void synth_mixer_init(synth_mixer_t *mixer);
+
+/**
+ * @brief Silence every voice immediately
+ */
+void synth_mixer_stop_all(synth_mixer_t *mixer);
+
+/**
+ * @brief Start a timeline on a free (or the oldest) voice
+ * @param delay_ms Silence before the first note
+ */
+void synth_mixer_start_timeline(synth_mixer_t *mixer, const sound_timeline_t *timeline,
+                                uint16_t delay_ms);
+
+/**
+ * @brief Start a single tone with an explicit ADSR envelope
+ * @param envelope Envelope to use (nullptr for ADSR_BEEP)
+ * @param delay_ms Silence before the tone
+ */
+void synth_mixer_start_tone(synth_mixer_t *mixer, float frequency, uint16_t duration_ms,
+                            const adsr_envelope_t *envelope, uint16_t delay_ms);
+
+/**
+ * @brief Start playing pre-rendered samples on a voice
+ *
+ * Samples are mixed with master volume applied; @p pcm must stay valid
+ * until the voice finishes (it normally points into flash).
+ */
+void synth_mixer_start_pcm(synth_mixer_t *mixer, const uint8_t *pcm, uint32_t length,
+                           uint16_t delay_ms);
+
+/**
+ * @brief Check whether an effect renders identically every time
+ *
+ * Only these effects are baked into the PCM blob; tones and randomized
+ * effects keep being synthesized.
+ */
+bool synth_effect_is_cacheable(uint8_t effect_id);
+
+/**
+ * @brief Look up an effect in a pre-rendered PCM blob
+ * @return false if the blob is invalid or does not contain the effect
+ */
+bool synth_pcm_find(const uint8_t *blob, size_t blob_len, uint8_t effect_id,
+                    const uint8_t **pcm, uint32_t *length);
+
+/**
+ * @brief Schedule a predefined SOUND_EFFECT_* on the mixer
+ * @param seed Randomness for effects that vary between plays (water fill)
+ * @return false for an unknown effect id
+ */
+bool synth_mixer_play_effect(synth_mixer_t *mixer, uint8_t effect_id, uint32_t seed);
+
+/**
+ * @brief Render unsigned 8-bit samples (silence = 128) with all voices mixed
+ * @return true if any voice is still active after this call
+ */
+bool synth_mixer_render(synth_mixer_t *mixer, uint8_t *out, size_t count);
+
+/**
+ * @brief Check whether any voice is playing or waiting to start
+ */
+bool synth_mixer_active(const synth_mixer_t *mixer);
+
+#ifdef __cplusplus
+}
+#endif
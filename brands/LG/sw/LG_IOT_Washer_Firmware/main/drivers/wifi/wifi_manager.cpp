@@ -34,6 +34,7 @@
 #include "freertos/queue.h"
 
 #include "cJSON.h"
+#include "tasks/static_alloc.h"
 
 static const char *TAG = "wifi_mgr";
 
@@ -46,6 +47,8 @@ typedef struct {
 
 static QueueHandle_t s_wifi_evt_queue = nullptr;
 static TaskHandle_t s_wifi_evt_task = nullptr;
+static StaticQueueSlot<wifi_internal_event_t, 8> s_wifi_evt_queue_slot;
+static StaticTaskSlot<3072> s_wifi_evt_task_slot;
 
 static void wifi_event_processor_task(void *pv);
 
@@ -124,10 +127,11 @@ esp_err_t wifi_manager_init(void)
      * outside of the vendor task/callback context. This keeps callbacks
      * minimal and non-blocking. */
     if (s_wifi_evt_queue == nullptr) {
-        s_wifi_evt_queue = xQueueCreate(8, sizeof(wifi_internal_event_t));
+        s_wifi_evt_queue = create_queue(s_wifi_evt_queue_slot);
     }
     if (s_wifi_evt_task == nullptr && s_wifi_evt_queue) {
-        xTaskCreate(wifi_event_processor_task, "wifi_evt_proc", 3072, nullptr, tskIDLE_PRIORITY+3, &s_wifi_evt_task);
+        create_task(s_wifi_evt_task_slot, wifi_event_processor_task, "wifi_evt_proc", nullptr,
+                    tskIDLE_PRIORITY+3, &s_wifi_evt_task, tskNO_AFFINITY);
     }
     /* Register a lightweight esp_event handler to detect when a station
      * connects to our SoftAP. The handler only enqueues an internal event
@@ -434,6 +438,85 @@ static esp_err_t http_get_captive(httpd_req_t *req);
 
 #include "machine_state.h"
 #include "machine_state/constants.h"
+#include "tasks/tasks.h"
+#if CONFIG_RUNTIME_STATS
+#include "diagnostics/runtime_stats.h"
+#endif
+#if CONFIG_LATENCY_TRACE || CONFIG_EVENT_TRACE
+#include "diagnostics/trace.h"
+#endif
+
+#if CONFIG_RUNTIME_STATS
+static esp_err_t http_get_stats(httpd_req_t *req)
+{
+    // Static: both are too big for the httpd stack, and httpd runs one
+    // handler at a time
+    static runtime_stats_t stats;
+    static char json[3584];
+    if (!runtime_stats_get(&stats)) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "No sample yet");
+    }
+    size_t len = runtime_stats_to_json(&stats, json, sizeof(json));
+    if (len >= sizeof(json)) {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR, "Stats too large");
+    }
+    httpd_resp_set_type(req, "application/json");
+    return httpd_resp_send(req, json, len);
+}
+#endif
+
+#if CONFIG_LATENCY_TRACE || CONFIG_EVENT_TRACE
+// Batches the small dump pieces into larger HTTP chunks
+struct TraceChunkWriter {
+    httpd_req_t *req;
+    char buf[512];
+    size_t used;
+};
+
+static esp_err_t flush_trace_chunk(TraceChunkWriter *writer)
+{
+    esp_err_t ret = ESP_OK;
+    if (writer->used > 0) {
+        ret = httpd_resp_send_chunk(writer->req, writer->buf, writer->used);
+        writer->used = 0;
+    }
+    return ret;
+}
+
+static esp_err_t write_trace_chunk(void *ctx, const void *data, size_t len)
+{
+    auto *writer = static_cast<TraceChunkWriter *>(ctx);
+    if (writer->used + len > sizeof(writer->buf)) {
+        esp_err_t ret = flush_trace_chunk(writer);
+        if (ret != ESP_OK) {
+            return ret;
+        }
+    }
+    memcpy(writer->buf + writer->used, data, len);
+    writer->used += len;
+    return ESP_OK;
+}
+
+static esp_err_t http_get_trace(httpd_req_t *req)
+{
+    // Binary dump for tools/trace_decode: the latency records, then the
+    // event trace. Streamed while recording is paused; the rings are too
+    // big to copy
+    static TraceChunkWriter writer;
+    writer.req = req;
+    writer.used = 0;
+    httpd_resp_set_type(req, "application/octet-stream");
+    httpd_resp_set_hdr(req, "Content-Disposition", "attachment; filename=\"wm_trace.bin\"");
+    esp_err_t ret = trace_dump_all(write_trace_chunk, &writer);
+    if (ret == ESP_OK) {
+        ret = flush_trace_chunk(&writer);
+    }
+    if (ret != ESP_OK) {
+        return ret;
+    }
+    return httpd_resp_send_chunk(req, nullptr, 0);
+}
+#endif
 
 esp_err_t http_server_start(void)
 {
@@ -446,7 +529,7 @@ esp_err_t http_server_start(void)
     // callbacks are serviced promptly during FreeHome setup.
     config.task_priority = configMAX_PRIORITIES - 1;
     config.uri_match_fn = httpd_uri_match_wildcard;
-    config.max_uri_handlers = 10;
+    config.max_uri_handlers = 12;
     
     esp_err_t ret = httpd_start(&s_http_server, &config);
     if (ret != ESP_OK) {
@@ -467,6 +550,22 @@ esp_err_t http_server_start(void)
     uri_status.handler = http_get_status;
     httpd_register_uri_handler(s_http_server, &uri_status);
     
+#if CONFIG_RUNTIME_STATS
+    httpd_uri_t uri_stats = {};
+    uri_stats.uri = "/api/stats";
+    uri_stats.method = HTTP_GET;
+    uri_stats.handler = http_get_stats;
+    httpd_register_uri_handler(s_http_server, &uri_stats);
+#endif
+
+#if CONFIG_LATENCY_TRACE || CONFIG_EVENT_TRACE
+    httpd_uri_t uri_trace = {};
+    uri_trace.uri = "/api/trace";
+    uri_trace.method = HTTP_GET;
+    uri_trace.handler = http_get_trace;
+    httpd_register_uri_handler(s_http_server, &uri_trace);
+#endif
+
     httpd_uri_t uri_start = {};
     uri_start.uri = "/api/start";
     uri_start.method = HTTP_POST;
@@ -542,6 +641,7 @@ static esp_err_t http_get_root(httpd_req_t *req)
                        " Connect to the device AP and open your browser; the captive portal"
                        " will redirect you to the provisioning UI.</p></div>"
                        "<div><p><a href='/api/status'>View machine status</a></p></div>"
+                       "<div><p><a href='/api/stats'>View runtime statistics</a></p></div>"
                        "</body></html>";
     // Notify UI that a provisioning page was loaded so the device UI can
     // advance from the "Join AP" page to the "Waiting for credentials" page.
@@ -568,10 +668,8 @@ static esp_err_t http_get_status(httpd_req_t *req)
 
 static esp_err_t http_post_start(httpd_req_t *req)
 {
-    // Trigger start via external function
-    extern void handle_start_stop_button(void);
     if (!machine_is_running() && machine_is_powered() && !machine_is_door_open()) {
-        handle_start_stop_button();
+        tasks_post_simple_event(WM_PRODUCER_HTTP, WM_EVENT_START_BUTTON, 0);
         return httpd_resp_send(req, "{\"ok\":true}", 11);
     }
     return httpd_resp_send(req, "{\"ok\":false}", 12);
@@ -579,9 +677,8 @@ static esp_err_t http_post_start(httpd_req_t *req)
 
 static esp_err_t http_post_stop(httpd_req_t *req)
 {
-    extern void handle_start_stop_button(void);
     if (machine_is_running()) {
-        handle_start_stop_button();
+        tasks_post_simple_event(WM_PRODUCER_HTTP, WM_EVENT_START_BUTTON, 0);
         return httpd_resp_send(req, "{\"ok\":true}", 11);
     }
     return httpd_resp_send(req, "{\"ok\":false}", 12);
@@ -0,0 +1,296 @@
+/*
+ * cycle_checkpoint.cpp
+ * Power-loss-safe checkpoint of the running wash cycle
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why RTC memory plus one NVS u64:
+ * - The whole checkpoint packs into 64 bits, which NVS stores as a single
+ *   32-byte entry. NVS is already an append log: each write takes the next
+ *   free entry, and a page is only erased once all 126 of its entries are
+ *   used and its live data has been moved on. A separate partition would
+ *   need its own log and wear leveling, and the 4 MB flash has no room
+ *   left for one next to three app slots.
+ * - Wear: at the default 60 s period plus section changes a 2 h cycle
+ *   writes ~130 entries, about one page erase. The 16 KB NVS partition
+ *   rotates over its pages, so 100k erase cycles last for centuries of
+ *   daily washing. The counters logged at power off show the real rate.
+ * - Between flash writes the newest checkpoint lives in RTC_NOINIT memory,
+ *   which survives panics, watchdog resets and deep sleep. After one of
+ *   those the resume point is exact; after a real power cut it is at most
+ *   one period old.
+ * - A flash write can stall for tens of milliseconds while NVS erases a
+ *   page, so the manager only hands the word to a low-priority writer
+ *   task and never waits for the flash.
+ */
+
+#include "cycle_checkpoint.h"
+#include "tasks/static_alloc.h"
+#include "sdkconfig.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs.h"
+
+static const char *TAG = "checkpoint";
+
+#ifndef CONFIG_CYCLE_CHECKPOINT_PERIOD_S
+#define CONFIG_CYCLE_CHECKPOINT_PERIOD_S 60
+#endif
+
+#define CHECKPOINT_NAMESPACE    "wm_ckpt"
+#define CHECKPOINT_KEY          "cycle"
+#define CHECKPOINT_VERSION      1
+#define RTC_CHECK_KEY           0x57434B5054ull     // "WCKPT"
+#define NVS_ENTRIES_PER_PAGE    126
+
+// Survives resets and deep sleep; valid only while s_rtc_check matches.
+// A valid zero word means "cleared", which overrides the flash copy.
+RTC_NOINIT_ATTR static uint64_t s_rtc_word;
+RTC_NOINIT_ATTR static uint64_t s_rtc_check;
+
+static nvs_handle_t s_nvs = 0;
+static TaskHandle_t s_writer = nullptr;
+static StaticTaskSlot<3072> s_writer_slot;
+
+static bool s_have_pending = false;
+static cycle_checkpoint_t s_pending;        // From the previous run
+
+// Hand-off to the writer task (s_lock held)
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_flash_word = 0;           // 0 = erase
+static bool s_flash_dirty = false;
+
+// Manager side
+static uint64_t s_last_queued_word = 0;
+static int64_t s_last_flash_us = 0;
+
+static cycle_checkpoint_stats_t s_stats;
+
+/*===========================================================================
+ * Encoding
+ *===========================================================================*/
+
+// Bit layout, LSB first: version 3, program 4, load 2, prewash 1, rinses 2,
+// temp+1 3, spin+1 3, soil+1 3, stage 4, remaining 16, elapsed 17
+static inline uint64_t put(uint64_t value, unsigned shift, unsigned bits)
+{
+    const uint64_t mask = (1ull << bits) - 1;
+    return (value > mask ? mask : value) << shift;
+}
+
+static inline uint32_t get(uint64_t word, unsigned shift, unsigned bits)
+{
+    return (uint32_t)((word >> shift) & ((1ull << bits) - 1));
+}
+
+static uint64_t encode(const cycle_checkpoint_t &cp)
+{
+    return put(CHECKPOINT_VERSION, 0, 3) |
+           put(cp.program, 3, 4) |
+           put(cp.load_size, 7, 2) |
+           put(cp.prewash ? 1 : 0, 9, 1) |
+           put(cp.extra_rinses, 10, 2) |
+           put((uint64_t)(cp.temp_idx + 1), 12, 3) |
+           put((uint64_t)(cp.spin_idx + 1), 15, 3) |
+           put((uint64_t)(cp.soil_idx + 1), 18, 3) |
+           put(cp.stage_index, 21, 4) |
+           put(cp.remaining_seconds, 25, 16) |
+           put(cp.elapsed_seconds, 41, 17);
+}
+
+static bool decode(uint64_t word, cycle_checkpoint_t *cp)
+{
+    if (get(word, 0, 3) != CHECKPOINT_VERSION) {
+        return false;
+    }
+    cp->program = (uint8_t)get(word, 3, 4);
+    cp->load_size = (uint8_t)get(word, 7, 2);
+    cp->prewash = get(word, 9, 1) != 0;
+    cp->extra_rinses = (uint8_t)get(word, 10, 2);
+    cp->temp_idx = (int8_t)((int)get(word, 12, 3) - 1);
+    cp->spin_idx = (int8_t)((int)get(word, 15, 3) - 1);
+    cp->soil_idx = (int8_t)((int)get(word, 18, 3) - 1);
+    cp->stage_index = (uint8_t)get(word, 21, 4);
+    cp->remaining_seconds = (uint16_t)get(word, 25, 16);
+    cp->elapsed_seconds = get(word, 41, 17);
+    return true;
+}
+
+static inline void rtc_store(uint64_t word)
+{
+    s_rtc_word = word;
+    s_rtc_check = word ^ RTC_CHECK_KEY;
+}
+
+/*===========================================================================
+ * Flash Writer
+ *===========================================================================*/
+
+static void queue_flash_write(uint64_t word)
+{
+    portENTER_CRITICAL(&s_lock);
+    s_flash_word = word;
+    s_flash_dirty = true;
+    portEXIT_CRITICAL(&s_lock);
+    s_last_queued_word = word;
+    s_last_flash_us = esp_timer_get_time();
+    if (s_writer) {
+        xTaskNotifyGive(s_writer);
+    }
+}
+
+static void writer_task(void *arg)
+{
+    (void)arg;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        portENTER_CRITICAL(&s_lock);
+        const bool dirty = s_flash_dirty;
+        const uint64_t word = s_flash_word;
+        s_flash_dirty = false;
+        portEXIT_CRITICAL(&s_lock);
+        if (!dirty) {
+            continue;
+        }
+
+        const int64_t start = esp_timer_get_time();
+        esp_err_t err;
+        if (word) {
+            err = nvs_set_u64(s_nvs, CHECKPOINT_KEY, word);
+        } else {
+            err = nvs_erase_key(s_nvs, CHECKPOINT_KEY);
+            if (err == ESP_ERR_NVS_NOT_FOUND) {
+                err = ESP_OK;
+            }
+        }
+        if (err == ESP_OK) {
+            err = nvs_commit(s_nvs);
+        }
+        const uint32_t elapsed = (uint32_t)(esp_timer_get_time() - start);
+
+        portENTER_CRITICAL(&s_lock);
+        s_stats.flash_writes++;
+        s_stats.write_total_us += elapsed;
+        if (elapsed > s_stats.write_max_us) {
+            s_stats.write_max_us = elapsed;
+        }
+        portEXIT_CRITICAL(&s_lock);
+        if (err != ESP_OK) {
+            ESP_LOGW(TAG, "Flash write failed: %s", esp_err_to_name(err));
+        }
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+esp_err_t cycle_checkpoint_init(void)
+{
+    // RTC first: it is never older than the flash copy
+    uint64_t word = 0;
+    const char *source = nullptr;
+    const bool rtc_valid = s_rtc_check == (s_rtc_word ^ RTC_CHECK_KEY);
+    if (rtc_valid) {
+        word = s_rtc_word;
+        source = "RTC";
+    }
+
+    esp_err_t err = nvs_open(CHECKPOINT_NAMESPACE, NVS_READWRITE, &s_nvs);
+    if (err != ESP_OK) {
+        ESP_LOGE(TAG, "nvs_open failed: %s", esp_err_to_name(err));
+        return err;
+    }
+    uint64_t flash_word = 0;
+    if (nvs_get_u64(s_nvs, CHECKPOINT_KEY, &flash_word) == ESP_OK && !rtc_valid) {
+        word = flash_word;
+        source = "flash";
+    }
+    s_last_queued_word = flash_word;
+
+    if (word != 0 && decode(word, &s_pending)) {
+        s_have_pending = true;
+        ESP_LOGI(TAG, "Unfinished cycle in %s: program %u, section %u, %u s left",
+                 source, s_pending.program, s_pending.stage_index, s_pending.remaining_seconds);
+    }
+
+    if (create_task(s_writer_slot, writer_task, "wm_ckpt", nullptr, 1, &s_writer,
+                    tskNO_AFFINITY) != pdPASS) {
+        return ESP_ERR_NO_MEM;
+    }
+    // Cleared in RTC, but deep sleep came before the flash erase did
+    if (rtc_valid && word == 0 && flash_word != 0) {
+        queue_flash_write(0);
+    }
+    return ESP_OK;
+}
+
+bool cycle_checkpoint_pending(cycle_checkpoint_t *out)
+{
+    if (!s_have_pending) {
+        return false;
+    }
+    if (out) {
+        *out = s_pending;
+    }
+    return true;
+}
+
+void cycle_checkpoint_save(const cycle_checkpoint_t *checkpoint, bool section_changed)
+{
+    if (!checkpoint) {
+        return;
+    }
+    const uint64_t word = encode(*checkpoint);
+    rtc_store(word);
+    s_have_pending = false;     // Superseded by the running cycle
+    s_stats.saves++;
+
+    const int64_t period_us = (int64_t)CONFIG_CYCLE_CHECKPOINT_PERIOD_S * 1000000;
+    const bool due = (esp_timer_get_time() - s_last_flash_us) >= period_us;
+    if (word != s_last_queued_word && (section_changed || due)) {
+        queue_flash_write(word);
+    } else {
+        s_stats.flash_skipped++;
+    }
+}
+
+void cycle_checkpoint_clear(void)
+{
+    rtc_store(0);
+    s_have_pending = false;
+    if (s_last_queued_word != 0) {
+        queue_flash_write(0);
+    }
+}
+
+void cycle_checkpoint_get_stats(cycle_checkpoint_stats_t *out)
+{
+    if (!out) {
+        return;
+    }
+    portENTER_CRITICAL(&s_lock);
+    *out = s_stats;
+    portEXIT_CRITICAL(&s_lock);
+}
+
+void cycle_checkpoint_log_stats(void)
+{
+    cycle_checkpoint_stats_t stats;
+    cycle_checkpoint_get_stats(&stats);
+    const uint32_t avg_us = stats.flash_writes ? stats.write_total_us / stats.flash_writes : 0;
+    ESP_LOGI(TAG, "saves=%lu flash_writes=%lu rtc_only=%lu write avg=%lu us max=%lu us",
+             (unsigned long)stats.saves, (unsigned long)stats.flash_writes,
+             (unsigned long)stats.flash_skipped, (unsigned long)avg_us,
+             (unsigned long)stats.write_max_us);
+    // One NVS entry per write; a page is erased once its entries are used up
+    ESP_LOGI(TAG, "~%lu NVS page erases since boot",
+             (unsigned long)((stats.flash_writes + NVS_ENTRIES_PER_PAGE - 1) / NVS_ENTRIES_PER_PAGE));
+}
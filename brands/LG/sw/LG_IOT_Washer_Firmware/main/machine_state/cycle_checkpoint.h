@@ -0,0 +1,90 @@
+/*
+ * cycle_checkpoint.h
+ * Power-loss-safe checkpoint of the running wash cycle
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Checkpoint Contents
+ *===========================================================================*/
+
+// Everything needed to rebuild the plan and continue where the cycle was
+typedef struct {
+    uint8_t program;
+    uint8_t load_size;
+    bool prewash;
+    uint8_t extra_rinses;
+    int8_t temp_idx;            // -1 = program has no setting
+    int8_t spin_idx;
+    int8_t soil_idx;
+    uint8_t stage_index;
+    uint16_t remaining_seconds; // Left in the current section
+    uint32_t elapsed_seconds;
+} cycle_checkpoint_t;
+
+typedef struct {
+    uint32_t saves;             // cycle_checkpoint_save() calls
+    uint32_t flash_writes;      // NVS commits (saves and clears)
+    uint32_t flash_skipped;     // Saves kept in RTC memory only
+    uint32_t write_max_us;
+    uint32_t write_total_us;
+} cycle_checkpoint_stats_t;
+
+/*===========================================================================
+ * Checkpoint API
+ *
+ * Every save lands in RTC memory at once, which survives resets and deep
+ * sleep but not power loss. The flash copy (NVS) is written by a
+ * low-priority task on section changes and at most every
+ * CONFIG_CYCLE_CHECKPOINT_PERIOD_S otherwise.
+ *===========================================================================*/
+
+/**
+ * @brief Load the checkpoint left by the previous run and start the writer
+ *
+ * Call after nvs_flash_init() and before the control plane starts.
+ * @return ESP_OK, or the NVS/task error (checkpoints are then disabled)
+ */
+esp_err_t cycle_checkpoint_init(void);
+
+/**
+ * @brief Checkpoint left by a cycle that did not finish
+ * @return false if the previous run ended normally or nothing was stored
+ */
+bool cycle_checkpoint_pending(cycle_checkpoint_t *out);
+
+/**
+ * @brief Record the running cycle (manager task)
+ * @param section_changed Force a flash write (new section, start, pause)
+ */
+void cycle_checkpoint_save(const cycle_checkpoint_t *checkpoint, bool section_changed);
+
+/**
+ * @brief Forget the checkpoint (cycle finished, discarded or powered off)
+ */
+void cycle_checkpoint_clear(void);
+
+/**
+ * @brief Copy the write counters
+ */
+void cycle_checkpoint_get_stats(cycle_checkpoint_stats_t *out);
+
+/**
+ * @brief Log write counts, write time and the flash wear they imply
+ */
+void cycle_checkpoint_log_stats(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -24,9 +24,7 @@
 #include "freertos/semphr.h"
 #include "esp_log.h"
 #include <string.h>
-#if CONFIG_SIMULATOR_MODE
-#include "simulator.h"
-#endif
+#include "tasks/static_alloc.h"
 
 static const char *TAG = "machine_state";
 
@@ -40,18 +38,7 @@ static system_state_t system_state;
 static machine_state_observer_t observers[4] = {0};
 
 static SemaphoreHandle_t state_mutex = nullptr;
-
-#if CONFIG_SIMULATOR_MODE
-static inline void snapshot_motor_state(int *target_rpm, float *current_rpm, bool *direction_ccw)
-{
-    if (!target_rpm || !current_rpm || !direction_ccw) {
-        return;
-    }
-    *target_rpm = motor_state.target_rpm;
-    *current_rpm = motor_state.current_rpm;
-    *direction_ccw = motor_state.direction_ccw;
-}
-#endif
+static StaticMutexSlot s_state_mutex_slot;
 
 /*===========================================================================
  * Initialization
@@ -59,7 +46,7 @@ static inline void snapshot_motor_state(int *target_rpm, float *current_rpm, boo
 
 esp_err_t machine_state_init(void)
 {
-    state_mutex = xSemaphoreCreateMutex();
+    state_mutex = create_mutex(s_state_mutex_slot);
     if (state_mutex == nullptr) {
         ESP_LOGE(TAG, "Failed to create state mutex");
         return ESP_FAIL;
@@ -206,21 +193,10 @@ void machine_get_observable_state(machine_observable_state_t *out_state)
  *===========================================================================*/
 
 void machine_set_target_rpm(int rpm) {
-#if CONFIG_SIMULATOR_MODE
-    int snapshot_target = 0;
-    float snapshot_current = 0.0f;
-    bool snapshot_dir = false;
-#endif
     LOCK_STATE();
     motor_state.target_rpm = rpm;
-#if CONFIG_SIMULATOR_MODE
-    snapshot_motor_state(&snapshot_target, &snapshot_current, &snapshot_dir);
-#endif
     UNLOCK_STATE();
     notify_observers();
-#if CONFIG_SIMULATOR_MODE
-    simulator_send_motor_state(snapshot_target, snapshot_current, snapshot_dir);
-#endif
 }
 
 int machine_get_target_rpm(void) {
@@ -231,21 +207,10 @@ int machine_get_target_rpm(void) {
 }
 
 void machine_set_current_rpm(float rpm) {
-#if CONFIG_SIMULATOR_MODE
-    int snapshot_target = 0;
-    float snapshot_current = 0.0f;
-    bool snapshot_dir = false;
-#endif
     LOCK_STATE();
     motor_state.current_rpm = rpm;
-#if CONFIG_SIMULATOR_MODE
-    snapshot_motor_state(&snapshot_target, &snapshot_current, &snapshot_dir);
-#endif
     UNLOCK_STATE();
     notify_observers();
-#if CONFIG_SIMULATOR_MODE
-    simulator_send_motor_state(snapshot_target, snapshot_current, snapshot_dir);
-#endif
 }
 
 float machine_get_current_rpm(void) {
@@ -256,21 +221,10 @@ float machine_get_current_rpm(void) {
 }
 
 void machine_set_motor_dir(bool ccw) {
-#if CONFIG_SIMULATOR_MODE
-    int snapshot_target = 0;
-    float snapshot_current = 0.0f;
-    bool snapshot_dir = false;
-#endif
     LOCK_STATE();
     motor_state.direction_ccw = ccw;
-#if CONFIG_SIMULATOR_MODE
-    snapshot_motor_state(&snapshot_target, &snapshot_current, &snapshot_dir);
-#endif
     UNLOCK_STATE();
     notify_observers();
-#if CONFIG_SIMULATOR_MODE
-    simulator_send_motor_state(snapshot_target, snapshot_current, snapshot_dir);
-#endif
 }
 
 bool machine_get_motor_dir(void) {
@@ -391,6 +345,13 @@ void machine_set_elapsed_seconds(int seconds) {
     notify_observers();
 }
 
+int machine_get_elapsed_seconds(void) {
+    LOCK_STATE_RET(0);
+    int val = program_state.elapsed_seconds;
+    UNLOCK_STATE();
+    return val;
+}
+
 void machine_set_eta_available(bool available) {
     LOCK_STATE();
     program_state.eta_available = available;
@@ -103,6 +103,7 @@ void machine_set_eta(int seconds);
 int machine_get_eta(void);
 void machine_increment_elapsed(void);
 void machine_set_elapsed_seconds(int seconds);
+int machine_get_elapsed_seconds(void);
 void machine_set_eta_available(bool available);
 bool machine_is_eta_available(void);
 void machine_set_prewash_enabled(bool enabled);
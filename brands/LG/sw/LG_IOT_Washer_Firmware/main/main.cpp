@@ -35,8 +35,20 @@
 #include "odrive.h"
 #include "sound.h"
 #include "tasks.h"
+#if CONFIG_DIAL_ENCODER
+#include "encoder.h"
+#include "drivers/led_ring.h"
+#endif
 #if CONFIG_SIMULATOR_MODE
 #include "simulator.h"
+#include "sim_plant.h"
+#endif
+#if CONFIG_RUNTIME_STATS
+#include "runtime_stats.h"
+#endif
+#include "heap_report.h"
+#if CONFIG_CYCLE_CHECKPOINT
+#include "cycle_checkpoint.h"
 #endif
 #if CONFIG_WIFI_ENABLED
 #include "drivers/wifi/wifi_manager.h"
@@ -47,24 +59,6 @@ static const char *TAG = "main";
 static bool s_woke_from_ulp = false;
 static uint32_t s_ulp_edge_count = 0;
 
-void handle_power_button(void)
-{
-    ESP_LOGI(TAG, "Power button pressed");
-    tasks_post_simple_event(WM_EVENT_POWER_BUTTON, 0);
-}
-
-void handle_start_stop_button(void)
-{
-    ESP_LOGI(TAG, "Start/Stop button pressed");
-    tasks_post_simple_event(WM_EVENT_START_BUTTON, 0);
-}
-
-void handle_start_stop_long_press(void)
-{
-    ESP_LOGI(TAG, "Start/Stop button long pressed");
-    tasks_post_simple_event(WM_EVENT_START_LONG_PRESS, 0);
-}
-
 static void init_nvs(void)
 {
     esp_err_t ret = nvs_flash_init();
@@ -88,6 +82,9 @@ static void init_peripherals(void)
 #else
     ESP_LOGI(TAG, "Balance detection disabled; skipping MPU6050 init");
 #endif
+#if CONFIG_DIAL_ENCODER
+    program_dial_leds_init();
+#endif
 }
 
 #if CONFIG_SIMULATOR_MODE
@@ -96,9 +93,10 @@ static void simulator_draw_rect_cb(int16_t x, int16_t y, int16_t w, int16_t h, u
     simulator_send_draw_rect(x, y, w, h, color);
 }
 
-static void simulator_draw_bitmap_cb(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data)
+static void simulator_draw_bitmap_cb(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                                     const uint16_t *previous)
 {
-    simulator_send_bitmap(x, y, w, h, data);
+    simulator_send_bitmap(x, y, w, h, data, previous);
 }
 
 static void init_simulator_hooks(void)
@@ -116,6 +114,19 @@ static void init_simulator_hooks(void)
 static inline void init_simulator_hooks(void) {}
 #endif
 
+#if CONFIG_SIM_PLANT
+// Before the peripherals: the MPU6050 probes the plant at init instead of the bus
+static void init_plant(void)
+{
+    // Without it the drum reaches any speed at once and the pumps move no water
+    if (sim_plant_start(nullptr) != ESP_OK) {
+        ESP_LOGW(TAG, "Plant model unavailable");
+    }
+}
+#else
+static inline void init_plant(void) {}
+#endif
+
 extern "C" void app_main(void)
 {   
     ESP_LOGI(TAG, "Booting LG washer controller");
@@ -151,6 +162,12 @@ extern "C" void app_main(void)
     init_nvs();
     ESP_ERROR_CHECK(esp_event_loop_create_default());  
     ESP_ERROR_CHECK(machine_state_init());
+#if CONFIG_CYCLE_CHECKPOINT
+    // Before the control plane starts so power-on can offer a resume
+    if (cycle_checkpoint_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Cycle checkpoints unavailable");
+    }
+#endif
     // Initialize FreeHome manager and only initialize WiFi if FreeHome is enabled
 #if CONFIG_WIFI_ENABLED
     // Initialize FreeHome first (reads persisted state from NVS)
@@ -167,16 +184,30 @@ extern "C" void app_main(void)
         ESP_LOGI(TAG, "FreeHome disabled; skipping WiFi init at boot");
     }
 #endif 
+    init_plant();
     init_peripherals();
     init_simulator_hooks();
 
     ESP_ERROR_CHECK(tasks_create_all());
+#if CONFIG_DIAL_ENCODER
+    // Posts into the event queue; the machine runs without the dial
+    if (encoder_init() != ESP_OK) {
+        ESP_LOGW(TAG, "Dial encoder unavailable");
+    }
+#endif
+#if CONFIG_RUNTIME_STATS
+    // Telemetry only; the machine runs without it
+    if (runtime_stats_start() != ESP_OK) {
+        ESP_LOGW(TAG, "Runtime statistics unavailable");
+    }
+#endif
+    heap_report_mark_boot();
     // Keep the ULP program running so we can re-enter deep sleep when powering off
 
     ESP_ERROR_CHECK(ulp_power_arm());
     if (s_woke_from_ulp && s_ulp_edge_count > 0) {
         // Mirror a power-button press into the existing event flow
-        tasks_post_simple_event(WM_EVENT_POWER_BUTTON, 0);
+        tasks_post_simple_event(WM_PRODUCER_SYSTEM, WM_EVENT_POWER_BUTTON, 0);
     }
     ESP_LOGI(TAG, "Main task idling; control plane active");
     while (true) {
@@ -0,0 +1,431 @@
+/*
+ * sim_plant.cpp
+ * Physical model of the drum, water and pumps for simulator mode
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why a plant model instead of the instant ODrive stub:
+ * - The stub set the drum speed to the target at once and the pumps moved
+ *   no water, so nothing closed-loop (fill detection, ramps, imbalance
+ *   handling) could be tried without the machine. The model follows the
+ *   same inputs the hardware does: the ODrive velocity setpoint and the
+ *   LEDC duty of the fill and drain pumps, read back from the peripheral
+ *   so fades count too.
+ * - It answers through the same APIs as the hardware: the drum speed
+ *   through machine_set_current_rpm() as the encoder would, velocity and
+ *   Iq through odrive_get_velocity()/odrive_get_current(), and the tub
+ *   acceleration through the MPU6050 registers. Code developed against it
+ *   runs on the machine unchanged.
+ * - State is advanced lazily to the current time in fixed 2 ms steps, so
+ *   readers always see the present and the publishing task only sets the
+ *   update rate of the UI, not the accuracy.
+ *
+ * Model:
+ * - The ODrive velocity loop is a PI controller limited by torque and by
+ *   power, so heavier or wetter loads ramp slower and draw more current.
+ * - While the load tumbles, half its mass turns with the drum and lifting
+ *   it costs torque. Once the centripetal acceleration exceeds 1 g the
+ *   load plasters: all of it turns with the drum, and an unbalanced mass is
+ *   drawn (mostly small, sometimes up to max_imbalance_kg). It falls apart
+ *   again below 0.8 g.
+ * - The laundry soaks up free water up to absorb_ratio and spinning wrings
+ *   it out again, so a spin drains water that a fill put in minutes before.
+ * - The unbalanced mass shakes the suspended tub like a driven
+ *   mass-spring-damper; the amplitude peaks at suspension_hz and the
+ *   acceleration keeps growing with speed above it.
+ */
+
+#include "sim_plant.h"
+#include "app_config.h"
+#include "machine_state.h"
+#include "tasks/static_alloc.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include "driver/ledc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+
+static const char *TAG = "sim_plant";
+
+#define PLANT_STEP_US           2000        // Integration step
+#define PLANT_MAX_STEPS         1000        // Per advance; longer gaps use longer steps
+#define PLANT_PUBLISH_MS        50          // Drum speed updates to machine_state
+#define PLANT_DUTY_MAX          4095.0f     // LEDC_DUTY_RES
+#define GRAVITY                 9.81f
+#define TWO_PI                  6.2831853f
+#define TUMBLE_LIFT             0.3f        // Share of the tumbling weight the drum lifts
+#define SOAK_TIME_S             30.0f       // Time constant of the laundry soaking up water
+#define WRING_TIME_S            5.0f        // ... and of a spin wringing it out
+#define WRING_G                 100.0f      // G-force that halves the water the laundry holds
+#define SENSOR_NOISE_G          0.01f
+
+/*===========================================================================
+ * State Variables
+ *===========================================================================*/
+
+static sim_plant_config_t s_config;
+static SemaphoreHandle_t s_mutex = nullptr;
+static StaticMutexSlot s_mutex_slot;
+static StaticTaskSlot<3072> s_task_slot;
+
+static struct {
+    int64_t time_us;            // Advanced up to here
+    float omega;                // rad/s
+    float theta;                // rad
+    float target_omega;
+    float integrator;           // N m
+    float torque;
+    bool enabled;
+    bool plastered;
+    float forced_imbalance_kg;  // < 0: drawn at random
+    float imbalance_kg;
+    float imbalance_phase;
+    float water_l;
+    float absorbed_l;
+    bool overflowed;
+    uint32_t imbalance_rng;
+    uint32_t noise_rng;         // Separate, so sampling does not change the draws
+} s_plant;
+
+/*===========================================================================
+ * Model
+ *===========================================================================*/
+
+// xorshift32; the draws repeat for a seed
+static float random_unit(uint32_t &state)
+{
+    uint32_t x = state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    state = x;
+    return (float)(x >> 8) / 16777216.0f;
+}
+
+static inline float sign_of(float v)
+{
+    return v > 0.0f ? 1.0f : (v < 0.0f ? -1.0f : 0.0f);
+}
+
+static inline float clampf(float v, float lo, float hi)
+{
+    return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static float g_force(float omega)
+{
+    return omega * omega * s_config.drum_radius / GRAVITY;
+}
+
+static float wet_load_kg(void)
+{
+    return s_config.load_kg + s_plant.absorbed_l;
+}
+
+static float inertia(void)
+{
+    const float r2 = s_config.drum_radius * s_config.drum_radius;
+    return s_config.drum_inertia + wet_load_kg() * r2 * (s_plant.plastered ? 1.0f : 0.5f);
+}
+
+// ODrive velocity loop: PI, clamped to the torque and power limits, with
+// the integrator held while clamped
+static float motor_torque(float dt)
+{
+    if (!s_plant.enabled) {
+        s_plant.integrator = 0.0f;
+        return 0.0f;
+    }
+    const float error = s_plant.target_omega - s_plant.omega;
+    const float integrator = s_plant.integrator + s_config.velocity_integrator_gain * error * dt;
+    float limit = s_config.torque_limit;
+    const float speed = fabsf(s_plant.omega);
+    if (speed * limit > s_config.power_limit) {
+        limit = s_config.power_limit / speed;
+    }
+    const float demand = s_config.velocity_gain * error + integrator;
+    const float torque = clampf(demand, -limit, limit);
+    if (torque == demand) {
+        s_plant.integrator = clampf(integrator, -limit, limit);
+    }
+    return torque;
+}
+
+static void update_load(float fill, float drain, float dt)
+{
+    const float gf = g_force(s_plant.omega);
+    if (!s_plant.plastered && gf > 1.0f) {
+        s_plant.plastered = true;
+        if (s_plant.forced_imbalance_kg >= 0.0f) {
+            s_plant.imbalance_kg = s_plant.forced_imbalance_kg;
+        } else {
+            const float u = random_unit(s_plant.imbalance_rng);
+            s_plant.imbalance_kg = s_config.max_imbalance_kg * u * u;
+        }
+        s_plant.imbalance_phase = TWO_PI * random_unit(s_plant.imbalance_rng);
+    } else if (s_plant.plastered && gf < 0.8f) {
+        s_plant.plastered = false;
+        s_plant.imbalance_kg = 0.0f;
+    }
+
+    s_plant.water_l += fill * s_config.fill_flow_lpm / 60.0f * dt;
+    if (s_plant.water_l > s_config.capacity_l) {
+        s_plant.water_l = s_config.capacity_l;
+        s_plant.overflowed = true;
+    }
+    s_plant.water_l -= fminf(s_plant.water_l, drain * s_config.drain_flow_lpm / 60.0f * dt);
+
+    // Laundry soaks while there is free water and is wrung out by spinning
+    const float hold = s_config.load_kg * s_config.absorb_ratio / (1.0f + gf / WRING_G);
+    if (s_plant.absorbed_l < hold) {
+        const float soak = fminf((hold - s_plant.absorbed_l) * dt / SOAK_TIME_S, s_plant.water_l);
+        s_plant.absorbed_l += soak;
+        s_plant.water_l -= soak;
+    } else {
+        const float wrung = (s_plant.absorbed_l - hold) * fminf(dt / WRING_TIME_S, 1.0f);
+        s_plant.absorbed_l -= wrung;
+        s_plant.water_l += wrung;
+    }
+}
+
+// fill and drain are pump duties from 0 to 1
+static void step(float fill, float drain, float dt)
+{
+    update_load(fill, drain, dt);
+
+    const float torque = motor_torque(dt);
+    const float r = s_config.drum_radius;
+    // Losses that grow with speed, and those that act like dry friction
+    const float viscous = (s_config.viscous_friction + s_config.water_drag * s_plant.water_l) * s_plant.omega;
+    float dry = s_config.coulomb_friction;
+    if (!s_plant.plastered) {
+        dry += TUMBLE_LIFT * wet_load_kg() * GRAVITY * r;
+    }
+    float drive = torque - viscous;
+    if (s_plant.plastered) {
+        // The unbalanced mass is lifted on one side and falls on the other
+        drive -= s_plant.imbalance_kg * GRAVITY * r * cosf(s_plant.theta + s_plant.imbalance_phase);
+    }
+
+    const float j = inertia();
+    if (s_plant.omega == 0.0f && fabsf(drive) <= dry) {
+        // Stuck until the drive beats dry friction
+    } else {
+        const float moving = s_plant.omega != 0.0f ? sign_of(s_plant.omega) : sign_of(drive);
+        const float omega = s_plant.omega + (drive - dry * moving) / j * dt;
+        // Dry friction stops the drum; it never reverses it
+        s_plant.omega = (s_plant.omega != 0.0f && sign_of(omega) != sign_of(s_plant.omega)) ? 0.0f : omega;
+    }
+    s_plant.theta = fmodf(s_plant.theta + s_plant.omega * dt, TWO_PI);
+    s_plant.torque = torque;
+}
+
+static void advance(void)
+{
+    const int64_t now = esp_timer_get_time();
+    const int64_t gap = now - s_plant.time_us;
+    if (gap <= 0) {
+        return;
+    }
+    int64_t steps = (gap + PLANT_STEP_US - 1) / PLANT_STEP_US;
+    if (steps > PLANT_MAX_STEPS) {
+        steps = PLANT_MAX_STEPS;
+    }
+    const float dt = (float)gap / (float)steps * 1e-6f;
+    // Duty read back from LEDC, so soft starts are included
+    const float fill = ledc_get_duty(LEDC_MODE, LEDC_CH_FILL) / PLANT_DUTY_MAX;
+    const float drain = ledc_get_duty(LEDC_MODE, LEDC_CH_DRAIN) / PLANT_DUTY_MAX;
+    for (int64_t i = 0; i < steps; i++) {
+        step(fill, drain, dt);
+    }
+    s_plant.time_us = now;
+}
+
+// Peak tub acceleration: the force of the unbalanced mass through the
+// suspension's frequency response, times the square of the drum speed
+static float vibration_g(void)
+{
+    if (s_plant.imbalance_kg <= 0.0f) {
+        return 0.0f;
+    }
+    const float w = s_plant.omega;
+    const float wn = TWO_PI * s_config.suspension_hz;
+    const float mass = s_config.tub_mass_kg + wet_load_kg() + s_plant.water_l;
+    const float force = s_plant.imbalance_kg * s_config.drum_radius * w * w;
+    const float ratio = fabsf(w) / wn;
+    const float a = 1.0f - ratio * ratio;
+    const float b = 2.0f * s_config.suspension_damping * ratio;
+    const float displacement = force / (mass * wn * wn) / sqrtf(a * a + b * b);
+    return displacement * w * w / GRAVITY;
+}
+
+/*===========================================================================
+ * Publishing
+ *===========================================================================*/
+
+static void plant_task(void *arg)
+{
+    (void)arg;
+    int published_rpm = -1;
+    TickType_t last = xTaskGetTickCount();
+    while (true) {
+        vTaskDelayUntil(&last, pdMS_TO_TICKS(PLANT_PUBLISH_MS));
+        xSemaphoreTake(s_mutex, portMAX_DELAY);
+        advance();
+        const int rpm = (int)lroundf(fabsf(s_plant.omega) * 60.0f / TWO_PI);
+        xSemaphoreGive(s_mutex);
+        // The encoder reads the speed; the direction is the commanded one
+        if (rpm != published_rpm) {
+            published_rpm = rpm;
+            machine_set_current_rpm((float)rpm);
+        }
+    }
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+void sim_plant_default_config(sim_plant_config_t *config)
+{
+    config->drum_inertia = 0.35f;
+    config->drum_radius = 0.25f;
+    config->torque_limit = 35.0f;
+    config->power_limit = 600.0f;
+    config->torque_constant = 1.2f;
+    config->velocity_gain = 4.0f;
+    config->velocity_integrator_gain = 20.0f;
+    config->viscous_friction = 0.01f;
+    config->coulomb_friction = 0.4f;
+    config->water_drag = 0.02f;
+    config->load_kg = 4.0f;
+    config->absorb_ratio = 2.0f;
+    config->fill_flow_lpm = 12.0f;
+    config->drain_flow_lpm = 25.0f;
+    config->capacity_l = 25.0f;
+    config->max_imbalance_kg = 0.3f;
+    config->tub_mass_kg = 40.0f;
+    config->suspension_hz = 4.5f;
+    config->suspension_damping = 0.12f;
+    config->seed = 1;
+}
+
+esp_err_t sim_plant_start(const sim_plant_config_t *config)
+{
+    if (s_mutex) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (config) {
+        s_config = *config;
+    } else {
+        sim_plant_default_config(&s_config);
+    }
+    memset(&s_plant, 0, sizeof(s_plant));
+    s_plant.time_us = esp_timer_get_time();
+    s_plant.enabled = true;     // The ODrive starts up in closed loop
+    s_plant.forced_imbalance_kg = -1.0f;
+    s_plant.imbalance_rng = s_config.seed ? s_config.seed : 1;
+    s_plant.noise_rng = s_plant.imbalance_rng ^ 0x9E3779B9u;
+
+    s_mutex = create_mutex(s_mutex_slot);
+    if (s_mutex == nullptr) {
+        ESP_LOGE(TAG, "Failed to create mutex");
+        return ESP_ERR_NO_MEM;
+    }
+    if (create_task(s_task_slot, plant_task, "sim_plant", nullptr, 3, nullptr, 0) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create plant task");
+        return ESP_FAIL;
+    }
+    ESP_LOGI(TAG, "Plant model running (%.1f kg load)", s_config.load_kg);
+    return ESP_OK;
+}
+
+bool sim_plant_is_running(void)
+{
+    return s_mutex != nullptr;
+}
+
+void sim_plant_set_velocity(float turns_per_sec)
+{
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    advance();
+    s_plant.target_omega = turns_per_sec * TWO_PI;
+    xSemaphoreGive(s_mutex);
+}
+
+void sim_plant_set_motor_enabled(bool enabled)
+{
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    advance();
+    s_plant.enabled = enabled;
+    xSemaphoreGive(s_mutex);
+}
+
+void sim_plant_set_load(float kg)
+{
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    advance();
+    s_config.load_kg = kg > 0.0f ? kg : 0.0f;
+    xSemaphoreGive(s_mutex);
+}
+
+void sim_plant_set_imbalance(float kg)
+{
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    advance();
+    s_plant.forced_imbalance_kg = kg;
+    if (s_plant.plastered && kg >= 0.0f) {
+        s_plant.imbalance_kg = kg;
+    }
+    xSemaphoreGive(s_mutex);
+}
+
+void sim_plant_get_state(sim_plant_state_t *state)
+{
+    memset(state, 0, sizeof(*state));
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    advance();
+    state->velocity_rpm = s_plant.omega * 60.0f / TWO_PI;
+    state->target_rpm = s_plant.target_omega * 60.0f / TWO_PI;
+    state->torque = s_plant.torque;
+    state->current = s_plant.torque / s_config.torque_constant;
+    state->water_l = s_plant.water_l;
+    state->absorbed_l = s_plant.absorbed_l;
+    state->imbalance_kg = s_plant.imbalance_kg;
+    state->vibration_g = vibration_g();
+    state->motor_enabled = s_plant.enabled;
+    state->overflowed = s_plant.overflowed;
+    xSemaphoreGive(s_mutex);
+}
+
+void sim_plant_read_accel(float accel_g[3])
+{
+    accel_g[0] = 0.0f;
+    accel_g[1] = 0.0f;
+    accel_g[2] = 1.0f;
+    if (!s_mutex) return;
+    xSemaphoreTake(s_mutex, portMAX_DELAY);
+    advance();
+    // The tub moves in the plane across the drum axis: X and the vertical Z
+    const float peak = vibration_g();
+    const float angle = s_plant.theta + s_plant.imbalance_phase;
+    accel_g[0] = peak * cosf(angle);
+    accel_g[2] = 1.0f + peak * sinf(angle);
+    for (int i = 0; i < 3; i++) {
+        accel_g[i] += SENSOR_NOISE_G * (2.0f * random_unit(s_plant.noise_rng) - 1.0f);
+    }
+    xSemaphoreGive(s_mutex);
+}
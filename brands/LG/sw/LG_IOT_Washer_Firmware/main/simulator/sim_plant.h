@@ -0,0 +1,118 @@
+/*
+ * sim_plant.h
+ * Physical model of the drum, water and pumps for simulator mode
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*===========================================================================
+ * Configuration
+ *===========================================================================*/
+
+typedef struct {
+    // Drum and motor
+    float drum_inertia;         // kg m^2, empty drum and rotor
+    float drum_radius;          // m
+    float torque_limit;         // N m at the drum
+    float power_limit;          // W
+    float torque_constant;      // N m per A, for the reported motor current
+    float velocity_gain;        // N m per rad/s, ODrive vel_gain
+    float velocity_integrator_gain; // N m per rad, ODrive vel_integrator_gain
+    float viscous_friction;     // N m per rad/s
+    float coulomb_friction;     // N m
+    float water_drag;           // N m per rad/s, per litre of free water
+    // Load and water
+    float load_kg;              // Dry laundry
+    float absorb_ratio;         // Litres the laundry holds per dry kg when soaked
+    float fill_flow_lpm;        // At full fill pump duty
+    float drain_flow_lpm;       // At full drain pump duty
+    float capacity_l;           // Free water the tub holds before it overflows
+    // Imbalance and suspension
+    float max_imbalance_kg;     // Largest unbalanced mass drawn when the load plasters
+    float tub_mass_kg;          // Suspended tub, drum and counterweights
+    float suspension_hz;        // Natural frequency of the suspended tub
+    float suspension_damping;   // Damping ratio
+    uint32_t seed;              // For the imbalance draws and sensor noise
+} sim_plant_config_t;
+
+typedef struct {
+    float velocity_rpm;         // Drum, signed like the ODrive velocity
+    float target_rpm;           // Velocity setpoint
+    float torque;               // Motor torque at the drum, N m
+    float current;              // Motor current, A
+    float water_l;              // Free water in the tub
+    float absorbed_l;           // Water held by the laundry
+    float imbalance_kg;         // Unbalanced mass; zero while the load tumbles
+    float vibration_g;          // Peak acceleration of the tub
+    bool motor_enabled;         // Axis in closed loop; idle coasts
+    bool overflowed;            // Fill ran past capacity since start
+} sim_plant_state_t;
+
+/**
+ * @brief Fill @p config with a front loader of about 8 kg capacity
+ */
+void sim_plant_default_config(sim_plant_config_t *config);
+
+/*===========================================================================
+ * API
+ *===========================================================================*/
+
+/**
+ * @brief Start the model and the task that publishes the drum speed
+ * @param config Plant parameters, or nullptr for the defaults
+ * @return ESP_OK on success
+ *
+ * Until started, the ODrive stub answers velocity commands instantly.
+ */
+esp_err_t sim_plant_start(const sim_plant_config_t *config);
+
+/**
+ * @brief Check if the model runs
+ */
+bool sim_plant_is_running(void);
+
+/**
+ * @brief Set the velocity setpoint (turns per second), as the ODrive does
+ */
+void sim_plant_set_velocity(float turns_per_sec);
+
+/**
+ * @brief Put the axis in closed loop (true) or idle, where the drum coasts
+ */
+void sim_plant_set_motor_enabled(bool enabled);
+
+/**
+ * @brief Change the dry load in the drum
+ */
+void sim_plant_set_load(float kg);
+
+/**
+ * @brief Fix the unbalanced mass used whenever the load plasters
+ * @param kg Mass in kg, or a negative value to draw it at random again
+ */
+void sim_plant_set_imbalance(float kg);
+
+/**
+ * @brief Get the model state at the current time
+ */
+void sim_plant_get_state(sim_plant_state_t *state);
+
+/**
+ * @brief Sample the tub accelerometer at the current time
+ * @param[out] accel_g X, Y and Z in g; Z carries gravity
+ */
+void sim_plant_read_accel(float accel_g[3]);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,258 @@
+/*
+ * sim_protocol.cpp
+ * Binary framing of the simulator link and the delta coding of bitmaps
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why COBS frames instead of "$" lines and raw bitmaps:
+ * - A raw 40 KB bitmap after a "$b" header is only found again by reading
+ *   exactly the announced length; one lost byte shifted every later
+ *   command, and text could not be told from pixels. A COBS frame never
+ *   contains 0x00, so the delimiter alone finds the next frame, and the
+ *   CRC drops a damaged one instead of drawing it.
+ * - Framing streams: the writer holds one 255-byte COBS block, so a full
+ *   bitmap needs no frame-sized buffer.
+ *
+ * Why bitmaps are XOR runs against the previous frame:
+ * - Between two frames the UI changes a few digits of the ETA or one
+ *   icon, so most XORed words are zero and a frame shrinks from 40 KB to
+ *   tens of bytes. Flat areas of a key frame collapse into repeat runs.
+ * - A delta names the sequence number of its reference. A host that
+ *   missed that frame asks for a key frame instead of drawing garbage.
+ */
+
+#include "sim_protocol.h"
+
+#include <string.h>
+
+/*===========================================================================
+ * CRC
+ *===========================================================================*/
+
+struct CrcTable {
+    uint16_t v[256];
+};
+
+static constexpr CrcTable make_crc_table()
+{
+    CrcTable table = {};
+    for (int i = 0; i < 256; i++) {
+        uint16_t crc = (uint16_t)(i << 8);
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+        table.v[i] = crc;
+    }
+    return table;
+}
+
+static constexpr CrcTable s_crc_table = make_crc_table();
+
+static inline uint16_t crc_update(uint16_t crc, uint8_t byte)
+{
+    return (uint16_t)((crc << 8) ^ s_crc_table.v[(crc >> 8) ^ byte]);
+}
+
+/*===========================================================================
+ * Writing
+ *===========================================================================*/
+
+static void flush_block(sim_frame_writer_t *writer)
+{
+    writer->block[0] = writer->block_len;
+    writer->write(writer->ctx, writer->block, writer->block_len);
+    writer->block_len = 1;
+}
+
+// COBS: each block is a code byte (its length) and up to 254 non-zero
+// bytes; a block shorter than 255 stands for a 0x00 after it
+static void put_encoded(sim_frame_writer_t *writer, uint8_t byte)
+{
+    if (byte == 0) {
+        flush_block(writer);
+        return;
+    }
+    writer->block[writer->block_len++] = byte;
+    if (writer->block_len == 255) {
+        flush_block(writer);
+    }
+}
+
+void sim_frame_begin(sim_frame_writer_t *writer, sim_write_fn write, void *ctx,
+                     sim_msg_type_t type, uint8_t sequence)
+{
+    static const uint8_t delimiter = SIM_FRAME_DELIMITER;
+    writer->write = write;
+    writer->ctx = ctx;
+    writer->crc = 0xFFFF;
+    writer->block_len = 1;
+    write(ctx, &delimiter, 1);
+    sim_frame_put_u8(writer, (uint8_t)type);
+    sim_frame_put_u8(writer, sequence);
+}
+
+void sim_frame_put(sim_frame_writer_t *writer, const void *data, size_t len)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < len; i++) {
+        writer->crc = crc_update(writer->crc, bytes[i]);
+        put_encoded(writer, bytes[i]);
+    }
+}
+
+void sim_frame_put_u8(sim_frame_writer_t *writer, uint8_t value)
+{
+    sim_frame_put(writer, &value, 1);
+}
+
+void sim_frame_put_i16(sim_frame_writer_t *writer, int16_t value)
+{
+    const uint8_t bytes[2] = { (uint8_t)value, (uint8_t)((uint16_t)value >> 8) };
+    sim_frame_put(writer, bytes, sizeof(bytes));
+}
+
+static void put_run(sim_frame_writer_t *writer, sim_run_op_t op, size_t count)
+{
+    uint32_t value = (uint32_t)(count << 2) | (uint32_t)op;
+    while (value >= 0x80) {
+        sim_frame_put_u8(writer, (uint8_t)(value | 0x80));
+        value >>= 7;
+    }
+    sim_frame_put_u8(writer, (uint8_t)value);
+}
+
+void sim_frame_put_bitmap_runs(sim_frame_writer_t *writer, const uint16_t *data,
+                               const uint16_t *reference, size_t words)
+{
+    auto word = [data, reference](size_t i) -> uint16_t {
+        return reference ? (uint16_t)(data[i] ^ reference[i]) : data[i];
+    };
+    size_t i = 0;
+    while (i < words) {
+        const uint16_t value = word(i);
+        size_t end = i + 1;
+        while (end < words && word(end) == value) {
+            end++;
+        }
+        if (value == 0) {
+            if (end == words) {
+                break;              // Unchanged to the end
+            }
+            put_run(writer, SIM_RUN_SKIP, end - i);
+        } else if (end - i >= 3) {
+            put_run(writer, SIM_RUN_REPEAT, end - i);
+            sim_frame_put(writer, &value, sizeof(value));
+        } else {
+            // Literal up to the next unchanged word or run of three
+            end = i + 1;
+            while (end < words) {
+                const uint16_t next = word(end);
+                if (next == 0 ||
+                    (end + 2 < words && word(end + 1) == next && word(end + 2) == next)) {
+                    break;
+                }
+                end++;
+            }
+            put_run(writer, SIM_RUN_LITERAL, end - i);
+            for (size_t k = i; k < end; k++) {
+                const uint16_t literal = word(k);
+                sim_frame_put(writer, &literal, sizeof(literal));
+            }
+        }
+        i = end;
+    }
+}
+
+void sim_frame_end(sim_frame_writer_t *writer)
+{
+    static const uint8_t delimiter = SIM_FRAME_DELIMITER;
+    const uint16_t crc = writer->crc;
+    put_encoded(writer, (uint8_t)crc);
+    put_encoded(writer, (uint8_t)(crc >> 8));
+    flush_block(writer);
+    writer->write(writer->ctx, &delimiter, 1);
+}
+
+/*===========================================================================
+ * Reading
+ *===========================================================================*/
+
+static void reader_restart(sim_frame_reader_t *reader)
+{
+    reader->len = 0;
+    reader->left = 0;
+    reader->started = false;
+    reader->zero_pending = false;
+    reader->overflow = false;
+}
+
+void sim_frame_reader_init(sim_frame_reader_t *reader, uint8_t *buf, size_t cap)
+{
+    reader->buf = buf;
+    reader->cap = cap;
+    reader->in_frame = false;
+    reader_restart(reader);
+}
+
+static void reader_append(sim_frame_reader_t *reader, uint8_t byte)
+{
+    if (reader->len < reader->cap) {
+        reader->buf[reader->len++] = byte;
+    } else {
+        reader->overflow = true;
+    }
+}
+
+static bool reader_complete(sim_frame_reader_t *reader, sim_frame_t *frame)
+{
+    if (!reader->started || reader->left != 0 || reader->overflow ||
+        reader->len < SIM_FRAME_OVERHEAD) {
+        return false;
+    }
+    const size_t body = reader->len - 2;
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < body; i++) {
+        crc = crc_update(crc, reader->buf[i]);
+    }
+    if (crc != (uint16_t)(reader->buf[body] | (reader->buf[body + 1] << 8))) {
+        return false;
+    }
+    frame->type = (sim_msg_type_t)reader->buf[0];
+    frame->sequence = reader->buf[1];
+    frame->payload = reader->buf + 2;
+    frame->len = body - 2;
+    return true;
+}
+
+sim_read_result_t sim_frame_reader_feed(sim_frame_reader_t *reader, uint8_t byte,
+                                        sim_frame_t *frame)
+{
+    if (byte == SIM_FRAME_DELIMITER) {
+        const bool ok = reader->in_frame && reader_complete(reader, frame);
+        // A frame ends at its delimiter; anything else may be a start
+        reader->in_frame = !ok;
+        reader_restart(reader);
+        return ok ? SIM_READ_FRAME : SIM_READ_NONE;
+    }
+    if (!reader->in_frame) {
+        return SIM_READ_TEXT;
+    }
+    if (reader->left == 0) {
+        if (reader->zero_pending) {
+            reader_append(reader, 0);
+        }
+        reader->started = true;
+        reader->code = byte;
+        reader->left = (uint8_t)(byte - 1);
+        reader->zero_pending = reader->left == 0;   // An empty block is just a 0x00
+        return SIM_READ_NONE;
+    }
+    reader_append(reader, byte);
+    if (--reader->left == 0) {
+        reader->zero_pending = reader->code != 0xFF;
+    }
+    return SIM_READ_NONE;
+}
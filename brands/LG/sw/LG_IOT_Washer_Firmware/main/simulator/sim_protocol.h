@@ -0,0 +1,180 @@
+/*
+ * sim_protocol.h
+ * Binary framing of the simulator link and the delta coding of bitmaps
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Frame on the wire: 0x00, COBS(type, sequence, payload, CRC-16), 0x00
+ *
+ *   type       sim_msg_type_t
+ *   sequence   per direction, +1 for every frame sent
+ *   CRC-16     CCITT (polynomial 0x1021, initial 0xFFFF) of type, sequence
+ *              and payload, little endian
+ *
+ * COBS leaves no 0x00 inside a frame, so a receiver finds the next frame
+ * after noise or a lost byte, and text between frames (boot messages,
+ * trace dumps) stays readable. Multi-byte fields are little endian.
+ */
+#define SIM_PROTOCOL_VERSION        3
+#define SIM_FRAME_DELIMITER         0x00
+#define SIM_FRAME_OVERHEAD          4           // Type, sequence, CRC
+
+typedef enum {
+    // Firmware to host
+    SIM_MSG_HELLO = 0x01,       // u8 version; the firmware (re)started, forget references
+    SIM_MSG_LOG = 0x02,         // One log line, without the newline
+    SIM_MSG_RECT = 0x03,        // i16 x, y, w, h, u16 RGB565 color
+    SIM_MSG_BITMAP = 0x04,      // i16 x, y, w, h, u8 flags, u8 reference sequence, runs
+    SIM_MSG_GPIO = 0x05,        // u8 pin, u8 level (a TELEMETRY record)
+    SIM_MSG_MOTOR = 0x06,       // i16 target RPM, i16 current RPM, u8 counter-clockwise (record)
+    SIM_MSG_STATE = 0x07,       // u8 SIM_STATE_* flags, u8 program, u8 stage, u8 stages, i16 ETA s, label (record)
+    SIM_MSG_TELEMETRY = 0x08,   // Records of u8 type, u8 length, payload
+    // Host to firmware
+    SIM_MSG_INPUT = 0x81,       // u8 pin, u8 level
+    SIM_MSG_DIAL = 0x82,        // i16 detents
+    SIM_MSG_COMMAND = 0x83,     // u8 command letter ('T', 'E', 'R', 'H', 'S'), u8 argument
+    SIM_MSG_KEYFRAME = 0x84,    // The host lost its reference; send the next bitmap in full
+} sim_msg_type_t;
+
+/*
+ * Output levels, motor and machine state travel as records in one
+ * TELEMETRY frame per period (CONFIG_SIM_TELEMETRY_PERIOD_MS), each record
+ * laid out as the payload of its type. A frame carries only what changed
+ * since the previous one; the one after HELLO and the answer to the 'S'
+ * command carry everything. The state label fills the rest of its record,
+ * without a terminator.
+ */
+#define SIM_STATE_POWERED           0x01
+#define SIM_STATE_RUNNING           0x02
+#define SIM_STATE_DOOR_OPEN         0x04
+#define SIM_STATE_ETA_AVAILABLE     0x08
+
+/*
+ * Bitmap pixels are coded as runs of 16-bit words, each XORed with the
+ * word at the same place in the reference: the bitmap frame named by the
+ * reference sequence (SIM_BITMAP_FLAG_DELTA), or all zero for a key frame.
+ * A run is a varint (count << 2 | op):
+ *
+ *   SIM_RUN_SKIP       count words are unchanged
+ *   SIM_RUN_LITERAL    count words follow
+ *   SIM_RUN_REPEAT     one word follows, for count words
+ *
+ * Words after the last run are unchanged. Words are sent in memory order,
+ * so the host sees the big-endian pixels the display is sent.
+ */
+#define SIM_BITMAP_FLAG_DELTA       0x01
+
+typedef enum {
+    SIM_RUN_SKIP = 0,
+    SIM_RUN_LITERAL = 1,
+    SIM_RUN_REPEAT = 2,
+} sim_run_op_t;
+
+/*===========================================================================
+ * Writing
+ *===========================================================================*/
+
+typedef void (*sim_write_fn)(void *ctx, const uint8_t *data, size_t len);
+
+typedef struct {
+    sim_write_fn write;
+    void *ctx;
+    uint16_t crc;
+    uint8_t block_len;          // Including the code byte at block[0]
+    uint8_t block[255];
+} sim_frame_writer_t;
+
+/**
+ * @brief Start a frame; @p write receives it in pieces of up to 255 bytes
+ *
+ * The caller keeps other writers off the link until sim_frame_end().
+ */
+void sim_frame_begin(sim_frame_writer_t *writer, sim_write_fn write, void *ctx,
+                     sim_msg_type_t type, uint8_t sequence);
+
+/**
+ * @brief Append payload bytes
+ */
+void sim_frame_put(sim_frame_writer_t *writer, const void *data, size_t len);
+
+void sim_frame_put_u8(sim_frame_writer_t *writer, uint8_t value);
+void sim_frame_put_i16(sim_frame_writer_t *writer, int16_t value);
+
+/**
+ * @brief Append the runs coding @p words pixels against @p reference
+ *        (nullptr for a key frame)
+ */
+void sim_frame_put_bitmap_runs(sim_frame_writer_t *writer, const uint16_t *data,
+                               const uint16_t *reference, size_t words);
+
+/**
+ * @brief Append the CRC and the closing delimiter
+ */
+void sim_frame_end(sim_frame_writer_t *writer);
+
+/*===========================================================================
+ * Reading
+ *===========================================================================*/
+
+typedef enum {
+    SIM_READ_NONE,              // Byte consumed
+    SIM_READ_TEXT,              // Byte is text outside any frame
+    SIM_READ_FRAME,             // A frame with a good CRC is complete
+} sim_read_result_t;
+
+typedef struct {
+    sim_msg_type_t type;
+    uint8_t sequence;
+    const uint8_t *payload;     // In the reader's buffer; valid until the next byte
+    size_t len;
+} sim_frame_t;
+
+typedef struct {
+    uint8_t *buf;
+    size_t cap;
+    size_t len;
+    uint8_t code;               // Of the COBS block being read
+    uint8_t left;               // Bytes left in it
+    bool in_frame;
+    bool started;               // A code byte has been read
+    bool zero_pending;          // The block ended short: a 0x00 was removed there
+    bool overflow;
+} sim_frame_reader_t;
+
+/**
+ * @brief Prepare to read frames of up to @p cap bytes (before COBS) into @p buf
+ */
+void sim_frame_reader_init(sim_frame_reader_t *reader, uint8_t *buf, size_t cap);
+
+/**
+ * @brief Feed one received byte
+ *
+ * A delimiter that ends a damaged frame is taken as the start of the next
+ * one, so text read as a frame costs that text and nothing else.
+ */
+sim_read_result_t sim_frame_reader_feed(sim_frame_reader_t *reader, uint8_t byte,
+                                        sim_frame_t *frame);
+
+/**
+ * @brief Read a little-endian i16 from a payload
+ */
+static inline int16_t sim_get_i16(const uint8_t *p)
+{
+    return (int16_t)(p[0] | (p[1] << 8));
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,30 +7,419 @@
 #include "esp_log.h"
 #include "esp_vfs_dev.h"
 #include "tasks.h"
+#include "gpio_hal.h"
+#include "machine_state.h"
+#include "sim_protocol.h"
+#include "diagnostics/trace.h"
+#include "diagnostics/event_record.h"
+#include "diagnostics/heap_report.h"
+#include "tasks/static_alloc.h"
 
 #include "freertos/semphr.h"
 
+#include <atomic>
+
 static const char *TAG = "simulator";
 
 // Simulated GPIO state (Inputs)
 static uint64_t s_gpio_inputs = 0;
 static uint64_t s_gpio_latched = 0; // Latch for short pulses
 static portMUX_TYPE s_gpio_lock = portMUX_INITIALIZER_UNLOCKED;
-static SemaphoreHandle_t s_uart_mutex = nullptr;
+static StaticTaskSlot<4096> s_input_task_slot;
 
 #define SIM_UART_NUM UART_NUM_0
 #define BUF_SIZE 1024
+#define RX_FRAME_MAX 64             // Host frames are a few bytes
+#define LOG_LINE_MAX 256
+
+/*
+ * Why every writer holds the link mutex for a whole frame:
+ * - A frame is written in COBS blocks, so another writer in between would
+ *   split it. Logs are routed through esp_log_set_vprintf() into LOG
+ *   frames under the same mutex, and the text of trace dumps is printed
+ *   with it held. The mutex is recursive because a dump may log.
+ * - Logging never waits for the link: a bitmap frame holds the mutex for
+ *   as long as its bytes take on the UART, and the control loops log.
+ *   A line that finds the link busy, or is raised while this task is
+ *   inside a frame (by the UART driver), is dropped and counted, and the
+ *   next line that gets through is preceded by the count.
+ */
+static SemaphoreHandle_t s_link_mutex = nullptr;
+static StaticMutexSlot s_link_mutex_slot;
+static sim_frame_writer_t s_writer;
+static uint8_t s_tx_sequence = 0;
+static bool s_in_frame = false;
+static char s_log_line[LOG_LINE_MAX];
+static std::atomic<uint32_t> s_logs_dropped{0};
+static bool s_link_ready = false;      // HELLO sent; the host listens for frames
+
+// The last bitmap the host holds, if a delta may refer to it
+static struct {
+    bool valid;
+    uint8_t sequence;
+    int16_t x, y, w, h;
+} s_bitmap_ref = {};
+
+/*===========================================================================
+ * Link Output
+ *===========================================================================*/
+
+static void link_write(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    uart_write_bytes(SIM_UART_NUM, data, len);
+}
+
+static void link_lock(void)
+{
+    if (s_link_mutex) xSemaphoreTakeRecursive(s_link_mutex, portMAX_DELAY);
+}
+
+static void link_unlock(void)
+{
+    if (s_link_mutex) xSemaphoreGiveRecursive(s_link_mutex);
+}
+
+// Frames are only built between frame_begin() and frame_end()
+static void frame_begin(sim_msg_type_t type)
+{
+    link_lock();
+    s_in_frame = true;
+    sim_frame_begin(&s_writer, link_write, nullptr, type, s_tx_sequence++);
+}
+
+static void frame_end(void)
+{
+    sim_frame_end(&s_writer);
+    s_in_frame = false;
+    link_unlock();
+}
+
+static int log_vprintf(const char *format, va_list args)
+{
+    if (s_link_mutex && xSemaphoreTakeRecursive(s_link_mutex, 0) != pdTRUE) {
+        s_logs_dropped.fetch_add(1, std::memory_order_relaxed);
+        return 0;
+    }
+    if (s_in_frame) {
+        s_logs_dropped.fetch_add(1, std::memory_order_relaxed);
+        link_unlock();
+        return 0;
+    }
+    const uint32_t dropped = s_logs_dropped.exchange(0, std::memory_order_relaxed);
+    if (dropped > 0) {
+        char note[48];
+        const int note_len = snprintf(note, sizeof(note), "(%lu log lines dropped, link busy)",
+                                      (unsigned long)dropped);
+        frame_begin(SIM_MSG_LOG);
+        sim_frame_put(&s_writer, note, (size_t)note_len);
+        frame_end();
+    }
+    int len = vsnprintf(s_log_line, sizeof(s_log_line), format, args);
+    if (len > (int)sizeof(s_log_line) - 1) {
+        len = sizeof(s_log_line) - 1;
+    }
+    int text_len = len;
+    while (text_len > 0 && (s_log_line[text_len - 1] == '\n' || s_log_line[text_len - 1] == '\r')) {
+        text_len--;
+    }
+    if (text_len > 0) {
+        frame_begin(SIM_MSG_LOG);
+        sim_frame_put(&s_writer, s_log_line, (size_t)text_len);
+        frame_end();
+    }
+    link_unlock();
+    return len;
+}
+
+/*===========================================================================
+ * Telemetry
+ *===========================================================================*/
+
+/*
+ * Why telemetry is coalesced into one frame per period:
+ * - One odrive_set_velocity() sets the target, the direction and the
+ *   measured speed, and every one of those used to take the link mutex and
+ *   send its own frame. Writers now only note what changed: outputs in a
+ *   bit mask under a spinlock, motor and state not at all, since the
+ *   telemetry task reads them from machine_state when it sends.
+ * - The task sends at most one TELEMETRY frame per
+ *   CONFIG_SIM_TELEMETRY_PERIOD_MS, with only the records that changed.
+ *   A door opening, a pause, power off or the drum being told to stop
+ *   wake it at once, so the host never sees those a period late, and
+ *   the power off sequence flushes before deep sleep.
+ * - An output that goes on and off again within a period is not sent.
+ */
+static StaticTaskSlot<3072> s_telemetry_task_slot;
+static TaskHandle_t s_telemetry_task = nullptr;
+static portMUX_TYPE s_telemetry_lock = portMUX_INITIALIZER_UNLOCKED;
+static uint64_t s_output_levels = 0;
+static uint64_t s_outputs_written = 0;     // Ever, for a full frame
+static uint64_t s_outputs_changed = 0;     // Since the last frame
+static bool s_send_all = false;
+
+// What the observer saw last, to spot the changes that are sent at once
+static struct {
+    bool powered, running, door_open;
+    int target_rpm;
+} s_observed = {};
+
+static void telemetry_flush(void)
+{
+    if (s_telemetry_task) {
+        xTaskNotifyGive(s_telemetry_task);
+    }
+}
+
+static void telemetry_request_all(void)
+{
+    portENTER_CRITICAL(&s_telemetry_lock);
+    s_send_all = true;
+    portEXIT_CRITICAL(&s_telemetry_lock);
+    telemetry_flush();
+}
+
+static void put_record(sim_msg_type_t type, uint8_t len)
+{
+    sim_frame_put_u8(&s_writer, (uint8_t)type);
+    sim_frame_put_u8(&s_writer, len);
+}
+
+static void send_telemetry(void)
+{
+    // What the host has; only touched under the link lock
+    static struct {
+        int16_t target, current;
+        bool ccw;
+    } s_motor = {};
+    static struct {
+        uint8_t flags, program, stage, stages;
+        int16_t eta;
+        char label[32];
+    } s_state = {};
+
+    link_lock();
+    if (!s_link_ready) {
+        link_unlock();
+        return;     // The frame after HELLO carries everything
+    }
+    portENTER_CRITICAL(&s_telemetry_lock);
+    const bool all = s_send_all;
+    const uint64_t levels = s_output_levels;
+    const uint64_t outputs = all ? s_outputs_written : s_outputs_changed;
+    s_outputs_changed = 0;
+    s_send_all = false;
+    portEXIT_CRITICAL(&s_telemetry_lock);
+
+    machine_observable_state_t state;
+    machine_get_observable_state(&state);
+    const int16_t target = (int16_t)state.target_rpm;
+    const int16_t current = (int16_t)state.current_rpm;
+    const bool motor_changed = all || target != s_motor.target || current != s_motor.current ||
+                               state.direction_ccw != s_motor.ccw;
+
+    const uint8_t flags = (state.powered ? SIM_STATE_POWERED : 0) |
+                          (state.running ? SIM_STATE_RUNNING : 0) |
+                          (state.door_open ? SIM_STATE_DOOR_OPEN : 0) |
+                          (state.eta_available ? SIM_STATE_ETA_AVAILABLE : 0);
+    const uint8_t program = (uint8_t)machine_get_program();
+    const int16_t eta = (int16_t)(state.eta_seconds > INT16_MAX ? INT16_MAX : state.eta_seconds);
+    const bool state_changed = all || flags != s_state.flags || program != s_state.program ||
+                               (uint8_t)state.stage != s_state.stage ||
+                               (uint8_t)state.total_stages != s_state.stages ||
+                               eta != s_state.eta || strcmp(state.stage_label, s_state.label) != 0;
+
+    if (!outputs && !motor_changed && !state_changed) {
+        link_unlock();
+        return;
+    }
+    frame_begin(SIM_MSG_TELEMETRY);
+    for (int pin = 0; pin < 64; pin++) {
+        if (outputs & (1ULL << pin)) {
+            put_record(SIM_MSG_GPIO, 2);
+            sim_frame_put_u8(&s_writer, (uint8_t)pin);
+            sim_frame_put_u8(&s_writer, (uint8_t)((levels >> pin) & 1));
+        }
+    }
+    if (motor_changed) {
+        s_motor.target = target;
+        s_motor.current = current;
+        s_motor.ccw = state.direction_ccw;
+        put_record(SIM_MSG_MOTOR, 5);
+        sim_frame_put_i16(&s_writer, target);
+        sim_frame_put_i16(&s_writer, current);
+        sim_frame_put_u8(&s_writer, s_motor.ccw ? 1 : 0);
+    }
+    if (state_changed) {
+        s_state.flags = flags;
+        s_state.program = program;
+        s_state.stage = (uint8_t)state.stage;
+        s_state.stages = (uint8_t)state.total_stages;
+        s_state.eta = eta;
+        snprintf(s_state.label, sizeof(s_state.label), "%s", state.stage_label);
+        const size_t label_len = strlen(s_state.label);
+        put_record(SIM_MSG_STATE, (uint8_t)(6 + label_len));
+        sim_frame_put_u8(&s_writer, flags);
+        sim_frame_put_u8(&s_writer, program);
+        sim_frame_put_u8(&s_writer, s_state.stage);
+        sim_frame_put_u8(&s_writer, s_state.stages);
+        sim_frame_put_i16(&s_writer, eta);
+        sim_frame_put(&s_writer, s_state.label, label_len);
+    }
+    frame_end();
+    link_unlock();
+}
+
+static void simulator_telemetry_task(void *arg)
+{
+    (void)arg;
+    const TickType_t period = pdMS_TO_TICKS(CONFIG_SIM_TELEMETRY_PERIOD_MS);
+    while (1) {
+        // A flush cuts the wait short
+        ulTaskNotifyTake(pdTRUE, period);
+        send_telemetry();
+    }
+}
+
+static void on_state_change(const machine_observable_state_t *snapshot)
+{
+    portENTER_CRITICAL(&s_telemetry_lock);
+    const bool urgent = snapshot->powered != s_observed.powered ||
+                        snapshot->running != s_observed.running ||
+                        snapshot->door_open != s_observed.door_open ||
+                        (snapshot->target_rpm == 0 && s_observed.target_rpm != 0);
+    s_observed.powered = snapshot->powered;
+    s_observed.running = snapshot->running;
+    s_observed.door_open = snapshot->door_open;
+    s_observed.target_rpm = snapshot->target_rpm;
+    portEXIT_CRITICAL(&s_telemetry_lock);
+    if (urgent) {
+        telemetry_flush();
+    }
+}
 
 /*===========================================================================
  * Serial Input Handling
  *===========================================================================*/
 
+static void apply_input(int pin, int val)
+{
+    if (pin < 0 || pin >= 64) {
+        ESP_LOGW(TAG, "Sim Input: bad GPIO %d", pin);
+        return;
+    }
+    simulator_set_gpio_input(pin, val);
+    gpio_hal_sim_input(pin, val);
+    ESP_LOGI(TAG, "Sim Input: GPIO %d = %d", pin, val);
+}
+
+static void apply_dial(int delta)
+{
+    if (delta != 0) {
+        tasks_post_dial_delta(delta);
+        ESP_LOGI(TAG, "Sim Input: Dial delta %d", delta);
+    }
+}
+
+static void run_command(char command, char arg)
+{
+    switch (command) {
+    case 'T':
+    case 'R':
+        // Dumps are printed as text; keep frames out of them
+        link_lock();
+        if (command == 'T') {
+            trace_dump_uart();      // Latency and event trace in one dump
+        } else {
+            event_record_dump_uart();
+        }
+        fflush(stdout);
+        link_unlock();
+        break;
+    case 'S':
+        // Scripted hosts ask for everything once connected
+        telemetry_request_all();
+        break;
+    case 'H':
+        // H1 starts the steady-state heap check, H0 reports it
+        if (arg == '1') {
+            heap_report_check_start();
+        } else {
+            heap_report_check_stop(nullptr);
+        }
+        break;
+    default:
+        ESP_LOGW(TAG, "Unknown command '%c'", command);
+        break;
+    }
+}
+
+static void handle_frame(const sim_frame_t &frame)
+{
+    static uint8_t s_rx_expected = 0;
+    static bool s_rx_synced = false;
+    if (s_rx_synced && frame.sequence != s_rx_expected) {
+        ESP_LOGW(TAG, "Lost %u frames from the host", (unsigned)(uint8_t)(frame.sequence - s_rx_expected));
+    }
+    s_rx_synced = true;
+    s_rx_expected = frame.sequence + 1;
+
+    switch (frame.type) {
+    case SIM_MSG_INPUT:
+        if (frame.len >= 2) {
+            apply_input(frame.payload[0], frame.payload[1] ? 1 : 0);
+        }
+        break;
+    case SIM_MSG_DIAL:
+        if (frame.len >= 2) {
+            apply_dial(sim_get_i16(frame.payload));
+        }
+        break;
+    case SIM_MSG_COMMAND:
+        if (frame.len >= 1) {
+            run_command((char)frame.payload[0], frame.len >= 2 ? (char)frame.payload[1] : 0);
+        }
+        break;
+    case SIM_MSG_KEYFRAME:
+        link_lock();
+        s_bitmap_ref.valid = false;
+        link_unlock();
+        break;
+    default:
+        break;
+    }
+}
+
+// "$" lines are still accepted, for typing into a terminal
+static void handle_text_line(const char *line_buf)
+{
+    if (strncmp(line_buf, "$I", 2) == 0) {
+        int pin, val;
+        if (sscanf(line_buf + 2, "%d,%d", &pin, &val) == 2) {
+            apply_input(pin, val);
+        } else {
+            ESP_LOGW(TAG, "Failed to parse: %s", line_buf);
+        }
+    } else if (strncmp(line_buf, "$D", 2) == 0) {
+        int delta = 0;
+        if (sscanf(line_buf + 2, "%d", &delta) == 1 && delta != 0) {
+            apply_dial(delta);
+        } else {
+            ESP_LOGW(TAG, "Failed to parse dial: %s", line_buf);
+        }
+    } else if (line_buf[0] == '$' && line_buf[1] != 0) {
+        run_command(line_buf[1], line_buf[2]);
+    }
+}
+
 static void simulator_input_task(void *arg)
 {
     // We need to re-configure the UART driver to ensure we have a RX buffer
     // and that it's set to the correct baud rate.
     // The default console installation might not have a sufficient RX buffer for uart_read_bytes.
-    
+    // Writers wait meanwhile.
+    link_lock();
+
     // 1. Try to uninstall the default driver (ignore error if not installed)
     uart_driver_delete(SIM_UART_NUM);
 
@@ -42,59 +431,59 @@ static void simulator_input_task(void *arg)
     uart_config.stop_bits = UART_STOP_BITS_1;
     uart_config.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
     uart_config.source_clk = UART_SCLK_DEFAULT;
-    
+
     // Install driver: RX buffer = BUF_SIZE*2, TX buffer = 0 (blocking), No event queue
     ESP_ERROR_CHECK(uart_driver_install(SIM_UART_NUM, BUF_SIZE * 2, 0, 0, nullptr, 0));
     ESP_ERROR_CHECK(uart_param_config(SIM_UART_NUM, &uart_config));
-    
+
     // 3. Re-connect the VFS to this UART so printf/ESP_LOG still works
     esp_vfs_dev_uart_use_driver(SIM_UART_NUM);
 
-    uint8_t *data = (uint8_t *) malloc(BUF_SIZE);
+    // 4. From here on logs travel in frames; the host drops what it drew
+    esp_log_set_vprintf(log_vprintf);
+    frame_begin(SIM_MSG_HELLO);
+    sim_frame_put_u8(&s_writer, SIM_PROTOCOL_VERSION);
+    frame_end();
+    s_link_ready = true;
+    link_unlock();
+    telemetry_request_all();
+
+    static uint8_t data[BUF_SIZE];
+    static uint8_t frame_buf[RX_FRAME_MAX];
+    sim_frame_reader_t reader;
+    sim_frame_reader_init(&reader, frame_buf, sizeof(frame_buf));
     char line_buf[128];
     int line_pos = 0;
-    
+
     while (1) {
         // Read data from the UART
         int len = uart_read_bytes(SIM_UART_NUM, data, BUF_SIZE - 1, 20 / portTICK_PERIOD_MS);
-        if (len > 0) {
-            for (int i = 0; i < len; i++) {
-                char c = (char)data[i];
-                if (c == '\n' || c == '\r') {
-                    if (line_pos > 0) {
-                        line_buf[line_pos] = 0;
-                        // Parse line
-                        if (strncmp(line_buf, "$I", 2) == 0) {
-                            int pin, val;
-                            if (sscanf(line_buf + 2, "%d,%d", &pin, &val) == 2) {
-                                simulator_set_gpio_input(pin, val);
-                                ESP_LOGI(TAG, "Sim Input: GPIO %d = %d", pin, val);
-                            } else {
-                                ESP_LOGW(TAG, "Failed to parse: %s", line_buf);
-                            }
-                        } else if (strncmp(line_buf, "$D", 2) == 0) {
-                            int delta = 0;
-                            if (sscanf(line_buf + 2, "%d", &delta) == 1 && delta != 0) {
-                                tasks_post_dial_delta(delta);
-                                ESP_LOGI(TAG, "Sim Input: Dial delta %d", delta);
-                            } else {
-                                ESP_LOGW(TAG, "Failed to parse dial: %s", line_buf);
-                            }
-                        }
-                        line_pos = 0;
-                    }
-                } else {
-                    if (line_pos < sizeof(line_buf) - 1) {
-                        line_buf[line_pos++] = c;
-                    } else {
-                        // Buffer overflow, reset
-                        line_pos = 0;
-                    }
+        for (int i = 0; i < len; i++) {
+            sim_frame_t frame;
+            const sim_read_result_t result = sim_frame_reader_feed(&reader, data[i], &frame);
+            if (result == SIM_READ_FRAME) {
+                handle_frame(frame);
+                line_pos = 0;
+                continue;
+            }
+            if (result != SIM_READ_TEXT) {
+                continue;
+            }
+            char c = (char)data[i];
+            if (c == '\n' || c == '\r') {
+                if (line_pos > 0) {
+                    line_buf[line_pos] = 0;
+                    handle_text_line(line_buf);
+                    line_pos = 0;
                 }
+            } else if (line_pos < (int)sizeof(line_buf) - 1) {
+                line_buf[line_pos++] = c;
+            } else {
+                // Buffer overflow, reset
+                line_pos = 0;
             }
         }
     }
-    free(data);
     vTaskDelete(nullptr);
 }
 
@@ -104,62 +493,85 @@ static void simulator_input_task(void *arg)
 
 esp_err_t simulator_init(void)
 {
-    s_uart_mutex = xSemaphoreCreateMutex();
-    
+    s_link_mutex = create_recursive_mutex(s_link_mutex_slot);
+    if (!s_link_mutex) {
+        return ESP_ERR_NO_MEM;
+    }
+
     // Create input task
-    xTaskCreate(simulator_input_task, "sim_input", 4096, nullptr, 10, nullptr);
-    
-    // We don't use ESP_LOG here because we changed the baud rate and it might conflict
-    // But if we want to see logs on the host, we should ensure they are sent correctly.
-    // The host script forwards lines that don't start with $ as logs.
-    
+    create_task(s_input_task_slot, simulator_input_task, "sim_input", nullptr, 10, nullptr,
+                tskNO_AFFINITY);
+    create_task(s_telemetry_task_slot, simulator_telemetry_task, "sim_telem", nullptr, 4,
+                &s_telemetry_task, tskNO_AFFINITY);
+    if (!machine_register_observer(on_state_change)) {
+        ESP_LOGW(TAG, "No observer slot; machine state is only sent with other changes");
+    }
+
     return ESP_OK;
 }
 
 void simulator_send_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color)
 {
-    if (s_uart_mutex) xSemaphoreTake(s_uart_mutex, portMAX_DELAY);
-    // Format: $R<x>,<y>,<w>,<h>,<color>\n
-    char buf[64];
-    int len = snprintf(buf, sizeof(buf), "$R%d,%d,%d,%d,%d\n", x, y, w, h, color);
-    uart_write_bytes(SIM_UART_NUM, buf, len);
-    if (s_uart_mutex) xSemaphoreGive(s_uart_mutex);
+    frame_begin(SIM_MSG_RECT);
+    sim_frame_put_i16(&s_writer, x);
+    sim_frame_put_i16(&s_writer, y);
+    sim_frame_put_i16(&s_writer, w);
+    sim_frame_put_i16(&s_writer, h);
+    sim_frame_put_i16(&s_writer, (int16_t)color);
+    frame_end();
 }
 
-void simulator_send_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data)
+void simulator_send_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                           const uint16_t *previous)
 {
-    if (s_uart_mutex) xSemaphoreTake(s_uart_mutex, portMAX_DELAY);
-    
-    // Format: $b<x>,<y>,<w>,<h>\n<binary_data>
-    // We use 'b' for binary mode to distinguish from 'B' (hex mode)
-    char buf[64];
-    int len = snprintf(buf, sizeof(buf), "$b%d,%d,%d,%d\n", x, y, w, h);
-    uart_write_bytes(SIM_UART_NUM, buf, len);
-    
-    // Send raw binary data (w * h * 2 bytes)
-    uart_write_bytes(SIM_UART_NUM, (const char*)data, w * h * 2);
-    
-    if (s_uart_mutex) xSemaphoreGive(s_uart_mutex);
+    const size_t words = (size_t)w * (size_t)h;
+    link_lock();
+    const bool delta = previous && s_bitmap_ref.valid && s_bitmap_ref.x == x &&
+                       s_bitmap_ref.y == y && s_bitmap_ref.w == w && s_bitmap_ref.h == h;
+    if (delta && memcmp(data, previous, words * sizeof(uint16_t)) == 0) {
+        link_unlock();
+        return;     // The host has this frame
+    }
+    const uint8_t sequence = s_tx_sequence;
+    frame_begin(SIM_MSG_BITMAP);
+    sim_frame_put_i16(&s_writer, x);
+    sim_frame_put_i16(&s_writer, y);
+    sim_frame_put_i16(&s_writer, w);
+    sim_frame_put_i16(&s_writer, h);
+    sim_frame_put_u8(&s_writer, delta ? SIM_BITMAP_FLAG_DELTA : 0);
+    sim_frame_put_u8(&s_writer, s_bitmap_ref.sequence);
+    sim_frame_put_bitmap_runs(&s_writer, data, delta ? previous : nullptr, words);
+    frame_end();
+    // Only a caller that passes the previous frame can follow with a delta
+    s_bitmap_ref.valid = previous != nullptr;
+    s_bitmap_ref.sequence = sequence;
+    s_bitmap_ref.x = x;
+    s_bitmap_ref.y = y;
+    s_bitmap_ref.w = w;
+    s_bitmap_ref.h = h;
+    link_unlock();
 }
 
 void simulator_send_gpio_state(int pin, int level)
 {
-    if (s_uart_mutex) xSemaphoreTake(s_uart_mutex, portMAX_DELAY);
-    // Format: $G<pin>,<val>\n
-    char buf[32];
-    int len = snprintf(buf, sizeof(buf), "$G%d,%d\n", pin, level ? 1 : 0);
-    uart_write_bytes(SIM_UART_NUM, buf, len);
-    if (s_uart_mutex) xSemaphoreGive(s_uart_mutex);
+    if (pin < 0 || pin >= 64) {
+        return;
+    }
+    const uint64_t bit = 1ULL << pin;
+    portENTER_CRITICAL(&s_telemetry_lock);
+    if (level) {
+        s_output_levels |= bit;
+    } else {
+        s_output_levels &= ~bit;
+    }
+    s_outputs_written |= bit;
+    s_outputs_changed |= bit;
+    portEXIT_CRITICAL(&s_telemetry_lock);
 }
 
-void simulator_send_motor_state(int target_rpm, float current_rpm, bool direction_ccw)
+void simulator_flush_telemetry(void)
 {
-    if (s_uart_mutex) xSemaphoreTake(s_uart_mutex, portMAX_DELAY);
-    int current_int = (int)current_rpm;
-    char buf[64];
-    int len = snprintf(buf, sizeof(buf), "$M%d,%d,%d\n", target_rpm, current_int, direction_ccw ? 1 : 0);
-    uart_write_bytes(SIM_UART_NUM, buf, len);
-    if (s_uart_mutex) xSemaphoreGive(s_uart_mutex);
+    send_telemetry();
 }
 
 void simulator_set_gpio_input(int pin, int level)
@@ -14,14 +14,19 @@ esp_err_t simulator_init(void);
 // Send a draw rectangle command to the web client
 void simulator_send_draw_rect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
 
-// Send a bitmap draw command to the web client
-void simulator_send_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data);
-
-// Send a GPIO update to the web client
+// Send a bitmap draw command to the web client. With the bitmap passed on
+// the previous call for the same rectangle as previous (nullptr if unknown),
+// only the difference is sent, and nothing if there is none.
+void simulator_send_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                           const uint16_t *previous);
+
+// Report an output level; sent with the next telemetry frame. Motor and
+// machine state are taken from machine_state at that time.
 void simulator_send_gpio_state(int pin, int level);
 
-// Send current motor telemetry (target/current RPM + direction)
-void simulator_send_motor_state(int target_rpm, float current_rpm, bool direction_ccw);
+// Send what the next telemetry frame would carry now, from the calling task.
+// Used before deep sleep, which would drop it.
+void simulator_flush_telemetry(void);
 
 // Get the simulated state of a GPIO pin (for inputs)
 int simulator_get_gpio_state(int pin);
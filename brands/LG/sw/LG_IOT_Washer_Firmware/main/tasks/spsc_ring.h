@@ -0,0 +1,82 @@
+/*
+ * spsc_ring.h
+ * Lock-free single-producer/single-consumer ring (no ESP-IDF dependencies)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief Fixed-size ring for exactly one producer and one consumer
+ *
+ * push() and pop_batch() never block and never take a lock, so the producer
+ * may be an ISR. head_ is written only by the producer and tail_ only by the
+ * consumer; the release/acquire pairs publish the slot contents. Indices run
+ * freely and wrap at 2^32, so Capacity must be a power of two.
+ */
+template <typename T, uint32_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscRing capacity must be a power of two");
+
+public:
+    /**
+     * @brief Append one item (producer side)
+     * @return false if the ring is full; the item is dropped
+     */
+    bool push(const T &item)
+    {
+        const uint32_t head = head_.load(std::memory_order_relaxed);
+        const uint32_t tail = tail_.load(std::memory_order_acquire);
+        if (head - tail == Capacity) {
+            return false;
+        }
+        slots_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Move up to @p max items into @p out (consumer side)
+     * @return Number of items copied
+     */
+    size_t pop_batch(T *out, size_t max)
+    {
+        const uint32_t tail = tail_.load(std::memory_order_relaxed);
+        const uint32_t head = head_.load(std::memory_order_acquire);
+        uint32_t count = head - tail;
+        if (count > max) {
+            count = (uint32_t)max;
+        }
+        for (uint32_t i = 0; i < count; i++) {
+            out[i] = slots_[(tail + i) & (Capacity - 1)];
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    bool pop(T *out)
+    {
+        return pop_batch(out, 1) == 1;
+    }
+
+    /**
+     * @brief Items waiting; exact from either side, a snapshot otherwise
+     */
+    uint32_t size() const
+    {
+        return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+    }
+
+    static constexpr uint32_t capacity() { return Capacity; }
+
+private:
+    std::atomic<uint32_t> head_{0};
+    std::atomic<uint32_t> tail_{0};
+    T slots_[Capacity];
+};
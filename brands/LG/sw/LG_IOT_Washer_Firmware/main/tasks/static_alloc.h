@@ -0,0 +1,126 @@
+/*
+ * static_alloc.h
+ * Task, queue and semaphore creation with optional static storage
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/*
+ * Why slots instead of calling xTaskCreate directly:
+ * - With CONFIG_STATIC_ALLOCATION every long-lived task, queue and mutex
+ *   gets its TCB, stack and storage from a slot defined next to its owner,
+ *   so memory use is fixed at link time and shows up in the size report
+ *   instead of as heap fragmentation. Without it the slots are empty and
+ *   creation falls back to the heap, exactly as before.
+ * - A static task slot may only be reused once FreeRTOS has really
+ *   released the previous task. Deleting a task that is not running
+ *   releases it at once; deleting one running on the other core defers
+ *   that to the idle task. Re-created tasks therefore share a core with the
+ *   task that deletes them.
+ */
+
+#include <stdint.h>
+#include "sdkconfig.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+
+template <uint32_t StackBytes>
+struct StaticTaskSlot {
+#if CONFIG_STATIC_ALLOCATION
+    StaticTask_t tcb;
+    StackType_t stack[StackBytes / sizeof(StackType_t)];
+#endif
+};
+
+template <typename T, uint32_t Length>
+struct StaticQueueSlot {
+#if CONFIG_STATIC_ALLOCATION
+    StaticQueue_t queue;
+    uint8_t storage[Length * sizeof(T)];
+#endif
+};
+
+struct StaticMutexSlot {
+#if CONFIG_STATIC_ALLOCATION
+    StaticSemaphore_t mutex;
+#endif
+};
+
+/**
+ * @brief xTaskCreatePinnedToCore() with the stack size taken from @p slot
+ * @return pdPASS or pdFAIL
+ */
+template <uint32_t StackBytes>
+static inline BaseType_t create_task(StaticTaskSlot<StackBytes> &slot, TaskFunction_t entry,
+                                     const char *name, void *arg, UBaseType_t priority,
+                                     TaskHandle_t *handle, BaseType_t core)
+{
+#if CONFIG_STATIC_ALLOCATION
+    TaskHandle_t task = xTaskCreateStaticPinnedToCore(entry, name, StackBytes, arg, priority,
+                                                      slot.stack, &slot.tcb, core);
+    if (handle) {
+        *handle = task;
+    }
+    return task ? pdPASS : pdFAIL;
+#else
+    (void)slot;
+    return xTaskCreatePinnedToCore(entry, name, StackBytes, arg, priority, handle, core);
+#endif
+}
+
+/**
+ * @brief xQueueCreate() for @p Length items of type @p T
+ */
+template <typename T, uint32_t Length>
+static inline QueueHandle_t create_queue(StaticQueueSlot<T, Length> &slot)
+{
+#if CONFIG_STATIC_ALLOCATION
+    return xQueueCreateStatic(Length, sizeof(T), slot.storage, &slot.queue);
+#else
+    (void)slot;
+    return xQueueCreate(Length, sizeof(T));
+#endif
+}
+
+/**
+ * @brief xSemaphoreCreateMutex()
+ */
+static inline SemaphoreHandle_t create_mutex(StaticMutexSlot &slot)
+{
+#if CONFIG_STATIC_ALLOCATION
+    return xSemaphoreCreateMutexStatic(&slot.mutex);
+#else
+    (void)slot;
+    return xSemaphoreCreateMutex();
+#endif
+}
+
+/**
+ * @brief xSemaphoreCreateRecursiveMutex()
+ */
+static inline SemaphoreHandle_t create_recursive_mutex(StaticMutexSlot &slot)
+{
+#if CONFIG_STATIC_ALLOCATION
+    return xSemaphoreCreateRecursiveMutexStatic(&slot.mutex);
+#else
+    (void)slot;
+    return xSemaphoreCreateRecursiveMutex();
+#endif
+}
+
+/**
+ * @brief xSemaphoreCreateBinary(); the slot holds any kind of semaphore
+ */
+static inline SemaphoreHandle_t create_binary_semaphore(StaticMutexSlot &slot)
+{
+#if CONFIG_STATIC_ALLOCATION
+    return xSemaphoreCreateBinaryStatic(&slot.mutex);
+#else
+    (void)slot;
+    return xSemaphoreCreateBinary();
+#endif
+}
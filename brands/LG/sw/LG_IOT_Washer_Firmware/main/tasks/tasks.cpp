@@ -16,90 +16,421 @@
 #include "drivers/display/display.h"
 #include "drivers/sound/sound.h"
 #include "wash_plan.h"
+#include "diagnostics/latency_hist.h"
+#include "diagnostics/trace.h"
+#include "diagnostics/event_trace.h"
+#include "diagnostics/event_record.h"
+#include "spsc_ring.h"
+#include "static_alloc.h"
 #if CONFIG_BALANCE_DETECTION
 #include "drivers/mpu6050/mpu6050.h"
 #endif
+#if CONFIG_CYCLE_CHECKPOINT
+#include "cycle_checkpoint.h"
+#endif
+#if CONFIG_DIAL_ENCODER
+#include "drivers/led_ring.h"
+#endif
+#if CONFIG_SIMULATOR_MODE
+#include "simulator.h"
+#endif
 
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "esp_log.h"
 #include "esp_random.h"
+#include "esp_timer.h"
 #include "esp_err.h"
 #include "wash_types.h"
 #include "drivers/odrive/odrive.h"
 #include <cstdio>
 #include <cstring>
 #include <cstdlib>
+#include <atomic>
+#include <initializer_list>
 
 static const char *TAG = "wm_control";
 
-static QueueHandle_t s_event_queue = nullptr;
-static QueueHandle_t s_command_queue = nullptr;
 static TaskHandle_t s_wash_task_handle = nullptr;
 static TaskHandle_t s_mgr_task = nullptr;
 static TaskHandle_t s_actuator_task = nullptr;
-static TaskHandle_t s_io_task = nullptr;
 #if CONFIG_BALANCE_DETECTION
 static TaskHandle_t s_sensor_task = nullptr;
 #endif
 static TaskHandle_t s_tick_task = nullptr;
 static TaskHandle_t s_display_task = nullptr;
 
+// Task storage (empty unless CONFIG_STATIC_ALLOCATION)
+static StaticTaskSlot<4096> s_wash_slot;
+static StaticTaskSlot<6144> s_mgr_slot;
+static StaticTaskSlot<4096> s_actuator_slot;
+#if CONFIG_BALANCE_DETECTION
+static StaticTaskSlot<4096> s_sensor_slot;
+#endif
+static StaticTaskSlot<2048> s_tick_slot;
+static StaticTaskSlot<4096> s_display_slot;
+
+// The manager deletes and re-creates the wash task; on its own core the
+// deletion completes at once, so a static slot can be reused right away
+#if CONFIG_STATIC_ALLOCATION
+#define WASH_TASK_CORE      1
+#else
+#define WASH_TASK_CORE      tskNO_AFFINITY
+#endif
+
+// Parameters of the running wash task; rewritten only after it is deleted
+static wash_params_t s_wash_params;
+
+// One event ring per producer; the manager task is the only consumer
+#define EVENT_RING_SIZE     16
+#define EVENT_BATCH_MAX     32
+#define COMMAND_RING_SIZE   32
+static SpscRing<wm_event_t, EVENT_RING_SIZE> s_event_rings[WM_PRODUCER_COUNT];
+static wm_queue_stats_t s_event_stats[WM_PRODUCER_COUNT];   // Entry i written only by producer i
+
+// Manager -> actuator commands
+static SpscRing<wm_command_t, COMMAND_RING_SIZE> s_command_ring;
+
+// Given by the actuator once it has settled, when s_actuator_idle_wanted
+// asks for it; see wait_actuator_idle()
+static SemaphoreHandle_t s_actuator_idle = nullptr;
+static StaticMutexSlot s_actuator_idle_slot;
+static std::atomic<bool> s_actuator_idle_wanted{false};
+
+// Longest apply_power_off() waits for the outputs before deep sleep
+#define POWER_OFF_SETTLE_MS 2000
+
+// Edge-to-dequeue latency of input events, indexed by wm_event_type_t.
+// Written only by the manager task.
+static latency_hist_t s_input_latency[WM_EVENT_TYPE_COUNT];
+
+// Time spent waiting in each lane, indexed by wm_event_lane_t (manager only)
+static latency_hist_t s_lane_latency[WM_LANE_COUNT];
+
+// Collapsible events are folded into this state instead of being queued
+static portMUX_TYPE s_collapse_lock = portMUX_INITIALIZER_UNLOCKED;
+static struct {
+    bool dial_pending;
+    int32_t dial_delta;
+    uint32_t dial_timestamp_us;     // Oldest edge folded into dial_delta
+    uint32_t dial_queued_us;
+    uint16_t dial_trace_id;         // Trace of the oldest folded delta
+    uint32_t ticks;
+    uint32_t tick_queued_us;
+} s_collapsed = {};
+
+// Producer-side command counters (manager task is the only writer)
+static wm_queue_stats_t s_command_stats = {};
+
+// Trace of the event the manager is dispatching; stamped on its commands
+static uint16_t s_dispatch_trace_id = 0;
+
+// Events come only from tasks_post_replay_event(); set before start-up
+static bool s_replay_mode = false;
+
 /*
  * Why this task/queue architecture:
  * - The control plane is event-driven to decouple hardware interrupts and
- *   time-critical I/O from higher-level wash logic. Queues provide natural
- *   backpressure and bounded buffering so producers don't block critical
- *   ISRs. Timeouts used when sending to queues (20-50ms) are chosen to be
- *   short so the system remains responsive while still tolerating brief
- *   contention; they are a trade-off between robustness and latency.
- * - Tasks are split by responsibility (manager, actuators, IO, display,
+ *   time-critical I/O from higher-level wash logic. Bounded buffers between
+ *   tasks give backpressure without ever blocking a producer: a full ring
+ *   drops the item and counts it instead of stalling an ISR or the manager.
+ * - Tasks are split by responsibility (manager, actuators, display,
  *   wash motion) to improve isolation and make it easier to suspend/resume
  *   subsets during power saving or error handling.
+ * - Inputs have no task of their own: the door GPIO interrupt, the ULP
+ *   button interrupt and the dial post straight into the control plane, each
+ *   event stamped with the time of its edge so the manager can measure
+ *   input latency (s_input_latency). Input events also carry a trace id
+ *   that follows them into the actuator and display (diagnostics/trace.h).
+ *
+ * Why events travel in lanes:
+ * - With one FIFO a door-open or imbalance event could wait behind a burst
+ *   of dial deltas and ticks. The manager dispatches every safety event of
+ *   a drained batch before any other event.
+ * - Dial deltas and timer ticks are never queued. Dial deltas are summed
+ *   and ticks are counted in s_collapsed, so a burst takes one slot.
+ *   Ticks keep their count so no wash seconds are lost.
+ * - Time spent waiting in each lane is recorded in s_lane_latency.
+ *
+ * Why SPSC rings instead of FreeRTOS queues:
+ * - Each producer (wm_producer_t) owns a lock-free ring (spsc_ring.h), so
+ *   posting is a copy and an index store. There is no critical section and
+ *   no blocking timeout, and it works the same from an ISR.
+ * - A task notification is the doorbell. The manager wakes once and drains
+ *   every ring in one pass, where the queue needed a wake and a receive per
+ *   event. Commands to the actuator use the same scheme. tools/queue_bench
+ *   compares the two paths on the host.
+ * - A producer must only post under its own wm_producer_t. Two producers
+ *   on one ring would corrupt it.
  */
 
-static inline bool enqueue_event_internal(wm_event_type_t type, int32_t value)
+static inline uint32_t event_timestamp_now(void)
+{
+    return (uint32_t)esp_timer_get_time();
+}
+
+static wm_event_lane_t event_lane(wm_event_type_t type)
 {
-    if (!s_event_queue) {
+    switch (type) {
+        case WM_EVENT_DOOR_STATE:
+        case WM_EVENT_SENSOR_SAMPLE:
+        case WM_EVENT_MOTOR_FAULT:
+            return WM_LANE_SAFETY;
+        case WM_EVENT_DIAL_DELTA:
+        case WM_EVENT_TIMER_TICK:
+            return WM_LANE_COLLAPSED;
+        default:
+            return WM_LANE_NORMAL;
+    }
+}
+
+static bool is_input_event(wm_event_type_t type)
+{
+    switch (type) {
+        case WM_EVENT_POWER_BUTTON:
+        case WM_EVENT_START_BUTTON:
+        case WM_EVENT_DOOR_STATE:
+        case WM_EVENT_START_LONG_PRESS:
+        case WM_EVENT_DIAL_DELTA:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Fold a collapsible event into s_collapsed; callable from tasks and ISRs
+static void collapse_event(const wm_event_t &evt)
+{
+    portENTER_CRITICAL_SAFE(&s_collapse_lock);
+    if (evt.type == WM_EVENT_DIAL_DELTA) {
+        if (!s_collapsed.dial_pending) {
+            s_collapsed.dial_pending = true;
+            s_collapsed.dial_delta = 0;
+            s_collapsed.dial_timestamp_us = evt.timestamp_us;
+            s_collapsed.dial_queued_us = evt.queued_us;
+            s_collapsed.dial_trace_id = evt.trace_id;
+        }
+        s_collapsed.dial_delta += evt.value;
+    } else {
+        if (s_collapsed.ticks == 0) {
+            s_collapsed.tick_queued_us = evt.queued_us;
+        }
+        s_collapsed.ticks++;
+    }
+    portEXIT_CRITICAL_SAFE(&s_collapse_lock);
+}
+
+/**
+ * Route an event to its producer ring (or the collapsed state) and ring
+ * the manager's doorbell. higher_priority_task_woken == nullptr means task
+ * context.
+ */
+static bool post_from(wm_producer_t producer, wm_event_t evt, BaseType_t *higher_priority_task_woken)
+{
+    if (producer >= WM_PRODUCER_COUNT) {
         return false;
     }
-    wm_event_t evt = {
-        .type = type,
-        .value = value,
-    };
-    return xQueueSend(s_event_queue, &evt, pdMS_TO_TICKS(20)) == pdTRUE;
+    evt.queued_us = event_timestamp_now();
+    if (is_input_event(evt.type)) {
+        evt.trace_id = trace_begin();
+        trace_mark(evt.trace_id, TRACE_STAGE_EDGE, evt.timestamp_us ? evt.timestamp_us : evt.queued_us,
+                   (uint8_t)evt.type);
+    }
+
+    bool posted = true;
+    if (event_lane(evt.type) == WM_LANE_COLLAPSED) {
+        collapse_event(evt);
+    } else {
+        wm_queue_stats_t &stats = s_event_stats[producer];
+        posted = s_event_rings[producer].push(evt);
+        if (posted) {
+            ETRACE(ETRACE_EVENT_POST, producer, evt.type);
+            stats.sent++;
+            uint32_t depth = s_event_rings[producer].size();
+            if (depth > stats.high_water) {
+                stats.high_water = depth;
+            }
+        } else {
+            ETRACE(ETRACE_EVENT_DROP, producer, evt.type);
+            stats.dropped++;
+        }
+    }
+
+    // ENQUEUE keeps the time taken before the push, so it still precedes a
+    // dispatch on the other core that beats this mark to the trace ring
+    if (posted) {
+        trace_mark(evt.trace_id, TRACE_STAGE_ENQUEUE, evt.queued_us, (uint8_t)evt.type);
+    } else {
+        trace_drop(evt.trace_id);
+    }
+
+    if (posted && s_mgr_task) {
+        if (higher_priority_task_woken) {
+            vTaskNotifyGiveFromISR(s_mgr_task, higher_priority_task_woken);
+        } else {
+            xTaskNotifyGive(s_mgr_task);
+        }
+    }
+    return posted;
+}
+
+static inline bool enqueue_event_internal(wm_producer_t producer, wm_event_type_t type, int32_t value)
+{
+    wm_event_t evt = {};
+    evt.type = type;
+    evt.value = value;
+    evt.timestamp_us = event_timestamp_now();
+    return post_from(producer, evt, nullptr);
+}
+
+static bool send_command(wm_command_t cmd)
+{
+    cmd.trace_id = s_dispatch_trace_id;
+    trace_mark(cmd.trace_id, TRACE_STAGE_COMMAND, 0, (uint8_t)cmd.type);
+    if (!s_command_ring.push(cmd)) {
+        ETRACE(ETRACE_COMMAND_DROP, cmd.type, 0);
+        s_command_stats.dropped++;
+        ESP_LOGW(TAG, "Command ring full; dropped command %d (%lu drops)",
+                 cmd.type, (unsigned long)s_command_stats.dropped);
+        return false;
+    }
+    s_command_stats.sent++;
+    uint32_t depth = s_command_ring.size();
+    if (depth > s_command_stats.high_water) {
+        s_command_stats.high_water = depth;
+    }
+    if (s_actuator_task) {
+        xTaskNotifyGive(s_actuator_task);
+    }
+    return true;
 }
 
 static inline void enqueue_command(wm_command_type_t type, int32_t arg0, int32_t arg1)
 {
-    if (!s_command_queue) {
+    wm_command_t cmd = {};
+    cmd.type = type;
+    cmd.arg0 = arg0;
+    cmd.arg1 = arg1;
+    send_command(cmd);
+}
+
+// Several output writes applied back to back by the actuator
+static void enqueue_batch(std::initializer_list<wm_output_op_t> ops)
+{
+    wm_command_t cmd = {};
+    cmd.type = WM_CMD_BATCH;
+    for (const wm_output_op_t &op : ops) {
+        if (cmd.batch.count == WM_CMD_BATCH_MAX) {
+            send_command(cmd);
+            cmd.batch.count = 0;
+        }
+        cmd.batch.ops[cmd.batch.count++] = op;
+    }
+    if (cmd.batch.count > 0) {
+        send_command(cmd);
+    }
+}
+
+// Play a static table of timed steps; replaces any sequence still running
+static inline void enqueue_sequence(const wm_sequence_step_t *steps, uint8_t count)
+{
+    wm_command_t cmd = {};
+    cmd.type = WM_CMD_SEQUENCE;
+    cmd.sequence.steps = steps;
+    cmd.sequence.count = count;
+    send_command(cmd);
+}
+
+// Block until the actuator has taken every command and its fades have run
+// out; false if it is still busy after timeout
+static bool wait_actuator_idle(TickType_t timeout)
+{
+    xSemaphoreTake(s_actuator_idle, 0);     // Drop an answer nobody took
+    s_actuator_idle_wanted.store(true, std::memory_order_release);
+    xTaskNotifyGive(s_actuator_task);
+    if (xSemaphoreTake(s_actuator_idle, timeout) == pdPASS) {
+        return true;
+    }
+    s_actuator_idle_wanted.store(false, std::memory_order_relaxed);
+    return false;
+}
+
+void tasks_get_command_queue_stats(wm_queue_stats_t *stats)
+{
+    if (!stats) {
         return;
     }
-    wm_command_t cmd = {
-        .type = type,
-        .arg0 = arg0,
-        .arg1 = arg1,
-    };
-    xQueueSend(s_command_queue, &cmd, pdMS_TO_TICKS(50));
+    *stats = s_command_stats;
+    stats->depth = s_command_ring.size();
+}
+
+void tasks_get_event_ring_stats(wm_producer_t producer, wm_queue_stats_t *stats)
+{
+    if (!stats || producer >= WM_PRODUCER_COUNT) {
+        return;
+    }
+    *stats = s_event_stats[producer];
+    stats->depth = s_event_rings[producer].size();
 }
 
-bool tasks_post_event(const wm_event_t *event)
+bool tasks_post_event(wm_producer_t producer, const wm_event_t *event)
 {
     if (!event) {
         return false;
     }
-    return enqueue_event_internal(event->type, event->value);
+    wm_event_t evt = *event;
+    if (evt.timestamp_us == 0) {
+        evt.timestamp_us = event_timestamp_now();
+    }
+    return post_from(producer, evt, nullptr);
+}
+
+bool tasks_post_event_from_isr(const wm_event_t *event, BaseType_t *higher_priority_task_woken)
+{
+    if (!event || !higher_priority_task_woken) {
+        return false;
+    }
+    return post_from(WM_PRODUCER_IO, *event, higher_priority_task_woken);
 }
 
-bool tasks_post_simple_event(wm_event_type_t type, int32_t value)
+bool tasks_post_simple_event(wm_producer_t producer, wm_event_type_t type, int32_t value)
 {
-    return enqueue_event_internal(type, value);
+    return enqueue_event_internal(producer, type, value);
 }
 
 bool tasks_post_dial_delta(int delta)
 {
-    return enqueue_event_internal(WM_EVENT_DIAL_DELTA, delta);
+    // Collapsed lane: safe from any task
+    return enqueue_event_internal(WM_PRODUCER_SYSTEM, WM_EVENT_DIAL_DELTA, delta);
+}
+
+void tasks_set_replay_mode(bool enabled)
+{
+    s_replay_mode = enabled;
+}
+
+// Recorded events were dispatched after collapsing, so they go into a ring
+// as they are; the manager's handling of a tick or dial event does not
+// depend on its lane
+bool tasks_post_replay_event(const wm_event_t *event)
+{
+    if (!event) {
+        return false;
+    }
+    wm_event_t evt = *event;
+    evt.timestamp_us = 0;
+    evt.queued_us = event_timestamp_now();
+    evt.trace_id = 0;
+    wm_queue_stats_t &stats = s_event_stats[WM_PRODUCER_REPLAY];
+    if (!s_event_rings[WM_PRODUCER_REPLAY].push(evt)) {
+        stats.dropped++;
+        return false;
+    }
+    stats.sent++;
+    if (s_mgr_task) {
+        xTaskNotifyGive(s_mgr_task);
+    }
+    return true;
 }
 
 static void suspend_if(TaskHandle_t h) {
@@ -121,7 +452,6 @@ void tasks_suspend_all(void)
 {
     suspend_if(s_mgr_task);
     suspend_if(s_actuator_task);
-    suspend_if(s_io_task);
 #if CONFIG_BALANCE_DETECTION
     suspend_if(s_sensor_task);
 #endif
@@ -134,7 +464,6 @@ void tasks_resume_all(void)
 {
     resume_if(s_mgr_task);
     resume_if(s_actuator_task);
-    resume_if(s_io_task);
 #if CONFIG_BALANCE_DETECTION
     resume_if(s_sensor_task);
 #endif
@@ -147,7 +476,6 @@ void tasks_delete_all(void)
 {
     delete_if(s_mgr_task);
     delete_if(s_actuator_task);
-    delete_if(s_io_task);
 #if CONFIG_BALANCE_DETECTION
     delete_if(s_sensor_task);
 #endif
@@ -156,26 +484,156 @@ void tasks_delete_all(void)
     delete_if(s_wash_task_handle);
 }
 
+// Settings a plan was built from; the same fields cycle_checkpoint_t packs
+struct WmPlanInputs {
+    int program = -1;
+    int load_size = 0;
+    bool prewash = false;
+    uint8_t extra_rinses = 0;
+    int temp_idx = -1;
+    int spin_idx = -1;
+    int soil_idx = -1;
+};
+
 struct WmRuntimeContext {
     size_t stage_index = 0;
     wash_plan_t plan = {};
+    WmPlanInputs inputs;    // What the plan was built for
+    bool paused = false;    // Plan and motion task frozen mid-section
 };
 
+static WmPlanInputs current_plan_inputs(void)
+{
+    WmPlanInputs in;
+    in.program = machine_get_program();
+    in.load_size = machine_get_load_size();
+    in.prewash = machine_is_prewash_enabled();
+    in.extra_rinses = machine_get_extra_rinse_count();
+    in.temp_idx = machine_get_temp_idx();
+    in.spin_idx = machine_get_spin_idx();
+    in.soil_idx = machine_get_soil_idx();
+    return in;
+}
+
+static bool same_plan_inputs(const WmPlanInputs &a, const WmPlanInputs &b)
+{
+    return a.program == b.program && a.load_size == b.load_size && a.prewash == b.prewash &&
+           a.extra_rinses == b.extra_rinses && a.temp_idx == b.temp_idx &&
+           a.spin_idx == b.spin_idx && a.soil_idx == b.soil_idx;
+}
+
+/*
+ * Why pause parks the motion task instead of deleting it:
+ * - The motion task is a straight-line program (fill, then tumble or spin
+ *   loops), so its phase lives in its stack and locals. Deleting it on
+ *   pause and starting the section again on resume repeated the fill and
+ *   restarted the tumble pattern. Pausing now only raises a flag and rings
+ *   the task's notification; every wait in the task wakes on it, stops
+ *   the outputs it owns and blocks until resumed. It then restores those
+ *   outputs and finishes the wait it was in with the time that was left.
+ * - The task parks only inside a wait, never during an ODrive transaction,
+ *   so it never holds the ODrive mutex while parked.
+ * - Water stays in the drum while paused unless something drains it. The
+ *   drum is filled again on resume only if it held water when paused and
+ *   the drain pump ran meanwhile (s_drum_has_water).
+ */
+static std::atomic<bool> s_motion_paused{false};
+static std::atomic<bool> s_drum_has_water{false};
+
 static void wash_motion_task_entry(void *arg)
 {
-    wash_params_t params = *(wash_params_t *)arg;
-    free(arg);
+    const wash_params_t params = *(const wash_params_t *)arg;
     bool dir = false;
 
-    // Helper: bounded wait that sleeps in small chunks so the task remains
-    // responsive and timing can be polled or interrupted by the scheduler.
-    auto bounded_delay_ms = [](int total_ms) {
-        const int chunk = 50; // 50ms chunks
-        int remaining = total_ms;
-        while (remaining > 0) {
-            int wait = remaining > chunk ? chunk : remaining;
-            vTaskDelay(pdMS_TO_TICKS(wait));
-            remaining -= wait;
+    // Outputs as the task last set them; restored after a pause
+    float velocity_out = 0.0f;
+    uint32_t circulation_out = 0;
+    uint32_t fill_out = 0;
+    uint32_t drain_out = 0;
+
+    // A failed motor command is a safety event; report it once per task
+    bool fault_posted = false;
+    auto send_drum_velocity = [&fault_posted](float velocity) {
+        esp_err_t err = odrive_set_velocity(0, velocity);
+        if (err != ESP_OK && !fault_posted) {
+            fault_posted = tasks_post_simple_event(WM_PRODUCER_MOTION, WM_EVENT_MOTOR_FAULT, err);
+        }
+    };
+    auto set_drum_velocity = [&](float velocity) {
+        velocity_out = velocity;
+        send_drum_velocity(velocity);
+    };
+    auto set_circulation_pump = [&](uint32_t duty) {
+        circulation_out = duty;
+        pwm_set_circulation_pump(duty);
+    };
+    auto set_fill_pump = [&](uint32_t duty) {
+        fill_out = duty;
+        pwm_set_fill_pump(duty);
+    };
+    auto set_drain_pump = [&](uint32_t duty) {
+        drain_out = duty;
+        if (duty > 0) {
+            s_drum_has_water.store(false, std::memory_order_relaxed);
+        }
+        pwm_set_drain_pump(duty);
+    };
+
+    // Wait up to `remaining` ticks; the pause notification cuts it short.
+    // Returns true if paused, with `remaining` reduced by the time waited.
+    auto wait_step = [](TickType_t &remaining) {
+        const TickType_t start = xTaskGetTickCount();
+        if (!s_motion_paused.load(std::memory_order_acquire)) {
+            ulTaskNotifyTake(pdTRUE, remaining);
+        }
+        const TickType_t waited = xTaskGetTickCount() - start;
+        remaining = waited >= remaining ? 0 : remaining - waited;
+        return s_motion_paused.load(std::memory_order_acquire);
+    };
+
+    // Stop every output and block until resumed
+    auto hold = [&send_drum_velocity]() {
+        send_drum_velocity(0);
+        pwm_set_circulation_pump(0);
+        pwm_set_fill_pump(0);
+        pwm_set_drain_pump(0);
+        while (s_motion_paused.load(std::memory_order_acquire)) {
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        }
+    };
+
+    // Hold, top the drum up again if it was drained meanwhile, then put the
+    // outputs back as they were
+    auto park = [&]() {
+        const bool had_water = s_drum_has_water.load(std::memory_order_relaxed);
+        hold();
+        if (had_water && !s_drum_has_water.load(std::memory_order_relaxed)) {
+            ESP_LOGI(TAG, "Drum drained while paused; filling again");
+            pwm_set_fill_pump(4095);
+            TickType_t left = pdMS_TO_TICKS(10000);
+            while (left > 0) {
+                if (wait_step(left)) {
+                    hold();
+                    pwm_set_fill_pump(4095);
+                }
+            }
+            pwm_set_fill_pump(0);
+            s_drum_has_water.store(true, std::memory_order_relaxed);
+        }
+        pwm_set_circulation_pump(circulation_out);
+        pwm_set_fill_pump(fill_out);
+        pwm_set_drain_pump(drain_out);
+        send_drum_velocity(velocity_out);
+    };
+
+    // Replaces fixed delays: the clock stops while paused, and the outputs
+    // stop within a context switch of the pause
+    auto wait_ms = [&](int total_ms) {
+        TickType_t left = total_ms > 0 ? pdMS_TO_TICKS(total_ms) : 0;
+        while (left > 0) {
+            if (wait_step(left)) {
+                park();
+            }
         }
     };
 
@@ -188,26 +646,23 @@ static void wash_motion_task_entry(void *arg)
      *   keeps the initial implementation predictable for tests.
      */
     if (params.fill_water) {
-        pwm_set_fill_pump(4095);
-        // Use bounded wait so task stays responsive and can be preempted
-        bounded_delay_ms(10000);
-        pwm_set_fill_pump(0);
+        set_fill_pump(4095);
+        wait_ms(10000);
+        set_fill_pump(0);
+        s_drum_has_water.store(true, std::memory_order_relaxed);
     }
 
     if (params.drain_water) {
-        pwm_set_drain_pump(4095);
+        set_drain_pump(4095);
         // Drain continues during spin usually.
     }
 
     if (params.spin_rpm > 0) {
-        // Spin cycle: set target velocity and then wait while allowing
-        // the task to remain responsive. Use bounded_delay_ms so that
-        // other events (stop/abort) can be serviced in a timely manner.
-        odrive_set_velocity(0, rpm_to_turns_per_sec(params.spin_rpm));
-        // Wait indefinitely until task is deleted by stop_wash_action; use
-        // a long bounded loop to avoid a single huge blocking delay.
+        // Spin cycle: set target velocity and then wait until the task is
+        // deleted by stop_wash_action, in waits that pause can interrupt
+        set_drum_velocity(rpm_to_turns_per_sec(params.spin_rpm));
         while (true) {
-            bounded_delay_ms(1000);
+            wait_ms(1000);
         }
     }
 
@@ -215,29 +670,29 @@ static void wash_motion_task_entry(void *arg)
     while (true) {
         if (params.alternate_direction) {
             // Stop before reversing
-            odrive_set_velocity(0, 0);
-            vTaskDelay(pdMS_TO_TICKS(150));
+            set_drum_velocity(0);
+            wait_ms(150);
             dir = !dir;
         }
 
         float velocity = rpm_to_turns_per_sec(params.tumble_rpm);
         if (dir) velocity = -velocity;
-        odrive_set_velocity(0, velocity);
+        set_drum_velocity(velocity);
 
         if (params.pump_on_steps > 0) {
             for (int i = 0; i < params.pump_on_steps; i++) {
-                pwm_set_circulation_pump(params.circulation_pump_pwm);
-                bounded_delay_ms(params.pump_on_step_ms);
-                pwm_set_circulation_pump(0);
-                bounded_delay_ms(params.pump_on_step_ms);
+                set_circulation_pump(params.circulation_pump_pwm);
+                wait_ms(params.pump_on_step_ms);
+                set_circulation_pump(0);
+                wait_ms(params.pump_on_step_ms);
                 if (params.alternate_direction) {
                     dir = !dir;
                     velocity = -velocity;
-                    odrive_set_velocity(0, velocity);
+                    set_drum_velocity(velocity);
                 }
             }
-            odrive_set_velocity(0, 0);
-            bounded_delay_ms(params.stop_duration_ms);
+            set_drum_velocity(0);
+            wait_ms(params.stop_duration_ms);
             continue;
         }
 
@@ -246,42 +701,54 @@ static void wash_motion_task_entry(void *arg)
         int pump_on_end = (int)(tumble_ms * params.pump_on_end_frac);
 
         if (pump_on_start > 0) {
-            bounded_delay_ms(pump_on_start);
+            wait_ms(pump_on_start);
         }
 
         if (pump_on_end > pump_on_start) {
-            pwm_set_circulation_pump(params.circulation_pump_pwm);
-            bounded_delay_ms(pump_on_end - pump_on_start);
-            pwm_set_circulation_pump(0);
+            set_circulation_pump(params.circulation_pump_pwm);
+            wait_ms(pump_on_end - pump_on_start);
+            set_circulation_pump(0);
         }
 
         if (tumble_ms > pump_on_end) {
-            bounded_delay_ms(tumble_ms - pump_on_end);
+            wait_ms(tumble_ms - pump_on_end);
         }
 
-        odrive_set_velocity(0, 0);
-        vTaskDelay(pdMS_TO_TICKS(params.stop_duration_ms));
+        set_drum_velocity(0);
+        wait_ms(params.stop_duration_ms);
     }
 }
 
+// Outputs owned by the motion task
+static void stop_motion_outputs(void)
+{
+    odrive_set_velocity(0, 0);
+    pwm_set_circulation_pump(0);
+    pwm_set_fill_pump(0);
+    pwm_set_drain_pump(0);
+}
+
 static void start_wash_action(const wash_params_t &params)
 {
     if (s_wash_task_handle) {
         vTaskDelete(s_wash_task_handle);
         s_wash_task_handle = nullptr;
+        // Each section starts from rest: a rinse must not fill with the
+        // drain pump and the spin left over from the interim spin
+        stop_motion_outputs();
     }
+    s_motion_paused.store(false, std::memory_order_release);
     /*
-     * We copy `params` to heap memory and pass it to the wash task because
-     * FreeRTOS task entry functions accept a `void*` parameter. Allocating a
-     * small copy on the heap avoids stack lifetime issues and keeps the task
-     * API simple. The caller must ensure the runtime doesn't run out of heap
-     * for many concurrent wash starts; if that becomes a problem, switch to
-     * a pooled allocator or pass an index into preallocated storage.
+     * The task gets a pointer to s_wash_params rather than to `params`,
+     * whose lifetime ends with this call. Only one wash task exists at a
+     * time and the previous one is gone by now, so one slot is enough and
+     * starting a wash does not touch the heap.
      */
-    wash_params_t *p = (wash_params_t *)malloc(sizeof(wash_params_t));
-    if (p) {
-        *p = params;
-        xTaskCreate(wash_motion_task_entry, "wash_motion", 4096, p, 4, &s_wash_task_handle);
+    s_wash_params = params;
+    if (create_task(s_wash_slot, wash_motion_task_entry, "wash_motion", &s_wash_params, 4,
+                    &s_wash_task_handle, WASH_TASK_CORE) != pdPASS) {
+        s_wash_task_handle = nullptr;
+        ESP_LOGE(TAG, "Failed to create wash task");
     }
 }
 
@@ -291,10 +758,25 @@ static void stop_wash_action(void)
         vTaskDelete(s_wash_task_handle);
         s_wash_task_handle = nullptr;
     }
-    odrive_set_velocity(0, 0);
-    pwm_set_circulation_pump(0);
-    pwm_set_fill_pump(0);
-    pwm_set_drain_pump(0);
+    s_motion_paused.store(false, std::memory_order_release);
+    stop_motion_outputs();
+}
+
+// Park the motion task where it is; it stops its own outputs
+static void pause_wash_action(void)
+{
+    s_motion_paused.store(true, std::memory_order_release);
+    if (s_wash_task_handle) {
+        xTaskNotifyGive(s_wash_task_handle);
+    }
+}
+
+static void resume_wash_action(void)
+{
+    s_motion_paused.store(false, std::memory_order_release);
+    if (s_wash_task_handle) {
+        xTaskNotifyGive(s_wash_task_handle);
+    }
 }
 
 static void publish_plan_metadata(const WmRuntimeContext &ctx)
@@ -310,7 +792,10 @@ static void publish_plan_metadata(const WmRuntimeContext &ctx)
 static bool rebuild_program_plan(WmRuntimeContext &ctx)
 {
     ctx.stage_index = 0;
-    bool ok = wash_plan_build(&ctx.plan, machine_get_program(), machine_get_load_size(), machine_is_prewash_enabled(), machine_get_extra_rinse_count());
+    ctx.paused = false;
+    ctx.inputs = current_plan_inputs();
+    const WmPlanInputs &in = ctx.inputs;
+    bool ok = wash_plan_build(&ctx.plan, in.program, in.load_size, in.prewash, in.extra_rinses);
     if (!ok) {
         ESP_LOGE(TAG, "Wash plan is empty");
         machine_set_eta_available(false);
@@ -325,6 +810,89 @@ static bool rebuild_program_plan(WmRuntimeContext &ctx)
     return true;
 }
 
+#if CONFIG_CYCLE_CHECKPOINT
+// Set at power-on while the resume prompt is up; manager task only
+static bool s_resume_offered = false;
+
+static void save_checkpoint(const WmRuntimeContext &ctx, bool section_changed)
+{
+    if (ctx.stage_index >= ctx.plan.length) {
+        return;
+    }
+    const int32_t remaining = ctx.plan.sections[ctx.stage_index].remaining_seconds;
+    // What the plan was built for, not edits made since (a paused cycle)
+    const WmPlanInputs &in = ctx.inputs;
+    cycle_checkpoint_t cp = {};
+    cp.program = static_cast<uint8_t>(in.program);
+    cp.load_size = static_cast<uint8_t>(in.load_size);
+    cp.prewash = in.prewash;
+    cp.extra_rinses = in.extra_rinses;
+    cp.temp_idx = static_cast<int8_t>(in.temp_idx);
+    cp.spin_idx = static_cast<int8_t>(in.spin_idx);
+    cp.soil_idx = static_cast<int8_t>(in.soil_idx);
+    cp.stage_index = static_cast<uint8_t>(ctx.stage_index);
+    cp.remaining_seconds = static_cast<uint16_t>(remaining > 0 ? remaining : 0);
+    cp.elapsed_seconds = static_cast<uint32_t>(machine_get_elapsed_seconds());
+    cycle_checkpoint_save(&cp, section_changed);
+}
+
+// Rebuild the interrupted cycle's plan and position it where it stopped
+static bool restore_checkpoint(WmRuntimeContext &ctx)
+{
+    cycle_checkpoint_t cp;
+    if (!cycle_checkpoint_pending(&cp)) {
+        return false;
+    }
+    // The program first: selecting it resets the options to its defaults
+    machine_set_program(cp.program);
+    machine_set_load_size(cp.load_size);
+    machine_set_prewash_enabled(cp.prewash);
+    machine_set_extra_rinse_count(cp.extra_rinses);
+    if (cp.temp_idx >= 0) {
+        machine_set_temp_idx(cp.temp_idx);
+    }
+    if (cp.spin_idx >= 0) {
+        machine_set_spin_idx(cp.spin_idx);
+    }
+    if (cp.soil_idx >= 0) {
+        machine_set_soil_idx(cp.soil_idx);
+    }
+    if (!rebuild_program_plan(ctx) || cp.stage_index >= ctx.plan.length) {
+        ESP_LOGW(TAG, "Checkpoint does not match the wash plan; discarding");
+        cycle_checkpoint_clear();
+        return false;
+    }
+    ctx.stage_index = cp.stage_index;
+    wash_section_instance_t &section = ctx.plan.sections[ctx.stage_index];
+    if (cp.remaining_seconds < section.remaining_seconds) {
+        section.remaining_seconds = cp.remaining_seconds;
+    }
+    machine_set_stage(static_cast<int>(ctx.stage_index));
+    machine_set_elapsed_seconds(static_cast<int>(cp.elapsed_seconds));
+    machine_set_eta(wash_plan_eta_from(&ctx.plan, ctx.stage_index));
+    publish_plan_metadata(ctx);
+    ESP_LOGI(TAG, "Offering to resume at %s, %ld s left in section",
+             section.label, (long)section.remaining_seconds);
+    return true;
+}
+#endif
+
+// The logo and the chime get a second, then the drum light fades in and the
+// logo hands over to the UI; played by the actuator so the manager keeps
+// taking input meanwhile
+static const wm_sequence_step_t kPowerOnSteps[] = {
+    { 1000, WM_CMD_RAMP, WM_CMD_SET_DRUM_LED, 3072, DRUM_LED_FADE_MS },
+    { 0, WM_CMD_SET_LOGO_ENABLE, 0, 0, 0 },
+};
+
+// Mirror image on the way down; apply_power_off() waits for it to finish
+static const wm_sequence_step_t kPowerOffSteps[] = {
+    { 1000, WM_CMD_RAMP, WM_CMD_SET_DRUM_LED, 0, DRUM_LED_FADE_MS },
+    { 0, WM_CMD_SET_POWER_LED, 0, 0, 0 },
+    { 0, WM_CMD_SET_DIAL_LEDS, -1, 0, 0 },     // WS2812s latch; clear before sleep
+    { 0, WM_CMD_SET_LOGO_ENABLE, 0, 0, 0 },
+};
+
 static void apply_power_on(WmRuntimeContext &ctx)
 {
     if (machine_is_powered()) {
@@ -337,23 +905,30 @@ static void apply_power_on(WmRuntimeContext &ctx)
     machine_set_logo_enabled(true);
     ui_controller_show_logo();
     machine_set_drum_light(false);
-    enqueue_command(WM_CMD_SET_POWER_LED, 1, 0);
-    enqueue_command(WM_CMD_SET_DRUM_LED, 0, 0);
-    enqueue_command(WM_CMD_SET_START_LED, 0, 0);
-    enqueue_command(WM_CMD_SET_LOGO_ENABLE, 1, 0);
+    enqueue_batch({
+        { WM_CMD_SET_POWER_LED, 1 },
+        { WM_CMD_SET_DRUM_LED, 0 },
+        { WM_CMD_SET_START_LED, 0 },
+        { WM_CMD_SET_LOGO_ENABLE, 1 },
+    });
     if (!machine_is_muted()) {
         enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_ON, 0);
     }
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    for (int level = 0; level <= 3072; level += 64) {
-        enqueue_command(WM_CMD_SET_DRUM_LED, level, 0);
-        vTaskDelay(pdMS_TO_TICKS(2));
-    }
+    // The display keeps the logo up until the sequence clears it
+    enqueue_sequence(kPowerOnSteps, sizeof(kPowerOnSteps) / sizeof(kPowerOnSteps[0]));
     machine_set_drum_light(true);
-    enqueue_command(WM_CMD_SET_LOGO_ENABLE, 0, 0);
-    machine_set_logo_enabled(false);
+#if CONFIG_CYCLE_CHECKPOINT
+    s_resume_offered = restore_checkpoint(ctx);
+    if (s_resume_offered) {
+        ui_controller_show_resume();
+    } else {
+        ui_controller_reset();
+    }
+#else
     ui_controller_reset();
-    ESP_LOGI(TAG, "Power on sequence complete");
+#endif
+    enqueue_command(WM_CMD_SET_DIAL_LEDS, machine_get_program(), 0);
+    ESP_LOGI(TAG, "Power on sequence started");
     // Enable both power and start buttons while the machine is on
     ulp_set_button_mask(0x3);
 
@@ -374,23 +949,42 @@ static void apply_power_off(WmRuntimeContext &ctx)
     machine_set_eta_available(false);
     machine_set_logo_enabled(true);
     ui_controller_show_logo();
-    enqueue_command(WM_CMD_SET_START_LED, 0, 0);
-    enqueue_command(WM_CMD_SET_LOGO_ENABLE, 1, 0);
+    enqueue_batch({
+        { WM_CMD_SET_START_LED, 0 },
+        { WM_CMD_SET_LOGO_ENABLE, 1 },
+    });
     if (!machine_is_muted()) {
         enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_OFF, 0);
     }
-    vTaskDelay(pdMS_TO_TICKS(1000));
-    for (int level = 3072; level >= 0; level -= 64) {
-        enqueue_command(WM_CMD_SET_DRUM_LED, level, 0);
-        vTaskDelay(pdMS_TO_TICKS(2));
-    }
+    enqueue_sequence(kPowerOffSteps, sizeof(kPowerOffSteps) / sizeof(kPowerOffSteps[0]));
     machine_set_drum_light(false);
-    enqueue_command(WM_CMD_SET_POWER_LED, 0, 0);
-    enqueue_command(WM_CMD_SET_LOGO_ENABLE, 0, 0);
+    // Deep sleep would cut the sequence short: let it play and the fade run
+    // out, or the drum light and the latched WS2812s stay lit
+    if (!wait_actuator_idle(pdMS_TO_TICKS(POWER_OFF_SETTLE_MS))) {
+        ESP_LOGW(TAG, "Outputs not settled after %d ms (%u commands queued); sleeping anyway",
+                 POWER_OFF_SETTLE_MS, (unsigned)s_command_ring.size());
+    }
     ESP_LOGI(TAG, "Power off sequence complete");
+#if CONFIG_CYCLE_CHECKPOINT
+    // Switching off abandons the cycle; an unanswered resume offer stays
+    if (!s_resume_offered) {
+        cycle_checkpoint_clear();
+    }
+    cycle_checkpoint_log_stats();
+#endif
+    tasks_log_latency();
+    wm_queue_stats_t cmd_stats;
+    tasks_get_command_queue_stats(&cmd_stats);
+    ESP_LOGI(TAG, "Command queue: sent=%lu dropped=%lu high_water=%lu/32",
+             (unsigned long)cmd_stats.sent, (unsigned long)cmd_stats.dropped,
+             (unsigned long)cmd_stats.high_water);
     // Only the power button should be active while off
     ulp_set_button_mask(0x1);
     ESP_LOGI(TAG, "Power off: entering deep sleep with ULP watching power button");
+#if CONFIG_SIMULATOR_MODE
+    // The last output writes are still waiting for the telemetry period
+    simulator_flush_telemetry();
+#endif
     ESP_ERROR_CHECK(ulp_power_enter_deep_sleep());
 }
 
@@ -406,38 +1000,115 @@ static void complete_cycle(WmRuntimeContext &ctx)
         enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_CYCLE_END, 0);
     }
     stop_wash_action();
+#if CONFIG_CYCLE_CHECKPOINT
+    cycle_checkpoint_clear();
+#endif
     ESP_LOGI(TAG, "Cycle complete");
 }
 
-static void start_cycle(WmRuntimeContext &ctx)
+static bool can_start_cycle(void)
 {
     if (!machine_is_powered()) {
         ESP_LOGW(TAG, "Ignoring start request while powered off");
-        return;
+        return false;
     }
     if (machine_is_running()) {
-        return;
+        return false;
     }
     if (machine_is_door_open()) {
         ESP_LOGW(TAG, "Door is open, refusing to start");
         if (!machine_is_muted()) {
             enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_ERROR, 0);
         }
-        return;
-    }
-    if (!rebuild_program_plan(ctx)) {
-        ESP_LOGE(TAG, "Failed to build wash plan; aborting start");
-        return;
+        return false;
     }
+    return true;
+}
+
+// Run the plan from ctx.stage_index
+static void run_cycle(WmRuntimeContext &ctx)
+{
     machine_set_running(true);
     enqueue_command(WM_CMD_SET_START_LED, 1, 0);
     if (!machine_is_muted()) {
         enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_CYCLE_START, 0);
     }
     start_wash_action(ctx.plan.sections[ctx.stage_index].params);
+#if CONFIG_CYCLE_CHECKPOINT
+    save_checkpoint(ctx, true);
+#endif
+}
+
+// Continue a paused cycle: same section, same remaining time, and the
+// motion task picks up where it was parked
+static void resume_paused_cycle(WmRuntimeContext &ctx)
+{
+    ctx.paused = false;
+    machine_set_running(true);
+    enqueue_command(WM_CMD_SET_START_LED, 1, 0);
+    if (!machine_is_muted()) {
+        enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_CYCLE_START, 0);
+    }
+    resume_wash_action();
+#if CONFIG_CYCLE_CHECKPOINT
+    save_checkpoint(ctx, true);
+#endif
+    ESP_LOGI(TAG, "Cycle resumed in %s, %ld s left in section",
+             ctx.plan.sections[ctx.stage_index].label,
+             (long)ctx.plan.sections[ctx.stage_index].remaining_seconds);
+}
+
+static void start_cycle(WmRuntimeContext &ctx)
+{
+    if (!can_start_cycle()) {
+        return;
+    }
+    if (ctx.paused && ctx.stage_index < ctx.plan.length) {
+        if (same_plan_inputs(current_plan_inputs(), ctx.inputs)) {
+            resume_paused_cycle(ctx);
+            return;
+        }
+        // The paused plan was built for other settings; honour the edit
+        ESP_LOGI(TAG, "Settings changed while paused; starting over");
+        stop_wash_action();
+    }
+    if (!rebuild_program_plan(ctx)) {
+        ESP_LOGE(TAG, "Failed to build wash plan; aborting start");
+        return;
+    }
+    run_cycle(ctx);
     ESP_LOGI(TAG, "Cycle started");
 }
 
+#if CONFIG_CYCLE_CHECKPOINT
+// Start on the resume prompt: continue the restored plan where it stopped
+static void resume_cycle(WmRuntimeContext &ctx)
+{
+    if (!can_start_cycle()) {
+        return;
+    }
+    s_resume_offered = false;
+    ui_controller_reset();
+    run_cycle(ctx);
+    ESP_LOGI(TAG, "Cycle resumed at %s", ctx.plan.sections[ctx.stage_index].label);
+}
+
+// Long press on the resume prompt: forget the interrupted cycle
+static void discard_resume(WmRuntimeContext &ctx)
+{
+    s_resume_offered = false;
+    cycle_checkpoint_clear();
+    ctx.stage_index = 0;
+    ctx.plan = {};
+    machine_set_stage(0);
+    machine_set_eta(0);
+    machine_set_elapsed_seconds(0);
+    publish_plan_metadata(ctx);
+    ui_controller_reset();
+    ESP_LOGI(TAG, "Interrupted cycle discarded");
+}
+#endif
+
 static void pause_cycle(WmRuntimeContext &ctx)
 {
     if (!machine_is_running()) {
@@ -448,7 +1119,11 @@ static void pause_cycle(WmRuntimeContext &ctx)
     if (!machine_is_muted()) {
         enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_STOP, 0);
     }
-    stop_wash_action();
+    pause_wash_action();
+    ctx.paused = true;
+#if CONFIG_CYCLE_CHECKPOINT
+    save_checkpoint(ctx, true);
+#endif
     ESP_LOGI(TAG, "Cycle paused");
 }
 
@@ -466,7 +1141,9 @@ static void process_timer_tick(WmRuntimeContext &ctx)
         machine_increment_elapsed();
     }
     machine_set_eta(wash_plan_eta_from(&ctx.plan, ctx.stage_index));
+    bool advanced = false;
     if (section.remaining_seconds <= 0) {
+        advanced = true;
         ctx.stage_index++;
         machine_set_stage(static_cast<int>(ctx.stage_index));
         publish_plan_metadata(ctx);
@@ -477,117 +1154,384 @@ static void process_timer_tick(WmRuntimeContext &ctx)
             start_wash_action(ctx.plan.sections[ctx.stage_index].params);
         }
     }
+#if CONFIG_CYCLE_CHECKPOINT
+    if (machine_is_running()) {
+        save_checkpoint(ctx, advanced);
+    }
+#else
+    (void)advanced;
+#endif
 }
 
-static void system_manager_task(void *arg)
+void tasks_log_latency(void)
 {
-    (void)arg;
-    WmRuntimeContext ctx;
-    ESP_LOGI(TAG, "System manager started");
-    while (true) {
-        wm_event_t evt;
-        if (xQueueReceive(s_event_queue, &evt, portMAX_DELAY) != pdTRUE) {
-            continue;
+    static const char *names[WM_EVENT_TYPE_COUNT] = {
+        "power_button", "start_button", "door", "tick", "sensor", "start_long", "dial",
+        "motor_fault",
+    };
+    static const char *lane_names[WM_LANE_COUNT] = {
+        "lane_safety", "lane_normal", "lane_collapsed",
+    };
+    for (int i = 0; i < WM_EVENT_TYPE_COUNT; i++) {
+        if (is_input_event(static_cast<wm_event_type_t>(i))) {
+            latency_hist_log(names[i], &s_input_latency[i]);
         }
-        switch (evt.type) {
-            case WM_EVENT_POWER_BUTTON:
-                if (machine_is_powered()) {
-                    apply_power_off(ctx);
-                } else {
-                    apply_power_on(ctx);
-                }
-                break;
-            case WM_EVENT_START_BUTTON:
-                if (ui_controller_handle_start_press()) {
-                    break;
-                }
-                if (machine_is_running()) {
-                    pause_cycle(ctx);
-                } else {
-                    start_cycle(ctx);
-                }
-                break;
-            case WM_EVENT_START_LONG_PRESS:
-                ui_controller_handle_start_long_press();
-                break;
-            case WM_EVENT_DOOR_STATE: {
-                const bool door_open = (evt.value != 0);
-                machine_set_door_open(door_open);
-                ESP_LOGI(TAG, "Door state: %s", door_open ? "open" : "closed");
-                if (door_open && machine_is_running()) {
-                    pause_cycle(ctx);
-                }
-                break;
+    }
+    for (int i = 0; i < WM_LANE_COUNT; i++) {
+        latency_hist_log(lane_names[i], &s_lane_latency[i]);
+    }
+    trace_log_histograms();
+}
+
+// Move up to max events out of the producer rings, in producer order
+static size_t drain_event_rings(wm_event_t *out, size_t max)
+{
+    size_t count = 0;
+    for (int p = 0; p < WM_PRODUCER_COUNT && count < max; p++) {
+        count += s_event_rings[p].pop_batch(out + count, max - count);
+    }
+    return count;
+}
+
+// Take the pending dial delta, then the pending ticks, as one event each
+static bool take_collapsed_event(wm_event_t *evt)
+{
+    bool found = false;
+    *evt = {};
+    portENTER_CRITICAL(&s_collapse_lock);
+    if (s_collapsed.dial_pending) {
+        evt->type = WM_EVENT_DIAL_DELTA;
+        evt->value = s_collapsed.dial_delta;
+        evt->timestamp_us = s_collapsed.dial_timestamp_us;
+        evt->queued_us = s_collapsed.dial_queued_us;
+        evt->trace_id = s_collapsed.dial_trace_id;
+        s_collapsed.dial_pending = false;
+        found = true;
+    } else if (s_collapsed.ticks > 0) {
+        evt->type = WM_EVENT_TIMER_TICK;
+        evt->value = (int32_t)s_collapsed.ticks;
+        evt->queued_us = s_collapsed.tick_queued_us;
+        s_collapsed.ticks = 0;
+        found = true;
+    }
+    portEXIT_CRITICAL(&s_collapse_lock);
+    return found;
+}
+
+static void dispatch_event(WmRuntimeContext &ctx, const wm_event_t &evt, wm_event_lane_t lane)
+{
+    const uint32_t now_us = event_timestamp_now();
+    latency_hist_record(&s_lane_latency[lane], now_us - evt.queued_us);
+    if (evt.type < WM_EVENT_TYPE_COUNT && evt.timestamp_us != 0 && is_input_event(evt.type)) {
+        latency_hist_record(&s_input_latency[evt.type], now_us - evt.timestamp_us);
+    }
+    trace_mark(evt.trace_id, TRACE_STAGE_DISPATCH, now_us, (uint8_t)evt.type);
+    event_record_dispatch(&evt);
+    s_dispatch_trace_id = evt.trace_id;
+    ETRACE(ETRACE_DISPATCH_BEGIN, evt.type, evt.value);
+    switch (evt.type) {
+        case WM_EVENT_POWER_BUTTON:
+            if (machine_is_powered()) {
+                apply_power_off(ctx);
+            } else {
+                apply_power_on(ctx);
             }
-            case WM_EVENT_TIMER_TICK:
-                process_timer_tick(ctx);
+            break;
+        case WM_EVENT_START_BUTTON:
+#if CONFIG_CYCLE_CHECKPOINT
+            if (s_resume_offered) {
+                resume_cycle(ctx);
                 break;
-            case WM_EVENT_SENSOR_SAMPLE:
-                ESP_LOGW(TAG, "Imbalance detected, magnitude=%ld", evt.value);
-                break;
-            case WM_EVENT_DIAL_DELTA:
-                ui_controller_handle_dial_delta(evt.value);
+            }
+#endif
+            if (ui_controller_handle_start_press()) {
                 break;
-            default:
+            }
+            if (machine_is_running()) {
+                pause_cycle(ctx);
+            } else {
+                start_cycle(ctx);
+            }
+            break;
+        case WM_EVENT_START_LONG_PRESS:
+#if CONFIG_CYCLE_CHECKPOINT
+            if (s_resume_offered) {
+                discard_resume(ctx);
                 break;
+            }
+#endif
+            ui_controller_handle_start_long_press();
+            break;
+        case WM_EVENT_DOOR_STATE: {
+            const bool door_open = (evt.value != 0);
+            machine_set_door_open(door_open);
+            ESP_LOGI(TAG, "Door state: %s", door_open ? "open" : "closed");
+            if (door_open && machine_is_running()) {
+                pause_cycle(ctx);
+            }
+            break;
         }
+        case WM_EVENT_TIMER_TICK:
+            // Collapsed ticks carry how many seconds elapsed
+            for (int32_t i = 0; i < evt.value; i++) {
+                process_timer_tick(ctx);
+            }
+            break;
+        case WM_EVENT_SENSOR_SAMPLE:
+            ESP_LOGW(TAG, "Imbalance detected, magnitude=%ld", (long)evt.value);
+            break;
+        case WM_EVENT_MOTOR_FAULT:
+            ESP_LOGE(TAG, "Motor fault: %s", esp_err_to_name(evt.value));
+            if (machine_is_running()) {
+                pause_cycle(ctx);
+                odrive_emergency_stop();
+                if (!machine_is_muted()) {
+                    enqueue_command(WM_CMD_PLAY_SOUND, SOUND_EFFECT_ERROR, 0);
+                }
+            }
+            break;
+        case WM_EVENT_DIAL_DELTA:
+            ui_controller_handle_dial_delta(evt.value);
+            // Keep the ring on the selected program; a no-op without the ring
+            enqueue_command(WM_CMD_SET_DIAL_LEDS, machine_get_program(), 0);
+            break;
+        default:
+            break;
     }
+    ETRACE(ETRACE_DISPATCH_END, evt.type, 0);
+    s_dispatch_trace_id = 0;
 }
 
-static void actuator_task(void *arg)
+static void system_manager_task(void *arg)
 {
     (void)arg;
-    wm_command_t cmd;
+    WmRuntimeContext ctx;
+    // Drain buffer lives outside the task stack; only this task touches it
+    static wm_event_t batch[EVENT_BATCH_MAX];
+    ESP_LOGI(TAG, "System manager started");
     while (true) {
-        if (xQueueReceive(s_command_queue, &cmd, portMAX_DELAY) != pdTRUE) {
-            continue;
+        const size_t count = drain_event_rings(batch, EVENT_BATCH_MAX);
+        // Safety lane first, then the rest of the batch in arrival order
+        for (size_t i = 0; i < count; i++) {
+            if (event_lane(batch[i].type) == WM_LANE_SAFETY) {
+                dispatch_event(ctx, batch[i], WM_LANE_SAFETY);
+            }
         }
-        switch (cmd.type) {
-            case WM_CMD_SET_POWER_LED:
-                gpio_write(PIN_POWER_LED, cmd.arg0 ? 1 : 0);
-                machine_set_power_led(cmd.arg0 != 0);
-                break;
-            case WM_CMD_SET_DRUM_LED:
-                pwm_set_drum_led(cmd.arg0);
-                break;
-            case WM_CMD_SET_START_LED:
-                gpio_write(PIN_START_STOP_LED, cmd.arg0 ? 1 : 0);
-                machine_set_start_stop_led(cmd.arg0 != 0);
-                break;
-            case WM_CMD_PLAY_SOUND:
-                sound_play_effect((uint8_t)cmd.arg0);
-                break;
-            case WM_CMD_SET_LOGO_ENABLE:
-                machine_set_logo_enabled(cmd.arg0 != 0);
-                break;
-            case WM_CMD_SET_CIRC_PUMP_PWM:
-                pwm_set_circulation_pump(cmd.arg0);
-                break;
-            case WM_CMD_SET_FILL_PUMP_PWM:
-                pwm_set_fill_pump(cmd.arg0);
-                break;
-            case WM_CMD_SET_DRAIN_PUMP_PWM:
-                pwm_set_drain_pump(cmd.arg0);
-                break;
-            default:
-                break;
+        for (size_t i = 0; i < count; i++) {
+            if (event_lane(batch[i].type) != WM_LANE_SAFETY) {
+                dispatch_event(ctx, batch[i], WM_LANE_NORMAL);
+            }
+        }
+        bool collapsed = false;
+        wm_event_t evt;
+        while (take_collapsed_event(&evt)) {
+            dispatch_event(ctx, evt, WM_LANE_COLLAPSED);
+            collapsed = true;
+        }
+        if (count == 0 && !collapsed) {
+            // Every post rings the doorbell, so nothing is missed while asleep
+            ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
         }
     }
 }
 
-static void io_scanner_task(void *arg)
+/*
+ * Why the actuator protocol has batch, ramp and sequence commands:
+ * - Each queue item used to set one output, so a multi-output change cost
+ *   one round trip per output and an animation cost one item per frame,
+ *   with the manager pacing it by blocking. A batch carries up to
+ *   WM_CMD_BATCH_MAX writes, a ramp hands the whole fade to the LEDC
+ *   hardware, and a sequence is a static table of timed steps that this
+ *   task plays back itself.
+ * - The sequence never blocks the task: the doorbell wait is bounded by
+ *   the time left until the next step, so commands posted while a sequence
+ *   runs are still applied immediately. A new sequence replaces the old one.
+ * - The task is idle once the ring is empty, no sequence is playing and the
+ *   last LEDC fade has run out. apply_power_off() waits for that on
+ *   s_actuator_idle instead of polling the ring; while it waits, the
+ *   actuator also wakes for the end of the fade.
+ */
+
+struct ActuatorSequence {
+    const wm_sequence_step_t *steps = nullptr;
+    uint8_t count = 0;
+    uint8_t index = 0;
+    TickType_t due = 0;     // Tick at which steps[index] runs
+};
+
+// Actuator only: the last hardware fade runs until s_fade_end
+static bool s_fading = false;
+static TickType_t s_fade_end = 0;
+
+static void apply_output(wm_command_type_t type, int32_t value)
+{
+    switch (type) {
+        case WM_CMD_SET_POWER_LED:
+            gpio_write(PIN_POWER_LED, value ? 1 : 0);
+            machine_set_power_led(value != 0);
+            break;
+        case WM_CMD_SET_DRUM_LED:
+            pwm_set_drum_led(value);
+            break;
+        case WM_CMD_SET_START_LED:
+            gpio_write(PIN_START_STOP_LED, value ? 1 : 0);
+            machine_set_start_stop_led(value != 0);
+            break;
+        case WM_CMD_PLAY_SOUND:
+            sound_play_effect((uint8_t)value);
+            break;
+        case WM_CMD_SET_LOGO_ENABLE:
+            machine_set_logo_enabled(value != 0);
+            break;
+        case WM_CMD_SET_CIRC_PUMP_PWM:
+            pwm_set_circulation_pump(value);
+            break;
+        case WM_CMD_SET_FILL_PUMP_PWM:
+            pwm_set_fill_pump(value);
+            break;
+        case WM_CMD_SET_DRAIN_PUMP_PWM:
+            if (value > 0) {
+                s_drum_has_water.store(false, std::memory_order_relaxed);
+            }
+            pwm_set_drain_pump(value);
+            break;
+        case WM_CMD_SET_DIAL_LEDS:
+#if CONFIG_DIAL_ENCODER
+            program_dial_leds_set_selected(value);
+#endif
+            break;
+        default:
+            ESP_LOGW(TAG, "Command %d is not a single output write", type);
+            break;
+    }
+}
+
+static void apply_ramp(wm_command_type_t output, int32_t target, int32_t time_ms)
+{
+    const uint32_t ms = time_ms > 0 ? (uint32_t)time_ms : 0;
+    TickType_t end = xTaskGetTickCount() + pdMS_TO_TICKS(ms);
+    if (!s_fading || (int32_t)(end - s_fade_end) > 0) {
+        s_fade_end = end;
+    }
+    s_fading = true;
+    switch (output) {
+        case WM_CMD_SET_DRUM_LED:
+            pwm_fade_drum_led(target, ms);
+            break;
+        case WM_CMD_SET_CIRC_PUMP_PWM:
+            pwm_fade_circulation_pump(target, ms);
+            break;
+        case WM_CMD_SET_FILL_PUMP_PWM:
+            pwm_fade_fill_pump(target, ms);
+            break;
+        case WM_CMD_SET_DRAIN_PUMP_PWM:
+            if (target > 0) {
+                s_drum_has_water.store(false, std::memory_order_relaxed);
+            }
+            pwm_fade_drain_pump(target, ms);
+            break;
+        default:
+            // Digital outputs cannot fade; jump to the target
+            apply_output(output, target);
+            break;
+    }
+}
+
+static void apply_step(wm_command_type_t type, int32_t arg0, int32_t arg1, int32_t arg2)
+{
+    if (type == WM_CMD_RAMP) {
+        apply_ramp(static_cast<wm_command_type_t>(arg0), arg1, arg2);
+    } else {
+        apply_output(type, arg0);
+    }
+}
+
+static void sequence_run_due(ActuatorSequence &seq)
+{
+    while (seq.steps && (int32_t)(xTaskGetTickCount() - seq.due) >= 0) {
+        const wm_sequence_step_t &step = seq.steps[seq.index];
+        apply_step(step.type, step.arg0, step.arg1, step.arg2);
+        if (++seq.index >= seq.count) {
+            seq.steps = nullptr;
+            break;
+        }
+        // Relative to the previous step's due time, so delays do not drift
+        seq.due += pdMS_TO_TICKS(seq.steps[seq.index].delay_ms);
+    }
+}
+
+static TickType_t sequence_wait_ticks(const ActuatorSequence &seq)
+{
+    if (!seq.steps) {
+        return portMAX_DELAY;
+    }
+    int32_t remaining = (int32_t)(seq.due - xTaskGetTickCount());
+    return remaining > 0 ? (TickType_t)remaining : 0;
+}
+
+// Ticks until the next sequence step or, while idle is awaited, the fade end
+static TickType_t actuator_wait_ticks(const ActuatorSequence &seq)
+{
+    TickType_t wait = sequence_wait_ticks(seq);
+    if (s_fading && s_actuator_idle_wanted.load(std::memory_order_acquire)) {
+        int32_t fade_left = (int32_t)(s_fade_end - xTaskGetTickCount());
+        TickType_t fade_wait = fade_left > 0 ? (TickType_t)fade_left : 0;
+        if (fade_wait < wait) {
+            wait = fade_wait;
+        }
+    }
+    return wait;
+}
+
+static void actuator_report_idle(const ActuatorSequence &seq)
+{
+    if (s_fading && (int32_t)(xTaskGetTickCount() - s_fade_end) >= 0) {
+        s_fading = false;
+    }
+    if (seq.steps || s_fading || s_command_ring.size() > 0) {
+        return;
+    }
+    if (s_actuator_idle_wanted.exchange(false, std::memory_order_acq_rel)) {
+        xSemaphoreGive(s_actuator_idle);
+    }
+}
+
+static void actuator_task(void *arg)
 {
     (void)arg;
-    bool last_door = machine_is_door_open();
-    enqueue_event_internal(WM_EVENT_DOOR_STATE, last_door ? 1 : 0);
+    wm_command_t cmd;
+    ActuatorSequence seq;
     while (true) {
-        check_buttons();
-        bool door_now = machine_is_door_open();
-        if (door_now != last_door) {
-            last_door = door_now;
-            enqueue_event_internal(WM_EVENT_DOOR_STATE, door_now ? 1 : 0);
+        // Doorbell from send_command(), or the next sequence step is due
+        ulTaskNotifyTake(pdTRUE, actuator_wait_ticks(seq));
+        while (s_command_ring.pop(&cmd)) {
+            ETRACE(ETRACE_COMMAND_BEGIN, cmd.type, cmd.arg0);
+            switch (cmd.type) {
+                case WM_CMD_RAMP:
+                    apply_ramp(static_cast<wm_command_type_t>(cmd.arg0), cmd.arg1, cmd.arg2);
+                    break;
+                case WM_CMD_BATCH:
+                    for (uint8_t i = 0; i < cmd.batch.count && i < WM_CMD_BATCH_MAX; i++) {
+                        apply_output(cmd.batch.ops[i].type, cmd.batch.ops[i].value);
+                    }
+                    break;
+                case WM_CMD_SEQUENCE:
+                    seq = ActuatorSequence();
+                    if (cmd.sequence.steps && cmd.sequence.count > 0) {
+                        seq.steps = cmd.sequence.steps;
+                        seq.count = cmd.sequence.count;
+                        seq.due = xTaskGetTickCount() + pdMS_TO_TICKS(seq.steps[0].delay_ms);
+                    }
+                    break;
+                default:
+                    apply_output(cmd.type, cmd.arg0);
+                    break;
+            }
+            trace_mark(cmd.trace_id, TRACE_STAGE_ACTUATE, 0, (uint8_t)cmd.type);
+            ETRACE(ETRACE_COMMAND_END, cmd.type, 0);
         }
-        vTaskDelay(pdMS_TO_TICKS(50));
+        sequence_run_due(seq);
+        actuator_report_idle(seq);
     }
 }
 
@@ -601,7 +1545,7 @@ static void sensor_task(void *arg)
         if (mpu6050_analyze_vibration(&vibe) == ESP_OK) {
             if (vibe.imbalanced) {
                 int32_t magnitude_milli_g = (int32_t)(vibe.magnitude * 1000.0f);
-                enqueue_event_internal(WM_EVENT_SENSOR_SAMPLE, magnitude_milli_g);
+                enqueue_event_internal(WM_PRODUCER_SENSOR, WM_EVENT_SENSOR_SAMPLE, magnitude_milli_g);
             }
         }
         vTaskDelay(period);
@@ -616,45 +1560,50 @@ static void timer_tick_task(void *arg)
     TickType_t last = xTaskGetTickCount();
     while (true) {
         vTaskDelayUntil(&last, period);
-        enqueue_event_internal(WM_EVENT_TIMER_TICK, 0);
+        enqueue_event_internal(WM_PRODUCER_SYSTEM, WM_EVENT_TIMER_TICK, 0);     // Collapsed, no ring
     }
 }
 
 esp_err_t tasks_create_all(void)
 {
     ui_controller_reset();
+    event_record_start();
 
-    s_event_queue = xQueueCreate(32, sizeof(wm_event_t));
-    s_command_queue = xQueueCreate(32, sizeof(wm_command_t));
-    if (!s_event_queue || !s_command_queue) {
-        ESP_LOGE(TAG, "Failed to create control queues");
+    s_actuator_idle = create_binary_semaphore(s_actuator_idle_slot);
+    if (!s_actuator_idle) {
         return ESP_ERR_NO_MEM;
     }
 
     BaseType_t ret;
-    ret = xTaskCreatePinnedToCore(system_manager_task, "wm_mgr", 6144, nullptr, 6, &s_mgr_task, 1);
+    ret = create_task(s_mgr_slot, system_manager_task, "wm_mgr", nullptr, 6, &s_mgr_task, 1);
     if (ret != pdPASS) {
         return ESP_FAIL;
     }
-    ret = xTaskCreatePinnedToCore(actuator_task, "wm_act", 4096, nullptr, 5, &s_actuator_task, 1);
+    ret = create_task(s_actuator_slot, actuator_task, "wm_act", nullptr, 5, &s_actuator_task, 1);
     if (ret != pdPASS) {
         return ESP_FAIL;
     }
-    ret = xTaskCreatePinnedToCore(io_scanner_task, "wm_io", 3072, nullptr, 4, &s_io_task, 0);
-    if (ret != pdPASS) {
-        return ESP_FAIL;
+    if (!s_replay_mode) {
+        // Inputs are interrupt driven; this also posts the initial door state
+        esp_err_t err = app_input_irq_init();
+        if (err != ESP_OK) {
+            return err;
+        }
     }
 #if CONFIG_BALANCE_DETECTION
-    ret = xTaskCreatePinnedToCore(sensor_task, "wm_sensor", 4096, nullptr, 3, &s_sensor_task, 0);
+    ret = create_task(s_sensor_slot, sensor_task, "wm_sensor", nullptr, 3, &s_sensor_task, 0);
     if (ret != pdPASS) {
         return ESP_FAIL;
     }
 #endif
-    ret = xTaskCreatePinnedToCore(timer_tick_task, "wm_tick", 2048, nullptr, 2, &s_tick_task, 0);
-    if (ret != pdPASS) {
-        return ESP_FAIL;
+    // A replay brings its own ticks
+    if (!s_replay_mode) {
+        ret = create_task(s_tick_slot, timer_tick_task, "wm_tick", nullptr, 2, &s_tick_task, 0);
+        if (ret != pdPASS) {
+            return ESP_FAIL;
+        }
     }
-    ret = xTaskCreatePinnedToCore(display_task_entry, "wm_display", 4096, nullptr, 2, &s_display_task, 1);
+    ret = create_task(s_display_slot, display_task_entry, "wm_display", nullptr, 2, &s_display_task, 1);
     if (ret != pdPASS) {
         return ESP_FAIL;
     }
@@ -10,6 +10,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include "esp_err.h"
+#include "freertos/FreeRTOS.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,13 +24,39 @@ typedef enum {
     WM_EVENT_SENSOR_SAMPLE = 4,
     WM_EVENT_START_LONG_PRESS = 5,
     WM_EVENT_DIAL_DELTA = 6,
+    WM_EVENT_MOTOR_FAULT = 7,       // value = esp_err_t of the failed motor command
+    WM_EVENT_TYPE_COUNT
 } wm_event_type_t;
 
 typedef struct {
     wm_event_type_t type;
     int32_t value;
+    uint32_t timestamp_us;  // esp_timer time of the source edge (low 32 bits, 0 = stamp on post)
+    uint32_t queued_us;     // Set by the control plane when the event enters its lane
+    uint16_t trace_id;      // Set by the control plane for input events (diagnostics/trace.h)
 } wm_event_t;
 
+// Event sources; each owns one single-producer ring, so a context must
+// only ever post under its own id
+typedef enum {
+    WM_PRODUCER_IO = 0,     // Door GPIO and ULP button ISRs (tasks_post_event_from_isr)
+    WM_PRODUCER_SENSOR,     // wm_sensor task
+    WM_PRODUCER_HTTP,       // HTTP server handlers
+    WM_PRODUCER_SIM,        // Simulator UART task
+    WM_PRODUCER_MOTION,     // wash_motion task
+    WM_PRODUCER_SYSTEM,     // app_main (boot-time events)
+    WM_PRODUCER_REPLAY,     // Host event replayer (tasks_post_replay_event)
+    WM_PRODUCER_COUNT
+} wm_producer_t;
+
+// Event lanes, drained by the manager in this order
+typedef enum {
+    WM_LANE_SAFETY = 0,     // Door, imbalance, motor fault
+    WM_LANE_NORMAL,         // Buttons and everything else
+    WM_LANE_COLLAPSED,      // Dial deltas (summed) and timer ticks (counted)
+    WM_LANE_COUNT
+} wm_event_lane_t;
+
 typedef enum {
     WM_CMD_SET_POWER_LED = 0,
     WM_CMD_SET_DRUM_LED,
@@ -39,18 +66,68 @@ typedef enum {
     WM_CMD_SET_CIRC_PUMP_PWM,
     WM_CMD_SET_FILL_PUMP_PWM,
     WM_CMD_SET_DRAIN_PUMP_PWM,
+    WM_CMD_SET_DIAL_LEDS,
+    // Multi-step commands (see actuator_task)
+    WM_CMD_RAMP,                // arg0 = output (WM_CMD_SET_*), arg1 = target, arg2 = time (ms)
+    WM_CMD_BATCH,               // Apply batch.ops[] in order
+    WM_CMD_SEQUENCE,            // Run sequence.steps[] with delays; nullptr cancels
 } wm_command_type_t;
 
+#define WM_CMD_BATCH_MAX 4
+
+// One output write inside a batch (single-value WM_CMD_SET_* / PLAY_SOUND)
+typedef struct {
+    wm_command_type_t type;
+    int32_t value;
+} wm_output_op_t;
+
+// One step of a sequence; only single-value commands and WM_CMD_RAMP
+typedef struct {
+    uint16_t delay_ms;          // Wait after the previous step
+    wm_command_type_t type;
+    int32_t arg0;
+    int32_t arg1;
+    int32_t arg2;
+} wm_sequence_step_t;
+
 typedef struct {
     wm_command_type_t type;
     int32_t arg0;
     int32_t arg1;
+    int32_t arg2;
+    uint16_t trace_id;          // Input event being handled when this was sent (0 = none)
+    union {
+        struct {
+            uint8_t count;
+            wm_output_op_t ops[WM_CMD_BATCH_MAX];
+        } batch;
+        struct {
+            const wm_sequence_step_t *steps;    // Must stay valid (normally static const)
+            uint8_t count;
+        } sequence;
+    };
 } wm_command_t;
 
+typedef struct {
+    uint32_t sent;
+    uint32_t dropped;           // Rejected because the ring was full
+    uint32_t depth;             // Items waiting right now
+    uint32_t high_water;        // Deepest the queue has been
+} wm_queue_stats_t;
+
 esp_err_t tasks_create_all(void);
-bool tasks_post_event(const wm_event_t *event);
-bool tasks_post_simple_event(wm_event_type_t type, int32_t value);
-bool tasks_post_dial_delta(int delta);
+bool tasks_post_event(wm_producer_t producer, const wm_event_t *event);
+bool tasks_post_simple_event(wm_producer_t producer, wm_event_type_t type, int32_t value);
+bool tasks_post_dial_delta(int delta);      // Any task; dial deltas are collapsed, not queued
+bool tasks_post_event_from_isr(const wm_event_t *event, BaseType_t *higher_priority_task_woken);
+void tasks_log_latency(void);
+// Replay (diagnostics/event_record.h): set before tasks_create_all() to
+// leave out the inputs and the tick task, then post recorded events, each
+// once the previous one has been dispatched
+void tasks_set_replay_mode(bool enabled);
+bool tasks_post_replay_event(const wm_event_t *event);     // One task only
+void tasks_get_command_queue_stats(wm_queue_stats_t *stats);
+void tasks_get_event_ring_stats(wm_producer_t producer, wm_queue_stats_t *stats);
 void tasks_suspend_all(void);
 void tasks_resume_all(void);
 void tasks_delete_all(void);
@@ -3,6 +3,9 @@
 #include "machine_state.h"
 #include "constants.h"
 #include "drivers/freehome/freehome_manager.h"
+#if CONFIG_RUNTIME_STATS
+#include "diagnostics/runtime_stats.h"
+#endif
 #if CONFIG_WIFI_ENABLED
 #include "drivers/wifi/wifi_manager.h"
 #endif
@@ -18,6 +21,7 @@ struct UiState {
     bool editing = false;
     int freehome_page = 0;
     int freehome_button = 0; // 0 = Back, 1 = Next
+    int diag_cursor = 0;
 };
 
 UiState g_state;
@@ -87,6 +91,11 @@ void ui_controller_show_logo(void) {
     g_state.editing = false;
 }
 
+void ui_controller_show_resume(void) {
+    g_state = UiState{};
+    g_state.menu = UI_MENU_RESUME;
+}
+
 void ui_controller_handle_start_long_press(void) {
     if (g_state.menu == UI_MENU_DEFAULT) {
         g_state.menu = UI_MENU_WASH_SETTINGS;
@@ -136,6 +145,9 @@ bool ui_controller_handle_start_press(void) {
             g_state.editing = false;
             if (g_state.machine_cursor == UI_MACHINE_OPTION_BACK) {
                 g_state.menu = UI_MENU_WASH_SETTINGS;
+            } else if (g_state.machine_cursor == UI_MACHINE_OPTION_DIAGNOSTICS) {
+                g_state.menu = UI_MENU_DIAGNOSTICS;
+                g_state.diag_cursor = 0;
             } else if (g_state.machine_cursor == UI_MACHINE_OPTION_FREEHOME) {
                 // Enter FreeHome menu
                 g_state.menu = UI_MENU_FREEHOME;
@@ -157,6 +169,9 @@ bool ui_controller_handle_start_press(void) {
         #endif
             }
             return true;
+        case UI_MENU_DIAGNOSTICS:
+            g_state.menu = UI_MENU_MACHINE_SETTINGS;
+            return true;
         default:
             return false; // allow normal start/stop handling
     }
@@ -166,7 +181,8 @@ void ui_controller_handle_dial_delta(int delta) {
     if (delta == 0) return;
     switch (g_state.menu) {
         case UI_MENU_LOGO:
-            // ignore dial in logo
+        case UI_MENU_RESUME:
+            // ignore dial in logo and while the resume prompt is up
             break;
         case UI_MENU_DEFAULT: {
             int prog = machine_get_program();
@@ -196,11 +212,24 @@ void ui_controller_handle_dial_delta(int delta) {
             g_state.machine_cursor += (delta > 0 ? 1 : -1);
             clamp_cursor(g_state.machine_cursor, UI_MACHINE_OPTION_COUNT);
             break;
+        case UI_MENU_DIAGNOSTICS: {
+            // Read-only page: the dial scrolls
+            int rows = 1;
+#if CONFIG_RUNTIME_STATS
+            static runtime_stats_t stats;
+            if (runtime_stats_get(&stats)) {
+                rows = runtime_stats_row_count(&stats);
+            }
+#endif
+            g_state.diag_cursor += (delta > 0 ? 1 : -1);
+            clamp_cursor(g_state.diag_cursor, rows);
+            break;
+        }
     }
 }
 
 ui_render_state_t ui_controller_get_render_state(void) {
-    ui_render_state_t out = { g_state.menu, g_state.wash_cursor, g_state.machine_cursor, g_state.editing, g_state.freehome_page, g_state.freehome_button };
+    ui_render_state_t out = { g_state.menu, g_state.wash_cursor, g_state.machine_cursor, g_state.editing, g_state.freehome_page, g_state.freehome_button, g_state.diag_cursor };
     return out;
 }
 
@@ -279,6 +308,7 @@ const char *ui_machine_option_label(int idx) {
         case UI_MACHINE_OPTION_DISPLAY: return "Display";
         case UI_MACHINE_OPTION_ADVANCED: return "Advanced";
         case UI_MACHINE_OPTION_FREEHOME: return "FreeHome";
+        case UI_MACHINE_OPTION_DIAGNOSTICS: return "Diagnostics";
         case UI_MACHINE_OPTION_BACK: return "Back";
         default: return "";
     }
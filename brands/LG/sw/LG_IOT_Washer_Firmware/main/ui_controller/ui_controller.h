@@ -14,6 +14,8 @@ typedef enum {
     UI_MENU_WASH_SETTINGS,
     UI_MENU_FREEHOME,
     UI_MENU_MACHINE_SETTINGS,
+    UI_MENU_DIAGNOSTICS,
+    UI_MENU_RESUME,       // Offer to continue a cycle cut off by power loss
 } ui_menu_t;
 
 typedef struct {
@@ -23,6 +25,7 @@ typedef struct {
     bool editing;
     int freehome_page;    // current page in FreeHome wizard
     int freehome_button;  // 0=Back, 1=Next (selected)
+    int diag_cursor;      // First visible row on the diagnostics page
 } ui_render_state_t;
 
 typedef enum {
@@ -41,12 +44,15 @@ typedef enum {
     UI_MACHINE_OPTION_DISPLAY,
     UI_MACHINE_OPTION_ADVANCED,
     UI_MACHINE_OPTION_FREEHOME,
+    UI_MACHINE_OPTION_DIAGNOSTICS,
     UI_MACHINE_OPTION_BACK,
     UI_MACHINE_OPTION_COUNT
 } ui_machine_option_t;
 
 void ui_controller_reset(void);
 void ui_controller_show_logo(void);
+// Ask whether to resume an unfinished cycle; Start resumes, hold discards
+void ui_controller_show_resume(void);
 void ui_controller_handle_start_long_press(void);
 // Returns true if the event was consumed (no start/stop action should run)
 bool ui_controller_handle_start_press(void);
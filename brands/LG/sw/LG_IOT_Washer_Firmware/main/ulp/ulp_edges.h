@@ -0,0 +1,44 @@
+/*
+ * ulp_edges.h
+ * Rebuild the debounced button edges the ULP counted between interrupts
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Edges replayed per interrupt at most; a longer burst is bounce the ULP
+// let through, and only its last edges matter
+#define ULP_EDGES_MAX   4
+
+/**
+ * @brief Number of edges to report for @p counted edges, at most
+ *        ULP_EDGES_MAX and with the same parity, so the last one still
+ *        ends at the current level
+ */
+static inline uint32_t ulp_edges_to_report(uint32_t counted)
+{
+    if (counted <= ULP_EDGES_MAX) {
+        return counted;
+    }
+    return ULP_EDGES_MAX - ((ULP_EDGES_MAX ^ counted) & 1);
+}
+
+/**
+ * @brief Level after edge @p k (0 = oldest) of @p edges, given the level
+ *        after the last one; debounced levels alternate
+ */
+static inline uint32_t ulp_edge_level(uint32_t edges, uint32_t last_level, uint32_t k)
+{
+    return (last_level ^ (edges - 1 - k)) & 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -4,10 +4,12 @@
 #include "esp_log.h"
 #include "esp_sleep.h"
 #include "esp_check.h"
+#include "esp_timer.h"
 #include "driver/rtc_io.h"
 #include "ulp.h"
 #include "ulp_main.h"
 #include "ulp_manager.h"
+#include "ulp_edges.h"
 #include "app_config.h"
 
 static const char *TAG = "ulp_mgr";
@@ -27,8 +29,10 @@ uint32_t *edge_count_buttons = &ulp_edge_count_buttons;
 static uint32_t s_wake_edges = 1;
 static uint32_t s_debounce_samples = 3;
 static uint32_t s_wakeup_period_us = 20000; // 20 ms
+static uint32_t s_awake_period_us = 0;      // 0 = awake at the init-time period
 static uint32_t s_button_mask = 1; // bit0=power, bit1=start
 static bool s_ulp_loaded = false;
+static ulp_button_edge_cb_t s_edge_cb = nullptr;
 
 static esp_err_t configure_rtc_input(gpio_num_t gpio)
 {
@@ -108,9 +112,13 @@ esp_err_t ulp_power_arm(void)
     ulp_buttons_clear_counters();
     next_edge[0] = 0;
     next_edge[1] = 0;
-    ESP_RETURN_ON_ERROR(ulp_set_wakeup_period(0, s_wakeup_period_us), TAG, "set period failed");
+    // Arming while awake keeps the awake period; only deep sleep drops it
+    const uint32_t period_us = s_awake_period_us ? s_awake_period_us : s_wakeup_period_us;
+    ESP_RETURN_ON_ERROR(ulp_set_wakeup_period(0, period_us), TAG, "set period failed");
     esp_err_t err = ulp_run(&ulp_entry - RTC_SLOW_MEM);
     ESP_RETURN_ON_ERROR(err, TAG, "ulp_run failed");
+    ESP_LOGI(TAG, "ULP armed: %" PRIu32 " us period, debounce %" PRIu32 " us",
+             period_us, period_us * s_debounce_samples);
     return ESP_OK;
 }
 
@@ -138,10 +146,72 @@ void ulp_buttons_clear_counters(void)
     debounce_counter[1] = s_debounce_samples;
 }
 
+/*
+ * Why button edges arrive through the ULP interrupt:
+ * - The ULP already debounces both buttons, so the main CPU only needs to
+ *   know when a debounced edge happened. buttons.S executes `wake` on every
+ *   edge once the edge counter reaches the threshold; with the main CPU
+ *   running that raises the ULP interrupt instead of waking from sleep.
+ *   Clearing the counters here re-arms it for the next edge.
+ * - The counter is cleared without a handshake. The ULP only runs for a few
+ *   microseconds per period, so an edge landing in that window is the only
+ *   thing that can be lost, and the next edge resynchronises the level.
+ * - A short tap can complete within one interrupt latency, so the counter
+ *   may hold more than one edge. Only the final level is known, but levels
+ *   alternate, so every counted edge is replayed in order (ulp_edges.h);
+ *   reporting only the final level would turn a tap into nothing.
+ */
+static void ulp_button_isr(void *arg)
+{
+    (void)arg;
+    uint32_t now_us = (uint32_t)esp_timer_get_time();
+    BaseType_t woken = pdFALSE;
+
+    for (int i = 0; i < 2; i++) {
+        const uint32_t counted = edge_count_buttons[i] & UINT16_MAX;
+        if (counted == 0) {
+            continue;
+        }
+        edge_count_buttons[i] = 0;
+        if (s_edge_cb) {
+            const uint32_t level = next_edge[i] & 1;
+            const uint32_t edges = ulp_edges_to_report(counted);
+            for (uint32_t k = 0; k < edges; k++) {
+                s_edge_cb(i, ulp_edge_level(edges, level, k), now_us, &woken);
+            }
+        }
+    }
+
+    if (woken == pdTRUE) {
+        portYIELD_FROM_ISR();
+    }
+}
+
+esp_err_t ulp_buttons_set_edge_callback(ulp_button_edge_cb_t cb)
+{
+    if (!s_ulp_loaded) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    if (s_edge_cb == nullptr && cb != nullptr) {
+        ESP_RETURN_ON_ERROR(ulp_isr_register(ulp_button_isr, nullptr), TAG, "isr register failed");
+    } else if (s_edge_cb != nullptr && cb == nullptr) {
+        ulp_isr_deregister(ulp_button_isr, nullptr);
+    }
+    s_edge_cb = cb;
+    return ESP_OK;
+}
+
+esp_err_t ulp_set_awake_period(uint32_t period_us)
+{
+    s_awake_period_us = period_us;
+    return ulp_set_wakeup_period(0, period_us);
+}
+
 esp_err_t ulp_power_enter_deep_sleep(void)
 {
     // Ensure only the power button is armed for wake from deep sleep
     ulp_set_button_mask(0x1);
+    s_awake_period_us = 0;
     ESP_LOGI(TAG, "Arming ULP for power button wake");
     ESP_RETURN_ON_ERROR(ulp_power_arm(), TAG, "arm failed");
     ESP_RETURN_ON_ERROR(esp_sleep_enable_ulp_wakeup(), TAG, "enable wakeup failed");
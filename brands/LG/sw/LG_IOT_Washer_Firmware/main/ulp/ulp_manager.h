@@ -5,6 +5,7 @@
 
 #include "esp_err.h"
 #include "driver/gpio.h"
+#include "freertos/FreeRTOS.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -35,6 +36,20 @@ uint32_t ulp_button_level(int index);
 static inline uint32_t ulp_power_edge_count(void) { return ulp_button_edge_count(0); }
 static inline void ulp_power_clear_counters(void) { ulp_buttons_clear_counters(); }
 
+// Called from the ULP interrupt for every debounced edge since the last
+// interrupt, oldest first (index 0=power, 1=start, level 1=pressed).
+typedef void (*ulp_button_edge_cb_t)(int index, uint32_t level, uint32_t timestamp_us,
+                                     BaseType_t *higher_priority_task_woken);
+
+// Route debounced edges to `cb` from the ULP wake interrupt while the main
+// CPU is running (replaces polling ulp_button_level()).
+esp_err_t ulp_buttons_set_edge_callback(ulp_button_edge_cb_t cb);
+
+// Change the ULP sampling period while awake (shorter = lower button
+// latency). Kept by ulp_power_arm(); ulp_power_enter_deep_sleep()
+// restores the init-time period.
+esp_err_t ulp_set_awake_period(uint32_t period_us);
+
 // Arm ULP and enter deep sleep waiting for the power button.
 esp_err_t ulp_power_enter_deep_sleep(void);
 
@@ -0,0 +1,327 @@
+/*
+ * bench.cpp
+ * Host benchmarks of the firmware hot paths (Google Benchmark)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why this tool exists:
+ * - The display, the wash plan, machine_state, the balance analysis, the
+ *   synth, the ODrive commands and the simulator link each run many times
+ *   a second on the chip. A change that slows one down only shows up as
+ *   a stutter much later. Timing them here, compiled from the same
+ *   sources as washer_host, puts a number on every change.
+ * - Google Benchmark picks the iteration counts and writes JSON
+ *   (--benchmark_out=FILE). Two runs compare with its tools/compare.py,
+ *   so a regression shows in the JSON attached to a review.
+ * - Host numbers are only meaningful relative to each other, not as ESP32
+ *   timings. Locks are the host shim's, so the machine_state contention
+ *   figures are for a mutex and condition variable, not the FreeRTOS
+ *   scheduler.
+ * - In simulator mode the ODrive UART exchange is compiled out. What is
+ *   timed is the command formatting and the reply parsing around it.
+ *
+ * Usage: firmware_bench [--benchmark_filter=REGEX] [--benchmark_out=FILE]
+ */
+
+#include "bench.h"
+
+#include "app_config.h"
+#include "constants.h"
+#include "display.h"
+#include "machine_state.h"
+#include "mpu6050.h"
+#include "odrive.h"
+#include "sim_plant.h"
+#include "sim_protocol.h"
+#include "sound.h"
+#include "sound_synth.h"
+#include "wash_plan.h"
+#include "host_port.h"
+
+#include "esp_log.h"
+
+#include <benchmark/benchmark.h>
+
+#include <string.h>
+#include <vector>
+
+host_options_t g_host_options = {
+    .link_mode = HOST_LINK_STDIO,
+    .tcp_port = 0,
+    .pty_link = nullptr,
+    .nvs_path = "",
+    .wake_cause = ESP_SLEEP_WAKEUP_ULP,
+    .time_scale = 1,
+    .virtual_time = false,
+    .link_fd = -1,
+    .listen_fd = -1,
+    .pty_hold_fd = -1,
+    .rtc_fd = -1,
+    .start_us = 0,
+    .argc = 0,
+    .argv = nullptr,
+    .deep_sleep_hook = nullptr,
+};
+
+/*===========================================================================
+ * Simulator stand-ins
+ *===========================================================================*/
+
+// gpio_hal and the control plane report to the simulator; nobody listens
+extern "C" void simulator_send_gpio_state(int pin, int level)
+{
+    (void)pin;
+    (void)level;
+}
+
+extern "C" void simulator_flush_telemetry(void)
+{
+}
+
+extern "C" void simulator_set_gpio_input(int pin, int level)
+{
+    (void)pin;
+    (void)level;
+}
+
+extern "C" int simulator_get_gpio_state(int pin)
+{
+    (void)pin;
+    return 0;
+}
+
+void bench_link_sink(void *ctx, const uint8_t *data, size_t len)
+{
+    benchmark::DoNotOptimize(data);
+    *static_cast<size_t *>(ctx) += len;
+}
+
+size_t bench_encode_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                           const uint16_t *previous)
+{
+    const size_t words = (size_t)w * (size_t)h;
+    if (previous && memcmp(data, previous, words * sizeof(uint16_t)) == 0) {
+        return 0;
+    }
+    size_t bytes = 0;
+    sim_frame_writer_t writer;
+    sim_frame_begin(&writer, bench_link_sink, &bytes, SIM_MSG_BITMAP, 0);
+    sim_frame_put_i16(&writer, x);
+    sim_frame_put_i16(&writer, y);
+    sim_frame_put_i16(&writer, w);
+    sim_frame_put_i16(&writer, h);
+    sim_frame_put_u8(&writer, previous ? SIM_BITMAP_FLAG_DELTA : 0);
+    sim_frame_put_u8(&writer, 0);
+    sim_frame_put_bitmap_runs(&writer, data, previous, words);
+    sim_frame_end(&writer);
+    return bytes;
+}
+
+/*===========================================================================
+ * Wash plan
+ *===========================================================================*/
+
+// Every program at medium load with prewash and one extra rinse
+static void BM_WashPlanBuild(benchmark::State &state)
+{
+    wash_plan_t plan;
+    for (auto _ : state) {
+        for (int program = 0; program < NUM_PROGRAMS; program++) {
+            wash_plan_build(&plan, program, 1, true, 1);
+            benchmark::DoNotOptimize(plan.length);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * NUM_PROGRAMS);
+}
+BENCHMARK(BM_WashPlanBuild);
+
+// The ETA from every section, as the manager refreshes it
+static void BM_WashPlanEta(benchmark::State &state)
+{
+    wash_plan_t plan;
+    wash_plan_build(&plan, 0, 1, true, 1);
+    for (auto _ : state) {
+        for (size_t i = 0; i < plan.length; i++) {
+            benchmark::DoNotOptimize(wash_plan_eta_from(&plan, i));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * plan.length);
+}
+BENCHMARK(BM_WashPlanEta);
+
+/*===========================================================================
+ * machine_state
+ *===========================================================================*/
+
+// Even threads write the motor speed and ETA like the motion and manager
+// tasks; odd ones take snapshots like the display and the simulator
+static void BM_MachineState(benchmark::State &state)
+{
+    const bool writer = state.thread_index() % 2 == 0;
+    machine_observable_state_t snapshot;
+    int n = 0;
+    for (auto _ : state) {
+        if (writer) {
+            machine_set_current_rpm((float)(n & 1023));
+            machine_set_eta(n & 4095);
+        } else {
+            machine_get_observable_state(&snapshot);
+            benchmark::DoNotOptimize(snapshot.current_rpm);
+        }
+        n++;
+    }
+}
+BENCHMARK(BM_MachineState)->ThreadRange(1, 4)->UseRealTime();
+
+/*===========================================================================
+ * Balance detection
+ *===========================================================================*/
+
+static void BM_Mpu6050AnalyzeVibration(benchmark::State &state)
+{
+    mpu6050_vibration_t vibration;
+    for (auto _ : state) {
+        mpu6050_analyze_vibration(&vibration);
+        benchmark::DoNotOptimize(vibration.magnitude);
+    }
+}
+BENCHMARK(BM_Mpu6050AnalyzeVibration);
+
+/*===========================================================================
+ * Sound
+ *===========================================================================*/
+
+// Arg: effect; one SOUND_BLOCK_SAMPLES block per iteration, as sound_task
+static void BM_SynthRender(benchmark::State &state)
+{
+    const uint8_t effect = (uint8_t)state.range(0);
+    state.SetLabel(effect == SOUND_EFFECT_WATER_FILL ? "water_fill" : "cycle_end");
+    synth_mixer_t mixer;
+    synth_mixer_init(&mixer);
+    uint8_t block[SOUND_BLOCK_SAMPLES];
+    uint32_t seed = 1;
+    for (auto _ : state) {
+        if (!synth_mixer_active(&mixer)) {
+            synth_mixer_play_effect(&mixer, effect, seed++);
+        }
+        synth_mixer_render(&mixer, block, sizeof(block));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * SOUND_BLOCK_SAMPLES);
+}
+BENCHMARK(BM_SynthRender)->Arg(SOUND_EFFECT_WATER_FILL)->Arg(SOUND_EFFECT_CYCLE_END);
+
+/*===========================================================================
+ * ODrive
+ *===========================================================================*/
+
+static void BM_ODriveFormat(benchmark::State &state)
+{
+    float velocity = 0.0f;
+    for (auto _ : state) {
+        odrive_set_velocity_ff(0, velocity, 0.125f);
+        velocity += 0.37f;
+    }
+}
+BENCHMARK(BM_ODriveFormat);
+
+static void BM_ODriveParse(benchmark::State &state)
+{
+    float voltage;
+    for (auto _ : state) {
+        odrive_get_bus_voltage(&voltage);
+        benchmark::DoNotOptimize(voltage);
+    }
+}
+BENCHMARK(BM_ODriveParse);
+
+/*===========================================================================
+ * Simulator protocol
+ *===========================================================================*/
+
+// Arg 0: key frame; Arg 1: one label changed against the previous frame
+static void BM_SimEncodeBitmap(benchmark::State &state)
+{
+    const bool delta = state.range(0) != 0;
+    state.SetLabel(delta ? "delta" : "key");
+    std::vector<uint16_t> previous(SPRITE_WIDTH * SPRITE_HEIGHT);
+    for (size_t i = 0; i < previous.size(); i++) {
+        previous[i] = (i / SPRITE_WIDTH) % 20 < 10 ? COLOR_BGROUND : COLOR_BLACK;
+    }
+    std::vector<uint16_t> frame = previous;
+    for (int row = 29; row < 49; row++) {
+        for (int col = 141; col < 185; col++) {
+            frame[row * SPRITE_WIDTH + col] ^= 0x1234;
+        }
+    }
+    size_t bytes = 0;
+    for (auto _ : state) {
+        bytes = bench_encode_bitmap(0, 0, SPRITE_WIDTH, SPRITE_HEIGHT, frame.data(),
+                                    delta ? previous.data() : nullptr);
+    }
+    state.SetBytesProcessed(state.iterations() * frame.size() * sizeof(uint16_t));
+    state.counters["link_bytes"] = (double)bytes;
+}
+BENCHMARK(BM_SimEncodeBitmap)->Arg(0)->Arg(1);
+
+// A telemetry frame with three outputs, the motor and the machine state
+static void BM_SimEncodeTelemetry(benchmark::State &state)
+{
+    static const char label[] = "Main Wash";
+    size_t bytes = 0;
+    uint8_t sequence = 0;
+    for (auto _ : state) {
+        bytes = 0;
+        sim_frame_writer_t writer;
+        sim_frame_begin(&writer, bench_link_sink, &bytes, SIM_MSG_TELEMETRY, sequence++);
+        for (int pin = 0; pin < 3; pin++) {
+            sim_frame_put_u8(&writer, SIM_MSG_GPIO);
+            sim_frame_put_u8(&writer, 2);
+            sim_frame_put_u8(&writer, (uint8_t)(12 + pin));
+            sim_frame_put_u8(&writer, 1);
+        }
+        sim_frame_put_u8(&writer, SIM_MSG_MOTOR);
+        sim_frame_put_u8(&writer, 5);
+        sim_frame_put_i16(&writer, 1000);
+        sim_frame_put_i16(&writer, 987);
+        sim_frame_put_u8(&writer, 0);
+        sim_frame_put_u8(&writer, SIM_MSG_STATE);
+        sim_frame_put_u8(&writer, (uint8_t)(6 + sizeof(label) - 1));
+        sim_frame_put_u8(&writer, SIM_STATE_POWERED | SIM_STATE_RUNNING | SIM_STATE_ETA_AVAILABLE);
+        sim_frame_put_u8(&writer, 0);
+        sim_frame_put_u8(&writer, 2);
+        sim_frame_put_u8(&writer, 8);
+        sim_frame_put_i16(&writer, 3120);
+        sim_frame_put(&writer, label, sizeof(label) - 1);
+        sim_frame_end(&writer);
+    }
+    state.counters["link_bytes"] = (double)bytes;
+}
+BENCHMARK(BM_SimEncodeTelemetry);
+
+/*===========================================================================
+ * Main
+ *===========================================================================*/
+
+int main(int argc, char **argv)
+{
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 2;
+    }
+    esp_log_level_set("*", ESP_LOG_WARN);
+    host_time_init(0);
+    ESP_ERROR_CHECK(machine_state_init());
+    // The MPU6050 reads the plant while it runs; the host has no I2C bus
+    ESP_ERROR_CHECK(sim_plant_start(nullptr));
+    ESP_ERROR_CHECK(mpu6050_init());
+    ESP_ERROR_CHECK(odrive_init());
+    ESP_ERROR_CHECK(display_init());
+
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
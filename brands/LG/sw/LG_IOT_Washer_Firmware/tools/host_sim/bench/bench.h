@@ -0,0 +1,25 @@
+/*
+ * bench.h
+ * Shared pieces of the host benchmarks
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @brief sim_write_fn that counts the bytes into the size_t at @p ctx, in
+ *        place of the link
+ */
+void bench_link_sink(void *ctx, const uint8_t *data, size_t len);
+
+/**
+ * @brief What simulator_send_bitmap() does with a frame, minus the link:
+ *        skip it if unchanged, else encode it against @p previous
+ * @return Frame bytes, 0 if skipped
+ */
+size_t bench_encode_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                           const uint16_t *previous);
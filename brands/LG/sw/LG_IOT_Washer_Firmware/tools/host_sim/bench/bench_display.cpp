@@ -0,0 +1,155 @@
+/*
+ * bench_display.cpp
+ * Host benchmarks: sprite drawing and sprite_push
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why display.cpp is included rather than linked:
+ * - The sprite functions are static, and they are what every frame spends
+ *   its time in. Compiling the driver into this file reaches them without
+ *   exporting anything from the firmware.
+ * - display_init() runs first (from main), so the sprite buffers are
+ *   allocated as on the chip and the SPI calls go to the host stubs.
+ */
+
+#include "display.cpp"
+
+#include "bench.h"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+static size_t s_pushed_bytes = 0;
+
+// The two screens a screen switch alternates between, as rendered sprites
+static std::vector<uint16_t> s_settings_screen;
+static std::vector<uint16_t> s_cycle_screen;
+
+static void on_bitmap(int16_t x, int16_t y, int16_t w, int16_t h, const uint16_t *data,
+                      const uint16_t *previous)
+{
+    s_pushed_bytes += bench_encode_bitmap(x, y, w, h, data, previous);
+}
+
+// Native-endian test image; the assets may be the host fallback
+static const uint16_t *test_image(int w, int h)
+{
+    static uint16_t pixels[SPRITE_WIDTH * SPRITE_HEIGHT];
+    for (int i = 0; i < w * h; i++) {
+        pixels[i] = (uint16_t)(i * 2654435761u >> 16);
+    }
+    return pixels;
+}
+
+// The wash settings list, and the cycle view of a running Main Wash as
+// display_draw_ui() renders it
+static void render_screens(void)
+{
+    const size_t words = SPRITE_WIDTH * SPRITE_HEIGHT;
+    ui_render_state_t settings = ui_controller_get_render_state();
+    settings.menu = UI_MENU_WASH_SETTINGS;
+    settings.editing = false;
+    draw_wash_settings(settings);
+    s_settings_screen.assign(s_sprite_buf, s_sprite_buf + words);
+
+    machine_set_powered(true);
+    machine_set_logo_enabled(false);
+    machine_set_running(true);
+    machine_set_stage_label("Main Wash");
+    machine_set_eta(3120);
+    machine_set_eta_available(true);
+    display_draw_ui();
+    s_cycle_screen.assign(s_sprite_buf, s_sprite_buf + words);
+    machine_set_running(false);
+    machine_set_powered(false);
+}
+
+/*===========================================================================
+ * Drawing
+ *===========================================================================*/
+
+// Args: w, h
+static void BM_SpriteFill(benchmark::State &state)
+{
+    const int w = (int)state.range(0);
+    const int h = (int)state.range(1);
+    uint16_t color = COLOR_BGROUND;
+    for (auto _ : state) {
+        sprite_fill_rect(0, 0, w, h, color);
+        color ^= 0xFFFF;
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * w * h);
+}
+BENCHMARK(BM_SpriteFill)->Args({ SPRITE_WIDTH, SPRITE_HEIGHT })->Args({ 80, 20 });
+
+// Args: w, h; the logo and an icon
+static void BM_SpriteBlit(benchmark::State &state)
+{
+    const int w = (int)state.range(0);
+    const int h = (int)state.range(1);
+    const uint16_t *image = test_image(w, h);
+    for (auto _ : state) {
+        sprite_draw_bitmap(1, 8, w, h, image);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * w * h);
+}
+BENCHMARK(BM_SpriteBlit)->Args({ 186, 90 })->Args({ 24, 20 });
+
+// Arg: display_font_t
+static void BM_SpriteText(benchmark::State &state)
+{
+    const display_font_t font = (display_font_t)state.range(0);
+    const char *text = font == FONT_MEDIUM ? "Cotton/Normal" : "1:23";
+    state.SetLabel(text);
+    for (auto _ : state) {
+        sprite_draw_text(10, 10, text, font, COLOR_BLACK, COLOR_BGROUND);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * strlen(text));
+}
+BENCHMARK(BM_SpriteText)->Arg(FONT_MEDIUM)->Arg(FONT_XXLARGE);
+
+/*===========================================================================
+ * sprite_push
+ *===========================================================================*/
+
+// Arg 0: nothing changed, the simulator frame is skipped
+// Arg 1: the ETA ticks, as every second of a cycle
+// Arg 2: a screen switch, between the settings list and the cycle view
+static void BM_SpritePush(benchmark::State &state)
+{
+    static const char *const labels[] = { "unchanged", "eta_tick", "full" };
+    const int64_t change = state.range(0);
+    state.SetLabel(labels[change]);
+    if (s_cycle_screen.empty()) {
+        render_screens();
+    }
+    display_set_simulator_bitmap_hook(on_bitmap);
+    sprite_clear(COLOR_BGROUND);
+    sprite_push(SPRITE_X, SPRITE_Y);
+    s_pushed_bytes = 0;
+    int tick = 0;
+    for (auto _ : state) {
+        if (change == 1) {
+            char eta[8];
+            snprintf(eta, sizeof(eta), "1:%02d", tick % 60);
+            sprite_fill_rect(141, 29, 44, 20, COLOR_BGROUND);
+            sprite_draw_text(141, 29, eta, FONT_MEDIUM, COLOR_BLACK, COLOR_BGROUND);
+        } else if (change == 2) {
+            const std::vector<uint16_t> &screen = tick & 1 ? s_cycle_screen : s_settings_screen;
+            memcpy(s_sprite_buf, screen.data(), screen.size() * sizeof(uint16_t));
+        }
+        sprite_push(SPRITE_X, SPRITE_Y);
+        tick++;
+    }
+    display_set_simulator_bitmap_hook(nullptr);
+    state.counters["link_bytes"] =
+        benchmark::Counter((double)s_pushed_bytes, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK(BM_SpritePush)->DenseRange(0, 2);
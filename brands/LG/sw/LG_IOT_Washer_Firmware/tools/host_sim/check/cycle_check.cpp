@@ -0,0 +1,612 @@
+/*
+ * cycle_check.cpp
+ * Runs whole wash programs on the virtual clock and checks the section
+ * order, the actuator timeline and the ETA of every second
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Time is virtual (see freertos_host.cpp), so every timestamp is exact: a
+ * section must last its planned seconds to the millisecond. The control
+ * plane runs headless (harness.cpp).
+ *
+ * With --plant the drum, water and pumps are simulated (sim_plant.cpp).
+ * The timeline checks are the same; in addition the tub must be empty at
+ * the end and never overflow, and the drum speeds, water levels and
+ * vibration are reported.
+ *
+ * With --heap each cycle, from the start press to the outputs going off,
+ * runs inside a heap_report steady-state check, and any allocation in it
+ * fails the program. The control plane allocates at boot only; churn that
+ * frees what it takes fails too, as it fragments the ESP32 heap.
+ */
+
+#include "harness.h"
+
+#include "app_config.h"
+#include "constants.h"
+#include "event_record.h"
+#include "heap_report.h"
+#include "machine_state.h"
+#include "sim_plant.h"
+#include "tasks.h"
+#include "wash_plan.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include <math.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+#define MS_US               1000LL
+#define S_US                1000000LL
+#define TIME_SLACK_US       (1 * MS_US)     // Allowed jitter on exact timestamps
+#define FILL_US             (10 * S_US)     // Fixed fill time of the motion task
+#define REVERSE_STOP_US     (150 * MS_US)   // Stop before each direction change
+#define MAX_REPORTED        20
+#define PLANT_EMPTY_L       1.0f            // Free water left after the final drain
+#define PLANT_SAMPLE_MS     100
+
+/*===========================================================================
+ * Checks
+ *===========================================================================*/
+
+struct Interval {
+    int64_t on_us;
+    int64_t off_us;
+};
+
+class CycleCheck {
+public:
+    CycleCheck(const wash_plan_t &plan, std::vector<Record> records)
+        : plan_(plan), records_(std::move(records)) {}
+
+    int run(void)
+    {
+        if (!find_sections()) {
+            return failures_;
+        }
+        check_eta();
+        for (size_t k = 0; k < plan_.length; k++) {
+            check_section(k);
+        }
+        check_end();
+        return failures_;
+    }
+
+    int64_t virtual_us(void) const
+    {
+        return starts_.empty() ? 0 : starts_.back() - starts_.front();
+    }
+
+private:
+    void fail(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        if (++failures_ > MAX_REPORTED) {
+            return;
+        }
+        va_list args;
+        va_start(args, format);
+        printf("  FAIL ");
+        vprintf(format, args);
+        printf("\n");
+        va_end(args);
+    }
+
+    static bool near(int64_t a, int64_t b)
+    {
+        return llabs(a - b) <= TIME_SLACK_US;
+    }
+
+    // Section order: stages run 0..length-1 in plan order, each with its
+    // label, and end on "Complete"
+    bool find_sections(void)
+    {
+        int stage = -1;
+        const Record *last = nullptr;
+        for (size_t i = 0; i < records_.size(); i++) {
+            const Record &rec = records_[i];
+            if (rec.kind != RecordKind::State) {
+                continue;
+            }
+            if (stage < 0) {
+                if (!rec.running) {
+                    continue;
+                }
+                stage = rec.stage;
+                if (stage != 0) {
+                    fail("cycle started in stage %d", stage);
+                    return false;
+                }
+                first_ = i;
+                starts_.push_back(rec.time_us);
+            } else if (rec.stage != stage) {
+                if (rec.stage != stage + 1) {
+                    fail("stage %d followed by %d", stage, rec.stage);
+                    return false;
+                }
+                check_label(stage, last);
+                stage = rec.stage;
+                starts_.push_back(rec.time_us);
+            }
+            last = &rec;
+        }
+        if (stage != (int)plan_.length) {
+            fail("ended in stage %d of %zu", stage, plan_.length);
+            return false;
+        }
+        if (strcmp(last->label, "Complete") != 0 || last->running || last->eta != 0) {
+            fail("final state \"%s\" running=%d eta=%d", last->label, last->running, last->eta);
+        }
+        return true;
+    }
+
+    void check_label(int stage, const Record *last)
+    {
+        const char *expected = plan_.sections[stage].label;
+        if (!last || strcmp(last->label, expected) != 0) {
+            fail("stage %d labelled \"%s\", expected \"%s\"", stage, last ? last->label : "",
+                 expected);
+        }
+    }
+
+    // ETA: counts down one per second from the plan total, equals the
+    // rest of the plan at every section change, and sections last their
+    // planned time (the first up to a tick less: ticks are not aligned to
+    // the start press, and one may land on the press itself)
+    void check_eta(void)
+    {
+        const int total = wash_plan_eta_from(&plan_, 0);
+        int expected = total;
+        int64_t last_change_us = -1;
+        for (size_t i = first_; i < records_.size(); i++) {
+            const Record &rec = records_[i];
+            if (rec.kind != RecordKind::State || rec.eta == expected) {
+                continue;
+            }
+            if (rec.eta != expected - 1) {
+                fail("ETA went from %d to %d at %.3f s", expected, rec.eta, rel_s(rec.time_us));
+                return;
+            }
+            if (last_change_us >= 0 && !near(rec.time_us - last_change_us, S_US)) {
+                fail("ETA %d came %.3f s after the previous second", rec.eta,
+                     (rec.time_us - last_change_us) / 1e6);
+            }
+            expected = rec.eta;
+            last_change_us = rec.time_us;
+        }
+        if (expected != 0) {
+            fail("ETA stopped at %d", expected);
+        }
+
+        for (size_t k = 1; k <= plan_.length; k++) {
+            const int planned = wash_plan_eta_from(&plan_, k);
+            const int shown = eta_at(starts_[k]);
+            if (shown != planned) {
+                fail("ETA %d at the start of stage %zu, expected %d", shown, k, planned);
+            }
+        }
+        for (size_t k = 0; k < plan_.length; k++) {
+            const int64_t planned_us = plan_.sections[k].remaining_seconds * S_US;
+            const int64_t took_us = starts_[k + 1] - starts_[k];
+            const bool ok = k == 0 ? (took_us >= planned_us - S_US && took_us <= planned_us)
+                                   : near(took_us, planned_us);
+            if (!ok) {
+                fail("%s took %.3f s, planned %ld s", plan_.sections[k].label, took_us / 1e6,
+                     (long)plan_.sections[k].remaining_seconds);
+            }
+        }
+    }
+
+    // Actuator timeline of one section against its wash_params_t
+    void check_section(size_t k)
+    {
+        const wash_params_t &p = plan_.sections[k].params;
+        const char *name = plan_.sections[k].label;
+        const int64_t a = starts_[k];
+        const int64_t b = starts_[k + 1];
+
+        const std::vector<Interval> fill = on_intervals(PIN_FILL_PUMP, a, b);
+        if (p.fill_water) {
+            if (fill.size() != 1 || fill[0].on_us != a || !near(fill[0].off_us, a + FILL_US)) {
+                fail("%s: fill pump should run for the first 10 s", name);
+            }
+        } else if (!fill.empty()) {
+            fail("%s: fill pump ran at %.3f s", name, rel_s(fill[0].on_us));
+        }
+
+        const std::vector<Interval> drain = on_intervals(PIN_DRAIN_PUMP, a, b);
+        if (p.drain_water) {
+            if (drain.size() != 1 || drain[0].on_us != a || drain[0].off_us != b) {
+                fail("%s: drain pump should run for the whole section", name);
+            }
+        } else if (!drain.empty()) {
+            fail("%s: drain pump ran at %.3f s", name, rel_s(drain[0].on_us));
+        }
+
+        const std::vector<Record> motor = motor_commands(a, b);
+        const int64_t motion_us = p.fill_water ? a + FILL_US : a;
+        if (p.spin_rpm > 0) {
+            if (motor.size() != 1 || motor[0].time_us != a || motor[0].value != p.spin_rpm) {
+                fail("%s: drum should spin at %d RPM for the whole section", name, p.spin_rpm);
+            }
+        } else {
+            check_tumble(name, p, motor, motion_us);
+        }
+
+        // The circulation pump only runs while the drum turns
+        const std::vector<Interval> circulation = on_intervals(PIN_CIRCULATION_PUMP, a, b);
+        if (p.circulation_pump_pwm == 0 || p.spin_rpm > 0) {
+            if (!circulation.empty()) {
+                fail("%s: circulation pump ran at %.3f s", name, rel_s(circulation[0].on_us));
+            }
+        }
+        for (const Interval &on : circulation) {
+            if (target_at(motor, on.on_us) == 0 || target_at(motor, on.off_us - 1) == 0) {
+                fail("%s: circulation pump ran with the drum stopped at %.3f s", name,
+                     rel_s(on.on_us));
+                break;
+            }
+        }
+    }
+
+    // Tumble: one speed, alternating direction, a fixed pattern period
+    void check_tumble(const char *name, const wash_params_t &p, const std::vector<Record> &motor,
+                      int64_t motion_us)
+    {
+        const int64_t period_us = (int64_t)(p.tumble_duration_ms + p.stop_duration_ms) * MS_US +
+                                  (p.alternate_direction ? REVERSE_STOP_US : 0);
+        int64_t expected_us = motion_us + (p.alternate_direction ? REVERSE_STOP_US : 0);
+        int runs = 0;
+        bool ccw = false;
+        for (const Record &cmd : motor) {
+            if (cmd.value == 0) {
+                continue;
+            }
+            if (cmd.time_us < motion_us) {
+                fail("%s: drum turned during the fill", name);
+                return;
+            }
+            if (cmd.value != p.tumble_rpm) {
+                fail("%s: drum at %d RPM, expected %d", name, cmd.value, p.tumble_rpm);
+                return;
+            }
+            if (!near(cmd.time_us, expected_us)) {
+                fail("%s: tumble %d started at %.3f s, expected %.3f s", name, runs + 1,
+                     rel_s(cmd.time_us), rel_s(expected_us));
+                return;
+            }
+            if (runs > 0 && p.alternate_direction && cmd.ccw == ccw) {
+                fail("%s: tumble %d kept the direction", name, runs + 1);
+                return;
+            }
+            ccw = cmd.ccw;
+            expected_us += period_us;
+            runs++;
+        }
+        if (runs == 0) {
+            fail("%s: drum never turned", name);
+        }
+    }
+
+    // Everything off once the cycle is complete
+    void check_end(void)
+    {
+        const int64_t end = starts_.back();
+        const int pins[] = { PIN_FILL_PUMP, PIN_DRAIN_PUMP, PIN_CIRCULATION_PUMP };
+        for (int pin : pins) {
+            if (level_at(pin, end)) {
+                fail("GPIO %d still on after the cycle", pin);
+            }
+        }
+        if (target_at(motor_commands(0, INT64_MAX), end) != 0) {
+            fail("drum still turning after the cycle");
+        }
+    }
+
+    // Helpers; "at t" means after every record stamped t
+
+    double rel_s(int64_t time_us) const
+    {
+        return (time_us - starts_.front()) / 1e6;
+    }
+
+    int eta_at(int64_t time_us) const
+    {
+        int eta = -1;
+        for (const Record &rec : records_) {
+            if (rec.time_us > time_us) {
+                break;
+            }
+            if (rec.kind == RecordKind::State) {
+                eta = rec.eta;
+            }
+        }
+        return eta;
+    }
+
+    int level_at(int pin, int64_t time_us) const
+    {
+        int level = 0;
+        for (const Record &rec : records_) {
+            if (rec.time_us > time_us) {
+                break;
+            }
+            if (rec.kind == RecordKind::Output && rec.pin == pin) {
+                level = rec.value;
+            }
+        }
+        return level;
+    }
+
+    // On periods of an output that start in [a, b), cut off at b
+    std::vector<Interval> on_intervals(int pin, int64_t a, int64_t b) const
+    {
+        std::vector<Interval> out;
+        int level = level_at(pin, a);
+        int64_t on_us = a;
+        for (const Record &rec : records_) {
+            if (rec.time_us <= a || rec.kind != RecordKind::Output || rec.pin != pin) {
+                continue;
+            }
+            if (rec.time_us >= b) {
+                break;
+            }
+            if (rec.value && !level) {
+                on_us = rec.time_us;
+            } else if (!rec.value && level) {
+                out.push_back({ on_us, rec.time_us });
+            }
+            level = rec.value;
+        }
+        if (level) {
+            out.push_back({ on_us, b });
+        }
+        return out;
+    }
+
+    // Motor state after each timestamp in [a, b) where it changed
+    std::vector<Record> motor_commands(int64_t a, int64_t b) const
+    {
+        std::vector<Record> out;
+        for (const Record &rec : records_) {
+            if (rec.kind != RecordKind::Motor || rec.time_us < a || rec.time_us >= b) {
+                continue;
+            }
+            if (!out.empty() && out.back().time_us == rec.time_us) {
+                out.back() = rec;
+            } else {
+                out.push_back(rec);
+            }
+        }
+        // Drop timestamps that ended where the previous one did
+        std::vector<Record> changes;
+        for (const Record &rec : out) {
+            if (changes.empty() || changes.back().value != rec.value ||
+                changes.back().ccw != rec.ccw) {
+                changes.push_back(rec);
+            }
+        }
+        return changes;
+    }
+
+    static int target_at(const std::vector<Record> &motor, int64_t time_us)
+    {
+        int target = 0;
+        for (const Record &cmd : motor) {
+            if (cmd.time_us > time_us) {
+                break;
+            }
+            target = cmd.value;
+        }
+        return target;
+    }
+
+    const wash_plan_t &plan_;
+    std::vector<Record> records_;
+    size_t first_ = 0;                // Record where the cycle starts running
+    std::vector<int64_t> starts_;     // Start of each stage, then the end
+    int failures_ = 0;
+};
+
+/*===========================================================================
+ * Driver
+ *===========================================================================*/
+
+static std::vector<int> s_programs;
+static bool s_plant = false;
+static bool s_heap = false;
+
+// Peaks of the plant over one program
+struct PlantSummary {
+    float water_l = 0.0f;
+    float rpm = 0.0f;
+    float current = 0.0f;
+    float imbalance_kg = 0.0f;
+    float vibration_g = 0.0f;
+
+    void sample(void)
+    {
+        sim_plant_state_t state;
+        sim_plant_get_state(&state);
+        water_l = fmaxf(water_l, state.water_l);
+        rpm = fmaxf(rpm, fabsf(state.velocity_rpm));
+        current = fmaxf(current, fabsf(state.current));
+        imbalance_kg = fmaxf(imbalance_kg, state.imbalance_kg);
+        vibration_g = fmaxf(vibration_g, state.vibration_g);
+    }
+};
+
+// Wait for the drum to stop, then report the peaks and check the tub
+static int check_plant(const PlantSummary &peaks)
+{
+    const int64_t end_us = esp_timer_get_time();
+    sim_plant_state_t state;
+    sim_plant_get_state(&state);
+    while (fabsf(state.velocity_rpm) >= 1.0f && esp_timer_get_time() - end_us < 120 * S_US) {
+        vTaskDelay(pdMS_TO_TICKS(PLANT_SAMPLE_MS));
+        sim_plant_get_state(&state);
+    }
+    const double stop_s = (esp_timer_get_time() - end_us) / 1e6;
+    printf("  plant: water peak %.1f L, left %.1f L free + %.1f L held; drum peak %.0f RPM, "
+           "%.1f A, stopped %.1f s after; imbalance %.2f kg, vibration %.2f g\n",
+           peaks.water_l, state.water_l, state.absorbed_l, peaks.rpm, peaks.current, stop_s,
+           peaks.imbalance_kg, peaks.vibration_g);
+    int failures = 0;
+    if (state.water_l > PLANT_EMPTY_L) {
+        printf("  FAIL %.1f L of water left in the tub\n", state.water_l);
+        failures++;
+    }
+    if (state.overflowed) {
+        printf("  FAIL the tub overflowed\n");
+        failures++;
+    }
+    return failures;
+}
+
+// Dial to the program, press start and wait for the cycle to end
+static int run_program(int program)
+{
+    tasks_post_dial_delta(program - machine_get_program());
+    vTaskDelay(pdMS_TO_TICKS(100));
+    if (machine_get_program() != program) {
+        printf("%-16s FAIL dial selected program %d\n", program_profiles[program].name,
+               machine_get_program());
+        return 1;
+    }
+    wash_plan_t plan;
+    wash_plan_build(&plan, program, machine_get_load_size(), machine_is_prewash_enabled(),
+                    machine_get_extra_rinse_count());
+    const int total = wash_plan_eta_from(&plan, 0);
+
+    harness_take_records();
+    if (s_heap) {
+        ESP_ERROR_CHECK(heap_report_check_start());
+    }
+    const auto wall_start = std::chrono::steady_clock::now();
+    harness_press(PIN_START_STOP_BUTTON, 100);
+    const int64_t deadline_us = esp_timer_get_time() + (int64_t)(total + 60) * S_US;
+    vTaskDelay(pdMS_TO_TICKS(100));
+    PlantSummary peaks;
+    while (machine_is_running() && esp_timer_get_time() < deadline_us) {
+        if (s_plant) {
+            peaks.sample();
+        }
+        vTaskDelay(pdMS_TO_TICKS(s_plant ? PLANT_SAMPLE_MS : 1000));
+    }
+    // The manager turns the outputs off at the same virtual instant
+    vTaskDelay(pdMS_TO_TICKS(1000));
+    const double wall_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - wall_start).count();
+    uint32_t allocations = 0;
+    if (s_heap) {
+        ESP_ERROR_CHECK(heap_report_check_stop(&allocations));
+    }
+
+    CycleCheck check(plan, harness_take_records());
+    int failures = check.run();
+    const double virtual_s = check.virtual_us() / 1e6;
+    printf("%-16s %2zu sections %6.0f s virtual in %6.1f ms (%.0fx)  %s\n",
+           program_profiles[program].name, plan.length, virtual_s, wall_ms,
+           wall_ms > 0 ? virtual_s * 1000 / wall_ms : 0.0, failures ? "FAIL" : "ok");
+    if (allocations > 0) {
+        printf("  FAIL %u heap allocations during the cycle\n", (unsigned)allocations);
+        failures++;
+    }
+    if (s_plant) {
+        failures += check_plant(peaks);
+    }
+    return failures;
+}
+
+// The check drives the manager itself and keeps no recording. Without a
+// sink the recorder fills its RAM buffer a few programs into --all
+static esp_err_t discard_record(void *ctx, const void *data, size_t len)
+{
+    (void)ctx;
+    (void)data;
+    (void)len;
+    return ESP_OK;
+}
+
+static void check_main(void)
+{
+    event_record_set_sink(discard_record, nullptr);
+    harness_boot();
+    if (s_plant) {
+        ESP_ERROR_CHECK(sim_plant_start(nullptr));
+    }
+    harness_press(PIN_POWER_BUTTON, 100);
+    vTaskDelay(pdMS_TO_TICKS(2000));
+    int failures = 0;
+    if (!machine_is_powered()) {
+        printf("FAIL machine did not power on\n");
+        failures++;
+    }
+    for (size_t i = 0; i < s_programs.size() && failures == 0; i++) {
+        failures += run_program(s_programs[i]);
+    }
+    harness_exit(failures ? 1 : 0);
+}
+
+static int find_program(const char *name)
+{
+    for (int i = 0; i < NUM_PROGRAMS; i++) {
+        if (strcmp(program_profiles[i].name, name) == 0) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--program=N | --all] [--plant] [--heap] [-v]\n"
+            "  --program=N  run program N (0..%d, default Cotton/Normal)\n"
+            "  --all        run every program in turn\n"
+            "  --plant      simulate the drum, water and pumps, and check the tub\n"
+            "  --heap       fail on any heap allocation during a cycle\n"
+            "  -v           show firmware logs\n",
+            name, NUM_PROGRAMS - 1);
+}
+
+int main(int argc, char **argv)
+{
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--program=", 10) == 0) {
+            const int program = atoi(argv[i] + 10);
+            if (program < 0 || program >= NUM_PROGRAMS) {
+                usage(argv[0]);
+                return 2;
+            }
+            s_programs.push_back(program);
+        } else if (strcmp(argv[i], "--all") == 0) {
+            for (int program = 0; program < NUM_PROGRAMS; program++) {
+                s_programs.push_back(program);
+            }
+        } else if (strcmp(argv[i], "--plant") == 0) {
+            s_plant = true;
+        } else if (strcmp(argv[i], "--heap") == 0) {
+            s_heap = true;
+        } else if (strcmp(argv[i], "-v") == 0) {
+            verbose = true;
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (s_programs.empty()) {
+        s_programs.push_back(find_program("Cotton/Normal"));
+    }
+    harness_run(argc, argv, verbose, check_main);
+}
@@ -0,0 +1,468 @@
+/*
+ * event_replay.cpp
+ * Replays recorded manager events (diagnostics/event_record.h) through the
+ * control plane and diffs the resulting actuator and state trace
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why each session runs in its own process:
+ * - The control plane keeps its state in statics and its tasks never end,
+ *   so a clean start needs a new process. The parent forks one child per
+ *   recording before any task exists. The child boots the control plane
+ *   in replay mode on the virtual clock, replays, and exits with its
+ *   verdict. Children run in parallel.
+ *
+ * Why a session is replayed one event at a time:
+ * - The manager drains every ring in one pass and dispatches safety
+ *   events first. Two events posted together could therefore come out in
+ *   a different order from the recording. The replayer posts an event at
+ *   its recorded time and waits for the manager to dispatch it before it
+ *   posts the next. The replay is recorded as well, and must match the
+ *   input event for event and millisecond for millisecond.
+ *
+ * Why the trace keeps only the state at the end of each timestamp:
+ * - Tasks acting at the same virtual instant, such as the manager stopping
+ *   the outputs while the motion task starts, can report in either order.
+ *   The trace keeps the final state of each output at each instant, so
+ *   the order of reports within one instant does not matter.
+ * - For the same reason the trace stops just before the end of the tail:
+ *   what happens at that instant may or may not have been reported yet.
+ */
+
+#include "harness.h"
+#include "event_record.h"
+#include "tasks.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#define DISPATCH_TIMEOUT_MS 10000
+#define MAX_REPORTED        10
+
+static const char *const s_event_names[WM_EVENT_TYPE_COUNT] = {
+    "power", "start", "door", "tick", "sensor", "start_long", "dial", "motor_fault",
+};
+
+static struct {
+    bool update = false;        // Write the reference trace
+    bool print = false;         // Print the trace
+    bool verbose = false;
+    uint32_t tail_ms = 1000;    // Run on after the last event
+    int jobs = 0;
+} s_options;
+
+// Session of this child
+static const char *s_path = nullptr;
+static std::vector<event_record_entry_t> s_events;
+
+// The replay's own recording, filled on the manager task
+static std::vector<uint8_t> s_replayed;
+static std::atomic<size_t> s_dispatched{0};
+static int64_t s_replay_start_us = -1;
+static TaskHandle_t s_replayer = nullptr;
+
+/*===========================================================================
+ * Recording Files
+ *===========================================================================*/
+
+static bool read_file(const char *path, std::vector<uint8_t> *out)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t chunk[4096];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        out->insert(out->end(), chunk, chunk + n);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool decode(const std::vector<uint8_t> &data, std::vector<event_record_entry_t> *events,
+                   bool *truncated)
+{
+    event_record_reader_t reader;
+    if (event_record_reader_init(&reader, data.data(), data.size()) != ESP_OK) {
+        return false;
+    }
+    event_record_entry_t entry;
+    esp_err_t ret;
+    while ((ret = event_record_next(&reader, &entry)) == ESP_OK) {
+        if (entry.type >= WM_EVENT_TYPE_COUNT) {
+            return false;
+        }
+        events->push_back(entry);
+    }
+    if (truncated) {
+        *truncated = (reader.flags & EVENT_RECORD_FLAG_TRUNCATED) != 0;
+    }
+    return ret == ESP_ERR_NOT_FOUND;
+}
+
+/*===========================================================================
+ * Trace
+ *===========================================================================*/
+
+static std::string format_time(int64_t time_us)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%" PRId64 ".%06" PRId64, time_us / 1000000, time_us % 1000000);
+    return buf;
+}
+
+// One line per change, at the end of each virtual timestamp before end_us
+static std::vector<std::string> build_trace(const std::vector<Record> &records, int64_t end_us)
+{
+    std::vector<std::string> lines;
+    std::map<int, int> outputs;
+    std::string motor;
+    std::string state;
+    size_t i = 0;
+    while (i < records.size() && records[i].time_us < end_us) {
+        const int64_t now = records[i].time_us;
+        std::map<int, int> out_now = outputs;
+        std::string motor_now = motor;
+        std::string state_now = state;
+        bool sleep = false;
+        for (; i < records.size() && records[i].time_us == now; i++) {
+            const Record &rec = records[i];
+            char buf[96];
+            switch (rec.kind) {
+                case RecordKind::Output:
+                    out_now[rec.pin] = rec.value;
+                    break;
+                case RecordKind::Motor:
+                    snprintf(buf, sizeof(buf), "motor %d %s", rec.value, rec.ccw ? "ccw" : "cw");
+                    motor_now = buf;
+                    break;
+                case RecordKind::State:
+                    snprintf(buf, sizeof(buf),
+                             "state power=%d door=%d program=%d stage=%d \"%s\" eta=%d running=%d",
+                             rec.powered, rec.door_open, rec.program, rec.stage, rec.label, rec.eta,
+                             rec.running);
+                    state_now = buf;
+                    break;
+                case RecordKind::Sleep:
+                    sleep = true;
+                    break;
+            }
+        }
+        const std::string stamp = format_time(now) + " ";
+        for (const auto &out : out_now) {
+            auto old = outputs.find(out.first);
+            if (old == outputs.end() || old->second != out.second) {
+                lines.push_back(stamp + "gpio " + std::to_string(out.first) + " " +
+                                std::to_string(out.second));
+            }
+        }
+        if (motor_now != motor) {
+            lines.push_back(stamp + motor_now);
+        }
+        if (state_now != state) {
+            lines.push_back(stamp + state_now);
+        }
+        if (sleep) {
+            lines.push_back(stamp + "sleep");
+        }
+        outputs.swap(out_now);
+        motor.swap(motor_now);
+        state.swap(state_now);
+    }
+    return lines;
+}
+
+static bool read_lines(const std::string &path, std::vector<std::string> *lines)
+{
+    FILE *f = fopen(path.c_str(), "r");
+    if (!f) {
+        return false;
+    }
+    char buf[256];
+    while (fgets(buf, sizeof(buf), f)) {
+        buf[strcspn(buf, "\n")] = 0;
+        lines->push_back(buf);
+    }
+    fclose(f);
+    return true;
+}
+
+static bool write_lines(const std::string &path, const std::vector<std::string> &lines)
+{
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    for (const std::string &line : lines) {
+        fprintf(f, "%s\n", line.c_str());
+    }
+    return fclose(f) == 0;
+}
+
+// Print where the traces part; returns the number of differing lines
+static int diff_lines(const std::vector<std::string> &expected,
+                      const std::vector<std::string> &actual)
+{
+    int differences = 0;
+    const size_t n = expected.size() > actual.size() ? expected.size() : actual.size();
+    for (size_t i = 0; i < n; i++) {
+        const char *want = i < expected.size() ? expected[i].c_str() : "(end)";
+        const char *got = i < actual.size() ? actual[i].c_str() : "(end)";
+        if (strcmp(want, got) == 0) {
+            continue;
+        }
+        if (++differences <= MAX_REPORTED) {
+            printf("  line %zu: expected %s\n  %*s  got      %s\n", i + 1, want,
+                   (int)std::to_string(i + 1).size() + 5, "", got);
+        }
+    }
+    return differences;
+}
+
+/*===========================================================================
+ * Replay (child process)
+ *===========================================================================*/
+
+// Sink of the replay's own recording; every call after the header is one
+// dispatched event
+static esp_err_t capture(void *ctx, const void *data, size_t len)
+{
+    (void)ctx;
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    if (s_replay_start_us < 0) {
+        s_replay_start_us = esp_timer_get_time();
+    } else {
+        s_dispatched.fetch_add(1);
+    }
+    s_replayed.insert(s_replayed.end(), bytes, bytes + len);
+    if (s_replayer) {
+        xTaskNotifyGive(s_replayer);
+    }
+    return ESP_OK;
+}
+
+// The replay must dispatch what was recorded, when it was recorded
+static int check_dispatches(void)
+{
+    std::vector<event_record_entry_t> replayed;
+    if (!decode(s_replayed, &replayed, nullptr)) {
+        printf("  replay recording unreadable\n");
+        return 1;
+    }
+    int mismatches = 0;
+    for (size_t i = 0; i < s_events.size(); i++) {
+        const event_record_entry_t &want = s_events[i];
+        if (i < replayed.size() && replayed[i].time_ms == want.time_ms &&
+            replayed[i].type == want.type && replayed[i].value == want.value) {
+            continue;
+        }
+        if (++mismatches <= MAX_REPORTED) {
+            if (i < replayed.size()) {
+                printf("  event %zu: recorded %s %" PRId32 " at %" PRIu32 " ms, replayed %s %"
+                       PRId32 " at %" PRIu32 " ms\n", i, s_event_names[want.type], want.value,
+                       want.time_ms, s_event_names[replayed[i].type], replayed[i].value,
+                       replayed[i].time_ms);
+            } else {
+                printf("  event %zu: recorded %s %" PRId32 " at %" PRIu32 " ms, not replayed\n",
+                       i, s_event_names[want.type], want.value, want.time_ms);
+            }
+        }
+    }
+    return mismatches;
+}
+
+static void replay_main(void)
+{
+    const auto wall_start = std::chrono::steady_clock::now();
+    s_replayer = xTaskGetCurrentTaskHandle();
+    tasks_set_replay_mode(true);
+    event_record_set_sink(capture, nullptr);
+    harness_boot();
+
+    const char *verdict = "ok";
+    int status = 0;
+    for (size_t i = 0; i < s_events.size() && status == 0; i++) {
+        wm_event_t evt = {};
+        evt.type = s_events[i].type;
+        evt.value = s_events[i].value;
+        const int64_t due_us = s_replay_start_us + (int64_t)s_events[i].time_ms * 1000;
+        const int64_t now_us = esp_timer_get_time();
+        if (due_us > now_us) {
+            vTaskDelay(pdMS_TO_TICKS((due_us - now_us + 999) / 1000));
+        }
+        if (!tasks_post_replay_event(&evt)) {
+            printf("%s: event %zu rejected\n", s_path, i);
+            verdict = "ERROR";
+            status = 2;
+            break;
+        }
+        while (s_dispatched.load() <= i) {
+            if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISPATCH_TIMEOUT_MS)) == 0) {
+                printf("%s: event %zu (%s) not dispatched\n", s_path, i,
+                       s_event_names[evt.type]);
+                verdict = "ERROR";
+                status = 2;
+                break;
+            }
+        }
+    }
+    vTaskDelay(pdMS_TO_TICKS(s_options.tail_ms));
+    const int64_t end_us = esp_timer_get_time();
+    const int64_t virtual_us = end_us - s_replay_start_us;
+    const std::vector<std::string> trace = build_trace(harness_take_records(), end_us);
+
+    if (status == 0 && check_dispatches() != 0) {
+        verdict = "MISMATCH";
+        status = 1;
+    }
+    const std::string reference = std::string(s_path) + ".trace";
+    if (status == 0 && s_options.update) {
+        if (!write_lines(reference, trace)) {
+            perror(reference.c_str());
+            verdict = "ERROR";
+            status = 2;
+        } else {
+            verdict = "saved";
+        }
+    } else if (status == 0) {
+        std::vector<std::string> expected;
+        if (!read_lines(reference, &expected)) {
+            verdict = "new";
+        } else if (diff_lines(expected, trace) != 0) {
+            verdict = "DIFF";
+            status = 1;
+        }
+    }
+    if (s_options.print) {
+        for (const std::string &line : trace) {
+            printf("%s\n", line.c_str());
+        }
+    }
+    const double wall_ms = std::chrono::duration<double, std::milli>(
+                               std::chrono::steady_clock::now() - wall_start).count();
+    printf("%-40s %6zu events %8.1f s virtual %7.1f ms  %s\n", s_path, s_events.size(),
+           virtual_us / 1e6, wall_ms, verdict);
+    harness_exit(status);
+}
+
+/*===========================================================================
+ * Sessions (parent process)
+ *===========================================================================*/
+
+static pid_t start_session(const char *path, int argc, char **argv)
+{
+    std::vector<uint8_t> data;
+    std::vector<event_record_entry_t> events;
+    bool truncated = false;
+    if (!read_file(path, &data)) {
+        perror(path);
+        return -1;
+    }
+    if (!decode(data, &events, &truncated)) {
+        fprintf(stderr, "%s: not an event recording\n", path);
+        return -1;
+    }
+    if (truncated) {
+        fprintf(stderr, "%s: recording was cut short; replaying what it holds\n", path);
+    }
+    fflush(stdout);
+    const pid_t pid = fork();
+    if (pid == 0) {
+        s_path = path;
+        s_events.swap(events);
+        harness_run(argc, argv, s_options.verbose, replay_main);
+    }
+    if (pid < 0) {
+        perror("fork");
+    }
+    return pid;
+}
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--update] [--print] [--tail=MS] [-jN] [-v] RECORDING...\n"
+            "  Replays each recording (washer_host --record, or \"$R\" from the device)\n"
+            "  and compares the actuator and state trace with RECORDING.trace.\n"
+            "  --update   write RECORDING.trace instead of comparing\n"
+            "  --print    print the trace\n"
+            "  --tail=MS  keep running MS after the last event (default 1000)\n"
+            "  -jN        replay N sessions at once (default: one per CPU)\n"
+            "  -v         show firmware logs\n",
+            name);
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<const char *> paths;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--update") == 0) {
+            s_options.update = true;
+        } else if (strcmp(argv[i], "--print") == 0) {
+            s_options.print = true;
+        } else if (strncmp(argv[i], "--tail=", 7) == 0) {
+            s_options.tail_ms = (uint32_t)atoi(argv[i] + 7);
+        } else if (strncmp(argv[i], "-j", 2) == 0) {
+            s_options.jobs = atoi(argv[i] + 2);
+        } else if (strcmp(argv[i], "-v") == 0) {
+            s_options.verbose = true;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return 2;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+    if (paths.empty()) {
+        usage(argv[0]);
+        return 2;
+    }
+    if (s_options.jobs <= 0) {
+        s_options.jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    const auto wall_start = std::chrono::steady_clock::now();
+    size_t next = 0;
+    int running = 0;
+    int failed = 0;
+    while (next < paths.size() || running > 0) {
+        while (next < paths.size() && running < s_options.jobs) {
+            if (start_session(paths[next++], argc, argv) > 0) {
+                running++;
+            } else {
+                failed++;
+            }
+        }
+        int wstatus = 0;
+        if (running > 0 && wait(&wstatus) > 0) {
+            running--;
+            if (!WIFEXITED(wstatus) || WEXITSTATUS(wstatus) != 0) {
+                failed++;
+            }
+        }
+    }
+    const double wall_s = std::chrono::duration<double>(
+                              std::chrono::steady_clock::now() - wall_start).count();
+    if (paths.size() > 1) {
+        printf("%zu sessions, %d failed, %.2f s (%.0f sessions/min)\n", paths.size(), failed,
+               wall_s, wall_s > 0 ? paths.size() * 60 / wall_s : 0.0);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,260 @@
+/*
+ * harness.cpp
+ * Headless control plane for the host checks: start-up, inputs and a
+ * record of every output and state change on the virtual clock
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why the checks stand in for the simulator and display modules:
+ * - gpio_hal reports every output through the simulator API, so the
+ *   recorder below implements that API and stamps each call with the
+ *   virtual time; motor and state changes come from a machine_state
+ *   observer, as the simulator's telemetry takes them. The control plane itself runs unchanged, with
+ *   the same tasks, rings and timeouts as on the chip.
+ * - The display task would draw ten frames per virtual second and
+ *   dominate the run, so a task that never wakes replaces it. The UI state
+ *   machine (ui_controller) still runs.
+ * - Buttons and the dial go through gpio_hal_sim_input() and the dial
+ *   post, as they do from sim_host.py.
+ */
+
+#include "harness.h"
+
+#include "app_config.h"
+#include "display.h"
+#include "gpio_hal.h"
+#include "machine_state.h"
+#include "odrive.h"
+#include "simulator.h"
+#include "tasks.h"
+#include "ulp_manager.h"
+#if CONFIG_CYCLE_CHECKPOINT
+#include "cycle_checkpoint.h"
+#endif
+#include "host_port.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <mutex>
+
+host_options_t g_host_options = {
+    .link_mode = HOST_LINK_STDIO,
+    .tcp_port = 0,
+    .pty_link = nullptr,
+    .nvs_path = "",                 // In memory; every run starts clean
+    .wake_cause = ESP_SLEEP_WAKEUP_ULP,
+    .time_scale = 1,
+    .virtual_time = true,
+    .link_fd = -1,
+    .listen_fd = -1,
+    .pty_hold_fd = -1,
+    .rtc_fd = -1,
+    .start_us = 0,
+    .argc = 0,
+    .argv = nullptr,
+    .deep_sleep_hook = nullptr,
+};
+
+/*===========================================================================
+ * Recorder
+ *===========================================================================*/
+
+static std::mutex s_record_lock;
+static std::vector<Record> s_records;
+static uint64_t s_inputs = 0;
+
+// The recorder stands in for the simulator link, which has no heap use on
+// the chip; it stays out of cycle_check --heap's count
+static void record(const Record &rec)
+{
+    HostHeapUncounted uncounted;
+    std::lock_guard<std::mutex> guard(s_record_lock);
+    s_records.push_back(rec);
+    s_records.back().time_us = esp_timer_get_time();
+}
+
+extern "C" void simulator_send_gpio_state(int pin, int level)
+{
+    Record rec = {};
+    rec.kind = RecordKind::Output;
+    rec.pin = pin;
+    rec.value = level ? 1 : 0;
+    record(rec);
+}
+
+extern "C" void simulator_flush_telemetry(void)
+{
+    // Records are taken as they happen; nothing waits
+}
+
+extern "C" void simulator_set_gpio_input(int pin, int level)
+{
+    std::lock_guard<std::mutex> guard(s_record_lock);
+    if (level) {
+        s_inputs |= 1ull << pin;
+    } else {
+        s_inputs &= ~(1ull << pin);
+    }
+}
+
+extern "C" int simulator_get_gpio_state(int pin)
+{
+    std::lock_guard<std::mutex> guard(s_record_lock);
+    return (int)((s_inputs >> pin) & 1);
+}
+
+static const Record *last_record(RecordKind kind)
+{
+    for (auto it = s_records.rbegin(); it != s_records.rend(); ++it) {
+        if (it->kind == kind) {
+            return &*it;
+        }
+    }
+    return nullptr;
+}
+
+// Only changes are kept, and only the target speed and direction: the
+// measured speed would record every step of the plant model. The state is
+// read again under the recorder lock: two tasks can deliver their
+// snapshots in the opposite order to the one they were taken in.
+static void on_state_change(const machine_observable_state_t *snapshot)
+{
+    (void)snapshot;
+    HostHeapUncounted uncounted;
+    std::lock_guard<std::mutex> guard(s_record_lock);
+    machine_observable_state_t state;
+    machine_get_observable_state(&state);
+    const int program = machine_get_program();
+    const int64_t now_us = esp_timer_get_time();
+
+    const Record *motor = last_record(RecordKind::Motor);
+    if (!motor || motor->value != state.target_rpm || motor->ccw != state.direction_ccw) {
+        Record rec = {};
+        rec.time_us = now_us;
+        rec.kind = RecordKind::Motor;
+        rec.value = state.target_rpm;
+        rec.ccw = state.direction_ccw;
+        s_records.push_back(rec);
+    }
+
+    const Record *last = last_record(RecordKind::State);
+    if (last && last->powered == state.powered && last->door_open == state.door_open &&
+        last->program == program && last->stage == state.stage && last->eta == state.eta_seconds &&
+        last->running == state.running && strcmp(last->label, state.stage_label) == 0) {
+        return;
+    }
+    Record rec = {};
+    rec.time_us = now_us;
+    rec.kind = RecordKind::State;
+    rec.powered = state.powered;
+    rec.door_open = state.door_open;
+    rec.program = program;
+    rec.stage = state.stage;
+    rec.eta = state.eta_seconds;
+    rec.running = state.running;
+    snprintf(rec.label, sizeof(rec.label), "%s", state.stage_label);
+    s_records.push_back(rec);
+}
+
+// Power off ends in deep sleep, which would re-exec the process and wait
+// for the link. Record it instead and park the manager; the check decides
+// when to stop.
+static void on_deep_sleep(void)
+{
+    Record rec = {};
+    rec.kind = RecordKind::Sleep;
+    record(rec);
+    while (true) {
+        vTaskDelay(portMAX_DELAY);
+    }
+}
+
+// The display is not drawn; its task just exists
+extern "C" void display_task_entry(void *arg)
+{
+    (void)arg;
+    while (true) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    }
+}
+
+/*===========================================================================
+ * Control
+ *===========================================================================*/
+
+static void (*s_entry)(void) = nullptr;
+
+static void entry_task(void *arg)
+{
+    (void)arg;
+    s_entry();
+    harness_exit(0);
+}
+
+void harness_run(int argc, char **argv, bool verbose, void (*entry)(void))
+{
+    if (!verbose) {
+        esp_log_level_set("*", ESP_LOG_WARN);
+    }
+    g_host_options.argc = argc;
+    g_host_options.argv = argv;
+    g_host_options.deep_sleep_hook = on_deep_sleep;
+    signal(SIGPIPE, SIG_IGN);
+    host_time_init(0);
+
+    s_entry = entry;
+    xTaskCreatePinnedToCore(entry_task, "check", 8192, nullptr, 1, nullptr, 0);
+    while (true) {
+        pause();
+    }
+}
+
+void harness_boot(void)
+{
+    ESP_ERROR_CHECK(nvs_flash_init());
+    ESP_ERROR_CHECK(machine_state_init());
+#if CONFIG_CYCLE_CHECKPOINT
+    ESP_ERROR_CHECK(cycle_checkpoint_init());
+#endif
+    ESP_ERROR_CHECK(app_gpio_init());
+    ESP_ERROR_CHECK(app_ledc_init());
+    ESP_ERROR_CHECK(odrive_init());
+    ESP_ERROR_CHECK(ulp_power_init(PIN_POWER_BUTTON, PIN_START_STOP_BUTTON, 1, 3, 20000));
+    machine_register_observer(on_state_change);
+    ESP_ERROR_CHECK(tasks_create_all());
+    ESP_ERROR_CHECK(ulp_power_arm());
+}
+
+void harness_press(int pin, uint32_t hold_ms)
+{
+    simulator_set_gpio_input(pin, 1);
+    gpio_hal_sim_input(pin, 1);
+    vTaskDelay(pdMS_TO_TICKS(hold_ms));
+    simulator_set_gpio_input(pin, 0);
+    gpio_hal_sim_input(pin, 0);
+}
+
+std::vector<Record> harness_take_records(void)
+{
+    std::vector<Record> records;
+    std::lock_guard<std::mutex> guard(s_record_lock);
+    records.swap(s_records);
+    return records;
+}
+
+void harness_exit(int status)
+{
+    fflush(stdout);
+    _exit(status);
+}
@@ -0,0 +1,56 @@
+/*
+ * harness.h
+ * Headless control plane for the host checks: start-up, inputs and a
+ * record of every output and state change on the virtual clock
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+enum class RecordKind : uint8_t { Output, Motor, State, Sleep };
+
+struct Record {
+    int64_t time_us;        // Virtual time
+    RecordKind kind;
+    int pin;                // Output
+    int value;              // Output level, or motor target RPM
+    bool ccw;               // Motor
+    bool powered;           // State
+    bool door_open;
+    int program;
+    int stage;
+    int eta;
+    bool running;
+    char label[32];
+};
+
+/**
+ * @brief Start the virtual clock and run @p entry as the first task
+ *
+ * Never returns; @p entry ends the process with harness_exit().
+ */
+[[noreturn]] void harness_run(int argc, char **argv, bool verbose, void (*entry)(void));
+
+/**
+ * @brief app_main() without the display, sound and radio
+ */
+void harness_boot(void);
+
+/**
+ * @brief Hold a button for @p hold_ms through the simulator input path
+ */
+void harness_press(int pin, uint32_t hold_ms);
+
+/**
+ * @brief Take the records made so far, oldest first
+ */
+std::vector<Record> harness_take_records(void);
+
+/**
+ * @brief Flush stdout and end the process
+ */
+[[noreturn]] void harness_exit(int status);
@@ -0,0 +1,23 @@
+/*
+ * graphic_assets.h
+ * Placeholder bitmaps for builds without the LG artwork header
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/*
+ * The artwork (logo and status icons, RGB565) is not part of the source
+ * tree. This directory comes last on the include path, so a real
+ * graphic_assets.h next to display.cpp wins; otherwise the display shows
+ * an outlined box of the right size for each image.
+ */
+
+#include <stdint.h>
+
+extern const uint16_t *const lg_logo;               // 186 x 90
+extern const uint16_t *const door_lock;             // 70 x 21
+extern const uint16_t *const turbowash;             // 23 x 20
+extern const uint16_t *const drumlight;             // 24 x 20
+extern const uint16_t *const est_time_remaining;    // 40 x 19
@@ -0,0 +1,36 @@
+/*
+ * dac_continuous.h
+ * DAC continuous output; the host build paces writes in real time
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "esp_err.h"
+typedef enum { DAC_CHAN_0, DAC_CHAN_1 } dac_channel_t;
+typedef enum { DAC_CHANNEL_MASK_CH0 = 1, DAC_CHANNEL_MASK_CH1 = 2, DAC_CHANNEL_MASK_ALL = 3 } dac_channel_mask_t;
+typedef enum { DAC_DIGI_CLK_SRC_PLL_D2, DAC_DIGI_CLK_SRC_APLL, DAC_DIGI_CLK_SRC_DEFAULT = DAC_DIGI_CLK_SRC_PLL_D2 } dac_continuous_digi_clk_src_t;
+typedef enum { DAC_CHANNEL_MODE_SIMUL, DAC_CHANNEL_MODE_ALTER } dac_continuous_channel_mode_t;
+typedef struct dac_continuous_s *dac_continuous_handle_t;
+typedef struct { dac_channel_mask_t chan_mask; uint32_t desc_num; size_t buf_size; uint32_t freq_hz; int8_t offset; dac_continuous_digi_clk_src_t clk_src; dac_continuous_channel_mode_t chan_mode; } dac_continuous_config_t;
+typedef struct { void *buf; size_t buf_size; size_t write_bytes; } dac_event_data_t;
+typedef bool (*dac_isr_callback_t)(dac_continuous_handle_t handle, const dac_event_data_t *event, void *user_data);
+typedef struct { dac_isr_callback_t on_convert_done; dac_isr_callback_t on_stop; } dac_event_callbacks_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t dac_continuous_new_channels(const dac_continuous_config_t *, dac_continuous_handle_t *);
+esp_err_t dac_continuous_del_channels(dac_continuous_handle_t);
+esp_err_t dac_continuous_enable(dac_continuous_handle_t);
+esp_err_t dac_continuous_disable(dac_continuous_handle_t);
+esp_err_t dac_continuous_write(dac_continuous_handle_t, uint8_t *, size_t, size_t *, int);
+esp_err_t dac_continuous_register_event_callback(dac_continuous_handle_t, const dac_event_callbacks_t *, void *);
+esp_err_t dac_continuous_start_async_writing(dac_continuous_handle_t);
+esp_err_t dac_continuous_stop_async_writing(dac_continuous_handle_t);
+esp_err_t dac_continuous_write_asynchronously(dac_continuous_handle_t, uint8_t *, size_t, const uint8_t *, size_t, size_t *);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,40 @@
+/*
+ * ledc.h
+ * LEDC PWM driver; the host build keeps duties in memory
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include <stdint.h>
+#include "esp_err.h"
+typedef enum { LEDC_LOW_SPEED_MODE } ledc_mode_t;
+typedef enum { LEDC_CHANNEL_0, LEDC_CHANNEL_1, LEDC_CHANNEL_2, LEDC_CHANNEL_3, LEDC_CHANNEL_4, LEDC_CHANNEL_5, LEDC_CHANNEL_6, LEDC_CHANNEL_7, LEDC_CHANNEL_MAX } ledc_channel_t;
+typedef enum { LEDC_TIMER_0, LEDC_TIMER_1 } ledc_timer_t;
+typedef enum { LEDC_TIMER_8_BIT=8, LEDC_TIMER_12_BIT=12 } ledc_timer_bit_t;
+typedef enum { LEDC_AUTO_CLK } ledc_clk_cfg_t;
+typedef enum { LEDC_INTR_DISABLE } ledc_intr_type_t;
+typedef enum { LEDC_FADE_NO_WAIT, LEDC_FADE_WAIT_DONE } ledc_fade_mode_t;
+typedef struct { ledc_mode_t speed_mode; ledc_timer_bit_t duty_resolution; ledc_timer_t timer_num; uint32_t freq_hz; ledc_clk_cfg_t clk_cfg; } ledc_timer_config_t;
+typedef struct { int gpio_num; ledc_mode_t speed_mode; ledc_channel_t channel; ledc_intr_type_t intr_type; ledc_timer_t timer_sel; uint32_t duty; int hpoint; } ledc_channel_config_t;
+typedef struct { int event; uint32_t speed_mode; uint32_t channel; uint32_t duty; } ledc_cb_param_t;
+typedef bool (*ledc_cb_t)(const ledc_cb_param_t *, void *);
+typedef struct { ledc_cb_t fade_cb; } ledc_cbs_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t ledc_timer_config(const ledc_timer_config_t *);
+esp_err_t ledc_channel_config(const ledc_channel_config_t *);
+esp_err_t ledc_set_duty(ledc_mode_t, ledc_channel_t, uint32_t);
+uint32_t ledc_get_duty(ledc_mode_t, ledc_channel_t);
+esp_err_t ledc_update_duty(ledc_mode_t, ledc_channel_t);
+esp_err_t ledc_fade_func_install(int);
+esp_err_t ledc_set_fade_with_time(ledc_mode_t, ledc_channel_t, uint32_t, int);
+esp_err_t ledc_fade_start(ledc_mode_t, ledc_channel_t, ledc_fade_mode_t);
+esp_err_t ledc_fade_stop(ledc_mode_t, ledc_channel_t);
+esp_err_t ledc_set_duty_and_update(ledc_mode_t, ledc_channel_t, uint32_t, uint32_t);
+esp_err_t ledc_set_fade_time_and_start(ledc_mode_t, ledc_channel_t, uint32_t, uint32_t, ledc_fade_mode_t);
+esp_err_t ledc_cb_register(ledc_mode_t, ledc_channel_t, ledc_cbs_t *, void *);
+#ifdef __cplusplus
+}
+#endif
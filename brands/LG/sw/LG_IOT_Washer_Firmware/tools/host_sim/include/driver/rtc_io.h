@@ -0,0 +1,24 @@
+/*
+ * rtc_io.h
+ * RTC GPIO driver; no-ops on the host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include "driver/gpio.h"
+typedef enum { RTC_GPIO_MODE_INPUT_ONLY } rtc_gpio_mode_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+bool rtc_gpio_is_valid_gpio(gpio_num_t);
+esp_err_t rtc_gpio_init(gpio_num_t);
+esp_err_t rtc_gpio_set_direction(gpio_num_t, rtc_gpio_mode_t);
+esp_err_t rtc_gpio_pullup_dis(gpio_num_t);
+esp_err_t rtc_gpio_pulldown_dis(gpio_num_t);
+esp_err_t rtc_gpio_hold_en(gpio_num_t);
+esp_err_t rtc_gpio_isolate(gpio_num_t);
+int rtc_io_number_get(gpio_num_t);
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,31 @@
+/*
+ * spi_master.h
+ * SPI master driver; the host build discards transfers
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+typedef enum { SPI1_HOST, SPI2_HOST, SPI3_HOST } spi_host_device_t;
+#define VSPI_HOST SPI3_HOST
+#define SPI_DMA_CH_AUTO 3
+typedef struct spi_device_t *spi_device_handle_t;
+typedef struct { int mosi_io_num, miso_io_num, sclk_io_num, quadwp_io_num, quadhd_io_num, max_transfer_sz; } spi_bus_config_t;
+typedef struct { int clock_speed_hz; int mode; int spics_io_num; int queue_size; } spi_device_interface_config_t;
+typedef struct { size_t length; const void *tx_buffer; void *rx_buffer; void *user; uint32_t flags; } spi_transaction_t;
+#ifdef __cplusplus
+extern "C" {
+#endif
+esp_err_t spi_bus_initialize(spi_host_device_t, const spi_bus_config_t *, int);
+esp_err_t spi_bus_add_device(spi_host_device_t, const spi_device_interface_config_t *, spi_device_handle_t *);
+esp_err_t spi_device_transmit(spi_device_handle_t, spi_transaction_t *);
+esp_err_t spi_device_polling_transmit(spi_device_handle_t, spi_transaction_t *);
+esp_err_t spi_device_queue_trans(spi_device_handle_t, spi_transaction_t *, TickType_t);
+esp_err_t spi_device_get_trans_result(spi_device_handle_t, spi_transaction_t **, TickType_t);
+#ifdef __cplusplus
+}
+#endif
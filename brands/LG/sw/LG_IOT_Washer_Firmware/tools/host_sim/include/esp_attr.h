@@ -0,0 +1,19 @@
+/*
+ * esp_attr.h
+ * Memory placement attributes for the Linux host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#define IRAM_ATTR
+#define DRAM_ATTR
+#define DMA_ATTR
+#define EXT_RAM_BSS_ATTR
+#define WORD_ALIGNED_ATTR __attribute__((aligned(4)))
+
+// RTC memory lives in its own section; the host copies it across the
+// simulated deep sleep (process re-exec), so it survives like on the chip
+#define RTC_NOINIT_ATTR __attribute__((section("host_rtc_mem")))
+#define RTC_DATA_ATTR   __attribute__((section("host_rtc_mem")))
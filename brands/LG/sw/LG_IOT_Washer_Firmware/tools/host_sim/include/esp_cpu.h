@@ -0,0 +1,16 @@
+/*
+ * esp_cpu.h
+ * CPU queries for the Linux host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "freertos/FreeRTOS.h"
+
+// Tasks report the core they were pinned to (0 if unpinned)
+static inline int esp_cpu_get_core_id(void)
+{
+    return (int)xPortGetCoreID();
+}
@@ -0,0 +1,20 @@
+/*
+ * esp_event.h
+ * Default event loop for the Linux host build (no events are raised)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_event_loop_create_default(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,50 @@
+/*
+ * esp_heap_trace.h
+ * Standalone heap tracer for the Linux host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+    HEAP_TRACE_ALL,
+    HEAP_TRACE_LEAKS,
+} heap_trace_mode_t;
+
+// The first allocations of a trace; the host keeps no call stacks
+typedef struct {
+    void *address;
+    size_t size;
+} heap_trace_record_t;
+
+typedef struct {
+    heap_trace_mode_t mode;
+    size_t total_allocations;
+    size_t total_frees;
+    size_t count;
+    size_t capacity;
+    size_t high_water_mark;
+    bool has_overflowed;
+} heap_trace_summary_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Counted by the malloc wrappers in esp_system_host.cpp, which see every
+// allocation the firmware sources make
+esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer, size_t num_records);
+esp_err_t heap_trace_start(heap_trace_mode_t mode);
+esp_err_t heap_trace_stop(void);
+esp_err_t heap_trace_summary(heap_trace_summary_t *summary);
+void heap_trace_dump(void);
+
+#ifdef __cplusplus
+}
+#endif
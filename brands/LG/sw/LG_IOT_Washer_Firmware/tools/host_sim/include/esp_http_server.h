@@ -0,0 +1,10 @@
+/*
+ * esp_http_server.h
+ * HTTP server types referenced by wifi_manager.h on the Linux host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+typedef void *httpd_handle_t;
@@ -0,0 +1,34 @@
+/*
+ * esp_sleep.h
+ * Wakeup cause for the Linux host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include "esp_err.h"
+
+typedef enum {
+    ESP_SLEEP_WAKEUP_UNDEFINED,
+    ESP_SLEEP_WAKEUP_ALL,
+    ESP_SLEEP_WAKEUP_EXT0,
+    ESP_SLEEP_WAKEUP_EXT1,
+    ESP_SLEEP_WAKEUP_TIMER,
+    ESP_SLEEP_WAKEUP_TOUCHPAD,
+    ESP_SLEEP_WAKEUP_ULP,
+} esp_sleep_wakeup_cause_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief ESP_SLEEP_WAKEUP_ULP after a simulated deep sleep, otherwise
+ *        ESP_SLEEP_WAKEUP_UNDEFINED (cold boot)
+ */
+esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,13 @@
+/*
+ * esp_vfs_dev.h
+ * Console routing for the Linux host build; logs always go to the link
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+static inline void esp_vfs_dev_uart_use_driver(int uart_num)
+{
+    (void)uart_num;
+}
@@ -0,0 +1,31 @@
+/*
+ * esp_wifi.h
+ * Wi-Fi queries used by the display on the Linux host build (always offline)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef struct {
+    uint8_t mac[6];
+    int8_t rssi;
+} wifi_sta_info_t;
+
+typedef struct {
+    wifi_sta_info_t sta[10];
+    int num;
+} wifi_sta_list_t;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+esp_err_t esp_wifi_ap_get_sta_list(wifi_sta_list_t *sta);
+
+#ifdef __cplusplus
+}
+#endif
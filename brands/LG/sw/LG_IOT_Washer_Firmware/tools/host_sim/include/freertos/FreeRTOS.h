@@ -0,0 +1,96 @@
+/*
+ * FreeRTOS.h
+ * FreeRTOS kernel types for the Linux host build (tools/host_sim)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+/*
+ * Why a thread-backed shim instead of the FreeRTOS POSIX port:
+ * - The firmware only uses the task, notification, queue and mutex API of
+ *   the ESP-IDF SMP kernel. Mapping each task to a std::thread and each
+ *   blocking call to one shared condition variable keeps the shim small
+ *   and needs nothing outside this directory.
+ * - Priorities are not enforced; every ready task runs, as on an SMP
+ *   kernel with one core per task. Code that relies on priority instead
+ *   of locks to exclude another task is wrong on the ESP32 too.
+ * - A task deleted by another task stops at its next blocking call
+ *   (delay, notify wait, queue or mutex), not mid-instruction.
+ */
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "sdkconfig.h"
+#include "esp_attr.h"
+#include "esp_heap_caps.h"     // Pulled in by the ESP-IDF port layer too
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint8_t StackType_t;
+
+#define pdTRUE                  1
+#define pdFALSE                 0
+#define pdPASS                  pdTRUE
+#define pdFAIL                  pdFALSE
+#define errQUEUE_FULL           0
+#define errQUEUE_EMPTY          0
+
+#define portMAX_DELAY           ((TickType_t)0xffffffffUL)
+#define configTICK_RATE_HZ      CONFIG_FREERTOS_HZ
+#define portTICK_PERIOD_MS      ((TickType_t)1000 / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(ms)       ((TickType_t)(((uint64_t)(ms) * configTICK_RATE_HZ) / 1000U))
+#define pdTICKS_TO_MS(ticks)    ((uint32_t)(((uint64_t)(ticks) * 1000U) / configTICK_RATE_HZ))
+
+#define configMAX_PRIORITIES        25
+#define configMAX_TASK_NAME_LEN     16
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#define portNUM_PROCESSORS          2
+#define tskNO_AFFINITY              ((BaseType_t)0x7fffffff)
+#define tskIDLE_PRIORITY            ((UBaseType_t)0)
+
+// Storage for the static create calls; the shim keeps its own state
+typedef struct { void *reserved[8]; } StaticTask_t;
+typedef struct { void *reserved[8]; } StaticQueue_t;
+typedef StaticQueue_t StaticSemaphore_t;
+
+/*===========================================================================
+ * Critical Sections
+ *
+ * Every portMUX maps to one process-wide recursive lock, so a critical
+ * section excludes all other critical sections, as with interrupts off on
+ * both cores. Never block inside one.
+ *===========================================================================*/
+
+typedef struct {
+    uint32_t owner;
+    uint32_t count;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED    { 0, 0 }
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void vPortEnterCritical(portMUX_TYPE *mux);
+void vPortExitCritical(portMUX_TYPE *mux);
+BaseType_t xPortGetCoreID(void);
+BaseType_t xPortInIsrContext(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#define portENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define portEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portENTER_CRITICAL_ISR(mux)     vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_ISR(mux)      vPortExitCritical(mux)
+#define portENTER_CRITICAL_SAFE(mux)    vPortEnterCritical(mux)
+#define portEXIT_CRITICAL_SAFE(mux)     vPortExitCritical(mux)
+#define taskENTER_CRITICAL(mux)         vPortEnterCritical(mux)
+#define taskEXIT_CRITICAL(mux)          vPortExitCritical(mux)
+#define portYIELD_FROM_ISR(...)         do {} while (0)
@@ -0,0 +1,35 @@
+/*
+ * sdkconfig.h
+ * Kconfig values for the Linux host build (tools/host_sim)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+// The host build always runs as the simulator, without Wi-Fi or the
+// hardware-only inputs; the balance sensor reads the plant model. Tasks
+// and queues are static, and the heap tracer is the host's
+// (esp_system_host.cpp), so cycle_check --heap holds a running cycle to
+// zero heap allocations. Everything else follows main/Kconfig defaults.
+#define CONFIG_IDF_TARGET_LINUX             1
+#define CONFIG_FREERTOS_HZ                  1000
+#define CONFIG_LOG_MAXIMUM_LEVEL            3
+
+#define CONFIG_SIMULATOR_MODE               1
+#define CONFIG_WIFI_ENABLED                 0
+#define CONFIG_SIM_PLANT                    1
+#define CONFIG_SIM_TELEMETRY_PERIOD_MS      50
+#define CONFIG_BALANCE_DETECTION            1
+#define CONFIG_DIAL_ENCODER                 0
+#define CONFIG_RUNTIME_STATS                0
+#define CONFIG_LATENCY_TRACE                1
+#define CONFIG_EVENT_TRACE                  1
+#define CONFIG_EVENT_TRACE_RECORDS          512
+#define CONFIG_EVENT_RECORD                 1
+#define CONFIG_EVENT_RECORD_BYTES           8192
+#define CONFIG_STATIC_ALLOCATION            1
+#define CONFIG_HEAP_TRACING_STANDALONE      1
+#define CONFIG_CYCLE_CHECKPOINT             1
+#define CONFIG_CYCLE_CHECKPOINT_PERIOD_S    60
+#define CONFIG_SOUND_PCM_CACHE              0
@@ -0,0 +1,5 @@
+/*
+ * rtc_cntl_reg.h
+ * Included by main.cpp; no registers on the Linux host build
+ */
+#pragma once
@@ -0,0 +1,8 @@
+/*
+ * ulp.h
+ * Included by main.cpp; the host build replaces the ULP with ulp_host.cpp
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
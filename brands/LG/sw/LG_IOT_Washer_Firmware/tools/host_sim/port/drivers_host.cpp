@@ -0,0 +1,452 @@
+/*
+ * drivers_host.cpp
+ * GPIO, LEDC, DAC, SPI, I2C, RTC IO and UART drivers for the host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * In simulator mode gpio_hal already reports every output to the simulator
+ * and reads inputs from it, so these drivers only keep enough state to
+ * answer reads. The DAC is the exception: the sound task is paced by
+ * dac_continuous_write() blocking while the DMA plays, so the host write
+ * waits for the samples' play time.
+ */
+
+#include "driver/dac_continuous.h"
+#include "driver/gpio.h"
+#include "driver/i2c_master.h"
+#include "driver/ledc.h"
+#include "driver/rtc_io.h"
+#include "driver/spi_master.h"
+#include "driver/uart.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "host_port.h"
+
+#include <string.h>
+#include <atomic>
+
+struct dac_continuous_s {
+    uint32_t freq_hz;
+    uint32_t channels;
+    bool enabled;
+};
+
+struct spi_device_t {
+    int clock_speed_hz;
+};
+
+static std::atomic<uint64_t> s_gpio_levels{0};
+static uint32_t s_ledc_duty[LEDC_CHANNEL_MAX];
+
+/*===========================================================================
+ * GPIO
+ *===========================================================================*/
+
+extern "C" esp_err_t gpio_config(const gpio_config_t *config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t gpio_set_level(gpio_num_t gpio, uint32_t level)
+{
+    if (gpio < 0 || gpio >= 64) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    const uint64_t bit = 1ull << gpio;
+    if (level) {
+        s_gpio_levels.fetch_or(bit);
+    } else {
+        s_gpio_levels.fetch_and(~bit);
+    }
+    return ESP_OK;
+}
+
+extern "C" int gpio_get_level(gpio_num_t gpio)
+{
+    if (gpio < 0 || gpio >= 64) {
+        return 0;
+    }
+    return (s_gpio_levels.load() >> gpio) & 1 ? 1 : 0;
+}
+
+extern "C" esp_err_t gpio_install_isr_service(int flags)
+{
+    (void)flags;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_isr_handler_add(gpio_num_t gpio, gpio_isr_t handler, void *arg)
+{
+    (void)gpio;
+    (void)handler;
+    (void)arg;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t gpio_isr_handler_remove(gpio_num_t gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+/*===========================================================================
+ * RTC IO
+ *===========================================================================*/
+
+extern "C" bool rtc_gpio_is_valid_gpio(gpio_num_t gpio)
+{
+    return gpio >= 0 && gpio < 40;
+}
+
+extern "C" esp_err_t rtc_gpio_init(gpio_num_t gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rtc_gpio_set_direction(gpio_num_t gpio, rtc_gpio_mode_t mode)
+{
+    (void)gpio;
+    (void)mode;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rtc_gpio_pullup_dis(gpio_num_t gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rtc_gpio_pulldown_dis(gpio_num_t gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rtc_gpio_hold_en(gpio_num_t gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t rtc_gpio_isolate(gpio_num_t gpio)
+{
+    (void)gpio;
+    return ESP_OK;
+}
+
+/*===========================================================================
+ * LEDC
+ *===========================================================================*/
+
+extern "C" esp_err_t ledc_timer_config(const ledc_timer_config_t *config)
+{
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t ledc_channel_config(const ledc_channel_config_t *config)
+{
+    if (!config || config->channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ledc_duty[config->channel] = config->duty;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ledc_fade_func_install(int flags)
+{
+    (void)flags;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ledc_set_duty(ledc_mode_t mode, ledc_channel_t channel, uint32_t duty)
+{
+    (void)mode;
+    if (channel >= LEDC_CHANNEL_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_ledc_duty[channel] = duty;
+    return ESP_OK;
+}
+
+extern "C" uint32_t ledc_get_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+    (void)mode;
+    return channel < LEDC_CHANNEL_MAX ? s_ledc_duty[channel] : 0;
+}
+
+extern "C" esp_err_t ledc_update_duty(ledc_mode_t mode, ledc_channel_t channel)
+{
+    (void)mode;
+    (void)channel;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ledc_fade_stop(ledc_mode_t mode, ledc_channel_t channel)
+{
+    (void)mode;
+    (void)channel;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ledc_set_duty_and_update(ledc_mode_t mode, ledc_channel_t channel,
+                                              uint32_t duty, uint32_t hpoint)
+{
+    (void)hpoint;
+    return ledc_set_duty(mode, channel, duty);
+}
+
+// Fades end at once; gpio_hal reports the target duty to the simulator
+extern "C" esp_err_t ledc_set_fade_time_and_start(ledc_mode_t mode, ledc_channel_t channel,
+                                                  uint32_t duty, uint32_t time_ms,
+                                                  ledc_fade_mode_t wait)
+{
+    (void)time_ms;
+    (void)wait;
+    return ledc_set_duty(mode, channel, duty);
+}
+
+/*===========================================================================
+ * DAC
+ *===========================================================================*/
+
+extern "C" esp_err_t dac_continuous_new_channels(const dac_continuous_config_t *config,
+                                                 dac_continuous_handle_t *handle)
+{
+    if (!config || !handle || config->freq_hz == 0) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    dac_continuous_handle_t dac = new dac_continuous_s();
+    dac->freq_hz = config->freq_hz;
+    // Simultaneous mode feeds both channels from each byte
+    dac->channels = (config->chan_mask == DAC_CHANNEL_MASK_ALL &&
+                     config->chan_mode == DAC_CHANNEL_MODE_ALTER) ? 2 : 1;
+    dac->enabled = false;
+    *handle = dac;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t dac_continuous_del_channels(dac_continuous_handle_t handle)
+{
+    delete handle;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t dac_continuous_enable(dac_continuous_handle_t handle)
+{
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->enabled = true;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t dac_continuous_disable(dac_continuous_handle_t handle)
+{
+    if (!handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    handle->enabled = false;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t dac_continuous_write(dac_continuous_handle_t handle, uint8_t *buf,
+                                          size_t buf_size, size_t *bytes_loaded, int timeout_ms)
+{
+    (void)buf;
+    (void)timeout_ms;
+    if (!handle || !handle->enabled) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const uint64_t play_ms = (uint64_t)buf_size * 1000 / handle->channels / handle->freq_hz;
+    vTaskDelay(pdMS_TO_TICKS(play_ms));
+    if (bytes_loaded) {
+        *bytes_loaded = buf_size;
+    }
+    return ESP_OK;
+}
+
+/*===========================================================================
+ * SPI
+ *===========================================================================*/
+
+extern "C" esp_err_t spi_bus_initialize(spi_host_device_t host, const spi_bus_config_t *config,
+                                        int dma_chan)
+{
+    (void)host;
+    (void)dma_chan;
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t spi_bus_add_device(spi_host_device_t host,
+                                        const spi_device_interface_config_t *config,
+                                        spi_device_handle_t *handle)
+{
+    (void)host;
+    if (!config || !handle) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    *handle = new spi_device_t{ config->clock_speed_hz };
+    return ESP_OK;
+}
+
+extern "C" esp_err_t spi_device_transmit(spi_device_handle_t handle, spi_transaction_t *trans)
+{
+    return (handle && trans) ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t spi_device_polling_transmit(spi_device_handle_t handle,
+                                                 spi_transaction_t *trans)
+{
+    return spi_device_transmit(handle, trans);
+}
+
+/*===========================================================================
+ * I2C
+ *
+ * No bus: the MPU6050 driver reads the plant model while it runs, and with
+ * the plant stopped its init fails here as on a board without the sensor.
+ *===========================================================================*/
+
+extern "C" esp_err_t i2c_master_get_bus_handle(i2c_port_num_t port, i2c_master_bus_handle_t *bus)
+{
+    (void)port;
+    *bus = nullptr;
+    return ESP_ERR_INVALID_STATE;
+}
+
+extern "C" esp_err_t i2c_new_master_bus(const i2c_master_bus_config_t *config,
+                                        i2c_master_bus_handle_t *bus)
+{
+    (void)config;
+    *bus = nullptr;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t i2c_master_bus_add_device(i2c_master_bus_handle_t bus,
+                                               const i2c_device_config_t *config,
+                                               i2c_master_dev_handle_t *device)
+{
+    (void)bus;
+    (void)config;
+    *device = nullptr;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t i2c_master_transmit(i2c_master_dev_handle_t device, const uint8_t *data,
+                                         size_t len, int timeout_ms)
+{
+    (void)device;
+    (void)data;
+    (void)len;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t i2c_master_transmit_receive(i2c_master_dev_handle_t device,
+                                                 const uint8_t *write, size_t write_len,
+                                                 uint8_t *read, size_t read_len, int timeout_ms)
+{
+    (void)device;
+    (void)write;
+    (void)write_len;
+    (void)read;
+    (void)read_len;
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+/*===========================================================================
+ * UART
+ *
+ * UART0 is the simulator link; the other ports have nothing attached
+ * (the ODrive driver returns before using its UART in simulator mode).
+ *===========================================================================*/
+
+extern "C" esp_err_t uart_driver_install(uart_port_t port, int rx_buffer_size, int tx_buffer_size,
+                                         int queue_size, QueueHandle_t *queue, int flags)
+{
+    (void)port;
+    (void)rx_buffer_size;
+    (void)tx_buffer_size;
+    (void)queue_size;
+    (void)flags;
+    if (queue) {
+        *queue = nullptr;
+    }
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_driver_delete(uart_port_t port)
+{
+    (void)port;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_param_config(uart_port_t port, const uart_config_t *config)
+{
+    (void)port;
+    return config ? ESP_OK : ESP_ERR_INVALID_ARG;
+}
+
+extern "C" esp_err_t uart_set_pin(uart_port_t port, int tx, int rx, int rts, int cts)
+{
+    (void)port;
+    (void)tx;
+    (void)rx;
+    (void)rts;
+    (void)cts;
+    return ESP_OK;
+}
+
+extern "C" int uart_write_bytes(uart_port_t port, const void *data, size_t len)
+{
+    if (port == UART_NUM_0) {
+        host_link_write(data, len);
+    }
+    return (int)len;
+}
+
+extern "C" int uart_read_bytes(uart_port_t port, void *data, uint32_t len, TickType_t ticks)
+{
+    if (port != UART_NUM_0) {
+        vTaskDelay(ticks);
+        return 0;
+    }
+    // A blocking point, so the reader stops here once deep sleep halts it
+    vTaskDelay(0);
+    if (g_host_options.virtual_time) {
+        // Poll, and wait in the kernel so the virtual clock can move on
+        const int n = host_link_read(data, len, 0);
+        if (n == 0) {
+            vTaskDelay(ticks);
+        }
+        return n;
+    }
+    // At least 1 ms, or a fast clock would turn the reader into a busy loop
+    const uint32_t wait_ms = pdTICKS_TO_MS(ticks) / g_host_options.time_scale;
+    return host_link_read(data, len, wait_ms > 0 ? wait_ms : 1);
+}
+
+extern "C" esp_err_t uart_flush_input(uart_port_t port)
+{
+    (void)port;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_get_buffered_data_len(uart_port_t port, size_t *size)
+{
+    (void)port;
+    *size = 0;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t uart_wait_tx_done(uart_port_t port, TickType_t ticks)
+{
+    (void)port;
+    (void)ticks;
+    return ESP_OK;
+}
@@ -0,0 +1,464 @@
+/*
+ * esp_system_host.cpp
+ * Logging, error names, clock, random numbers and heap for the host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "esp_err.h"
+#include "esp_event.h"
+#include "esp_heap_caps.h"
+#include "esp_heap_trace.h"
+#include "esp_log.h"
+#include "esp_random.h"
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#include "host_port.h"
+
+#include <malloc.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <new>
+#include <random>
+
+// Heap size reported to the firmware, about what the ESP32 has left after
+// Wi-Fi and the static data of this project
+#define HOST_HEAP_BYTES     (200 * 1024)
+
+/*===========================================================================
+ * Clock
+ *===========================================================================*/
+
+static std::chrono::steady_clock::time_point s_clock_origin = std::chrono::steady_clock::now();
+static int64_t s_clock_base_us = 0;
+static std::atomic<int64_t> s_virtual_us{0};
+
+void host_time_init(int64_t start_us)
+{
+    s_clock_origin = std::chrono::steady_clock::now();
+    s_clock_base_us = start_us;
+    s_virtual_us.store(start_us);
+}
+
+int64_t host_time_us(void)
+{
+    if (g_host_options.virtual_time) {
+        return s_virtual_us.load(std::memory_order_acquire);
+    }
+    const int64_t wall_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                                std::chrono::steady_clock::now() - s_clock_origin).count();
+    return s_clock_base_us + wall_us * g_host_options.time_scale;
+}
+
+void host_time_advance_to(int64_t time_us)
+{
+    if (time_us > s_virtual_us.load(std::memory_order_relaxed)) {
+        s_virtual_us.store(time_us, std::memory_order_release);
+    }
+}
+
+extern "C" int64_t esp_timer_get_time(void)
+{
+    return host_time_us();
+}
+
+/*===========================================================================
+ * Logging
+ *===========================================================================*/
+
+// One level for every tag; the firmware only ever sets "*"
+static std::atomic<int> s_log_level{ESP_LOG_VERBOSE};
+static std::atomic<vprintf_like_t> s_log_vprintf{nullptr};
+
+static int call_vprintf(vprintf_like_t func, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    const int ret = func(format, args);
+    va_end(args);
+    return ret;
+}
+
+extern "C" void esp_log_write(esp_log_level_t level, const char *tag, const char *format, ...)
+{
+    static const char s_letters[] = "NEWIDV";
+    if ((int)level > s_log_level.load(std::memory_order_relaxed)) {
+        return;
+    }
+    char line[512];
+    int len = snprintf(line, sizeof(line), "%c (%lu) %s: ", s_letters[level],
+                       (unsigned long)(host_time_us() / 1000), tag);
+    va_list args;
+    va_start(args, format);
+    len += vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+    va_end(args);
+    if (len > (int)sizeof(line) - 2) {
+        len = sizeof(line) - 2;
+    }
+    line[len++] = '\n';
+    line[len] = 0;
+    const vprintf_like_t func = s_log_vprintf.load(std::memory_order_acquire);
+    if (!func) {
+        host_link_log(line, (size_t)len);
+        return;
+    }
+    call_vprintf(func, "%s", line);
+    if (g_host_options.link_mode != HOST_LINK_STDIO) {
+        fwrite(line, 1, (size_t)len, stderr);
+    }
+}
+
+extern "C" vprintf_like_t esp_log_set_vprintf(vprintf_like_t func)
+{
+    return s_log_vprintf.exchange(func, std::memory_order_acq_rel);
+}
+
+extern "C" void esp_log_level_set(const char *tag, esp_log_level_t level)
+{
+    if (tag && strcmp(tag, "*") == 0) {
+        s_log_level.store(level, std::memory_order_relaxed);
+    }
+}
+
+/*===========================================================================
+ * Errors
+ *===========================================================================*/
+
+extern "C" const char *esp_err_to_name(esp_err_t code)
+{
+    switch (code) {
+    case ESP_OK:                        return "ESP_OK";
+    case ESP_FAIL:                      return "ESP_FAIL";
+    case ESP_ERR_NO_MEM:                return "ESP_ERR_NO_MEM";
+    case ESP_ERR_INVALID_ARG:           return "ESP_ERR_INVALID_ARG";
+    case ESP_ERR_INVALID_STATE:         return "ESP_ERR_INVALID_STATE";
+    case ESP_ERR_INVALID_SIZE:          return "ESP_ERR_INVALID_SIZE";
+    case ESP_ERR_NOT_FOUND:             return "ESP_ERR_NOT_FOUND";
+    case ESP_ERR_NOT_SUPPORTED:         return "ESP_ERR_NOT_SUPPORTED";
+    case ESP_ERR_TIMEOUT:               return "ESP_ERR_TIMEOUT";
+    case ESP_ERR_INVALID_RESPONSE:      return "ESP_ERR_INVALID_RESPONSE";
+    case ESP_ERR_INVALID_CRC:           return "ESP_ERR_INVALID_CRC";
+    case ESP_ERR_INVALID_VERSION:       return "ESP_ERR_INVALID_VERSION";
+    case ESP_ERR_NVS_NOT_INITIALIZED:   return "ESP_ERR_NVS_NOT_INITIALIZED";
+    case ESP_ERR_NVS_NOT_FOUND:         return "ESP_ERR_NVS_NOT_FOUND";
+    case ESP_ERR_NVS_TYPE_MISMATCH:     return "ESP_ERR_NVS_TYPE_MISMATCH";
+    case ESP_ERR_NVS_INVALID_HANDLE:    return "ESP_ERR_NVS_INVALID_HANDLE";
+    case ESP_ERR_NVS_INVALID_LENGTH:    return "ESP_ERR_NVS_INVALID_LENGTH";
+    default:                            return "UNKNOWN ERROR";
+    }
+}
+
+extern "C" void host_error_check_failed(esp_err_t rc, const char *file, int line, const char *expr)
+{
+    fprintf(stderr, "ESP_ERROR_CHECK failed: esp_err_t 0x%x (%s) at %s:%d\nexpression: %s\n",
+            (unsigned)rc, esp_err_to_name(rc), file, line, expr);
+    abort();
+}
+
+/*===========================================================================
+ * System
+ *===========================================================================*/
+
+extern "C" uint32_t esp_random(void)
+{
+    static std::mutex s_lock;
+    static std::mt19937 s_rng(std::random_device{}());
+    std::lock_guard<std::mutex> guard(s_lock);
+    return (uint32_t)s_rng();
+}
+
+extern "C" esp_sleep_wakeup_cause_t esp_sleep_get_wakeup_cause(void)
+{
+    return g_host_options.wake_cause;
+}
+
+extern "C" esp_err_t esp_event_loop_create_default(void)
+{
+    return ESP_OK;
+}
+
+/*===========================================================================
+ * Heap
+ *
+ * The linker wraps malloc and friends for the firmware objects and
+ * operator new/delete is replaced for the whole program, so the counters
+ * see what the firmware would take from the ESP-IDF heap. Besides the live
+ * blocks they count every allocation and free, which is what the heap
+ * tracer below reports: churn that frees what it takes leaves the live
+ * count unchanged. What the port allocates in place of flash or static
+ * kernel objects is live but not counted (host_heap_uncounted_begin()).
+ *===========================================================================*/
+
+static std::atomic<size_t> s_blocks{0};
+static std::atomic<size_t> s_bytes{0};
+static std::atomic<size_t> s_peak{0};
+static std::atomic<size_t> s_allocations{0};
+static std::atomic<size_t> s_frees{0};
+static thread_local int t_uncounted = 0;
+
+// Standalone heap tracer
+static heap_trace_record_t *s_trace_records = nullptr;
+static size_t s_trace_capacity = 0;
+static heap_trace_mode_t s_trace_mode = HEAP_TRACE_ALL;
+static std::atomic<bool> s_tracing{false};
+static std::atomic<size_t> s_trace_count{0};
+static size_t s_trace_allocations = 0;     // Counters at heap_trace_start()
+static size_t s_trace_frees = 0;
+
+extern "C" void *__real_malloc(size_t size);
+extern "C" void *__real_calloc(size_t n, size_t size);
+extern "C" void *__real_realloc(void *ptr, size_t size);
+extern "C" void __real_free(void *ptr);
+
+static void count_alloc(void *ptr)
+{
+    if (!ptr) {
+        return;
+    }
+    const size_t size = malloc_usable_size(ptr);
+    if (t_uncounted == 0) {
+        s_allocations.fetch_add(1, std::memory_order_relaxed);
+        if (s_tracing.load(std::memory_order_relaxed)) {
+            const size_t index = s_trace_count.fetch_add(1, std::memory_order_relaxed);
+            if (index < s_trace_capacity) {
+                s_trace_records[index].address = ptr;
+                s_trace_records[index].size = size;
+            }
+        }
+    }
+    s_blocks.fetch_add(1, std::memory_order_relaxed);
+    const size_t bytes = s_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    size_t peak = s_peak.load(std::memory_order_relaxed);
+    while (bytes > peak && !s_peak.compare_exchange_weak(peak, bytes)) {
+    }
+}
+
+static void count_free(size_t size)
+{
+    if (t_uncounted == 0) {
+        s_frees.fetch_add(1, std::memory_order_relaxed);
+    }
+    s_blocks.fetch_sub(1, std::memory_order_relaxed);
+    s_bytes.fetch_sub(size, std::memory_order_relaxed);
+}
+
+extern "C" void *__wrap_malloc(size_t size)
+{
+    void *ptr = __real_malloc(size);
+    count_alloc(ptr);
+    return ptr;
+}
+
+extern "C" void *__wrap_calloc(size_t n, size_t size)
+{
+    void *ptr = __real_calloc(n, size);
+    count_alloc(ptr);
+    return ptr;
+}
+
+extern "C" void *__wrap_realloc(void *ptr, size_t size)
+{
+    if (!ptr) {
+        return __wrap_malloc(size);
+    }
+    const size_t old_size = malloc_usable_size(ptr);
+    void *out = __real_realloc(ptr, size);
+    if (out || size == 0) {     // Old block released
+        count_free(old_size);
+        count_alloc(out);
+    }
+    return out;
+}
+
+extern "C" void __wrap_free(void *ptr)
+{
+    if (ptr) {
+        count_free(malloc_usable_size(ptr));
+        __real_free(ptr);
+    }
+}
+
+void *operator new(size_t size)
+{
+    void *ptr = __wrap_malloc(size ? size : 1);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void *operator new(size_t size, const std::nothrow_t &) noexcept
+{
+    return __wrap_malloc(size ? size : 1);
+}
+
+void *operator new[](size_t size, const std::nothrow_t &) noexcept
+{
+    return __wrap_malloc(size ? size : 1);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    __wrap_free(ptr);
+}
+
+void host_heap_get_stats(host_heap_stats_t *out)
+{
+    out->allocated_blocks = s_blocks.load(std::memory_order_relaxed);
+    out->allocated_bytes = s_bytes.load(std::memory_order_relaxed);
+    out->peak_bytes = s_peak.load(std::memory_order_relaxed);
+    out->total_allocations = s_allocations.load(std::memory_order_relaxed);
+    out->total_frees = s_frees.load(std::memory_order_relaxed);
+}
+
+void host_heap_uncounted_begin(void)
+{
+    t_uncounted++;
+}
+
+void host_heap_uncounted_end(void)
+{
+    t_uncounted--;
+}
+
+extern "C" esp_err_t heap_trace_init_standalone(heap_trace_record_t *record_buffer,
+                                                size_t num_records)
+{
+    if (s_tracing.load()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_trace_records = record_buffer;
+    s_trace_capacity = record_buffer ? num_records : 0;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t heap_trace_start(heap_trace_mode_t mode)
+{
+    if (!s_trace_records) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_tracing.store(false);
+    s_trace_mode = mode;
+    s_trace_count.store(0);
+    s_trace_allocations = s_allocations.load();
+    s_trace_frees = s_frees.load();
+    s_tracing.store(true);
+    return ESP_OK;
+}
+
+extern "C" esp_err_t heap_trace_stop(void)
+{
+    if (!s_tracing.exchange(false)) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    s_trace_allocations = s_allocations.load() - s_trace_allocations;
+    s_trace_frees = s_frees.load() - s_trace_frees;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t heap_trace_summary(heap_trace_summary_t *summary)
+{
+    if (!summary || s_tracing.load()) {
+        return ESP_ERR_INVALID_STATE;
+    }
+    const size_t count = s_trace_count.load();
+    summary->mode = s_trace_mode;
+    summary->total_allocations = s_trace_allocations;
+    summary->total_frees = s_trace_frees;
+    summary->count = count < s_trace_capacity ? count : s_trace_capacity;
+    summary->capacity = s_trace_capacity;
+    summary->high_water_mark = summary->count;
+    summary->has_overflowed = count > s_trace_capacity;
+    return ESP_OK;
+}
+
+extern "C" void heap_trace_dump(void)
+{
+    const size_t count = s_trace_count.load();
+    const size_t shown = count < s_trace_capacity ? count : s_trace_capacity;
+    printf("%zu allocations traced, %zu shown (no call stacks on the host)\n", count, shown);
+    for (size_t i = 0; i < shown; i++) {
+        printf("  %zu bytes at %p\n", s_trace_records[i].size, s_trace_records[i].address);
+    }
+}
+
+extern "C" void *heap_caps_malloc(size_t size, uint32_t caps)
+{
+    (void)caps;
+    return __wrap_malloc(size);
+}
+
+extern "C" void *heap_caps_calloc(size_t n, size_t size, uint32_t caps)
+{
+    (void)caps;
+    return __wrap_calloc(n, size);
+}
+
+extern "C" void heap_caps_free(void *ptr)
+{
+    __wrap_free(ptr);
+}
+
+extern "C" void heap_caps_get_info(multi_heap_info_t *info, uint32_t caps)
+{
+    (void)caps;
+    host_heap_stats_t stats;
+    host_heap_get_stats(&stats);
+    const size_t used = stats.allocated_bytes < HOST_HEAP_BYTES ? stats.allocated_bytes
+                                                                : HOST_HEAP_BYTES;
+    const size_t peak = stats.peak_bytes < HOST_HEAP_BYTES ? stats.peak_bytes : HOST_HEAP_BYTES;
+    info->total_free_bytes = HOST_HEAP_BYTES - used;
+    info->total_allocated_bytes = used;
+    info->largest_free_block = info->total_free_bytes;
+    info->minimum_free_bytes = HOST_HEAP_BYTES - peak;
+    info->allocated_blocks = stats.allocated_blocks;
+    info->free_blocks = 1;
+    info->total_blocks = stats.allocated_blocks + 1;
+}
+
+extern "C" size_t heap_caps_get_free_size(uint32_t caps)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    return info.total_free_bytes;
+}
+
+extern "C" size_t heap_caps_get_minimum_free_size(uint32_t caps)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    return info.minimum_free_bytes;
+}
+
+extern "C" size_t heap_caps_get_largest_free_block(uint32_t caps)
+{
+    multi_heap_info_t info;
+    heap_caps_get_info(&info, caps);
+    return info.largest_free_block;
+}
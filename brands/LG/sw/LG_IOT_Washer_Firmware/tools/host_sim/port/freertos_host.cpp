@@ -0,0 +1,833 @@
+/*
+ * freertos_host.cpp
+ * FreeRTOS task, notification, queue and semaphore API on std::thread
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why one lock and one condition variable for the whole kernel:
+ * - The firmware runs about ten tasks that block for milliseconds at a
+ *   time. Waking every waiter on each state change costs nothing at that
+ *   scale and leaves a single place where a task can be deleted,
+ *   suspended or halted: the blocking wait below.
+ * - Deleting another task raises a flag; the target throws TaskExit out
+ *   of its next blocking call, unwinding its stack like the real kernel
+ *   frees it. vTaskDelete() returns once the target is gone, so a static
+ *   slot or a handle can be reused at once.
+ *
+ * Why the virtual clock advances only when every task is blocked:
+ * - With virtual_time the tick count is a variable, not the wall clock, so
+ *   a 75 minute wash runs as fast as the tasks can compute. Code runs in
+ *   zero virtual time; the clock moves only when every task waits in the
+ *   kernel. It then jumps to the earliest timeout and wakes those tasks,
+ *   like a discrete-event simulator.
+ * - A task that was woken but has not run yet still counts as ready, so
+ *   the clock never passes work that is due now. Each waiting task keeps
+ *   its wake-up condition in its TCB for that check.
+ * - Time stops while any task is outside the kernel, including blocking
+ *   I/O on the simulator link, so runs are repeatable wherever the host
+ *   is slow.
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "host_port.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct TaskExit {};
+
+enum class QueueKind { Queue, Mutex, Binary };
+
+}  // namespace
+
+struct tskTaskControlBlock {
+    char name[configMAX_TASK_NAME_LEN];
+    TaskFunction_t entry;
+    void *arg;
+    UBaseType_t priority;
+    BaseType_t core;
+    UBaseType_t number = 0;
+    uint32_t notify_value = 0;
+    bool notify_pending = false;
+    bool released = false;          // Handle stored; entry may run
+    bool delete_requested = false;
+    bool deleted_by_other = false;  // The deleter joins and frees the task
+    bool suspended = false;
+    bool finished = false;
+    std::thread thread;
+    // Virtual clock: the wait this task is parked in
+    bool waiting = false;
+    int64_t wake_us = -1;           // Timeout, -1 = none
+    bool (*wait_ready)(const void *ctx) = nullptr;
+    const void *wait_ctx = nullptr;
+};
+
+struct QueueDefinition {
+    QueueKind kind;
+    UBaseType_t length;
+    UBaseType_t item_size;
+    UBaseType_t count = 0;
+    UBaseType_t head = 0;
+    std::vector<uint8_t> storage;
+    TaskHandle_t holder = nullptr;  // Mutex owner
+    UBaseType_t depth = 0;          // Recursive mutex: takes by the holder
+};
+
+static std::mutex s_lock;
+static std::condition_variable s_cv;
+static std::recursive_mutex s_critical;
+static std::vector<TaskHandle_t> s_tasks;
+static std::vector<TaskHandle_t> s_finished;    // Self-deleted, joined later
+static TaskHandle_t s_halt_owner = nullptr;
+static bool s_halted = false;
+static int s_running = 0;                       // Tasks not parked (virtual clock)
+static thread_local TaskHandle_t t_self = nullptr;
+
+/*===========================================================================
+ * Blocking
+ *===========================================================================*/
+
+static inline TickType_t tick_now(void)
+{
+    return (TickType_t)(host_time_us() / (1000000 / configTICK_RATE_HZ));
+}
+
+static inline bool is_runnable(TaskHandle_t task)
+{
+    return !task->suspended && !(s_halted && s_halt_owner != task);
+}
+
+// Whether a parked task would continue if it ran now (s_lock held)
+static bool is_ready(TaskHandle_t task)
+{
+    if (task->delete_requested) {
+        return true;
+    }
+    if (!is_runnable(task)) {
+        return false;
+    }
+    if (!task->wait_ready) {
+        return true;        // Parked only for suspend or halt
+    }
+    return task->wait_ready(task->wait_ctx) ||
+           (task->wake_us >= 0 && host_time_us() >= task->wake_us);
+}
+
+// Called when the last running task parks: jump to the earliest timeout
+static void advance_clock_if_idle(void)
+{
+    if (s_running > 0) {
+        return;
+    }
+    int64_t next_us = INT64_MAX;
+    for (TaskHandle_t task : s_tasks) {
+        if (!task->waiting) {
+            continue;
+        }
+        if (is_ready(task)) {
+            return;         // Woken and about to run
+        }
+        if (is_runnable(task) && task->wake_us >= 0 && task->wake_us < next_us) {
+            next_us = task->wake_us;
+        }
+    }
+    if (next_us != INT64_MAX) {
+        host_time_advance_to(next_us);
+        s_cv.notify_all();
+    }
+}
+
+// One wait on s_cv. Under the virtual clock the task stops counting as
+// running meanwhile, and the last one to park moves the clock.
+static void park(std::unique_lock<std::mutex> &lock, TaskHandle_t self)
+{
+    if (!g_host_options.virtual_time || !self) {
+        s_cv.wait(lock);
+        return;
+    }
+    self->waiting = true;
+    s_running--;
+    advance_clock_if_idle();
+    if (!is_ready(self)) {
+        s_cv.wait(lock);
+    }
+    self->waiting = false;
+    s_running++;
+}
+
+static void check_self(std::unique_lock<std::mutex> &lock)
+{
+    TaskHandle_t self = t_self;
+    if (!self) {
+        return;
+    }
+    while (true) {
+        if (self->delete_requested) {
+            throw TaskExit();
+        }
+        if (is_runnable(self)) {
+            return;
+        }
+        park(lock, self);
+    }
+}
+
+// block_until() under the virtual clock: the wait is described in the TCB
+// so advance_clock_if_idle() can tell whether this task is ready
+template <typename Ready>
+static bool block_virtual(std::unique_lock<std::mutex> &lock, TickType_t ticks, Ready &ready)
+{
+    TaskHandle_t self = t_self;
+    const int64_t wake_us = ticks == portMAX_DELAY
+        ? -1 : host_time_us() + (int64_t)ticks * portTICK_PERIOD_MS * 1000;
+    while (true) {
+        check_self(lock);
+        if (ready()) {
+            return true;
+        }
+        if (ticks == 0 || (wake_us >= 0 && host_time_us() >= wake_us)) {
+            return false;
+        }
+        self->wait_ready = [](const void *ctx) { return (*static_cast<const Ready *>(ctx))(); };
+        self->wait_ctx = &ready;
+        self->wake_us = wake_us;
+        park(lock, self);
+        self->wait_ready = nullptr;
+        self->wait_ctx = nullptr;
+        self->wake_us = -1;
+    }
+}
+
+// Wait with s_lock held until ready() is true or `ticks` pass.
+// Throws TaskExit when the calling task is deleted meanwhile.
+template <typename Ready>
+static bool block_until(std::unique_lock<std::mutex> &lock, TickType_t ticks, Ready ready)
+{
+    if (g_host_options.virtual_time && t_self) {
+        return block_virtual(lock, ticks, ready);
+    }
+    // A faster clock (time_scale) shortens the wall time of every timeout
+    const auto deadline = std::chrono::steady_clock::now() +
+                          std::chrono::microseconds((int64_t)ticks * portTICK_PERIOD_MS * 1000 /
+                                                    g_host_options.time_scale);
+    while (true) {
+        check_self(lock);
+        if (ready()) {
+            return true;
+        }
+        if (ticks == 0) {
+            return false;
+        }
+        if (ticks == portMAX_DELAY) {
+            s_cv.wait(lock);
+        } else if (s_cv.wait_until(lock, deadline) == std::cv_status::timeout) {
+            check_self(lock);
+            return ready();
+        }
+    }
+}
+
+static void reap_finished(std::unique_lock<std::mutex> &lock)
+{
+    std::vector<TaskHandle_t> done;
+    done.swap(s_finished);
+    lock.unlock();
+    for (TaskHandle_t task : done) {
+        if (task->thread.joinable()) {
+            task->thread.join();
+        }
+        delete task;
+    }
+    lock.lock();
+}
+
+/*===========================================================================
+ * Critical Sections and Port
+ *===========================================================================*/
+
+extern "C" void vPortEnterCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    s_critical.lock();
+}
+
+extern "C" void vPortExitCritical(portMUX_TYPE *mux)
+{
+    (void)mux;
+    s_critical.unlock();
+}
+
+extern "C" BaseType_t xPortGetCoreID(void)
+{
+    TaskHandle_t self = t_self;
+    return (self && self->core != tskNO_AFFINITY) ? self->core : 0;
+}
+
+extern "C" BaseType_t xPortInIsrContext(void)
+{
+    return pdFALSE;
+}
+
+void host_tasks_halt_others(void)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    s_halt_owner = t_self;
+    s_halted = true;
+    s_cv.notify_all();
+}
+
+/*===========================================================================
+ * Tasks
+ *===========================================================================*/
+
+static void task_main(TaskHandle_t task)
+{
+    t_self = task;
+    {
+        std::unique_lock<std::mutex> lock(s_lock);
+        s_cv.wait(lock, [task] { return task->released; });
+    }
+    try {
+        task->entry(task->arg);
+    } catch (const TaskExit &) {
+    }
+
+    std::lock_guard<std::mutex> guard(s_lock);
+    task->finished = true;
+    for (auto it = s_tasks.begin(); it != s_tasks.end(); ++it) {
+        if (*it == task) {
+            s_tasks.erase(it);
+            break;
+        }
+    }
+    s_running--;
+    if (g_host_options.virtual_time) {
+        advance_clock_if_idle();
+    }
+    // Returned or deleted itself: freed by the next task create
+    if (!task->deleted_by_other) {
+        s_finished.push_back(task);
+    }
+    s_cv.notify_all();
+}
+
+extern "C" BaseType_t xTaskCreatePinnedToCore(TaskFunction_t entry, const char *name,
+                                              uint32_t stack_bytes, void *arg,
+                                              UBaseType_t priority, TaskHandle_t *handle,
+                                              BaseType_t core)
+{
+    (void)stack_bytes;
+    TaskHandle_t task = new tskTaskControlBlock();
+    snprintf(task->name, sizeof(task->name), "%s", name ? name : "");
+    task->entry = entry;
+    task->arg = arg;
+    task->priority = priority;
+    task->core = core;
+
+    std::unique_lock<std::mutex> lock(s_lock);
+    reap_finished(lock);
+    s_tasks.push_back(task);
+    s_running++;
+    task->thread = std::thread(task_main, task);
+    if (handle) {
+        *handle = task;
+    }
+    task->released = true;
+    s_cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" TaskHandle_t xTaskCreateStaticPinnedToCore(TaskFunction_t entry, const char *name,
+                                                      uint32_t stack_bytes, void *arg,
+                                                      UBaseType_t priority, StackType_t *stack,
+                                                      StaticTask_t *tcb, BaseType_t core)
+{
+    (void)stack;
+    (void)tcb;
+    HostHeapUncounted uncounted;     // The caller's TCB and stack on the chip
+    TaskHandle_t task = nullptr;
+    xTaskCreatePinnedToCore(entry, name, stack_bytes, arg, priority, &task, core);
+    return task;
+}
+
+extern "C" BaseType_t xTaskCreate(TaskFunction_t entry, const char *name, uint32_t stack_bytes,
+                                  void *arg, UBaseType_t priority, TaskHandle_t *handle)
+{
+    return xTaskCreatePinnedToCore(entry, name, stack_bytes, arg, priority, handle,
+                                   tskNO_AFFINITY);
+}
+
+extern "C" void vTaskDelete(TaskHandle_t task)
+{
+    TaskHandle_t self = t_self;
+    if (!task || task == self) {
+        if (self) {
+            std::lock_guard<std::mutex> guard(s_lock);
+            self->delete_requested = true;
+        }
+        throw TaskExit();
+    }
+
+    std::unique_lock<std::mutex> lock(s_lock);
+    task->delete_requested = true;
+    task->deleted_by_other = true;
+    s_cv.notify_all();
+    // A task that never blocks again cannot be stopped; report and leak it
+    if (!s_cv.wait_for(lock, std::chrono::seconds(2), [task] { return task->finished; })) {
+        fprintf(stderr, "host: task %s did not reach a blocking call after delete\n", task->name);
+        return;
+    }
+    lock.unlock();
+    task->thread.join();
+    delete task;
+}
+
+extern "C" void vTaskSuspend(TaskHandle_t task)
+{
+    TaskHandle_t target = task ? task : t_self;
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (target) {
+        target->suspended = true;
+    }
+    if (target == t_self) {
+        check_self(lock);
+    }
+}
+
+extern "C" void vTaskResume(TaskHandle_t task)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (task) {
+        task->suspended = false;
+        s_cv.notify_all();
+    }
+}
+
+extern "C" void vTaskDelay(TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (ticks == 0) {
+        check_self(lock);
+        lock.unlock();
+        std::this_thread::yield();
+        return;
+    }
+    block_until(lock, ticks, [] { return false; });
+}
+
+extern "C" BaseType_t xTaskDelayUntil(TickType_t *previous_wake, TickType_t period)
+{
+    const TickType_t target = *previous_wake + period;
+    const TickType_t now = tick_now();
+    *previous_wake = target;
+    // Wrap-safe: a target in the past means the period was missed
+    if ((int32_t)(target - now) <= 0) {
+        vTaskDelay(0);
+        return pdFALSE;
+    }
+    vTaskDelay(target - now);
+    return pdTRUE;
+}
+
+extern "C" TickType_t xTaskGetTickCount(void)
+{
+    return tick_now();
+}
+
+extern "C" TickType_t xTaskGetTickCountFromISR(void)
+{
+    return tick_now();
+}
+
+extern "C" TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return t_self;
+}
+
+extern "C" char *pcTaskGetName(TaskHandle_t task)
+{
+    TaskHandle_t target = task ? task : t_self;
+    return target ? target->name : nullptr;
+}
+
+extern "C" UBaseType_t uxTaskGetNumberOfTasks(void)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    return (UBaseType_t)s_tasks.size();
+}
+
+extern "C" UBaseType_t uxTaskGetSystemState(TaskStatus_t *status, UBaseType_t count,
+                                            uint32_t *total_runtime)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    UBaseType_t n = 0;
+    for (TaskHandle_t task : s_tasks) {
+        if (n >= count) {
+            break;
+        }
+        TaskStatus_t &out = status[n++];
+        memset(&out, 0, sizeof(out));
+        out.xHandle = task;
+        out.pcTaskName = task->name;
+        out.xTaskNumber = task->number;
+        out.eCurrentState = task->suspended ? eSuspended : eBlocked;
+        out.uxCurrentPriority = task->priority;
+        out.uxBasePriority = task->priority;
+        out.xCoreID = task->core;
+    }
+    if (total_runtime) {
+        *total_runtime = 0;
+    }
+    return n;
+}
+
+extern "C" UBaseType_t uxTaskGetTaskNumber(TaskHandle_t task)
+{
+    TaskHandle_t target = task ? task : t_self;
+    return target ? target->number : 0;
+}
+
+extern "C" void vTaskSetTaskNumber(TaskHandle_t task, UBaseType_t number)
+{
+    TaskHandle_t target = task ? task : t_self;
+    if (target) {
+        target->number = number;
+    }
+}
+
+extern "C" UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    (void)task;
+    return 0;
+}
+
+/*===========================================================================
+ * Notifications
+ *===========================================================================*/
+
+extern "C" uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    TaskHandle_t self = t_self;
+    std::unique_lock<std::mutex> lock(s_lock);
+    block_until(lock, ticks, [self] { return self->notify_value != 0; });
+    const uint32_t value = self->notify_value;
+    if (value != 0) {
+        self->notify_value = clear_on_exit ? 0 : value - 1;
+    }
+    self->notify_pending = false;
+    return value;
+}
+
+extern "C" BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action)
+{
+    if (!task) {
+        return pdFAIL;
+    }
+    std::lock_guard<std::mutex> guard(s_lock);
+    BaseType_t ret = pdPASS;
+    switch (action) {
+    case eSetBits:
+        task->notify_value |= value;
+        break;
+    case eIncrement:
+        task->notify_value++;
+        break;
+    case eSetValueWithOverwrite:
+        task->notify_value = value;
+        break;
+    case eSetValueWithoutOverwrite:
+        if (task->notify_pending) {
+            ret = pdFAIL;
+        } else {
+            task->notify_value = value;
+        }
+        break;
+    case eNoAction:
+        break;
+    }
+    task->notify_pending = true;
+    s_cv.notify_all();
+    return ret;
+}
+
+extern "C" BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    return xTaskNotify(task, 0, eIncrement);
+}
+
+extern "C" void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *woken)
+{
+    xTaskNotify(task, 0, eIncrement);
+    if (woken) {
+        *woken = pdTRUE;
+    }
+}
+
+extern "C" BaseType_t xTaskNotifyFromISR(TaskHandle_t task, uint32_t value, eNotifyAction action,
+                                         BaseType_t *woken)
+{
+    if (woken) {
+        *woken = pdTRUE;
+    }
+    return xTaskNotify(task, value, action);
+}
+
+extern "C" BaseType_t xTaskNotifyWait(uint32_t clear_on_entry, uint32_t clear_on_exit,
+                                      uint32_t *value, TickType_t ticks)
+{
+    TaskHandle_t self = t_self;
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (!self->notify_pending) {
+        self->notify_value &= ~clear_on_entry;
+    }
+    const bool got = block_until(lock, ticks, [self] { return self->notify_pending; });
+    if (value) {
+        *value = self->notify_value;
+    }
+    if (got) {
+        self->notify_value &= ~clear_on_exit;
+    }
+    self->notify_pending = false;
+    return got ? pdTRUE : pdFALSE;
+}
+
+/*===========================================================================
+ * Queues
+ *===========================================================================*/
+
+static QueueHandle_t queue_new(QueueKind kind, UBaseType_t length, UBaseType_t item_size)
+{
+    QueueHandle_t queue = new QueueDefinition();
+    queue->kind = kind;
+    queue->length = length;
+    queue->item_size = item_size;
+    queue->storage.resize((size_t)length * item_size);
+    return queue;
+}
+
+extern "C" QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+    return queue_new(QueueKind::Queue, length, item_size);
+}
+
+extern "C" QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t item_size,
+                                            uint8_t *storage, StaticQueue_t *queue)
+{
+    (void)storage;
+    (void)queue;
+    HostHeapUncounted uncounted;
+    return queue_new(QueueKind::Queue, length, item_size);
+}
+
+extern "C" void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+static BaseType_t queue_send(QueueHandle_t queue, const void *item, TickType_t ticks, bool front)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (!block_until(lock, ticks, [queue] { return queue->count < queue->length; })) {
+        return errQUEUE_FULL;
+    }
+    UBaseType_t slot;
+    if (front) {
+        queue->head = (queue->head + queue->length - 1) % queue->length;
+        slot = queue->head;
+    } else {
+        slot = (queue->head + queue->count) % queue->length;
+    }
+    if (queue->item_size) {
+        memcpy(&queue->storage[(size_t)slot * queue->item_size], item, queue->item_size);
+    }
+    queue->count++;
+    s_cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, false);
+}
+
+extern "C" BaseType_t xQueueSendToFront(QueueHandle_t queue, const void *item, TickType_t ticks)
+{
+    return queue_send(queue, item, ticks, true);
+}
+
+extern "C" BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item, BaseType_t *woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return queue_send(queue, item, 0, false);
+}
+
+extern "C" BaseType_t xQueueOverwrite(QueueHandle_t queue, const void *item)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (queue->item_size) {
+        memcpy(queue->storage.data(), item, queue->item_size);
+    }
+    queue->head = 0;
+    queue->count = 1;
+    s_cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (!block_until(lock, ticks, [queue] { return queue->count > 0; })) {
+        return errQUEUE_EMPTY;
+    }
+    if (queue->item_size) {
+        memcpy(item, &queue->storage[(size_t)queue->head * queue->item_size], queue->item_size);
+    }
+    queue->head = (queue->head + 1) % queue->length;
+    queue->count--;
+    s_cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xQueueReset(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    queue->head = 0;
+    queue->count = 0;
+    s_cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    return queue->count;
+}
+
+extern "C" UBaseType_t uxQueueSpacesAvailable(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    return queue->length - queue->count;
+}
+
+/*===========================================================================
+ * Semaphores
+ *===========================================================================*/
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    QueueHandle_t sem = queue_new(QueueKind::Mutex, 1, 0);
+    sem->count = 1;
+    return sem;
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateMutexStatic(StaticSemaphore_t *buffer)
+{
+    (void)buffer;
+    HostHeapUncounted uncounted;
+    return xSemaphoreCreateMutex();
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateRecursiveMutex(void)
+{
+    return xSemaphoreCreateMutex();
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateRecursiveMutexStatic(StaticSemaphore_t *buffer)
+{
+    (void)buffer;
+    HostHeapUncounted uncounted;
+    return xSemaphoreCreateMutex();
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return queue_new(QueueKind::Binary, 1, 0);
+}
+
+extern "C" SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *buffer)
+{
+    (void)buffer;
+    HostHeapUncounted uncounted;
+    return xSemaphoreCreateBinary();
+}
+
+extern "C" BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (!block_until(lock, ticks, [sem] { return sem->count > 0; })) {
+        return pdFAIL;
+    }
+    sem->count--;
+    sem->holder = t_self;
+    return pdPASS;
+}
+
+extern "C" BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (sem->count >= sem->length) {
+        return pdFAIL;
+    }
+    sem->count++;
+    sem->holder = nullptr;
+    s_cv.notify_all();
+    return pdPASS;
+}
+
+extern "C" BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t sem, BaseType_t *woken)
+{
+    if (woken) {
+        *woken = pdFALSE;
+    }
+    return xSemaphoreGive(sem);
+}
+
+extern "C" BaseType_t xSemaphoreTakeRecursive(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    std::unique_lock<std::mutex> lock(s_lock);
+    if (sem->holder == t_self && sem->depth > 0) {
+        sem->depth++;
+        return pdPASS;
+    }
+    if (!block_until(lock, ticks, [sem] { return sem->count > 0; })) {
+        return pdFAIL;
+    }
+    sem->count--;
+    sem->holder = t_self;
+    sem->depth = 1;
+    return pdPASS;
+}
+
+extern "C" BaseType_t xSemaphoreGiveRecursive(SemaphoreHandle_t sem)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (sem->holder != t_self || sem->depth == 0) {
+        return pdFAIL;
+    }
+    if (--sem->depth == 0) {
+        sem->count++;
+        sem->holder = nullptr;
+        s_cv.notify_all();
+    }
+    return pdPASS;
+}
+
+extern "C" void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
@@ -0,0 +1,39 @@
+/*
+ * graphic_assets_host.cpp
+ * Placeholder bitmaps declared by fallback/graphic_assets.h
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "graphic_assets.h"
+
+#include <array>
+
+#define PLACEHOLDER_OUTLINE 0x8410      // Mid grey (RGB565)
+#define PLACEHOLDER_FILL    0x0000
+
+template <int W, int H>
+static constexpr std::array<uint16_t, W * H> outlined_box()
+{
+    std::array<uint16_t, W * H> pixels{};
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            const bool edge = x == 0 || y == 0 || x == W - 1 || y == H - 1;
+            pixels[y * W + x] = edge ? PLACEHOLDER_OUTLINE : PLACEHOLDER_FILL;
+        }
+    }
+    return pixels;
+}
+
+static constexpr auto s_lg_logo = outlined_box<186, 90>();
+static constexpr auto s_door_lock = outlined_box<70, 21>();
+static constexpr auto s_turbowash = outlined_box<23, 20>();
+static constexpr auto s_drumlight = outlined_box<24, 20>();
+static constexpr auto s_est_time_remaining = outlined_box<40, 19>();
+
+const uint16_t *const lg_logo = s_lg_logo.data();
+const uint16_t *const door_lock = s_door_lock.data();
+const uint16_t *const turbowash = s_turbowash.data();
+const uint16_t *const drumlight = s_drumlight.data();
+const uint16_t *const est_time_remaining = s_est_time_remaining.data();
@@ -0,0 +1,159 @@
+/*
+ * host_port.h
+ * Internal interfaces of the Linux host port (tools/host_sim)
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_sleep.h"
+
+/*===========================================================================
+ * Options
+ *===========================================================================*/
+
+typedef enum {
+    HOST_LINK_PTY,          // Print the slave path; sim_host.py opens it
+    HOST_LINK_TCP,          // Listen; sim_host.py connects to socket://host:port
+    HOST_LINK_STDIO,        // stdin/stdout, for pipes and scripted runs
+} host_link_mode_t;
+
+typedef struct {
+    host_link_mode_t link_mode;
+    int tcp_port;
+    const char *pty_link;           // Symlink to the PTY slave, or nullptr
+    const char *nvs_path;           // "" keeps NVS in memory only
+    esp_sleep_wakeup_cause_t wake_cause;
+    uint32_t time_scale;            // Clock runs this many times wall time
+    bool virtual_time;              // Clock jumps to the next wake-up when all tasks block
+    // Carried across the simulated deep sleep
+    int link_fd;                    // Connected link, -1 = open a new one
+    int listen_fd;                  // TCP listener, -1 = none yet
+    int pty_hold_fd;                // Keeps the PTY open between clients
+    int rtc_fd;                     // RTC memory image, -1 = cold boot
+    int64_t start_us;               // Clock at boot (kept across deep sleep)
+    int argc;
+    char **argv;
+    void (*deep_sleep_hook)(void);  // Runs instead of deep sleep; must not return
+} host_options_t;
+
+extern host_options_t g_host_options;
+
+/*===========================================================================
+ * Clock
+ *===========================================================================*/
+
+/**
+ * @brief Microseconds since the first boot of this run (monotonic, kept
+ *        across the simulated deep sleep)
+ */
+int64_t host_time_us(void);
+
+/**
+ * @brief Set the clock origin; after a deep sleep the new image continues
+ *        from the time the previous one stopped
+ */
+void host_time_init(int64_t start_us);
+
+/**
+ * @brief Move the virtual clock forward to @p time_us (virtual_time only;
+ *        called by the kernel once every task is blocked)
+ */
+void host_time_advance_to(int64_t time_us);
+
+/*===========================================================================
+ * Simulator Link (UART0)
+ *===========================================================================*/
+
+/**
+ * @brief Open the link given by g_host_options (or adopt link_fd)
+ * @return false if the link could not be set up
+ */
+bool host_link_init(void);
+
+/**
+ * @brief Write all bytes, waiting for a slow reader; dropped when no
+ *        client is connected
+ */
+void host_link_write(const void *data, size_t len);
+
+/**
+ * @brief Read what is available, waiting up to @p timeout_ms for the first
+ *        byte
+ * @return Bytes read (0 on timeout or while no client is connected)
+ */
+int host_link_read(void *data, size_t len, uint32_t timeout_ms);
+
+/**
+ * @brief Send one log line to the link and mirror it to stderr
+ */
+void host_link_log(const char *line, size_t len);
+
+/**
+ * @brief Descriptors to keep open across the simulated deep sleep
+ */
+void host_link_get_fds(int *link_fd, int *listen_fd, int *pty_hold_fd);
+
+/*===========================================================================
+ * Tasks
+ *===========================================================================*/
+
+/**
+ * @brief Block every task except the caller at its next blocking call,
+ *        as the CPU stops in deep sleep
+ */
+void host_tasks_halt_others(void);
+
+/*===========================================================================
+ * Power
+ *===========================================================================*/
+
+/**
+ * @brief Restore RTC memory from g_host_options.rtc_fd (before any task)
+ */
+void host_rtc_restore(void);
+
+/**
+ * @brief Re-exec the firmware as after a ULP wake: RAM is lost, RTC memory,
+ *        NVS, the clock and the simulator link are kept
+ */
+void host_deep_sleep_restart(void) __attribute__((noreturn));
+
+/*===========================================================================
+ * Heap
+ *===========================================================================*/
+
+typedef struct {
+    size_t allocated_blocks;
+    size_t allocated_bytes;
+    size_t peak_bytes;
+    size_t total_allocations;   // Since start-up, including freed blocks
+    size_t total_frees;
+} host_heap_stats_t;
+
+void host_heap_get_stats(host_heap_stats_t *out);
+
+/**
+ * @brief Stop counting the calling thread's allocations as allocations
+ *        (they stay in the live totals) until host_heap_uncounted_end()
+ *
+ * For what the port allocates in place of memory that is not heap on the
+ * chip: NVS flash, statically allocated kernel objects, the checks'
+ * recorder. Nests.
+ */
+void host_heap_uncounted_begin(void);
+void host_heap_uncounted_end(void);
+
+#ifdef __cplusplus
+// host_heap_uncounted_begin() for the enclosing scope
+struct HostHeapUncounted {
+    HostHeapUncounted() { host_heap_uncounted_begin(); }
+    ~HostHeapUncounted() { host_heap_uncounted_end(); }
+    HostHeapUncounted(const HostHeapUncounted &) = delete;
+    HostHeapUncounted &operator=(const HostHeapUncounted &) = delete;
+};
+#endif
@@ -0,0 +1,258 @@
+/*
+ * link_host.cpp
+ * Simulator link (UART0) for the host build over a PTY, TCP or stdio
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why a PTY by default:
+ * - sim_host.py already talks to a serial port. A PTY slave is one, so the
+ *   same script drives the chip or this process with only the port name
+ *   changed. TCP serves the same byte stream to pyserial's socket:// URL
+ *   for setups without PTYs; stdio suits pipes and scripted runs.
+ * - The link carries protocol frames (main/simulator/sim_protocol.h) and
+ *   printf output, exactly as UART0 does on the chip, including
+ *   interleaving at write granularity. stdout is routed into it, so the
+ *   trace dumps reach the decoders unchanged.
+ * - Nobody may be reading. Writes wait briefly for a slow reader, then the
+ *   link counts as stalled and drops output until the reader catches up,
+ *   so a missing simulator never stops the firmware.
+ */
+
+#include "host_port.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#include <mutex>
+
+#define LINK_WRITE_WAIT_MS  200
+
+static std::mutex s_write_lock;
+static std::mutex s_read_lock;
+static int s_read_fd = -1;
+static int s_write_fd = -1;
+static int s_listen_fd = -1;
+static int s_pty_hold_fd = -1;
+static bool s_stalled = false;
+
+static void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void drop_client(void)
+{
+    // Only TCP clients come and go; a PTY stays open through s_pty_hold_fd
+    if (g_host_options.link_mode == HOST_LINK_TCP && s_read_fd >= 0) {
+        close(s_read_fd);
+        s_read_fd = -1;
+        s_write_fd = -1;
+        fprintf(stderr, "host: simulator disconnected\n");
+    }
+}
+
+/*===========================================================================
+ * Setup
+ *===========================================================================*/
+
+static bool open_pty(void)
+{
+    if (g_host_options.link_fd < 0) {
+        const int master = posix_openpt(O_RDWR | O_NOCTTY);
+        if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+            perror("host: posix_openpt");
+            return false;
+        }
+        const char *slave_path = ptsname(master);
+        const int slave = open(slave_path, O_RDWR | O_NOCTTY);
+        if (slave < 0) {
+            perror("host: open PTY slave");
+            return false;
+        }
+        struct termios tio;
+        tcgetattr(slave, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(slave, TCSANOW, &tio);
+        g_host_options.link_fd = master;
+        g_host_options.pty_hold_fd = slave;
+    }
+    s_read_fd = s_write_fd = g_host_options.link_fd;
+    s_pty_hold_fd = g_host_options.pty_hold_fd;
+    set_nonblocking(s_read_fd);
+
+    const char *slave_path = ptsname(s_read_fd);
+    if (g_host_options.pty_link && slave_path) {
+        unlink(g_host_options.pty_link);
+        if (symlink(slave_path, g_host_options.pty_link) != 0) {
+            perror("host: symlink");
+        }
+    }
+    fprintf(stderr, "host: simulator link on %s%s%s\n", slave_path ? slave_path : "?",
+            g_host_options.pty_link ? " -> " : "",
+            g_host_options.pty_link ? g_host_options.pty_link : "");
+    return true;
+}
+
+static bool open_tcp(void)
+{
+    if (g_host_options.listen_fd < 0) {
+        const int fd = socket(AF_INET, SOCK_STREAM, 0);
+        const int on = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((uint16_t)g_host_options.tcp_port);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+            listen(fd, 1) != 0) {
+            perror("host: TCP listen");
+            return false;
+        }
+        g_host_options.listen_fd = fd;
+        fprintf(stderr, "host: simulator link on socket://127.0.0.1:%d\n",
+                g_host_options.tcp_port);
+    }
+    s_listen_fd = g_host_options.listen_fd;
+    s_read_fd = s_write_fd = g_host_options.link_fd;
+    if (s_read_fd >= 0) {
+        set_nonblocking(s_read_fd);
+    }
+    return true;
+}
+
+static ssize_t stdout_write(void *cookie, const char *data, size_t len)
+{
+    (void)cookie;
+    host_link_write(data, len);
+    return (ssize_t)len;
+}
+
+bool host_link_init(void)
+{
+    bool ok = false;
+    switch (g_host_options.link_mode) {
+    case HOST_LINK_PTY:
+        ok = open_pty();
+        break;
+    case HOST_LINK_TCP:
+        ok = open_tcp();
+        break;
+    case HOST_LINK_STDIO:
+        s_read_fd = STDIN_FILENO;
+        s_write_fd = dup(STDOUT_FILENO);
+        ok = true;
+        break;
+    }
+    if (ok) {
+        cookie_io_functions_t io = {};
+        io.write = stdout_write;
+        FILE *link = fopencookie(nullptr, "w", io);
+        if (link) {
+            setvbuf(link, nullptr, _IOLBF, 256);
+            stdout = link;
+        }
+    }
+    return ok;
+}
+
+void host_link_get_fds(int *link_fd, int *listen_fd, int *pty_hold_fd)
+{
+    *link_fd = g_host_options.link_mode == HOST_LINK_STDIO ? -1 : s_read_fd;
+    *listen_fd = s_listen_fd;
+    *pty_hold_fd = s_pty_hold_fd;
+}
+
+/*===========================================================================
+ * Data
+ *===========================================================================*/
+
+static void write_locked(const uint8_t *data, size_t len)
+{
+    while (len > 0 && s_write_fd >= 0) {
+        const ssize_t n = write(s_write_fd, data, len);
+        if (n > 0) {
+            s_stalled = false;
+            data += n;
+            len -= (size_t)n;
+            continue;
+        }
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0 && errno != EAGAIN) {
+            drop_client();
+            return;
+        }
+        struct pollfd pfd = { s_write_fd, POLLOUT, 0 };
+        if (poll(&pfd, 1, s_stalled ? 0 : LINK_WRITE_WAIT_MS) <= 0) {
+            s_stalled = true;
+            return;
+        }
+    }
+}
+
+void host_link_write(const void *data, size_t len)
+{
+    std::lock_guard<std::mutex> guard(s_write_lock);
+    write_locked(static_cast<const uint8_t *>(data), len);
+}
+
+void host_link_log(const char *line, size_t len)
+{
+    std::lock_guard<std::mutex> guard(s_write_lock);
+    write_locked(reinterpret_cast<const uint8_t *>(line), len);
+    // The checks never open the link; their logs go to stderr only
+    if (g_host_options.link_mode != HOST_LINK_STDIO || s_write_fd < 0) {
+        fwrite(line, 1, len, stderr);
+    }
+}
+
+int host_link_read(void *data, size_t len, uint32_t timeout_ms)
+{
+    std::lock_guard<std::mutex> guard(s_read_lock);
+    if (s_read_fd < 0) {
+        if (s_listen_fd < 0) {
+            usleep(timeout_ms * 1000);
+            return 0;
+        }
+        struct pollfd pfd = { s_listen_fd, POLLIN, 0 };
+        if (poll(&pfd, 1, (int)timeout_ms) > 0) {
+            const int fd = accept(s_listen_fd, nullptr, nullptr);
+            if (fd >= 0) {
+                set_nonblocking(fd);
+                std::lock_guard<std::mutex> write_guard(s_write_lock);
+                s_read_fd = s_write_fd = fd;
+                s_stalled = false;
+                fprintf(stderr, "host: simulator connected\n");
+            }
+        }
+        return 0;
+    }
+
+    struct pollfd pfd = { s_read_fd, POLLIN, 0 };
+    if (poll(&pfd, 1, (int)timeout_ms) <= 0) {
+        return 0;
+    }
+    const ssize_t n = read(s_read_fd, data, len);
+    if (n > 0) {
+        return (int)n;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EINTR)) {
+        std::lock_guard<std::mutex> write_guard(s_write_lock);
+        drop_client();
+        if (g_host_options.link_mode != HOST_LINK_TCP) {
+            usleep(timeout_ms * 1000);      // stdin closed; keep running
+        }
+    }
+    return 0;
+}
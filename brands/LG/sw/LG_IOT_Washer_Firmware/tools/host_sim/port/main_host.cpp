@@ -0,0 +1,154 @@
+/*
+ * main_host.cpp
+ * Entry point of the Linux host build: parse options, open the simulator
+ * link and run app_main() as a task
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "event_record.h"
+#include "host_port.h"
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+extern "C" void app_main(void);
+
+static const char *s_record_path = nullptr;
+static FILE *s_record_file = nullptr;
+
+host_options_t g_host_options = {
+    .link_mode = HOST_LINK_PTY,
+    .tcp_port = 0,
+    .pty_link = nullptr,
+    .nvs_path = nullptr,
+    .wake_cause = ESP_SLEEP_WAKEUP_UNDEFINED,
+    .time_scale = 1,
+    .virtual_time = false,
+    .link_fd = -1,
+    .listen_fd = -1,
+    .pty_hold_fd = -1,
+    .rtc_fd = -1,
+    .start_us = 0,
+    .argc = 0,
+    .argv = nullptr,
+    .deep_sleep_hook = nullptr,
+};
+
+static void usage(const char *name)
+{
+    fprintf(stderr,
+            "usage: %s [--pty[=LINK] | --tcp=PORT | --stdio] [--nvs=FILE] [--wake=ulp]\n"
+            "          [--speed=N | --virtual-time] [--record=FILE]\n"
+            "  --pty[=LINK]    simulator link on a new PTY (default); LINK gets a symlink to it\n"
+            "  --tcp=PORT      simulator link on 127.0.0.1:PORT (sim_host.py socket://...)\n"
+            "  --stdio         simulator link on stdin/stdout\n"
+            "  --nvs=FILE      NVS contents (default host_nvs.txt)\n"
+            "  --wake=ulp      boot as after a power button wake instead of a cold boot\n"
+            "  --speed=N       run the clock N times faster than wall time\n"
+            "  --virtual-time  skip idle time: the clock jumps whenever all tasks wait\n"
+            "  --record=FILE   record the manager's events for event_replay\n",
+            name);
+}
+
+static bool parse_args(int argc, char **argv)
+{
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *value = strchr(arg, '=');
+        value = value ? value + 1 : "";
+        if (strcmp(arg, "--pty") == 0) {
+            g_host_options.link_mode = HOST_LINK_PTY;
+        } else if (strncmp(arg, "--pty=", 6) == 0) {
+            g_host_options.link_mode = HOST_LINK_PTY;
+            g_host_options.pty_link = value;
+        } else if (strncmp(arg, "--tcp=", 6) == 0) {
+            g_host_options.link_mode = HOST_LINK_TCP;
+            g_host_options.tcp_port = atoi(value);
+        } else if (strcmp(arg, "--stdio") == 0) {
+            g_host_options.link_mode = HOST_LINK_STDIO;
+        } else if (strncmp(arg, "--nvs=", 6) == 0) {
+            g_host_options.nvs_path = value;
+        } else if (strncmp(arg, "--speed=", 8) == 0) {
+            g_host_options.time_scale = (uint32_t)atoi(value);
+            if (g_host_options.time_scale == 0) {
+                return false;
+            }
+        } else if (strcmp(arg, "--virtual-time") == 0) {
+            g_host_options.virtual_time = true;
+        } else if (strncmp(arg, "--record=", 9) == 0) {
+            s_record_path = value;
+        } else if (strcmp(arg, "--wake=ulp") == 0) {
+            g_host_options.wake_cause = ESP_SLEEP_WAKEUP_ULP;
+        } else if (strncmp(arg, "--link-fd=", 10) == 0) {
+            g_host_options.link_fd = atoi(value);
+        } else if (strncmp(arg, "--listen-fd=", 12) == 0) {
+            g_host_options.listen_fd = atoi(value);
+        } else if (strncmp(arg, "--pty-hold-fd=", 14) == 0) {
+            g_host_options.pty_hold_fd = atoi(value);
+        } else if (strncmp(arg, "--rtc-fd=", 9) == 0) {
+            g_host_options.rtc_fd = atoi(value);
+        } else if (strncmp(arg, "--time-us=", 10) == 0) {
+            g_host_options.start_us = strtoll(value, nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Opened on the first write, so a boot that goes straight back to deep
+// sleep leaves the previous boot's recording in place
+static esp_err_t write_record(void *ctx, const void *data, size_t len)
+{
+    (void)ctx;
+    if (!s_record_file) {
+        s_record_file = fopen(s_record_path, "wb");
+        if (!s_record_file) {
+            perror(s_record_path);
+            return ESP_FAIL;
+        }
+    }
+    if (fwrite(data, 1, len, s_record_file) != len || fflush(s_record_file) != 0) {
+        return ESP_FAIL;
+    }
+    return ESP_OK;
+}
+
+static void main_task(void *arg)
+{
+    (void)arg;
+    app_main();
+    vTaskDelete(nullptr);
+}
+
+int main(int argc, char **argv)
+{
+    g_host_options.argc = argc;
+    g_host_options.argv = argv;
+    if (!parse_args(argc, argv)) {
+        usage(argv[0]);
+        return 2;
+    }
+    signal(SIGPIPE, SIG_IGN);
+    host_time_init(g_host_options.start_us);
+    host_rtc_restore();
+    if (!host_link_init()) {
+        return 1;
+    }
+    if (s_record_path) {
+        event_record_set_sink(write_record, nullptr);
+    }
+
+    // ESP-IDF runs app_main() in the "main" task on core 0
+    xTaskCreatePinnedToCore(main_task, "main", 3584, nullptr, 1, nullptr, 0);
+    while (true) {
+        pause();
+    }
+}
@@ -0,0 +1,70 @@
+/*
+ * network_host.cpp
+ * Offline Wi-Fi, FreeHome and dial LED entry points for the host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The host build has no radio (CONFIG_ENABLE_WIFI is 0), but the display
+ * and the control plane still call a few of these directly. They answer as
+ * a washer that was never provisioned: no station, no link, no device ID.
+ */
+
+#include "esp_wifi.h"
+#include "wifi_manager.h"
+#include "freehome_manager.h"
+#include "led_ring.h"
+
+#include <string.h>
+
+/*===========================================================================
+ * Wi-Fi
+ *===========================================================================*/
+
+extern "C" esp_err_t esp_wifi_ap_get_sta_list(wifi_sta_list_t *sta)
+{
+    if (!sta) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    memset(sta, 0, sizeof(*sta));
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" esp_err_t wifi_start_ap_open(void)
+{
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+extern "C" void wifi_get_info(wifi_info_t *info)
+{
+    if (info) {
+        memset(info, 0, sizeof(*info));
+        info->status = WIFI_STATUS_DISCONNECTED;
+    }
+}
+
+/*===========================================================================
+ * FreeHome
+ *===========================================================================*/
+
+extern "C" bool freehome_is_linked(void)
+{
+    return false;
+}
+
+extern "C" const char *freehome_get_device_id(void)
+{
+    return "";
+}
+
+/*===========================================================================
+ * Program Dial LEDs
+ *===========================================================================*/
+
+// The dial LEDs are not part of the simulator protocol
+extern "C" void program_dial_leds_set_selected(int idx)
+{
+    (void)idx;
+}
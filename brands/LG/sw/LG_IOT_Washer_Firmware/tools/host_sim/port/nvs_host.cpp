@@ -0,0 +1,277 @@
+/*
+ * nvs_host.cpp
+ * NVS for the host build: one text file, rewritten on every write
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * The file holds one entry per line, "namespace key type value", so a test
+ * can prepare or inspect it by hand. ESP-IDF writes each set to flash at
+ * once and nvs_commit() only flushes caches, so every set and erase
+ * rewrites the file here too.
+ */
+
+#include "nvs.h"
+#include "nvs_flash.h"
+#include "host_port.h"
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+enum class NvsType : char { U8 = 'b', U32 = 'w', U64 = 'q', Str = 's' };
+
+struct NvsValue {
+    NvsType type;
+    std::string text;       // Number in decimal, or the string itself
+};
+
+}  // namespace
+
+static std::mutex s_lock;
+static bool s_ready = false;
+static std::map<std::string, NvsValue> s_entries;     // "namespace/key"
+static std::vector<std::string> s_namespaces;         // Index = handle - 1
+
+static const char *store_path(void)
+{
+    return g_host_options.nvs_path ? g_host_options.nvs_path : "host_nvs.txt";
+}
+
+static void load_file(void)
+{
+    s_entries.clear();
+    if (store_path()[0] == 0) {
+        return;
+    }
+    FILE *f = fopen(store_path(), "r");
+    if (!f) {
+        return;
+    }
+    char line[512];
+    while (fgets(line, sizeof(line), f)) {
+        line[strcspn(line, "\r\n")] = 0;
+        char ns[32], key[32], type;
+        int used = 0;
+        if (sscanf(line, "%31s %31s %c %n", ns, key, &type, &used) == 3) {
+            s_entries[std::string(ns) + "/" + key] = { (NvsType)type, line + used };
+        }
+    }
+    fclose(f);
+}
+
+static esp_err_t save_file(void)
+{
+    if (store_path()[0] == 0) {
+        return ESP_OK;
+    }
+    const std::string tmp = std::string(store_path()) + ".tmp";
+    FILE *f = fopen(tmp.c_str(), "w");
+    if (!f) {
+        return ESP_FAIL;
+    }
+    for (const auto &entry : s_entries) {
+        const size_t slash = entry.first.find('/');
+        fprintf(f, "%s %s %c %s\n", entry.first.substr(0, slash).c_str(),
+                entry.first.substr(slash + 1).c_str(), (char)entry.second.type,
+                entry.second.text.c_str());
+    }
+    fclose(f);
+    return rename(tmp.c_str(), store_path()) == 0 ? ESP_OK : ESP_FAIL;
+}
+
+static bool entry_name(nvs_handle_t handle, const char *key, std::string *out)
+{
+    if (handle == 0 || handle > s_namespaces.size() || !key) {
+        return false;
+    }
+    *out = s_namespaces[handle - 1] + "/" + key;
+    return true;
+}
+
+static esp_err_t set_value(nvs_handle_t handle, const char *key, NvsType type,
+                           const std::string &text)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    std::string name;
+    if (!entry_name(handle, key, &name)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    s_entries[name] = { type, text };
+    return save_file();
+}
+
+static esp_err_t get_value(nvs_handle_t handle, const char *key, NvsType type, std::string *text)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    std::string name;
+    if (!entry_name(handle, key, &name)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    auto it = s_entries.find(name);
+    if (it == s_entries.end()) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    if (it->second.type != type) {
+        return ESP_ERR_NVS_TYPE_MISMATCH;
+    }
+    *text = it->second.text;
+    return ESP_OK;
+}
+
+/*===========================================================================
+ * Public API
+ *===========================================================================*/
+
+// The std::string and map work below stands in for flash, so it is kept
+// out of the heap check's allocation count (host_heap_uncounted_begin())
+
+extern "C" esp_err_t nvs_flash_init(void)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    load_file();
+    s_ready = true;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_flash_erase(void)
+{
+    std::lock_guard<std::mutex> guard(s_lock);
+    s_entries.clear();
+    return save_file();
+}
+
+extern "C" esp_err_t nvs_open(const char *namespace_name, nvs_open_mode_t open_mode,
+                              nvs_handle_t *out_handle)
+{
+    HostHeapUncounted uncounted;
+    (void)open_mode;
+    std::lock_guard<std::mutex> guard(s_lock);
+    if (!s_ready) {
+        return ESP_ERR_NVS_NOT_INITIALIZED;
+    }
+    for (size_t i = 0; i < s_namespaces.size(); i++) {
+        if (s_namespaces[i] == namespace_name) {
+            *out_handle = (nvs_handle_t)(i + 1);
+            return ESP_OK;
+        }
+    }
+    s_namespaces.push_back(namespace_name);
+    *out_handle = (nvs_handle_t)s_namespaces.size();
+    return ESP_OK;
+}
+
+extern "C" void nvs_close(nvs_handle_t handle)
+{
+    (void)handle;
+}
+
+extern "C" esp_err_t nvs_set_u8(nvs_handle_t handle, const char *key, uint8_t value)
+{
+    HostHeapUncounted uncounted;
+    return set_value(handle, key, NvsType::U8, std::to_string(value));
+}
+
+extern "C" esp_err_t nvs_get_u8(nvs_handle_t handle, const char *key, uint8_t *out_value)
+{
+    HostHeapUncounted uncounted;
+    std::string text;
+    esp_err_t err = get_value(handle, key, NvsType::U8, &text);
+    if (err == ESP_OK) {
+        *out_value = (uint8_t)strtoul(text.c_str(), nullptr, 10);
+    }
+    return err;
+}
+
+extern "C" esp_err_t nvs_set_u32(nvs_handle_t handle, const char *key, uint32_t value)
+{
+    HostHeapUncounted uncounted;
+    return set_value(handle, key, NvsType::U32, std::to_string(value));
+}
+
+extern "C" esp_err_t nvs_get_u32(nvs_handle_t handle, const char *key, uint32_t *out_value)
+{
+    HostHeapUncounted uncounted;
+    std::string text;
+    esp_err_t err = get_value(handle, key, NvsType::U32, &text);
+    if (err == ESP_OK) {
+        *out_value = (uint32_t)strtoul(text.c_str(), nullptr, 10);
+    }
+    return err;
+}
+
+extern "C" esp_err_t nvs_set_u64(nvs_handle_t handle, const char *key, uint64_t value)
+{
+    HostHeapUncounted uncounted;
+    return set_value(handle, key, NvsType::U64, std::to_string(value));
+}
+
+extern "C" esp_err_t nvs_get_u64(nvs_handle_t handle, const char *key, uint64_t *out_value)
+{
+    HostHeapUncounted uncounted;
+    std::string text;
+    esp_err_t err = get_value(handle, key, NvsType::U64, &text);
+    if (err == ESP_OK) {
+        *out_value = (uint64_t)strtoull(text.c_str(), nullptr, 10);
+    }
+    return err;
+}
+
+extern "C" esp_err_t nvs_set_str(nvs_handle_t handle, const char *key, const char *value)
+{
+    HostHeapUncounted uncounted;
+    if (!value || strpbrk(value, "\r\n")) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    return set_value(handle, key, NvsType::Str, value);
+}
+
+extern "C" esp_err_t nvs_get_str(nvs_handle_t handle, const char *key, char *out_value,
+                                 size_t *length)
+{
+    HostHeapUncounted uncounted;
+    std::string text;
+    esp_err_t err = get_value(handle, key, NvsType::Str, &text);
+    if (err != ESP_OK) {
+        return err;
+    }
+    if (!out_value) {
+        *length = text.size() + 1;
+        return ESP_OK;
+    }
+    if (*length < text.size() + 1) {
+        return ESP_ERR_NVS_INVALID_LENGTH;
+    }
+    memcpy(out_value, text.c_str(), text.size() + 1);
+    *length = text.size() + 1;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t nvs_erase_key(nvs_handle_t handle, const char *key)
+{
+    HostHeapUncounted uncounted;
+    std::lock_guard<std::mutex> guard(s_lock);
+    std::string name;
+    if (!entry_name(handle, key, &name)) {
+        return ESP_ERR_NVS_INVALID_HANDLE;
+    }
+    if (!s_entries.erase(name)) {
+        return ESP_ERR_NVS_NOT_FOUND;
+    }
+    return save_file();
+}
+
+extern "C" esp_err_t nvs_commit(nvs_handle_t handle)
+{
+    (void)handle;
+    return ESP_OK;
+}
@@ -0,0 +1,259 @@
+/*
+ * ulp_host.cpp
+ * ULP button coprocessor and deep sleep for the host build
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why deep sleep re-executes the process:
+ * - On the chip deep sleep powers RAM down and the wake is a reset, so
+ *   app_main() starts over with only RTC memory and flash kept. Re-running
+ *   the image via /proc/self/exe gives the firmware the same clean start:
+ *   every static is initialised again and every task is gone.
+ * - RTC memory (RTC_NOINIT_ATTR/RTC_DATA_ATTR, placed in the host_rtc_mem
+ *   section) goes across in a memfd, the link descriptors stay open, and
+ *   the clock continues, so a wake looks the same to the firmware and to
+ *   sim_host.py as on hardware.
+ * - While awake, button edges come from the simulator link through
+ *   gpio_hal_sim_input(), so the edge callback is never called here.
+ */
+
+#include "ulp_manager.h"
+#include "host_port.h"
+#include "simulator.h"
+#include "sim_protocol.h"
+
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_log.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+static const char *TAG = "ulp_host";
+
+extern "C" char __start_host_rtc_mem[] __attribute__((weak));
+extern "C" char __stop_host_rtc_mem[] __attribute__((weak));
+
+static gpio_num_t s_pins[2] = { GPIO_NUM_NC, GPIO_NUM_NC };
+static uint32_t s_mask = 0x1;
+static uint32_t s_wake_edges = 0;
+
+/*===========================================================================
+ * RTC Memory
+ *===========================================================================*/
+
+static size_t rtc_size(void)
+{
+    return (__start_host_rtc_mem && __stop_host_rtc_mem)
+        ? (size_t)(__stop_host_rtc_mem - __start_host_rtc_mem) : 0;
+}
+
+void host_rtc_restore(void)
+{
+    const int fd = g_host_options.rtc_fd;
+    if (fd < 0) {
+        return;
+    }
+    if (pread(fd, __start_host_rtc_mem, rtc_size(), 0) != (ssize_t)rtc_size()) {
+        fprintf(stderr, "host: RTC memory image is short; starting cold\n");
+    }
+    close(fd);
+    g_host_options.rtc_fd = -1;
+    // The wake itself is what the ULP program counted before waking the CPU
+    s_wake_edges = g_host_options.wake_cause == ESP_SLEEP_WAKEUP_ULP ? 1 : 0;
+}
+
+static int rtc_save(void)
+{
+    const int fd = memfd_create("host_rtc_mem", 0);
+    if (fd < 0 || write(fd, __start_host_rtc_mem, rtc_size()) != (ssize_t)rtc_size()) {
+        return -1;
+    }
+    return fd;
+}
+
+/*===========================================================================
+ * Restart
+ *===========================================================================*/
+
+static bool is_carried_option(const char *arg)
+{
+    static const char *const s_carried[] = {
+        "--wake=", "--link-fd=", "--listen-fd=", "--pty-hold-fd=", "--rtc-fd=", "--time-us=",
+    };
+    for (const char *prefix : s_carried) {
+        if (strncmp(arg, prefix, strlen(prefix)) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void keep_open(int fd)
+{
+    if (fd >= 0) {
+        fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) & ~FD_CLOEXEC);
+    }
+}
+
+void host_deep_sleep_restart(void)
+{
+    int link_fd, listen_fd, pty_hold_fd;
+    host_link_get_fds(&link_fd, &listen_fd, &pty_hold_fd);
+    const int rtc_fd = rtc_save();
+    keep_open(link_fd);
+    keep_open(listen_fd);
+    keep_open(pty_hold_fd);
+    keep_open(rtc_fd);
+
+    std::vector<std::string> args;
+    for (int i = 0; i < g_host_options.argc; i++) {
+        if (i == 0 || !is_carried_option(g_host_options.argv[i])) {
+            args.push_back(g_host_options.argv[i]);
+        }
+    }
+    args.push_back("--wake=ulp");
+    args.push_back("--link-fd=" + std::to_string(link_fd));
+    args.push_back("--listen-fd=" + std::to_string(listen_fd));
+    args.push_back("--pty-hold-fd=" + std::to_string(pty_hold_fd));
+    args.push_back("--rtc-fd=" + std::to_string(rtc_fd));
+    args.push_back("--time-us=" + std::to_string(host_time_us()));
+
+    std::vector<char *> argv;
+    for (std::string &arg : args) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+    fflush(stdout);
+    execv("/proc/self/exe", argv.data());
+    perror("host: execv");
+    abort();
+}
+
+// Read the link until the power button is pressed, as an input frame or
+// as a "$I" line
+static void wait_for_power_button(void)
+{
+    char line[128];
+    size_t pos = 0;
+    char expected[16];
+    snprintf(expected, sizeof(expected), "$I%d,1", (int)s_pins[0]);
+    uint8_t frame_buf[64];
+    sim_frame_reader_t reader;
+    sim_frame_reader_init(&reader, frame_buf, sizeof(frame_buf));
+    while (true) {
+        char c;
+        if (host_link_read(&c, 1, 100) != 1) {
+            continue;
+        }
+        sim_frame_t frame;
+        const sim_read_result_t result = sim_frame_reader_feed(&reader, (uint8_t)c, &frame);
+        if (result == SIM_READ_FRAME) {
+            if (frame.type == SIM_MSG_INPUT && frame.len >= 2 &&
+                frame.payload[0] == (uint8_t)s_pins[0] && frame.payload[1]) {
+                return;
+            }
+            pos = 0;
+            continue;
+        }
+        if (result != SIM_READ_TEXT) {
+            continue;
+        }
+        if (c != '\n' && c != '\r') {
+            if (pos < sizeof(line) - 1) {
+                line[pos++] = c;
+            }
+            continue;
+        }
+        line[pos] = 0;
+        pos = 0;
+        if (strcmp(line, expected) == 0) {
+            return;
+        }
+    }
+}
+
+/*===========================================================================
+ * ULP Manager API
+ *===========================================================================*/
+
+extern "C" esp_err_t ulp_power_init(gpio_num_t power_gpio, gpio_num_t start_gpio,
+                                    uint32_t wake_edges, uint32_t debounce_samples,
+                                    uint32_t wake_period_us)
+{
+    (void)wake_edges;
+    (void)debounce_samples;
+    (void)wake_period_us;
+    s_pins[0] = power_gpio;
+    s_pins[1] = start_gpio;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ulp_set_button_mask(uint32_t mask_bits)
+{
+    s_mask = mask_bits | 0x1;       // Power is always enabled
+    return ESP_OK;
+}
+
+extern "C" uint32_t ulp_get_button_mask(void)
+{
+    return s_mask;
+}
+
+extern "C" esp_err_t ulp_power_arm(void)
+{
+    s_wake_edges = 0;
+    return ESP_OK;
+}
+
+extern "C" uint32_t ulp_button_edge_count(int index)
+{
+    return index == 0 ? s_wake_edges : 0;
+}
+
+extern "C" void ulp_buttons_clear_counters(void)
+{
+    s_wake_edges = 0;
+}
+
+extern "C" uint32_t ulp_button_level(int index)
+{
+    if (index < 0 || index > 1 || s_pins[index] == GPIO_NUM_NC) {
+        return 0;
+    }
+    return simulator_get_gpio_state(s_pins[index]) ? 1 : 0;
+}
+
+extern "C" esp_err_t ulp_buttons_set_edge_callback(ulp_button_edge_cb_t cb)
+{
+    (void)cb;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ulp_set_awake_period(uint32_t period_us)
+{
+    (void)period_us;
+    return ESP_OK;
+}
+
+extern "C" esp_err_t ulp_power_enter_deep_sleep(void)
+{
+    if (g_host_options.deep_sleep_hook) {
+        g_host_options.deep_sleep_hook();
+    }
+    ESP_LOGI(TAG, "Deep sleep; send \"$I%d,1\" to press power", (int)s_pins[0]);
+    host_tasks_halt_others();
+    // Let the halted tasks leave the link before reading it here
+    vTaskDelay(pdMS_TO_TICKS(50));
+    wait_for_power_button();
+    host_deep_sleep_restart();
+}
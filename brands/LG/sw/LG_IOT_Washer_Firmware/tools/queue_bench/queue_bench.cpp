@@ -0,0 +1,300 @@
+/*
+ * queue_bench.cpp
+ * Host benchmark: per-producer SPSC rings vs one shared blocking queue
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why this tool exists:
+ * - The control plane used to pass every event through one FreeRTOS queue:
+ *   a critical section per send, and a blocking receive (one consumer wake)
+ *   per event. It now uses spsc_ring.h per producer plus a doorbell, with
+ *   the manager draining all rings in batches.
+ * - FreeRTOS does not run here, so the old path is modelled as a
+ *   mutex + condition variable FIFO with per-item receive. The new path uses
+ *   the real SpscRing and a doorbell that behaves like a task notification
+ *   (give is idempotent, take clears). Numbers are only meaningful relative
+ *   to each other, not as ESP32 timings.
+ * - Two measurements: a single-threaded one where bursts are posted and
+ *   then drained in the same thread (pure CPU cost of the data path, no
+ *   scheduling), and a threaded one with one thread per producer reporting
+ *   wall time and consumer wakeups per event (the context switch proxy).
+ *   The threaded numbers depend heavily on the host's core count.
+ *
+ * Usage: queue_bench [events_per_producer] [burst]
+ */
+
+#include "spsc_ring.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Same size and layout class as wm_event_t (tasks.h pulls in FreeRTOS)
+struct BenchEvent {
+    uint32_t type;
+    int32_t value;
+    uint32_t timestamp_us;
+    uint32_t queued_us;
+    uint16_t trace_id;
+};
+static_assert(sizeof(BenchEvent) == 20, "wm_event_t is 20 bytes");
+
+static const int kProducers = 5;        // io, sensor, http, sim, motion
+static const size_t kQueueDepth = 32;   // Old s_event_queue depth
+static const uint32_t kRingSize = 16;   // EVENT_RING_SIZE
+static const size_t kBatchMax = 32;     // EVENT_BATCH_MAX
+
+struct Result {
+    double ns_per_event;
+    double wakeups_per_event;
+};
+
+/*===========================================================================
+ * Old path: one bounded FIFO, blocking send and per-item receive
+ *===========================================================================*/
+
+class BlockingQueue {
+public:
+    void send(const BenchEvent &evt)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] { return items_.size() < kQueueDepth; });
+        items_.push_back(evt);
+        not_empty_.notify_one();
+    }
+
+    // Returns true if the call had to sleep
+    bool receive(BenchEvent *out)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        bool slept = false;
+        while (items_.empty()) {
+            slept = true;
+            not_empty_.wait(lock);
+        }
+        *out = items_.front();
+        items_.pop_front();
+        not_full_.notify_one();
+        return slept;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::deque<BenchEvent> items_;
+};
+
+static Result run_queue(int events_per_producer, int burst)
+{
+    BlockingQueue queue;
+    const long total = (long)kProducers * events_per_producer;
+    long wakeups = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&queue, p, events_per_producer, burst] {
+            for (int i = 0; i < events_per_producer; i++) {
+                queue.send(BenchEvent{ (uint32_t)p, i, 0, 0, 0 });
+                if ((i + 1) % burst == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    BenchEvent evt;
+    for (long n = 0; n < total; n++) {
+        wakeups += queue.receive(&evt) ? 1 : 0;
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return { ns / total, (double)wakeups / total };
+}
+
+/*===========================================================================
+ * New path: SPSC ring per producer, doorbell, batch drain
+ *===========================================================================*/
+
+// Task-notification stand-in: give is cheap when a wake is already pending
+class Doorbell {
+public:
+    void give()
+    {
+        if (!pending_.exchange(true, std::memory_order_acq_rel)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            cv_.notify_one();
+        }
+    }
+
+    void take()
+    {
+        if (pending_.exchange(false, std::memory_order_acq_rel)) {
+            return;
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [this] { return pending_.load(std::memory_order_acquire); });
+        pending_.store(false, std::memory_order_release);
+    }
+
+private:
+    std::atomic<bool> pending_{false};
+    std::mutex mutex_;
+    std::condition_variable cv_;
+};
+
+static Result run_rings(int events_per_producer, int burst)
+{
+    static SpscRing<BenchEvent, kRingSize> rings[kProducers];
+    Doorbell doorbell;
+    const long total = (long)kProducers * events_per_producer;
+    long wakeups = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> producers;
+    for (int p = 0; p < kProducers; p++) {
+        producers.emplace_back([&doorbell, p, events_per_producer, burst] {
+            for (int i = 0; i < events_per_producer; i++) {
+                // The firmware drops on a full ring; here we retry so both
+                // paths deliver every event and the totals compare
+                while (!rings[p].push(BenchEvent{ (uint32_t)p, i, 0, 0, 0 })) {
+                    doorbell.give();
+                    std::this_thread::yield();
+                }
+                doorbell.give();
+                if ((i + 1) % burst == 0) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    BenchEvent batch[kBatchMax];
+    long received = 0;
+    while (received < total) {
+        size_t count = 0;
+        for (int p = 0; p < kProducers && count < kBatchMax; p++) {
+            count += rings[p].pop_batch(batch + count, kBatchMax - count);
+        }
+        received += (long)count;
+        if (count == 0) {
+            doorbell.take();
+            wakeups++;
+        }
+    }
+    for (auto &t : producers) {
+        t.join();
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    return { ns / total, (double)wakeups / total };
+}
+
+/*===========================================================================
+ * Single-threaded data path cost
+ *===========================================================================*/
+
+template <typename Fn>
+static double time_ns_per_event(long total, Fn &&fn)
+{
+    auto start = std::chrono::steady_clock::now();
+    fn();
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / total;
+}
+
+static double inline_queue(int events_per_producer, int burst)
+{
+    BlockingQueue queue;
+    const long total = (long)kProducers * events_per_producer;
+    volatile int32_t sink = 0;
+    return time_ns_per_event(total, [&] {
+        BenchEvent evt;
+        for (int i = 0; i < events_per_producer; i += burst) {
+            // One producer's burst at a time: all five would overflow
+            // kQueueDepth and block this thread forever
+            for (int p = 0; p < kProducers; p++) {
+                for (int b = 0; b < burst; b++) {
+                    queue.send(BenchEvent{ (uint32_t)p, i + b, 0, 0, 0 });
+                }
+                for (int n = 0; n < burst; n++) {
+                    queue.receive(&evt);
+                    sink = evt.value;
+                }
+            }
+        }
+    });
+}
+
+static double inline_rings(int events_per_producer, int burst)
+{
+    static SpscRing<BenchEvent, kRingSize> rings[kProducers];
+    Doorbell doorbell;
+    const long total = (long)kProducers * events_per_producer;
+    volatile int32_t sink = 0;
+    return time_ns_per_event(total, [&] {
+        BenchEvent batch[kBatchMax];
+        for (int i = 0; i < events_per_producer; i += burst) {
+            // Same pattern as inline_queue: post one burst, then drain it
+            for (int p = 0; p < kProducers; p++) {
+                for (int b = 0; b < burst; b++) {
+                    rings[p].push(BenchEvent{ (uint32_t)p, i + b, 0, 0, 0 });
+                    doorbell.give();
+                }
+                doorbell.take();
+                size_t count;
+                do {
+                    count = 0;
+                    for (int q = 0; q < kProducers && count < kBatchMax; q++) {
+                        count += rings[q].pop_batch(batch + count, kBatchMax - count);
+                    }
+                    for (size_t n = 0; n < count; n++) {
+                        sink = batch[n].value;
+                    }
+                } while (count > 0);
+            }
+        }
+    });
+}
+
+int main(int argc, char **argv)
+{
+    int events = argc > 1 ? atoi(argv[1]) : 200000;
+    int burst = argc > 2 ? atoi(argv[2]) : 8;
+    if (events <= 0 || burst <= 0) {
+        fprintf(stderr, "usage: %s [events_per_producer] [burst]\n", argv[0]);
+        return 2;
+    }
+
+    // A burst must fit one ring in the single-threaded test
+    if (burst > (int)kRingSize) {
+        burst = (int)kRingSize;
+    }
+    printf("%d producers x %d events, bursts of %d\n", kProducers, events, burst);
+    printf("single thread (data path only):\n");
+    printf("  queue (per-item receive) %8.1f ns/event\n", inline_queue(events, burst));
+    printf("  spsc rings (batch drain) %8.1f ns/event\n", inline_rings(events, burst));
+
+    printf("one thread per producer:\n");
+    Result queue = run_queue(events, burst);
+    printf("  queue (per-item receive) %8.1f ns/event  %.3f wakeups/event\n",
+           queue.ns_per_event, queue.wakeups_per_event);
+    Result rings = run_rings(events, burst);
+    printf("  spsc rings (batch drain) %8.1f ns/event  %.3f wakeups/event\n",
+           rings.ns_per_event, rings.wakeups_per_event);
+    return 0;
+}
@@ -6,7 +6,9 @@ import serial.tools.list_ports
 import struct
 import binascii
 import os
-from flask import Flask, render_template, send_from_directory
+import sim_protocol
+from functools import partial
+from flask import Flask, render_template, request, send_from_directory
 from flask_socketio import SocketIO, emit
 
 app = Flask(__name__)
@@ -20,6 +22,144 @@ SERIAL_PORT = None
 BAUD_RATE = 1000000
 ser = None
 
+# Trace dumps: "<PREFIX> <hex>" lines between "<PREFIX> BEGIN" and "<PREFIX> END"
+TRACE_DUMPS = {
+    "TRACE": ("wm_trace", "tools/trace_decode"),        # Latency and event trace ($T)
+    "EREC": ("wm_session", "event_replay"),             # Event recording ($R)
+}
+trace_prefix = None
+trace_lines = None
+
+# Link state: host-to-firmware sequence, and the last bitmap for deltas
+tx_lock = threading.Lock()
+tx_sequence = 0
+bitmaps = sim_protocol.BitmapDecoder()
+keyframe_requested = False
+
+# The canvas shows the whole panel (DISPLAY_WIDTH x DISPLAY_HEIGHT in
+# app_config.h); draws land at their panel coordinates
+SCREEN_W = 320
+SCREEN_H = 240
+SCREEN_ACK_TIMEOUT_S = 2.0
+
+
+class ScreenStream:
+    """Display contents for the browsers, as binary Socket.IO messages.
+
+    Why a composed screen instead of forwarding every draw:
+    - Bitmaps and fills land in one RGB565 buffer, and each browser gets
+      the band of rows that changed since the last picture it
+      acknowledged: u16 x, y, w, h, then big-endian RGB565. A full panel
+      is 150 KB; a frame where only the sprite changed is under 70 KB.
+    - The buffer is the panel, not the sprite window, so what the firmware
+      draws around the sprite (the progress bar, clears) shows up too.
+    - A browser acknowledges once the picture is on screen. Until then
+      newer pictures only replace the pending one, so a slow link or a
+      busy tab drops frames instead of queueing them, and every client
+      sees the latest picture as soon as it can take one.
+    """
+
+    def __init__(self):
+        self.changed = threading.Condition()
+        self.pixels = bytearray(SCREEN_W * SCREEN_H * 2)
+        self.version = 0
+        self.clients = {}
+
+    def _clip(self, x, y, w, h):
+        x0, y0 = max(x, 0), max(y, 0)
+        x1, y1 = min(x + w, SCREEN_W), min(y + h, SCREEN_H)
+        return x0, y0, x1, y1
+
+    def draw_bitmap(self, x, y, w, h, pixels):
+        x0, y0, x1, y1 = self._clip(x, y, w, h)
+        if x0 >= x1 or y0 >= y1:
+            return
+        with self.changed:
+            for row in range(y0, y1):
+                src = ((row - y) * w + x0 - x) * 2
+                dst = (row * SCREEN_W + x0) * 2
+                self.pixels[dst:dst + (x1 - x0) * 2] = pixels[src:src + (x1 - x0) * 2]
+            self.version += 1
+            self.changed.notify()
+
+    def fill_rect(self, x, y, w, h, color):
+        x0, y0, x1, y1 = self._clip(x, y, w, h)
+        if x0 >= x1 or y0 >= y1:
+            return
+        run = struct.pack('>H', color) * (x1 - x0)
+        with self.changed:
+            for row in range(y0, y1):
+                dst = (row * SCREEN_W + x0) * 2
+                self.pixels[dst:dst + len(run)] = run
+            self.version += 1
+            self.changed.notify()
+
+    def add_client(self, sid):
+        with self.changed:
+            self.clients[sid] = {'sent': None, 'version': -1, 'busy_since': None}
+            self.changed.notify()
+
+    def remove_client(self, sid):
+        with self.changed:
+            self.clients.pop(sid, None)
+
+    def ack(self, sid, *args):
+        with self.changed:
+            client = self.clients.get(sid)
+            if client:
+                client['busy_since'] = None
+                self.changed.notify()
+
+    def _next_message(self, client):
+        """Rows that differ from what the client has, or None if none do."""
+        row_bytes = SCREEN_W * 2
+        sent = client['sent']
+        first, last = 0, SCREEN_H - 1
+        if sent is not None:
+            while first < SCREEN_H and sent[first * row_bytes:(first + 1) * row_bytes] == \
+                    self.pixels[first * row_bytes:(first + 1) * row_bytes]:
+                first += 1
+            if first == SCREEN_H:
+                return None
+            while sent[last * row_bytes:(last + 1) * row_bytes] == \
+                    self.pixels[last * row_bytes:(last + 1) * row_bytes]:
+                last -= 1
+        header = struct.pack('<HHHH', 0, first, SCREEN_W, last - first + 1)
+        return header + bytes(self.pixels[first * row_bytes:(last + 1) * row_bytes])
+
+    def _ready(self, client, now):
+        """True if the client waits for nothing and misses a picture."""
+        if client['busy_since'] is not None:
+            if now - client['busy_since'] < SCREEN_ACK_TIMEOUT_S:
+                return False
+            client['busy_since'] = None
+            client['sent'] = None       # Lost; start over with a full picture
+        return client['sent'] is None or client['version'] != self.version
+
+    def run(self):
+        while True:
+            messages = []
+            with self.changed:
+                while True:
+                    now = time.monotonic()
+                    ready = [(sid, c) for sid, c in self.clients.items() if self._ready(c, now)]
+                    if ready:
+                        break
+                    self.changed.wait(timeout=SCREEN_ACK_TIMEOUT_S)
+                for sid, client in ready:
+                    message = self._next_message(client)
+                    client['version'] = self.version
+                    if message is None:
+                        continue
+                    client['sent'] = bytes(self.pixels)
+                    client['busy_since'] = now
+                    messages.append((sid, message))
+            for sid, message in messages:
+                socketio.emit('screen', message, to=sid, callback=partial(self.ack, sid))
+
+
+screen = ScreenStream()
+
 def find_esp32():
     ports = list(serial.tools.list_ports.comports())
     for p in ports:
@@ -27,123 +167,102 @@ def find_esp32():
             return p.device
     return None
 
+def collect_trace_line(line):
+    """Capture a trace dump; returns True if the line belonged to one."""
+    global trace_prefix, trace_lines
+    prefix, _, rest = line.partition(" ")
+    if prefix not in TRACE_DUMPS:
+        return False
+    if rest == "BEGIN":
+        trace_prefix = prefix
+        trace_lines = []
+        return True
+    if trace_lines is None or prefix != trace_prefix:
+        return False
+    if rest == "END":
+        name, tool = TRACE_DUMPS[prefix]
+        path = time.strftime(name + "_%Y%m%d_%H%M%S.bin")
+        with open(path, "wb") as f:
+            for hex_part in trace_lines:
+                f.write(binascii.unhexlify(hex_part))
+        trace_prefix = trace_lines = None
+        socketio.emit('log', {'msg': f"Trace saved to {path} ({tool})"})
+    else:
+        trace_lines.append(rest)
+    return True
+
+def send_frame(msg_type, payload=b""):
+    """Send one frame to the firmware; False if the port is not open."""
+    global tx_sequence
+    if not ser or not ser.is_open:
+        return False
+    with tx_lock:
+        ser.write(sim_protocol.encode_frame(msg_type, tx_sequence, payload))
+        tx_sequence = (tx_sequence + 1) & 0xFF
+    return True
+
+def handle_frame(msg_type, sequence, payload):
+    global keyframe_requested
+    if msg_type == sim_protocol.MSG_HELLO:
+        bitmaps.reset()
+        keyframe_requested = False
+        socketio.emit('log', {'msg': f"Firmware link protocol v{payload[0] if payload else '?'}"})
+    elif msg_type == sim_protocol.MSG_LOG:
+        socketio.emit('log', {'msg': payload.decode('utf-8', errors='ignore')})
+    elif msg_type == sim_protocol.MSG_RECT:
+        x, y, w, h, c = struct.unpack_from('<hhhhH', payload)
+        screen.fill_rect(x, y, w, h, c)
+    elif msg_type == sim_protocol.MSG_BITMAP:
+        bitmap = bitmaps.decode(sequence, payload)
+        if bitmap is None:
+            # Missed the reference frame: ask once for a full one
+            if not keyframe_requested:
+                keyframe_requested = send_frame(sim_protocol.MSG_KEYFRAME)
+            return
+        keyframe_requested = False
+        screen.draw_bitmap(*bitmap)
+    elif msg_type == sim_protocol.MSG_TELEMETRY:
+        for record_type, record in sim_protocol.split_telemetry(payload):
+            handle_frame(record_type, sequence, record)
+    elif msg_type == sim_protocol.MSG_GPIO:
+        pin, level = struct.unpack_from('<BB', payload)
+        socketio.emit('gpio_update', {'p': pin, 'v': level})
+    elif msg_type == sim_protocol.MSG_MOTOR:
+        target, current, direction = struct.unpack_from('<hhB', payload)
+        socketio.emit('motor_state', {
+            'target': float(target),
+            'current': float(current),
+            'direction': direction
+        })
+
 def serial_reader():
     global ser
+    reader = sim_protocol.FrameReader()
+    expected_sequence = None
     while True:
         if ser and ser.is_open:
             try:
-                # Read one byte to detect start of command
-                if ser.in_waiting:
-                    # Peek or read one byte
-                    c = ser.read(1)
-                    if not c:
+                data = ser.read(ser.in_waiting or 1)
+                if not data:
+                    continue
+                for item in reader.feed(data):
+                    if item[0] == "text":
+                        # Boot messages and trace dumps are plain text
+                        line = item[1]
+                        if not collect_trace_line(line):
+                            socketio.emit('log', {'msg': line})
                         continue
-                        
-                    if c == b'$':
-                        # Potential command
-                        cmd_type = ser.read(1)
-                        
-                        if cmd_type == b'b':
-                            # Binary Bitmap: $b<x>,<y>,<w>,<h>\n<binary_data>
-                            # Read header until \n
-                            header = b""
-                            while True:
-                                b = ser.read(1)
-                                if b == b'\n':
-                                    break
-                                header += b
-                            
-                            try:
-                                parts = header.decode().split(',')
-                                if len(parts) == 4:
-                                    x, y, w, h = map(int, parts)
-                                    total_bytes = w * h * 2
-                                    
-                                    # Read binary data
-                                    data = b""
-                                    while len(data) < total_bytes:
-                                        chunk = ser.read(total_bytes - len(data))
-                                        if chunk:
-                                            data += chunk
-                                    
-                                    # Convert to hex string for frontend compatibility
-                                    # Firmware sends Big Endian data now.
-                                    # binascii.hexlify converts b'\xF8\x00' to b'f800', which is exactly what we want.
-                                    hex_str = binascii.hexlify(data).decode('ascii').upper()
-                                    
-                                    socketio.emit('draw_bitmap', {
-                                        'x': x,
-                                        'y': y,
-                                        'w': w,
-                                        'h': h,
-                                        'data': hex_str
-                                    })
-                            except Exception as e:
-                                print(f"Binary Bitmap Error: {e}")
-
-                        else:
-                            # Text command or log
-                            # Read until newline
-                            line_bytes = cmd_type + ser.readline()
-                            try:
-                                line = line_bytes.decode('utf-8', errors='ignore').strip()
-                            except:
-                                line = ""
-                                
-                            if line.startswith('R'): # Was $R, but we ate $
-                                # Rect: R<x>,<y>,<w>,<h>,<color>
-                                try:
-                                    parts = line[1:].split(',')
-                                    if len(parts) == 5:
-                                        socketio.emit('draw_rect', {
-                                            'x': int(parts[0]),
-                                            'y': int(parts[1]),
-                                            'w': int(parts[2]),
-                                            'h': int(parts[3]),
-                                            'c': int(parts[4])
-                                        })
-                                except:
-                                    pass
-                            elif line.startswith('G'): # Was $G
-                                # GPIO: G<pin>,<val>
-                                try:
-                                    parts = line[1:].split(',')
-                                    if len(parts) == 2:
-                                        socketio.emit('gpio_update', {
-                                            'p': int(parts[0]),
-                                            'v': int(parts[1])
-                                        })
-                                except:
-                                    pass
-                            elif line.startswith('M'):
-                                # Motor telemetry: M<target>,<current>,<dir>
-                                try:
-                                    parts = line[1:].split(',')
-                                    if len(parts) >= 3:
-                                        socketio.emit('motor_state', {
-                                            'target': float(parts[0]),
-                                            'current': float(parts[1]),
-                                            'direction': int(parts[2])
-                                        })
-                                except:
-                                    pass
-                            else:
-                                # Log or unknown
-                                # Reconstruct full line for log
-                                full_line = "$" + line
-                                socketio.emit('log', {'msg': full_line})
-                    
-                    else:
-                        # Not a command start, just log text
-                        # Read line
-                        line_bytes = c + ser.readline()
-                        try:
-                            line = line_bytes.decode('utf-8', errors='ignore').strip()
-                            if line:
-                                socketio.emit('log', {'msg': line})
-                        except:
-                            pass
-                            
+                    _, msg_type, sequence, payload = item
+                    if msg_type == sim_protocol.MSG_HELLO:
+                        expected_sequence = None
+                    if expected_sequence is not None and sequence != expected_sequence:
+                        lost = (sequence - expected_sequence) & 0xFF
+                        socketio.emit('log', {'msg': f"Link: {lost} frames lost"})
+                    expected_sequence = (sequence + 1) & 0xFF
+                    try:
+                        handle_frame(msg_type, sequence, payload)
+                    except struct.error as e:
+                        print(f"Frame {msg_type:#x} too short: {e}")
             except Exception as e:
                 print(f"Serial Error: {e}")
                 time.sleep(1)
@@ -162,26 +281,42 @@ def drum_asset_3dm():
 def drum_asset_obj():
     return send_from_directory(TEMPLATE_DIR, 'washing machine drum.obj', mimetype='application/octet-stream')
 
+@app.route('/trace')
+def request_trace():
+    # The firmware answers with TRACE lines, saved by collect_trace_line()
+    if send_frame(sim_protocol.MSG_COMMAND, b"T\0"):
+        return "Trace dump requested"
+    return "Serial port not open", 503
+
+@app.route('/event_record')
+def request_event_record():
+    # Replay the saved session with tools/host_sim (event_replay)
+    if send_frame(sim_protocol.MSG_COMMAND, b"R\0"):
+        return "Event recording dump requested"
+    return "Serial port not open", 503
+
+@socketio.on('connect')
+def handle_connect():
+    screen.add_client(request.sid)
+
+@socketio.on('disconnect')
+def handle_disconnect(*args):
+    screen.remove_client(request.sid)
+
 @socketio.on('gpio_input')
 def handle_gpio_input(json):
-    global ser
-    if ser and ser.is_open:
-        # Format: $Ipin,val\n
-        cmd = f"$I{json['pin']},{json['val']}\n"
-        ser.write(cmd.encode())
+    send_frame(sim_protocol.MSG_INPUT,
+               struct.pack('<BB', int(json['pin']) & 0xFF, 1 if int(json['val']) else 0))
 
 
 @socketio.on('dial_delta')
 def handle_dial_delta(json):
-    global ser
-    if not ser or not ser.is_open:
-        return
     try:
         delta = int(json.get('delta', 0))
     except Exception:
         return
-    cmd = f"$D{delta}\n"
-    ser.write(cmd.encode())
+    delta = max(-32768, min(32767, delta))
+    send_frame(sim_protocol.MSG_DIAL, struct.pack('<h', delta))
 
 if __name__ == '__main__':
     if len(sys.argv) > 1:
@@ -192,7 +327,8 @@ if __name__ == '__main__':
     if SERIAL_PORT:
         print(f"Connecting to {SERIAL_PORT} at {BAUD_RATE}...")
         try:
-            ser = serial.Serial(SERIAL_PORT, BAUD_RATE, timeout=0.1)
+            # Also accepts URLs such as socket://localhost:5555 (host build)
+            ser = serial.serial_for_url(SERIAL_PORT, BAUD_RATE, timeout=0.1)
             t = threading.Thread(target=serial_reader)
             t.daemon = True
             t.start()
@@ -201,5 +337,6 @@ if __name__ == '__main__':
     else:
         print("No ESP32 found. Please specify port as argument.")
 
+    socketio.start_background_task(screen.run)
     print("Starting Web Server at http://localhost:5000")
     socketio.run(app, host='0.0.0.0', port=5000)
@@ -0,0 +1,222 @@
+"""Simulator link protocol: COBS frames with a type, a sequence number and
+a CRC-16, and bitmap runs coded against the previous frame.
+
+Mirrors main/simulator/sim_protocol.h; see there for the wire format.
+"""
+import binascii
+import struct
+
+PROTOCOL_VERSION = 3
+
+# Firmware to host
+MSG_HELLO = 0x01
+MSG_LOG = 0x02
+MSG_RECT = 0x03
+MSG_BITMAP = 0x04
+MSG_GPIO = 0x05
+MSG_MOTOR = 0x06
+MSG_STATE = 0x07
+MSG_TELEMETRY = 0x08
+# Host to firmware
+MSG_INPUT = 0x81
+MSG_DIAL = 0x82
+MSG_COMMAND = 0x83
+MSG_KEYFRAME = 0x84
+
+STATE_POWERED = 0x01
+STATE_RUNNING = 0x02
+STATE_DOOR_OPEN = 0x04
+STATE_ETA_AVAILABLE = 0x08
+
+BITMAP_FLAG_DELTA = 0x01
+RUN_SKIP, RUN_LITERAL, RUN_REPEAT = 0, 1, 2
+
+
+def crc16(data):
+    """CRC-16/CCITT, initial value 0xFFFF."""
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def cobs_encode(data):
+    out = bytearray()
+    block = bytearray()
+    for b in data:
+        if b == 0:
+            out.append(len(block) + 1)
+            out += block
+            block.clear()
+            continue
+        block.append(b)
+        if len(block) == 254:
+            out.append(255)
+            out += block
+            block.clear()
+    out.append(len(block) + 1)
+    out += block
+    return bytes(out)
+
+
+def cobs_decode(data):
+    """Returns the decoded bytes, or None if the block lengths do not fit."""
+    out = bytearray()
+    i = 0
+    n = len(data)
+    while i < n:
+        code = data[i]
+        end = i + code
+        if code == 0 or end > n:
+            return None
+        out += data[i + 1:end]
+        i = end
+        if code != 255 and i < n:
+            out.append(0)
+    return bytes(out)
+
+
+def encode_frame(msg_type, sequence, payload=b""):
+    body = bytes((msg_type, sequence & 0xFF)) + payload
+    body += struct.pack("<H", crc16(body))
+    return b"\x00" + cobs_encode(body) + b"\x00"
+
+
+def split_telemetry(payload):
+    """Returns the (type, payload) records of a MSG_TELEMETRY payload.
+
+    Each record is laid out as a frame of its type (MSG_GPIO, MSG_MOTOR,
+    MSG_STATE) would be.
+    """
+    records = []
+    i = 0
+    while i + 2 <= len(payload):
+        msg_type, length = payload[i], payload[i + 1]
+        records.append((msg_type, payload[i + 2:i + 2 + length]))
+        i += 2 + length
+    return records
+
+
+def decode_state(payload):
+    """Returns the fields of a MSG_STATE payload as a dict."""
+    flags, program, stage, stages, eta = struct.unpack_from("<BBBBh", payload)
+    return {
+        "powered": bool(flags & STATE_POWERED),
+        "running": bool(flags & STATE_RUNNING),
+        "door_open": bool(flags & STATE_DOOR_OPEN),
+        "eta_available": bool(flags & STATE_ETA_AVAILABLE),
+        "program": program,
+        "stage": stage,
+        "stages": stages,
+        "eta": eta,
+        "label": payload[6:].decode("utf-8", errors="ignore"),
+    }
+
+
+class FrameReader:
+    """Splits the byte stream into frames and text lines.
+
+    feed() returns a list of ("frame", type, sequence, payload) and
+    ("text", line) items. As in the firmware, a delimiter after a damaged
+    frame is taken as the start of the next one.
+    """
+
+    def __init__(self):
+        self.buf = bytearray()
+        self.in_frame = False
+        self.text = bytearray()
+        self.bad_frames = 0
+
+    def _text(self, data, items):
+        self.text += data
+        while True:
+            i = self.text.find(b"\n")
+            if i < 0:
+                break
+            line = self.text[:i].decode("utf-8", errors="ignore").strip()
+            del self.text[:i + 1]
+            if line:
+                items.append(("text", line))
+
+    def feed(self, data):
+        items = []
+        self.buf += data
+        while True:
+            i = self.buf.find(b"\x00")
+            if i < 0:
+                if not self.in_frame:
+                    self._text(bytes(self.buf), items)
+                    self.buf.clear()
+                return items
+            chunk = bytes(self.buf[:i])
+            del self.buf[:i + 1]
+            if not self.in_frame:
+                self._text(chunk, items)
+                # A line cut short by a frame still ends here
+                if self.text:
+                    self._text(b"\n", items)
+                self.in_frame = True
+                continue
+            if not chunk:
+                continue
+            body = cobs_decode(chunk)
+            if body is None or len(body) < 4 or \
+                    crc16(body[:-2]) != struct.unpack_from("<H", body, len(body) - 2)[0]:
+                self.bad_frames += 1
+                continue
+            self.in_frame = False
+            items.append(("frame", body[0], body[1], body[2:-2]))
+
+
+def _xor(a, b):
+    n = len(a)
+    return (int.from_bytes(a, "big") ^ int.from_bytes(b, "big")).to_bytes(n, "big")
+
+
+class BitmapDecoder:
+    """Keeps the last bitmap and applies the runs of the next one to it."""
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        self.sequence = None
+        self.size = None
+        self.pixels = None
+
+    def decode(self, sequence, payload):
+        """Returns (x, y, w, h, pixels), or None if the reference is missing."""
+        x, y, w, h, flags, ref_sequence = struct.unpack_from("<hhhhBB", payload)
+        words = w * h
+        if flags & BITMAP_FLAG_DELTA:
+            if self.pixels is None or self.sequence != ref_sequence or self.size != (w, h):
+                return None
+            ref = self.pixels
+        else:
+            ref = bytes(words * 2)
+        out = bytearray(ref)
+        pos = 0
+        i = 10
+        n = len(payload)
+        while i < n:
+            value = 0
+            shift = 0
+            while True:
+                b = payload[i]
+                i += 1
+                value |= (b & 0x7F) << shift
+                shift += 7
+                if not b & 0x80:
+                    break
+            op, count = value & 3, value >> 2
+            end = pos + count * 2
+            if end > len(out):
+                return None
+            if op == RUN_LITERAL:
+                out[pos:end] = _xor(ref[pos:end], payload[i:i + count * 2])
+                i += count * 2
+            elif op == RUN_REPEAT:
+                out[pos:end] = _xor(ref[pos:end], payload[i:i + 2] * count)
+                i += 2
+            pos = end
+        self.sequence = sequence
+        self.size = (w, h)
+        self.pixels = bytes(out)
+        return x, y, w, h, self.pixels
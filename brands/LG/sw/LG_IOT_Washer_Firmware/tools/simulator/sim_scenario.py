@@ -0,0 +1,612 @@
+"""Headless scenario runner for the simulator link.
+
+Runs scenario scripts against the host build (tools/host_sim, started
+once per scenario) or a device in simulator mode over its serial port,
+asserts on the machine state and the actuator trace, and reports how long
+every step took.
+
+    python tools/simulator/sim_scenario.py --host build/host_sim/washer_host \\
+        --speed 20 tools/simulator/scenarios/*.scn
+    python tools/simulator/sim_scenario.py --port /dev/ttyUSB0 door_pause.scn
+
+A script has one step per line; '#' starts a comment. Times are seconds on
+the scenario clock, which runs --speed times faster than wall time (set it
+to the host build's clock; 1 for a device).
+
+    [at T] press power|start|PIN [MS]   Hold a button (default 100 ms)
+    [at T] power | start                Short for "press power|start"
+    [at T] door open|close
+    [at T] dial N                       Turn the dial N detents
+    [at T] program N                    Dial to program N
+    [at T] wait S
+    [at T] expect COND [within S | for S]
+
+"at T" first waits until T seconds after the scenario began. "expect"
+waits up to 2 s for COND unless "within" says otherwise; "for S" requires
+COND to hold for S seconds. Conditions:
+
+    state off|idle|running|paused|complete
+    door open|closed
+    program N            stage OP N          eta OP N
+    label TEXT           motor OP N          rpm OP N
+    output fill|drain|circulation|drum_light|start_led|power_led|PIN on|off
+    log TEXT             A log line since the last action contains TEXT
+
+OP is one of == != < <= > >= (== if left out). "motor" is the target speed,
+"rpm" the measured one. "paused" means not running after the cycle was
+started, until it completes or the machine powers off.
+
+Exit status is 1 if any scenario fails.
+"""
+import argparse
+import json
+import operator
+import os
+import shlex
+import struct
+import subprocess
+import sys
+import tempfile
+import threading
+import time
+
+import sim_protocol
+
+# main/app_config.h
+PINS = {
+    "power": 33,
+    "start": 32,
+    "door": 34,
+    "fill": 12,
+    "drain": 27,
+    "circulation": 15,
+    "drum_light": 13,
+    "start_led": 14,
+    "power_led": 26,
+}
+
+OPERATORS = {
+    "==": operator.eq,
+    "!=": operator.ne,
+    "<": operator.lt,
+    "<=": operator.le,
+    ">": operator.gt,
+    ">=": operator.ge,
+}
+
+DEFAULT_WITHIN_S = 2.0
+PRESS_MS = 100
+
+
+class ScenarioError(Exception):
+    pass
+
+
+def pin_number(name):
+    if name in PINS:
+        return PINS[name]
+    try:
+        return int(name)
+    except ValueError:
+        raise ScenarioError(f"unknown pin '{name}'")
+
+
+
+# ---------------------------------------------------------------------------
+# Link
+# ---------------------------------------------------------------------------
+
+class Clock:
+    def __init__(self, speed):
+        self.speed = speed
+        self.start = time.monotonic()
+
+    def now(self):
+        return (time.monotonic() - self.start) * self.speed
+
+    def wall(self, seconds):
+        return max(0.0, seconds / self.speed)
+
+
+class Trace:
+    """What the firmware reported, on the scenario clock.
+
+    The reader thread updates it; steps wait on `changed` for a condition
+    to become true.
+    """
+
+    def __init__(self, clock):
+        self.clock = clock
+        self.changed = threading.Condition()
+        self.state = None
+        self.started = False
+        self.outputs = {}
+        self.motor = (0, 0, False)
+        self.logs = []
+        self.log_mark = 0           # First log line since the last action
+        self.events = []
+        self.lost_frames = 0
+
+    def _event(self, text):
+        self.events.append((self.clock.now(), text))
+
+    def on_frame(self, msg_type, payload):
+        with self.changed:
+            if msg_type == sim_protocol.MSG_TELEMETRY:
+                for record_type, record in sim_protocol.split_telemetry(payload):
+                    self._record(record_type, record)
+            elif not self._record(msg_type, payload):
+                return
+            self.changed.notify_all()
+
+    def _record(self, msg_type, payload):
+        """Applies one frame or telemetry record; False if not one we keep."""
+        if msg_type == sim_protocol.MSG_HELLO:
+            self._event(f"hello v{payload[0] if payload else '?'}")
+        elif msg_type == sim_protocol.MSG_LOG:
+            self.logs.append((self.clock.now(), payload.decode("utf-8", errors="ignore")))
+        elif msg_type == sim_protocol.MSG_GPIO:
+            pin, level = struct.unpack_from("<BB", payload)
+            if self.outputs.get(pin) != level:
+                self.outputs[pin] = level
+                self._event(f"gpio {pin} {'on' if level else 'off'}")
+        elif msg_type == sim_protocol.MSG_MOTOR:
+            target, current, ccw = struct.unpack_from("<hhB", payload)
+            if self.motor[0] != target or self.motor[2] != bool(ccw):
+                self._event(f"motor {target} rpm {'ccw' if ccw else 'cw'}")
+            self.motor = (target, current, bool(ccw))
+        elif msg_type == sim_protocol.MSG_STATE:
+            state = sim_protocol.decode_state(payload)
+            if state["running"]:
+                self.started = True
+            elif not state["powered"] or state["label"] == "Complete":
+                self.started = False
+            self.state = state
+            self._event(f"state {self.state_name()} program {state['program']} "
+                        f"stage {state['stage']}/{state['stages']} eta {state['eta']} "
+                        f"'{state['label']}'{' door open' if state['door_open'] else ''}")
+        else:
+            return False
+        return True
+
+    def on_text(self, line):
+        with self.changed:
+            self.logs.append((self.clock.now(), line))
+            self.changed.notify_all()
+
+    def state_name(self):
+        state = self.state
+        if state is None or not state["powered"]:
+            return "off"
+        if state["running"]:
+            return "running"
+        if state["label"] == "Complete":
+            return "complete"
+        return "paused" if self.started else "idle"
+
+
+class Link:
+    """Frames to and from the firmware over a byte stream."""
+
+    def __init__(self, trace, verbose):
+        self.trace = trace
+        self.verbose = verbose
+        self.sequence = 0
+        self.lock = threading.Lock()
+        self.closed = False
+
+    def start(self):
+        threading.Thread(target=self._reader, daemon=True).start()
+
+    def send(self, msg_type, payload=b""):
+        with self.lock:
+            self.write(sim_protocol.encode_frame(msg_type, self.sequence, payload))
+            self.sequence = (self.sequence + 1) & 0xFF
+
+    def _reader(self):
+        reader = sim_protocol.FrameReader()
+        expected = None
+        while not self.closed:
+            data = self.read()
+            if data is None:
+                break
+            for item in reader.feed(data):
+                if item[0] == "text":
+                    self.trace.on_text(item[1])
+                    if self.verbose:
+                        print(f"    | {item[1]}")
+                    continue
+                _, msg_type, sequence, payload = item
+                if msg_type == sim_protocol.MSG_HELLO:
+                    expected = None
+                if expected is not None and sequence != expected:
+                    self.trace.lost_frames += (sequence - expected) & 0xFF
+                expected = (sequence + 1) & 0xFF
+                if self.verbose and msg_type == sim_protocol.MSG_LOG:
+                    print(f"    | {payload.decode('utf-8', errors='ignore')}")
+                try:
+                    self.trace.on_frame(msg_type, payload)
+                except struct.error:
+                    pass
+
+
+class ProcessLink(Link):
+    """The host build, started with the link on its stdin and stdout."""
+
+    def __init__(self, trace, verbose, washer_host, speed):
+        super().__init__(trace, verbose)
+        self.workdir = tempfile.TemporaryDirectory(prefix="sim_scenario_")
+        self.stderr = open(os.path.join(self.workdir.name, "stderr.txt"), "wb")
+        self.process = subprocess.Popen(
+            [os.path.abspath(washer_host), "--stdio", f"--speed={int(speed)}",
+             "--nvs=" + os.path.join(self.workdir.name, "nvs.txt")],
+            cwd=self.workdir.name, stdin=subprocess.PIPE, stdout=subprocess.PIPE,
+            stderr=None if verbose else self.stderr, bufsize=0)
+
+    def write(self, data):
+        try:
+            self.process.stdin.write(data)
+        except (BrokenPipeError, ValueError):
+            raise ScenarioError("host build exited")
+
+    def read(self):
+        return os.read(self.process.stdout.fileno(), 4096) or None
+
+    def close(self):
+        self.closed = True
+        self.process.terminate()
+        try:
+            self.process.wait(timeout=5)
+        except subprocess.TimeoutExpired:
+            self.process.kill()
+            self.process.wait()
+        self.stderr.close()
+        self.workdir.cleanup()
+
+
+class SerialLink(Link):
+    """A device, or anything pyserial opens (socket://host:port for --tcp)."""
+
+    def __init__(self, trace, verbose, url):
+        super().__init__(trace, verbose)
+        import serial
+        self.port = serial.serial_for_url(url, 1000000, timeout=0.1)
+
+    def write(self, data):
+        self.port.write(data)
+
+    def read(self):
+        try:
+            return self.port.read(self.port.in_waiting or 1)
+        except Exception:
+            return None if self.closed else b""
+
+    def close(self):
+        self.closed = True
+        self.port.close()
+
+
+# ---------------------------------------------------------------------------
+# Scripts
+# ---------------------------------------------------------------------------
+
+class Step:
+    def __init__(self, line, text, at, verb, args):
+        self.line = line
+        self.text = text
+        self.at = at
+        self.verb = verb
+        self.args = args
+
+
+def parse_number(text, what):
+    try:
+        return float(text)
+    except ValueError:
+        raise ScenarioError(f"{what} '{text}' is not a number")
+
+
+def parse_comparison(args, what):
+    if len(args) == 2 and args[0] in OPERATORS:
+        return OPERATORS[args[0]], parse_number(args[1], what)
+    if len(args) == 1:
+        return operator.eq, parse_number(args[0], what)
+    raise ScenarioError(f"expected '{what} [OP] N'")
+
+
+def parse_condition(args):
+    """Returns (description, predicate on the trace)."""
+    if not args:
+        raise ScenarioError("missing condition")
+    kind, rest = args[0], args[1:]
+    text = " ".join(args)
+    if kind == "state":
+        names = ("off", "idle", "running", "paused", "complete")
+        if len(rest) != 1 or rest[0] not in names:
+            raise ScenarioError("expected 'state " + "|".join(names) + "'")
+        return text, lambda t: t.state_name() == rest[0]
+    if kind == "door":
+        if len(rest) != 1 or rest[0] not in ("open", "closed"):
+            raise ScenarioError("expected 'door open|closed'")
+        want = rest[0] == "open"
+        return text, lambda t: t.state is not None and t.state["door_open"] == want
+    if kind in ("program", "stage", "eta"):
+        op, value = parse_comparison(rest, kind)
+        return text, lambda t: t.state is not None and op(t.state[kind], value)
+    if kind == "label":
+        if len(rest) != 1:
+            raise ScenarioError("expected 'label TEXT' (quote text with spaces)")
+        return text, lambda t: t.state is not None and t.state["label"] == rest[0]
+    if kind in ("motor", "rpm"):
+        op, value = parse_comparison(rest, kind)
+        index = 0 if kind == "motor" else 1
+        return text, lambda t: op(t.motor[index], value)
+    if kind == "output":
+        if len(rest) != 2 or rest[1] not in ("on", "off"):
+            raise ScenarioError("expected 'output NAME on|off'")
+        pin = pin_number(rest[0])
+        want = 1 if rest[1] == "on" else 0
+        return text, lambda t: t.outputs.get(pin, 0) == want
+    if kind == "log":
+        if len(rest) != 1:
+            raise ScenarioError("expected 'log TEXT' (quote text with spaces)")
+        return text, lambda t: any(rest[0] in line for _, line in t.logs[t.log_mark:])
+    raise ScenarioError(f"unknown condition '{kind}'")
+
+
+def split_limit(args):
+    """Splits 'COND within S' or 'COND for S' into (COND, mode, S)."""
+    if len(args) >= 3 and args[-2] in ("within", "for"):
+        return args[:-2], args[-2], parse_number(args[-1], args[-2])
+    return args, "within", DEFAULT_WITHIN_S
+
+
+def check_step(step):
+    """Parse the arguments up front, so a typo fails before anything runs."""
+    verb, args = step.verb, step.args
+    if verb in ("power", "start"):
+        if args:
+            raise ScenarioError(f"'{verb}' takes no arguments")
+    elif verb == "press":
+        if len(args) not in (1, 2):
+            raise ScenarioError("expected 'press NAME [MS]'")
+        pin_number(args[0])
+        if len(args) == 2:
+            parse_number(args[1], "hold time")
+    elif verb == "door":
+        if args not in (["open"], ["close"]):
+            raise ScenarioError("expected 'door open|close'")
+    elif verb in ("dial", "program"):
+        if len(args) != 1:
+            raise ScenarioError(f"expected '{verb} N'")
+        int(parse_number(args[0], verb))
+    elif verb == "wait":
+        if len(args) != 1:
+            raise ScenarioError("expected 'wait S'")
+        parse_number(args[0], "wait")
+    elif verb == "expect":
+        parse_condition(split_limit(args)[0])
+    else:
+        raise ScenarioError(f"unknown step '{verb}'")
+
+
+def parse_scenario(path):
+    try:
+        with open(path) as f:
+            lines = f.readlines()
+    except OSError as e:
+        raise ScenarioError(f"{path}: {e.strerror}")
+    steps = []
+    for number, raw in enumerate(lines, 1):
+        text = raw.split("#", 1)[0].strip()
+        if not text:
+            continue
+        try:
+            words = shlex.split(text)
+            at = None
+            if words[0] == "at":
+                if len(words) < 3:
+                    raise ScenarioError("expected 'at T STEP'")
+                at = parse_number(words[1], "time")
+                words = words[2:]
+            step = Step(number, text, at, words[0], words[1:])
+            check_step(step)
+        except (ScenarioError, ValueError) as e:
+            raise ScenarioError(f"{path}:{number}: {e}")
+        steps.append(step)
+    return steps
+
+
+# ---------------------------------------------------------------------------
+# Running
+# ---------------------------------------------------------------------------
+
+class Runner:
+    def __init__(self, link, trace, clock):
+        self.link = link
+        self.trace = trace
+        self.clock = clock
+
+    def sleep(self, seconds):
+        if seconds > 0:
+            time.sleep(self.clock.wall(seconds))
+
+    def mark(self):
+        with self.trace.changed:
+            self.trace.log_mark = len(self.trace.logs)
+
+    def press(self, pin, hold_ms):
+        self.mark()
+        self.link.send(sim_protocol.MSG_INPUT, struct.pack("<BB", pin, 1))
+        self.sleep(hold_ms / 1000)
+        self.link.send(sim_protocol.MSG_INPUT, struct.pack("<BB", pin, 0))
+
+    def wait_for(self, description, predicate, mode, seconds):
+        """Returns how long the condition took to be met, or held."""
+        start = self.clock.now()
+        deadline = start + seconds
+        with self.trace.changed:
+            while True:
+                ok = predicate(self.trace)
+                now = self.clock.now()
+                if mode == "within" and ok:
+                    return now - start
+                if mode == "for" and not ok:
+                    raise ScenarioError(f"'{description}' stopped holding after "
+                                        f"{now - start:.2f} s")
+                if now >= deadline:
+                    if mode == "for":
+                        return now - start
+                    raise ScenarioError(f"'{description}' not met within {seconds:g} s")
+                # Conditions change with frames; the timeout ends the wait
+                self.trace.changed.wait(min(self.clock.wall(deadline - now), 0.5))
+
+    def run_step(self, step):
+        """Returns the time an expectation took, or None for an action."""
+        verb, args = step.verb, step.args
+        if verb in ("power", "start"):
+            self.press(PINS[verb], PRESS_MS)
+        elif verb == "press":
+            self.press(pin_number(args[0]), float(args[1]) if len(args) == 2 else PRESS_MS)
+        elif verb == "door":
+            self.mark()
+            self.link.send(sim_protocol.MSG_INPUT,
+                           struct.pack("<BB", PINS["door"], 1 if args[0] == "open" else 0))
+        elif verb == "dial":
+            self.mark()
+            self.link.send(sim_protocol.MSG_DIAL, struct.pack("<h", int(float(args[0]))))
+        elif verb == "program":
+            target = int(float(args[0]))
+            if self.trace.state is None:
+                raise ScenarioError("no machine state received yet")
+            self.mark()
+            self.link.send(sim_protocol.MSG_DIAL,
+                           struct.pack("<h", target - self.trace.state["program"]))
+            return self.wait_for(f"program {target}",
+                                 lambda t: t.state is not None and t.state["program"] == target,
+                                 "within", DEFAULT_WITHIN_S)
+        elif verb == "wait":
+            self.sleep(float(args[0]))
+        elif verb == "expect":
+            cond, mode, seconds = split_limit(args)
+            description, predicate = parse_condition(cond)
+            return self.wait_for(description, predicate, mode, seconds)
+        return None
+
+
+def print_trace_tail(trace, count=12):
+    with trace.changed:
+        tail = trace.events[-count:]
+        state = trace.state_name()
+        motor = trace.motor
+    print(f"       state {state}, motor {motor[0]} rpm target, {motor[1]} rpm; last events:")
+    for t, event in tail:
+        print(f"       {t:9.2f} s  {event}")
+
+
+def run_scenario(path, args):
+    steps = parse_scenario(path)
+    clock = Clock(args.speed if args.host else 1.0)
+    trace = Trace(clock)
+    if args.host:
+        link = ProcessLink(trace, args.verbose, args.host, args.speed)
+    else:
+        link = SerialLink(trace, args.verbose, args.port)
+    link.start()
+    runner = Runner(link, trace, clock)
+    wall_start = time.monotonic()
+    result = {"scenario": path, "passed": True, "steps": []}
+    try:
+        if not args.host:
+            # A device keeps running between scenarios; ask where it is
+            link.send(sim_protocol.MSG_COMMAND, b"S\0")
+        for step in steps:
+            if step.at is not None:
+                runner.sleep(step.at - clock.now())
+            started = clock.now()
+            entry = {"line": step.line, "step": step.text, "time_s": round(started, 3)}
+            if step.at is not None and started - step.at > 0.5:
+                entry["late_s"] = round(started - step.at, 3)
+            result["steps"].append(entry)
+            try:
+                took = runner.run_step(step)
+            except ScenarioError as e:
+                entry["error"] = str(e)
+                result["passed"] = False
+                print(f"  FAIL {path}:{step.line}: {step.text}\n       {e}")
+                print_trace_tail(trace)
+                break
+            entry["duration_s"] = round(clock.now() - started, 3)
+            if took is not None:
+                holds = step.verb == "expect" and split_limit(step.args)[1] == "for"
+                entry["held_s" if holds else "met_after_s"] = round(took, 3)
+            if args.verbose:
+                print(f"  {started:9.2f} s  {step.text}")
+    finally:
+        link.close()
+    result["scenario_s"] = round(clock.now(), 3)
+    result["wall_s"] = round(time.monotonic() - wall_start, 3)
+    result["lost_frames"] = trace.lost_frames
+    if args.trace:
+        result["trace"] = [{"time_s": round(t, 3), "event": e} for t, e in trace.events]
+    return result
+
+
+def print_report(result):
+    expects = [s for s in result["steps"] if "met_after_s" in s]
+    slowest = max(expects, key=lambda s: s["met_after_s"], default=None)
+    line = (f"{os.path.basename(result['scenario']):<24} {len(result['steps']):3d} steps "
+            f"{result['scenario_s']:8.1f} s scenario in {result['wall_s']:6.1f} s wall")
+    if slowest:
+        line += f"  slowest expect {slowest['met_after_s']:.2f} s (line {slowest['line']})"
+    late = [s for s in result["steps"] if "late_s" in s]
+    if late:
+        line += f"  {len(late)} steps late"
+    if result["lost_frames"]:
+        line += f"  {result['lost_frames']} frames lost"
+    print(f"{line}  {'ok' if result['passed'] else 'FAIL'}")
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description="Run simulator scenario scripts headless",
+        formatter_class=argparse.RawDescriptionHelpFormatter, epilog=__doc__)
+    target = parser.add_mutually_exclusive_group(required=True)
+    target.add_argument("--host", metavar="WASHER_HOST",
+                        help="start this host build for every scenario")
+    target.add_argument("--port", metavar="PORT",
+                        help="serial port or pyserial URL of a device in simulator mode")
+    parser.add_argument("--speed", type=int, default=1,
+                        help="host build clock speed (default 1)")
+    parser.add_argument("--json", metavar="FILE", help="write the timing report as JSON")
+    parser.add_argument("--trace", action="store_true",
+                        help="include the state and actuator trace in the JSON report")
+    parser.add_argument("-v", "--verbose", action="store_true",
+                        help="print firmware logs and every step")
+    parser.add_argument("scenarios", nargs="+")
+    args = parser.parse_args()
+    if args.speed < 1:
+        parser.error("--speed must be at least 1")
+
+    results = []
+    for path in args.scenarios:
+        try:
+            result = run_scenario(path, args)
+        except ScenarioError as e:
+            print(f"  FAIL {e}")
+            result = {"scenario": path, "passed": False, "error": str(e), "steps": [],
+                      "scenario_s": 0.0, "wall_s": 0.0, "lost_frames": 0}
+        print_report(result)
+        results.append(result)
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+    failed = sum(not r["passed"] for r in results)
+    if len(results) > 1:
+        print(f"{len(results) - failed}/{len(results)} scenarios passed")
+    sys.exit(1 if failed else 0)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,233 @@
+/*
+ * sound_render.cpp
+ * Host renderer: writes every SOUND_EFFECT_* to WAV and times the synth
+ *
+ * Copyright 2025 Yusuf Emre Kenaroglu
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+/*
+ * Why this tool exists:
+ * - sound_synth.cpp is the exact code that fills the DAC DMA buffers on the
+ *   device. Running it here makes effect changes audible without flashing,
+ *   and gives byte-exact WAVs that can be diffed between revisions.
+ * - The benchmark renders each effect repeatedly in SOUND_BLOCK_SAMPLES
+ *   chunks, the same way sound_task does, and reports the cost per block.
+ *   Host numbers are only useful relative to each other, not as ESP32 timing.
+ * - With --blob the deterministic effects are written as one PCM blob
+ *   (layout in sound_synth.h) which the firmware build embeds when
+ *   CONFIG_SOUND_PCM_CACHE is enabled.
+ *
+ * Usage: sound_render [out_dir] [--bench iterations] [--blob file]
+ */
+
+#include "sound_synth.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Must match SOUND_BLOCK_SAMPLES in sound.h (which pulls in ESP-IDF headers)
+static const size_t kBlockSamples = 128;
+
+// The blob is written with the host struct layout and read on the ESP32,
+// both little-endian with natural alignment
+static_assert(sizeof(sound_pcm_header_t) == 8, "blob header layout");
+static_assert(sizeof(sound_pcm_entry_t) == 12, "blob entry layout");
+
+// Fixed seed so the water fill effect renders identically every run
+static const uint32_t kSeed = 0x5EED1234u;
+
+static const char *effect_names[SOUND_EFFECT_COUNT] = {
+    "startup", "button_press", "cycle_start", "cycle_end", "error", "door_open",
+    "water_fill", "on", "off", "select", "stop",
+};
+
+static std::vector<uint8_t> render_effect(uint8_t effect_id, bool trim_silence = false)
+{
+    synth_mixer_t mixer;
+    synth_mixer_init(&mixer);
+    synth_mixer_play_effect(&mixer, effect_id, kSeed);
+
+    std::vector<uint8_t> pcm;
+    uint8_t block[kBlockSamples];
+    bool active = true;
+    while (active) {
+        active = synth_mixer_render(&mixer, block, kBlockSamples);
+        pcm.insert(pcm.end(), block, block + kBlockSamples);
+    }
+
+    if (trim_silence) {
+        while (!pcm.empty() && pcm.back() == 128) {
+            pcm.pop_back();
+        }
+    }
+    return pcm;
+}
+
+static void put_u16(FILE *f, uint16_t v)
+{
+    uint8_t b[2] = { (uint8_t)v, (uint8_t)(v >> 8) };
+    fwrite(b, 1, 2, f);
+}
+
+static void put_u32(FILE *f, uint32_t v)
+{
+    uint8_t b[4] = { (uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24) };
+    fwrite(b, 1, 4, f);
+}
+
+/**
+ * @brief Write 8-bit unsigned mono PCM (the DAC's native format) as WAV
+ */
+static bool write_wav(const std::string &path, const std::vector<uint8_t> &pcm)
+{
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        perror(path.c_str());
+        return false;
+    }
+
+    uint32_t data_len = (uint32_t)pcm.size();
+    fwrite("RIFF", 1, 4, f);
+    put_u32(f, 36 + data_len);
+    fwrite("WAVEfmt ", 1, 8, f);
+    put_u32(f, 16);                     // fmt chunk size
+    put_u16(f, 1);                      // PCM
+    put_u16(f, 1);                      // mono
+    put_u32(f, SOUND_SAMPLE_RATE);
+    put_u32(f, SOUND_SAMPLE_RATE);      // byte rate
+    put_u16(f, 1);                      // block align
+    put_u16(f, 8);                      // bits per sample
+    fwrite("data", 1, 4, f);
+    put_u32(f, data_len);
+    fwrite(pcm.data(), 1, pcm.size(), f);
+
+    fclose(f);
+    return true;
+}
+
+/**
+ * @brief Write every cacheable effect into one blob for the firmware build
+ */
+static bool write_blob(const std::string &path)
+{
+    std::vector<sound_pcm_entry_t> entries;
+    std::vector<uint8_t> samples;
+
+    for (uint8_t id = 0; id < SOUND_EFFECT_COUNT; id++) {
+        if (!synth_effect_is_cacheable(id)) {
+            continue;
+        }
+        std::vector<uint8_t> pcm = render_effect(id, true);
+        sound_pcm_entry_t entry = {};
+        entry.effect_id = id;
+        entry.length = (uint32_t)pcm.size();
+        entry.offset = (uint32_t)samples.size();     // Fixed up below
+        entries.push_back(entry);
+        samples.insert(samples.end(), pcm.begin(), pcm.end());
+    }
+
+    sound_pcm_header_t header = {};
+    header.magic = SOUND_PCM_MAGIC;
+    header.version = SOUND_PCM_VERSION;
+    header.count = (uint16_t)entries.size();
+
+    uint32_t data_start = sizeof(header) + entries.size() * sizeof(sound_pcm_entry_t);
+    for (auto &entry : entries) {
+        entry.offset += data_start;
+    }
+
+    FILE *f = fopen(path.c_str(), "wb");
+    if (f == nullptr) {
+        perror(path.c_str());
+        return false;
+    }
+    fwrite(&header, sizeof(header), 1, f);
+    fwrite(entries.data(), sizeof(sound_pcm_entry_t), entries.size(), f);
+    fwrite(samples.data(), 1, samples.size(), f);
+    fclose(f);
+
+    printf("blob: %zu effects, %zu bytes -> %s\n", entries.size(),
+           data_start + samples.size(), path.c_str());
+    return true;
+}
+
+static void bench_effect(uint8_t effect_id, int iterations)
+{
+    uint8_t block[kBlockSamples];
+    size_t blocks = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int it = 0; it < iterations; it++) {
+        synth_mixer_t mixer;
+        synth_mixer_init(&mixer);
+        synth_mixer_play_effect(&mixer, effect_id, kSeed);
+        bool active = true;
+        while (active) {
+            active = synth_mixer_render(&mixer, block, kBlockSamples);
+            blocks++;
+        }
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(end - start).count();
+    double ns_per_block = ns / (double)blocks;
+    double audio_s = (double)(blocks * kBlockSamples) / SOUND_SAMPLE_RATE;
+    printf("  %-14s %8.1f ns/block %8.2f ns/sample  %7.0fx realtime\n",
+           effect_names[effect_id], ns_per_block, ns_per_block / kBlockSamples,
+           audio_s / (ns / 1e9));
+}
+
+int main(int argc, char **argv)
+{
+    std::string out_dir;
+    std::string blob_path;
+    int bench_iterations = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc) {
+            bench_iterations = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--blob") == 0 && i + 1 < argc) {
+            blob_path = argv[++i];
+        } else if (argv[i][0] == '-') {
+            fprintf(stderr, "usage: %s [out_dir] [--bench iterations] [--blob file]\n", argv[0]);
+            return 2;
+        } else {
+            out_dir = argv[i];
+        }
+    }
+
+    // Blob-only runs (the firmware build) skip the WAVs
+    if (out_dir.empty() && !blob_path.empty()) {
+        return write_blob(blob_path) ? 0 : 1;
+    }
+    if (out_dir.empty()) {
+        out_dir = ".";
+    }
+    if (!blob_path.empty() && !write_blob(blob_path)) {
+        return 1;
+    }
+
+    for (uint8_t id = 0; id < SOUND_EFFECT_COUNT; id++) {
+        std::vector<uint8_t> pcm = render_effect(id);
+        std::string path = out_dir + "/" + effect_names[id] + ".wav";
+        if (!write_wav(path, pcm)) {
+            return 1;
+        }
+        printf("%-14s %6zu samples (%4zu ms) -> %s\n", effect_names[id], pcm.size(),
+               pcm.size() * 1000 / SOUND_SAMPLE_RATE, path.c_str());
+    }
+
+    if (bench_iterations > 0) {
+        printf("\nbenchmark (%d iterations, %zu-sample blocks):\n", bench_iterations, kBlockSamples);
+        for (uint8_t id = 0; id < SOUND_EFFECT_COUNT; id++) {
+            bench_effect(id, bench_iterations);
+        }
+    }
+
+    return 0;
+}
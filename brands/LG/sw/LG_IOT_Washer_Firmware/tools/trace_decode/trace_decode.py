@@ -0,0 +1,335 @@
+#!/usr/bin/env python3
+"""Decode a trace dump from the washer firmware (main/diagnostics/trace.h).
+
+The dump holds the latency trace (CONFIG_LATENCY_TRACE) followed by the
+per-core event trace (CONFIG_EVENT_TRACE, main/diagnostics/event_trace.h),
+each section starting with its own magic. Input is either the binary dump
+from GET /api/trace, or a console log that contains the "TRACE BEGIN" ...
+"TRACE END" hex lines printed by the simulator "$T" command
+(tools/simulator saves those as .bin already).
+
+Usage:
+    trace_decode.py wm_trace.bin            # latency and event summaries
+    trace_decode.py wm_trace.bin --traces   # plus one line per input
+    trace_decode.py wm_trace.bin --chrome wm_trace.json
+                                            # event timeline for Perfetto
+    curl -s http://<device>/api/trace | trace_decode.py -
+"""
+
+import argparse
+import contextlib
+import json
+import os
+import re
+import struct
+import sys
+
+MAGIC = 0x52544D57  # "WMTR"
+HEADER = struct.Struct("<IBBHII")
+RECORD = struct.Struct("<IHBB")
+
+EVENT_MAGIC = 0x54454D57  # "WMET"
+EVENT_HEADER = struct.Struct("<IBBBBIIIHH")
+EVENT_TASK = struct.Struct("<H14s")
+EVENT_RECORD = struct.Struct("<IBBHII")
+
+EVENT_HEADER_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                 "..", "..", "main", "diagnostics", "event_trace.h")
+
+# ISR records have no task; give each core's ISRs their own row
+ISR_TID_BASE = 1000
+
+STAGES = ["edge", "enqueue", "dispatch", "command", "actuate", "frame"]
+EDGE, ENQUEUE, DISPATCH, COMMAND, ACTUATE, FRAME = range(len(STAGES))
+
+# wm_event_type_t and wm_command_type_t (main/tasks/tasks.h)
+EVENTS = ["power_button", "start_button", "door", "tick", "sensor", "start_long",
+          "dial", "motor_fault"]
+COMMANDS = ["power_led", "drum_led", "start_led", "sound", "logo", "circ_pump",
+            "fill_pump", "drain_pump", "dial_leds", "ramp", "batch", "sequence"]
+
+# (name, from stage, to stage) reported in the summary
+SPANS = [
+    ("edge->enqueue", EDGE, ENQUEUE),
+    ("enqueue->dispatch", ENQUEUE, DISPATCH),
+    ("dispatch->command", DISPATCH, COMMAND),
+    ("command->actuate", COMMAND, ACTUATE),
+    ("dispatch->frame", DISPATCH, FRAME),
+    ("edge->actuate", EDGE, ACTUATE),
+    ("edge->frame", EDGE, FRAME),
+]
+
+
+def load(data):
+    """Return raw dump bytes from a binary file or a console log."""
+    if len(data) >= 4 and struct.unpack_from("<I", data)[0] in (MAGIC, EVENT_MAGIC):
+        return data
+    out = bytearray()
+    inside = False
+    for raw in data.decode("utf-8", errors="ignore").splitlines():
+        line = raw.strip()
+        pos = line.find("TRACE ")
+        if pos < 0:
+            continue
+        line = line[pos:]
+        if line == "TRACE BEGIN":
+            out.clear()
+            inside = True
+        elif line == "TRACE END":
+            inside = False
+        elif inside:
+            out += bytes.fromhex(line[6:])
+    if not out:
+        sys.exit("no trace dump found in input")
+    return bytes(out)
+
+
+def split(dump):
+    """Return (latency section, event section); either may be None."""
+    latency = events = None
+    offset = 0
+    while offset + 4 <= len(dump):
+        magic = struct.unpack_from("<I", dump, offset)[0]
+        if magic == MAGIC:
+            count = HEADER.unpack_from(dump, offset)[3]
+            end = offset + HEADER.size + count * RECORD.size
+            latency = dump[offset:end]
+        elif magic == EVENT_MAGIC:
+            fields = EVENT_HEADER.unpack_from(dump, offset)
+            cores, task_count = fields[3], fields[4]
+            records = sum(fields[8:10][:cores])
+            end = (offset + EVENT_HEADER.size + task_count * EVENT_TASK.size
+                   + records * EVENT_RECORD.size)
+            events = dump[offset:end]
+        else:
+            sys.exit(f"unknown dump section at byte {offset} (magic {magic:#x})")
+        offset = end
+    return latency, events
+
+
+def parse(dump):
+    magic, version, record_size, count, lost, now_us = HEADER.unpack_from(dump)
+    if magic != MAGIC or version != 1 or record_size != RECORD.size:
+        sys.exit(f"unsupported dump (magic {magic:#x}, version {version}, record {record_size})")
+    records = []
+    offset = HEADER.size
+    for _ in range(count):
+        if offset + RECORD.size > len(dump):
+            break
+        records.append(RECORD.unpack_from(dump, offset))
+        offset += RECORD.size
+    return records, lost, now_us
+
+
+def group(records):
+    """Map trace id -> {stage: (time_us, arg)}, keeping the first of each stage."""
+    traces = {}
+    for time_us, trace_id, stage, arg in records:
+        if stage == EDGE:
+            # Ids wrap at 65535; a new edge starts a new trace
+            traces[trace_id] = {}
+        stages = traces.setdefault(trace_id, {})
+        stages.setdefault(stage, (time_us, arg))
+    return traces
+
+
+def delta_us(later, earlier):
+    return (later - earlier) & 0xFFFFFFFF
+
+
+def percentile(values, pct):
+    ordered = sorted(values)
+    index = max(0, min(len(ordered) - 1, (len(ordered) * pct + 99) // 100 - 1))
+    return ordered[index]
+
+
+def name(table, index):
+    return table[index] if index < len(table) else str(index)
+
+
+def load_ids(path):
+    """Return [(name, kind)] in id order from the EVENT_TRACE_IDS list."""
+    ids = []
+    with open(path, encoding="utf-8") as f:
+        for line in f:
+            m = re.match(r"\s*X\(ETRACE_(\w+),\s*([BEI])\)", line)
+            if m:
+                ids.append((m.group(1).lower(), m.group(2)))
+    if not ids:
+        sys.exit(f"no trace ids found in {path}")
+    return ids
+
+
+def parse_events(dump):
+    (magic, version, record_size, cores, task_count, now_us,
+     written0, written1, records0, records1) = EVENT_HEADER.unpack_from(dump)
+    if magic != EVENT_MAGIC or version != 1 or record_size != EVENT_RECORD.size:
+        sys.exit(f"unsupported dump (magic {magic:#x}, version {version}, record {record_size})")
+    offset = EVENT_HEADER.size
+    tasks = {}
+    for _ in range(task_count):
+        number, name = EVENT_TASK.unpack_from(dump, offset)
+        tasks[number] = name.split(b"\0", 1)[0].decode("ascii", errors="replace")
+        offset += EVENT_TASK.size
+    records = []
+    counts = [records0, records1][:cores]
+    for count in counts:
+        for _ in range(count):
+            if offset + EVENT_RECORD.size > len(dump):
+                break
+            records.append(EVENT_RECORD.unpack_from(dump, offset))
+            offset += EVENT_RECORD.size
+    lost = sum(w - c for w, c in zip([written0, written1][:cores], counts))
+    return tasks, records, lost, now_us
+
+
+def unwrap(records, now_us):
+    """Sort records by time, undoing the 32-bit wrap relative to the dump time."""
+    out = []
+    for rec in records:
+        # Every record precedes the dump; age is exact across one wrap
+        age = (now_us - rec[0]) & 0xFFFFFFFF
+        out.append((-age,) + rec[1:])
+    out.sort(key=lambda r: r[0])
+    if out:
+        base = out[0][0]
+        out = [(r[0] - base,) + r[1:] for r in out]
+    return out
+
+
+def thread_id(flags, task):
+    core = flags & 1
+    if flags & 2:
+        return ISR_TID_BASE + core
+    return task
+
+
+def span_name(name):
+    return re.sub(r"_(begin|end)$", "", name)
+
+
+def to_chrome(ids, tasks, records):
+    events = []
+    tids = set()
+    for time_us, event_id, flags, task, a, b in records:
+        name, kind = ids[event_id] if event_id < len(ids) else (f"id{event_id}", "I")
+        tid = thread_id(flags, task)
+        tids.add(tid)
+        event = {"name": span_name(name), "ts": time_us, "pid": 0, "tid": tid,
+                 "args": {"a": a, "b": b, "core": flags & 1}}
+        if kind == "B":
+            event["ph"] = "B"
+        elif kind == "E":
+            event["ph"] = "E"
+        else:
+            event["ph"] = "i"
+            event["s"] = "t"
+        events.append(event)
+    for tid in sorted(tids):
+        if tid >= ISR_TID_BASE:
+            label = f"ISR core {tid - ISR_TID_BASE}"
+        else:
+            label = tasks.get(tid, f"task {tid}")
+        events.append({"name": "thread_name", "ph": "M", "pid": 0, "tid": tid,
+                       "args": {"name": label}})
+    events.append({"name": "process_name", "ph": "M", "pid": 0,
+                   "args": {"name": "washer"}})
+    return {"traceEvents": events, "displayTimeUnit": "ms"}
+
+
+def event_summary(ids, records):
+    """Per-id counts, and span durations for begin/end pairs on the same thread."""
+    counts = {}
+    spans = {}
+    open_spans = {}
+    for time_us, event_id, flags, task, _, _ in records:
+        name, kind = ids[event_id] if event_id < len(ids) else (f"id{event_id}", "I")
+        counts[name] = counts.get(name, 0) + 1
+        key = (thread_id(flags, task), span_name(name))
+        if kind == "B":
+            open_spans[key] = time_us
+        elif kind == "E" and key in open_spans:
+            spans.setdefault(key[1], []).append(time_us - open_spans.pop(key))
+    for name in sorted(counts):
+        print(f"{name:<20}{counts[name]:>8}")
+    print(f"{'span':<20}{'n':>6}{'min':>9}{'p50':>9}{'p99':>9}{'max':>9}  (us)")
+    for name, values in sorted(spans.items()):
+        values.sort()
+        p50 = values[(len(values) - 1) // 2]
+        p99 = values[min(len(values) - 1, (len(values) * 99 + 99) // 100 - 1)]
+        print(f"{name:<20}{len(values):>6}{values[0]:>9}{p50:>9}{p99:>9}{values[-1]:>9}")
+
+
+def latency_summary(dump, show_traces):
+    records, lost, _ = parse(dump)
+    traces = group(records)
+    print(f"{len(records)} records, {len(traces)} traces, {lost} records overwritten")
+
+    if show_traces:
+        for trace_id, stages in traces.items():
+            if EDGE not in stages:
+                continue
+            t0, event = stages[EDGE]
+            parts = [f"#{trace_id:<5} {name(EVENTS, event):<13}"]
+            for stage in range(ENQUEUE, len(STAGES)):
+                if stage in stages:
+                    t, arg = stages[stage]
+                    label = STAGES[stage]
+                    if stage in (COMMAND, ACTUATE):
+                        label += f"({name(COMMANDS, arg)})"
+                    parts.append(f"{label}+{delta_us(t, t0)}us")
+            print("  ".join(parts))
+
+    print(f"{'span':<20}{'n':>6}{'min':>9}{'p50':>9}{'p90':>9}{'p99':>9}{'max':>9}  (us)")
+    for span, first, last in SPANS:
+        values = [delta_us(s[last][0], s[first][0])
+                  for s in traces.values() if first in s and last in s]
+        if not values:
+            print(f"{span:<20}{0:>6}")
+            continue
+        print(f"{span:<20}{len(values):>6}{min(values):>9}{percentile(values, 50):>9}"
+              f"{percentile(values, 90):>9}{percentile(values, 99):>9}{max(values):>9}")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("dump", help="binary dump or console log ('-' = stdin)")
+    parser.add_argument("--traces", action="store_true", help="print every latency trace")
+    parser.add_argument("--chrome", metavar="FILE",
+                        help="write the event trace as Chrome trace JSON ('-' = stdout)")
+    parser.add_argument("--header", default=EVENT_HEADER_FILE, help="path to event_trace.h")
+    args = parser.parse_args()
+
+    if args.dump == "-":
+        data = sys.stdin.buffer.read()
+    else:
+        with open(args.dump, "rb") as f:
+            data = f.read()
+    latency, events = split(load(data))
+    if events is None and args.chrome:
+        sys.exit("dump has no event trace (CONFIG_EVENT_TRACE)")
+
+    # Summaries go to stderr when stdout carries the JSON
+    with contextlib.redirect_stdout(sys.stderr if args.chrome == "-" else sys.stdout):
+        if latency is not None:
+            latency_summary(latency, args.traces)
+        if events is None:
+            return
+        ids = load_ids(args.header)
+        tasks, records, lost, now_us = parse_events(events)
+        records = unwrap(records, now_us)
+        print(f"{len(records)} event records, {len(tasks)} tasks, {lost} records overwritten")
+        event_summary(ids, records)
+
+    if args.chrome:
+        trace = to_chrome(ids, tasks, records)
+        if args.chrome == "-":
+            json.dump(trace, sys.stdout)
+            print()
+        else:
+            with open(args.chrome, "w", encoding="utf-8") as f:
+                json.dump(trace, f)
+
+
+if __name__ == "__main__":
+    main()